@@ -13,6 +13,7 @@
 #include <anki/collision/ConvexHullShape.h>
 #include <anki/collision/Ray.h>
 #include <anki/collision/Cone.h>
+#include <anki/collision/RayPacket.h>
 
 #include <anki/collision/Functions.h>
 
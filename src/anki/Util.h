@@ -41,6 +41,7 @@
 #include <anki/util/Serializer.h>
 #include <anki/util/Xml.h>
 #include <anki/util/F16.h>
+#include <anki/util/RadixSort.h>
 
 /// @defgroup util Utilities (like STL)
 
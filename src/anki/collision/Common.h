@@ -57,6 +57,37 @@ enum class FrustumType : U8
 	FIRST = 0
 };
 ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(FrustumType)
+
+/// Penetration info of two intersecting convex shapes.
+class CollisionContact
+{
+public:
+	Vec4 m_normal = Vec4(0.0f); ///< Points from the 1st shape to the 2nd. Move the 1st by -m_normal*m_depth to resolve.
+	Vec4 m_point0 = Vec4(0.0f); ///< The deepest point of the 1st shape inside the 2nd.
+	Vec4 m_point1 = Vec4(0.0f); ///< The deepest point of the 2nd shape inside the 1st.
+	F32 m_depth = 0.0f; ///< Penetration depth.
+};
+
+/// Per shape pair cache that warm starts GJK. Keep it alive between frames for pairs that are tested repeatedly.
+class GjkCache
+{
+public:
+	/// The separating axis of the last query or the penetration normal if there was an intersection.
+	Vec4 m_dir = Vec4(1.0f, 0.0f, 0.0f, 0.0f);
+
+	/// The search directions of the tetrahedron that enclosed the origin in the last query. Re-evaluating the supports
+	/// of those directions most often encloses the origin again.
+	Array<Vec4, 4> m_simplexDirs;
+	U32 m_simplexCount = 0;
+
+	/// The GJK iterations the last query needed. It's zero when the cache settled the query without iterating.
+	U32 m_iterationCount = 0;
+
+	void reset()
+	{
+		*this = GjkCache();
+	}
+};
 /// @}
 
 } // end namespace anki
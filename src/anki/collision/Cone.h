@@ -105,6 +105,23 @@ public:
 		return out;
 	}
 
+	/// Compute the GJK support. Only convex cones (angle less than PI) have one.
+	Vec4 computeSupport(const Vec4& dir) const
+	{
+		check();
+		ANKI_ASSERT(m_angle < PI - EPSILON && "Cones that wide are not convex");
+
+		// The support is either the apex or a point in the rim of the base
+		const Vec4 baseCenter = m_origin + m_dir * m_length;
+		const Vec4 perp = dir - m_dir * dir.dot(m_dir);
+		const F32 perpLenSq = perp.getLengthSquared();
+		const Vec4 rim = (perpLenSq > EPSILON * EPSILON)
+							 ? baseCenter + perp * (m_length * tan(m_angle / 2.0f) / sqrt(perpLenSq))
+							 : baseCenter;
+
+		return (rim.dot(dir) >= m_origin.dot(dir)) ? rim : m_origin;
+	}
+
 private:
 	Vec4 m_origin
 #if ANKI_ENABLE_ASSERTS
@@ -5,6 +5,7 @@
 
 #include <anki/collision/ConvexHullShape.h>
 #include <anki/util/Functions.h>
+#include <algorithm>
 
 namespace anki
 {
@@ -16,7 +17,7 @@ ConvexHullShape ConvexHullShape::getTransformed(const Transform& trf) const
 	ConvexHullShape out = *this;
 
 	out.m_trf = m_trf.combineTransformations(trf);
-	out.m_invTrf = m_trf.getInverse();
+	out.m_invTrf = out.m_trf.getInverse();
 	out.m_trfIdentity = false;
 
 	return out;
@@ -33,17 +34,67 @@ Vec4 ConvexHullShape::computeSupport(const Vec4& dir) const
 {
 	check();
 
+	const Vec4 d = (m_trfIdentity) ? dir : (m_invTrf.getRotation() * dir).xyz0();
+
+	const U32 index = (usesHillClimbing()) ? findSupportHillClimbing(d) : findSupportScan(d);
+
+	return (m_trfIdentity) ? m_points[index] : m_trf.transform(m_points[index]);
+}
+
+U32 ConvexHullShape::findSupportScan(const Vec4& d) const
+{
 	F32 m = MIN_F32;
-	U index = 0;
+	U32 index = 0;
+	U32 i = 0;
 
-	const Vec4 d = (m_trfIdentity) ? dir : (m_invTrf.getRotation() * dir).xyz0();
+#if ANKI_SIMD_SSE
+	if(m_pointCount >= 4)
+	{
+		// Transpose 4 points at a time and compute 4 dot products in parallel
+		const __m128 dx = _mm_set1_ps(d.x());
+		const __m128 dy = _mm_set1_ps(d.y());
+		const __m128 dz = _mm_set1_ps(d.z());
+		const __m128i four = _mm_set1_epi32(4);
+
+		__m128 maxDots = _mm_set1_ps(MIN_F32);
+		__m128i maxIndices = _mm_setzero_si128();
+		__m128i indices = _mm_set_epi32(3, 2, 1, 0);
+
+		for(; i + 4 <= m_pointCount; i += 4)
+		{
+			__m128 x = m_points[i].getSimd();
+			__m128 y = m_points[i + 1].getSimd();
+			__m128 z = m_points[i + 2].getSimd();
+			__m128 w = m_points[i + 3].getSimd();
+			_MM_TRANSPOSE4_PS(x, y, z, w);
 
-	const Vec4* points = m_points;
-	const Vec4* end = m_points + m_pointCount;
-	U i = 0;
-	for(; points != end; ++points, ++i)
+			const __m128 dots = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, dx), _mm_mul_ps(y, dy)), _mm_mul_ps(z, dz));
+			const __m128 greater = _mm_cmpgt_ps(dots, maxDots);
+
+			maxDots = _mm_blendv_ps(maxDots, dots, greater);
+			maxIndices = _mm_castps_si128(
+				_mm_blendv_ps(_mm_castsi128_ps(maxIndices), _mm_castsi128_ps(indices), greater));
+			indices = _mm_add_epi32(indices, four);
+		}
+
+		alignas(16) Array<F32, 4> laneDots;
+		alignas(16) Array<U32, 4> laneIndices;
+		_mm_store_ps(&laneDots[0], maxDots);
+		_mm_store_si128(reinterpret_cast<__m128i*>(&laneIndices[0]), maxIndices);
+		for(U32 lane = 0; lane < 4; ++lane)
+		{
+			if(laneDots[lane] > m)
+			{
+				m = laneDots[lane];
+				index = laneIndices[lane];
+			}
+		}
+	}
+#endif
+
+	for(; i < m_pointCount; ++i)
 	{
-		const F32 dot = points->dot(d);
+		const F32 dot = m_points[i].dot(d);
 		if(dot > m)
 		{
 			m = dot;
@@ -51,7 +102,87 @@ Vec4 ConvexHullShape::computeSupport(const Vec4& dir) const
 		}
 	}
 
-	return (m_trfIdentity) ? m_points[index] : m_trf.transform(m_points[index]);
+	return index;
+}
+
+U32 ConvexHullShape::findSupportHillClimbing(const Vec4& d) const
+{
+	ANKI_ASSERT(m_adjacencyOffsets && m_adjacency);
+
+	U32 index = m_lastSupportIndex.load();
+	ANKI_ASSERT(index < m_pointCount);
+	F32 m = m_points[index].dot(d);
+
+	// Move to a better neighbour until there is none. On a convex hull the local maximum is the global one. The dot
+	// product increases strictly so it can't loop forever
+	Bool moved;
+	do
+	{
+		moved = false;
+
+		const U32 begin = m_adjacencyOffsets[index];
+		const U32 end = m_adjacencyOffsets[index + 1];
+		for(U32 i = begin; i < end; ++i)
+		{
+			const U32 neighbour = m_adjacency[i];
+			const F32 dot = m_points[neighbour].dot(d);
+			if(dot > m)
+			{
+				m = dot;
+				index = neighbour;
+				moved = true;
+			}
+		}
+	} while(moved);
+
+	m_lastSupportIndex.store(index);
+	return index;
+}
+
+void computeConvexHullAdjacency(U32 pointCount, ConstWeakArray<U32> indices, DynamicArrayAuto<U32>& offsets,
+								DynamicArrayAuto<U32>& adjacency)
+{
+	ANKI_ASSERT(pointCount > 0);
+	ANKI_ASSERT(indices.getSize() > 0 && (indices.getSize() % 3) == 0);
+
+	// Gather the edges of all triangles in both directions
+	DynamicArrayAuto<Array<U32, 2>> edges(offsets.getAllocator());
+	edges.create(indices.getSize() * 2);
+	for(U32 tri = 0; tri < indices.getSize(); tri += 3)
+	{
+		for(U32 i = 0; i < 3; ++i)
+		{
+			const U32 a = indices[tri + i];
+			const U32 b = indices[tri + (i + 1) % 3];
+			ANKI_ASSERT(a < pointCount && b < pointCount);
+			edges[(tri + i) * 2] = {{a, b}};
+			edges[(tri + i) * 2 + 1] = {{b, a}};
+		}
+	}
+
+	// Sort them and remove the duplicates, every edge is shared by 2 triangles
+	std::sort(edges.getBegin(), edges.getEnd(), [](const Array<U32, 2>& a, const Array<U32, 2>& b) {
+		return (a[0] != b[0]) ? a[0] < b[0] : a[1] < b[1];
+	});
+	const Array<U32, 2>* edgesEnd = std::unique(edges.getBegin(), edges.getEnd(),
+												[](const Array<U32, 2>& a, const Array<U32, 2>& b) {
+													return a[0] == b[0] && a[1] == b[1];
+												});
+	const U32 edgeCount = U32(edgesEnd - edges.getBegin());
+
+	// Write the output
+	offsets.create(pointCount + 1, 0);
+	adjacency.create(edgeCount);
+	for(U32 i = 0; i < edgeCount; ++i)
+	{
+		++offsets[edges[i][0] + 1];
+		adjacency[i] = edges[i][1];
+	}
+
+	for(U32 i = 0; i < pointCount; ++i)
+	{
+		offsets[i + 1] += offsets[i];
+	}
 }
 
 } // end namespace anki
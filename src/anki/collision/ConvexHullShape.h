@@ -7,6 +7,8 @@
 
 #include <anki/collision/Common.h>
 #include <anki/util/WeakArray.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/Atomic.h>
 
 namespace anki
 {
@@ -20,6 +22,9 @@ class ConvexHullShape
 public:
 	static constexpr CollisionShapeType CLASS_TYPE = CollisionShapeType::CONVEX_HULL;
 
+	/// Below that number of points the SIMD scan is faster than hill climbing.
+	static constexpr U32 HILL_CLIMBING_MIN_POINT_COUNT = 32;
+
 	/// Will not initialize any memory, nothing.
 	ConvexHullShape()
 	{
@@ -51,6 +56,9 @@ public:
 		m_invTrf = b.m_invTrf;
 		m_points = b.m_points;
 		m_pointCount = b.m_pointCount;
+		m_adjacencyOffsets = b.m_adjacencyOffsets;
+		m_adjacency = b.m_adjacency;
+		m_lastSupportIndex.store(b.m_lastSupportIndex.load());
 		m_trfIdentity = b.m_trfIdentity;
 		return *this;
 	}
@@ -62,6 +70,26 @@ public:
 		return ConstWeakArray<Vec4>(m_points, m_pointCount);
 	}
 
+	/// Set the vertex adjacency of the hull. With that the support is found by walking from the previous support
+	/// towards the direction instead of checking all points. The convex hull is not the owner of the storage.
+	/// @param offsets The neighbours of the Nth point are adjacency[offsets[N]] up to adjacency[offsets[N+1]]. Its
+	///                size should be pointCount+1.
+	/// @param adjacency The indices of the neighbours of all points.
+	/// @note All points should be vertices of the hull. See computeConvexHullAdjacency.
+	void setAdjacency(const U32* offsets, const U32* adjacency)
+	{
+		check();
+		ANKI_ASSERT(offsets && adjacency);
+		m_adjacencyOffsets = offsets;
+		m_adjacency = adjacency;
+		m_lastSupportIndex.store(0);
+	}
+
+	Bool hasAdjacency() const
+	{
+		return m_adjacencyOffsets != nullptr;
+	}
+
 	/// Get current transform.
 	const Transform& getTransform() const
 	{
@@ -85,6 +113,12 @@ public:
 	/// Get a transformed.
 	ANKI_USE_RESULT ConvexHullShape getTransformed(const Transform& trf) const;
 
+	/// Return true if computeSupport walks the adjacency instead of scanning all the points.
+	Bool usesHillClimbing() const
+	{
+		return hasAdjacency() && m_pointCount >= HILL_CLIMBING_MIN_POINT_COUNT;
+	}
+
 	/// Compute the GJK support.
 	ANKI_USE_RESULT Vec4 computeSupport(const Vec4& dir) const;
 
@@ -104,13 +138,34 @@ private:
 #endif
 		;
 
+	const U32* m_adjacencyOffsets = nullptr;
+	const U32* m_adjacency = nullptr;
+
+	/// Where the hill climbing starts from. Temporal coherence makes it very close to the next support.
+	mutable Atomic<U32> m_lastSupportIndex = {0};
+
 	Bool m_trfIdentity; ///< Optimization.
 
 	void check() const
 	{
 		ANKI_ASSERT(m_points && m_pointCount > 0);
 	}
+
+	/// Find the support by checking all points.
+	U32 findSupportScan(const Vec4& dir) const;
+
+	/// Find the support by walking the adjacency graph.
+	U32 findSupportHillClimbing(const Vec4& dir) const;
 };
+
+/// Compute the vertex adjacency of a convex hull out of its triangles. The output can be used in
+/// ConvexHullShape::setAdjacency.
+/// @param pointCount The number of points of the hull.
+/// @param indices The indices of the triangles of the hull.
+/// @param[out] offsets See ConvexHullShape::setAdjacency.
+/// @param[out] adjacency See ConvexHullShape::setAdjacency.
+void computeConvexHullAdjacency(U32 pointCount, ConstWeakArray<U32> indices, DynamicArrayAuto<U32>& offsets,
+								DynamicArrayAuto<U32>& adjacency);
 /// @}
 
 } // end namespace anki
@@ -205,6 +205,81 @@ inline F32 testCollisionInside(const Aabb& aabb, const Ray& ray)
 	return distToIntersect;
 }
 
+/// GJK based queries of two convex shapes. They are defined for every pair of Aabb, Sphere, Obb, ConvexHullShape and
+/// Cone:
+///
+/// Bool computeContact(const A& a, const B& b, CollisionContact& contact, GjkCache* cache = nullptr)
+/// Test collision and if the shapes intersect compute the penetration depth, normal and contact points using GJK and
+/// EPA. The contact is valid only if the function returned true. Keep the optional cache alive between frames to warm
+/// start the test.
+///
+/// F32 computeDistance(const A& a, const B& b, Vec4& normal)
+/// Return the distance or zero if the shapes intersect. The normal is the direction from the 1st shape to the 2nd and
+/// it's valid only if the distance is not zero.
+///
+/// Bool computeTimeOfImpact(const A& a, const Vec4& translationA, const B& b, F32& toi, F32 tolerance = 0.001f)
+/// Find when the 1st shape that moves by translationA in the time interval [0, 1] hits the static 2nd shape. It uses
+/// conservative advancement on top of GJK. The toi is valid only if the function returned true. The tolerance is the
+/// distance that is considered a contact.
+#define ANKI_DEF_GJK_FUNCS(A, B) \
+	Bool computeContact(const A& a, const B& b, CollisionContact& contact, GjkCache* cache = nullptr); \
+	F32 computeDistance(const A& a, const B& b, Vec4& normal); \
+	Bool computeTimeOfImpact(const A& a, const Vec4& translationA, const B& b, F32& toi, F32 tolerance = 0.001f);
+
+#define ANKI_DEF_GJK_FUNCS_ALL(A) \
+	ANKI_DEF_GJK_FUNCS(A, Aabb) \
+	ANKI_DEF_GJK_FUNCS(A, Sphere) \
+	ANKI_DEF_GJK_FUNCS(A, Obb) \
+	ANKI_DEF_GJK_FUNCS(A, ConvexHullShape) \
+	ANKI_DEF_GJK_FUNCS(A, Cone)
+
+ANKI_DEF_GJK_FUNCS_ALL(Aabb)
+ANKI_DEF_GJK_FUNCS_ALL(Sphere)
+ANKI_DEF_GJK_FUNCS_ALL(Obb)
+ANKI_DEF_GJK_FUNCS_ALL(ConvexHullShape)
+ANKI_DEF_GJK_FUNCS_ALL(Cone)
+
+#undef ANKI_DEF_GJK_FUNCS
+#undef ANKI_DEF_GJK_FUNCS_ALL
+
+/// Swept test of a sphere that moves by @a translation in the time interval [0, 1] against a static shape.
+/// @param[out] toi The time of the first contact. Valid only if the function returned true.
+/// @return True if they collide.
+Bool sweepCollision(const Sphere& a, const Vec4& translation, const Plane& b, F32& toi);
+
+/// @copydoc sweepCollision(const Sphere&, const Vec4&, const Plane&, F32&)
+Bool sweepCollision(const Sphere& a, const Vec4& translation, const Sphere& b, F32& toi);
+
+/// @copydoc sweepCollision(const Sphere&, const Vec4&, const Plane&, F32&)
+Bool sweepCollision(const Sphere& a, const Vec4& translation, const Aabb& b, F32& toi);
+
+/// @copydoc sweepCollision(const Sphere&, const Vec4&, const Plane&, F32&)
+Bool sweepCollision(const Sphere& a, const Vec4& translation, const Obb& b, F32& toi);
+
+/// Swept test of a box that moves by @a translation in the time interval [0, 1] against a static shape.
+/// @param[out] toi The time of the first contact. Valid only if the function returned true.
+/// @return True if they collide.
+Bool sweepCollision(const Aabb& a, const Vec4& translation, const Aabb& b, F32& toi);
+
+/// @copydoc sweepCollision(const Aabb&, const Vec4&, const Aabb&, F32&)
+inline Bool sweepCollision(const Aabb& a, const Vec4& translation, const Sphere& b, F32& toi)
+{
+	// Same as the sphere moving towards the other direction
+	return sweepCollision(b, -translation, a, toi);
+}
+
+/// @copydoc sweepCollision(const Aabb&, const Vec4&, const Aabb&, F32&)
+inline Bool sweepCollision(const Obb& a, const Vec4& translation, const Sphere& b, F32& toi)
+{
+	return sweepCollision(b, -translation, a, toi);
+}
+
+/// @copydoc sweepCollision(const Aabb&, const Vec4&, const Aabb&, F32&)
+Bool sweepCollision(const Obb& a, const Vec4& translation, const Obb& b, F32& toi);
+
+/// @copydoc sweepCollision(const Aabb&, const Vec4&, const Aabb&, F32&)
+Bool sweepCollision(const Obb& a, const Vec4& translation, const Aabb& b, F32& toi);
+
 #undef ANKI_DEF_TEST_COLLISION_FUNC
 #undef ANKI_DEF_TEST_COLLISION_FUNC_PLANE
 
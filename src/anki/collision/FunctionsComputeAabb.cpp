@@ -42,6 +42,20 @@ Aabb computeAabb(const ConvexHullShape& hull)
 	Vec4 mina(MAX_F32);
 	Vec4 maxa(MIN_F32);
 
+	if(hull.usesHillClimbing())
+	{
+		// Walking the hull along the 6 axes touches a lot less points than iterating all of them
+		for(U32 axis = 0; axis < 3; ++axis)
+		{
+			Vec4 dir(0.0f);
+			dir[axis] = 1.0f;
+			maxa[axis] = hull.computeSupport(dir)[axis];
+			mina[axis] = hull.computeSupport(-dir)[axis];
+		}
+
+		return Aabb(mina.xyz0(), maxa.xyz0());
+	}
+
 	for(const Vec4& point : hull.getPoints())
 	{
 		const Vec4 o = (hull.isTransformIdentity()) ? point : hull.getTransform().transform(point);
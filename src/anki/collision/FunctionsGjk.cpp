@@ -0,0 +1,47 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/collision/Functions.h>
+#include <anki/collision/ConvexHullShape.h>
+#include <anki/collision/Obb.h>
+#include <anki/collision/Cone.h>
+#include <anki/collision/Sphere.h>
+#include <anki/collision/GjkEpa.h>
+
+namespace anki
+{
+
+#define ANKI_DEF_GJK_FUNCS(A, B) \
+	Bool computeContact(const A& a, const B& b, CollisionContact& contact, GjkCache* cache) \
+	{ \
+		return gjkEpa(&a, getGjkSupportCallback<A>(), &b, getGjkSupportCallback<B>(), contact, cache); \
+	} \
+	F32 computeDistance(const A& a, const B& b, Vec4& normal) \
+	{ \
+		return gjkDistance(&a, getGjkSupportCallback<A>(), &b, getGjkSupportCallback<B>(), normal); \
+	} \
+	Bool computeTimeOfImpact(const A& a, const Vec4& translationA, const B& b, F32& toi, F32 tolerance) \
+	{ \
+		return gjkTimeOfImpact(&a, getGjkSupportCallback<A>(), translationA, &b, getGjkSupportCallback<B>(), \
+							   tolerance, toi); \
+	}
+
+#define ANKI_DEF_GJK_FUNCS_ALL(A) \
+	ANKI_DEF_GJK_FUNCS(A, Aabb) \
+	ANKI_DEF_GJK_FUNCS(A, Sphere) \
+	ANKI_DEF_GJK_FUNCS(A, Obb) \
+	ANKI_DEF_GJK_FUNCS(A, ConvexHullShape) \
+	ANKI_DEF_GJK_FUNCS(A, Cone)
+
+ANKI_DEF_GJK_FUNCS_ALL(Aabb)
+ANKI_DEF_GJK_FUNCS_ALL(Sphere)
+ANKI_DEF_GJK_FUNCS_ALL(Obb)
+ANKI_DEF_GJK_FUNCS_ALL(ConvexHullShape)
+ANKI_DEF_GJK_FUNCS_ALL(Cone)
+
+#undef ANKI_DEF_GJK_FUNCS
+#undef ANKI_DEF_GJK_FUNCS_ALL
+
+} // end namespace anki
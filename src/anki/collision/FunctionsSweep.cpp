@@ -0,0 +1,225 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/collision/Functions.h>
+#include <anki/collision/Sphere.h>
+#include <anki/collision/Obb.h>
+
+namespace anki
+{
+
+Bool sweepCollision(const Sphere& a, const Vec4& translation, const Plane& b, F32& toi)
+{
+	const F32 r = a.getRadius();
+	const F32 dist = testPlane(b, a.getCenter());
+	if(absolute(dist) <= r)
+	{
+		toi = 0.0f;
+		return true;
+	}
+
+	// Find when the distance becomes r or -r depending on the side the sphere is
+	const F32 speed = b.getNormal().dot(translation);
+	if((dist > 0.0f && speed >= 0.0f) || (dist < 0.0f && speed <= 0.0f))
+	{
+		return false;
+	}
+
+	const F32 t = (dist > 0.0f) ? (r - dist) / speed : (-r - dist) / speed;
+	if(t > 1.0f)
+	{
+		return false;
+	}
+
+	toi = t;
+	return true;
+}
+
+Bool sweepCollision(const Sphere& a, const Vec4& translation, const Sphere& b, F32& toi)
+{
+	// Solve |s + translation * t| = r for t
+	const Vec4 s = a.getCenter() - b.getCenter();
+	const F32 r = a.getRadius() + b.getRadius();
+	const F32 c = s.dot(s) - r * r;
+	if(c <= 0.0f)
+	{
+		toi = 0.0f;
+		return true;
+	}
+
+	const F32 halfB = s.dot(translation);
+	if(halfB >= 0.0f)
+	{
+		// Moving away
+		return false;
+	}
+
+	const F32 a2 = translation.dot(translation);
+	const F32 discriminant = halfB * halfB - a2 * c;
+	if(discriminant < 0.0f)
+	{
+		return false;
+	}
+
+	const F32 t = (-halfB - sqrt(discriminant)) / a2;
+	if(t > 1.0f)
+	{
+		return false;
+	}
+
+	toi = t;
+	return true;
+}
+
+Bool sweepCollision(const Sphere& a, const Vec4& translation, const Aabb& b, F32& toi)
+{
+	const Vec4& c = a.getCenter();
+	const F32 r = a.getRadius();
+
+	// Intersect the path of the center with the box enlarged by the radius. That's the exact shape everywhere except
+	// the edges and the corners that should be rounded
+	F32 tNear = 0.0f;
+	F32 tFar = 1.0f;
+	for(U i = 0; i < 3; ++i)
+	{
+		const F32 minb = b.getMin()[i] - r;
+		const F32 maxb = b.getMax()[i] + r;
+		if(isZero(translation[i]))
+		{
+			if(c[i] < minb || c[i] > maxb)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			const F32 invDir = 1.0f / translation[i];
+			F32 t0 = (minb - c[i]) * invDir;
+			F32 t1 = (maxb - c[i]) * invDir;
+			if(t0 > t1)
+			{
+				swapValues(t0, t1);
+			}
+
+			tNear = max(tNear, t0);
+			tFar = min(tFar, t1);
+			if(tNear > tFar)
+			{
+				return false;
+			}
+		}
+	}
+
+	// Advance conservatively from the entry point since it may be in the empty space of an edge or a corner
+	constexpr U32 MAX_ITERATIONS = 16;
+	const F32 tolerance = r * 1.0e-3f;
+	F32 t = tNear;
+	for(U32 iteration = 0; iteration < MAX_ITERATIONS; ++iteration)
+	{
+		const Vec4 p = c + translation * t;
+		const Vec4 closest = p.max(b.getMin()).min(b.getMax());
+		const Vec4 diff = closest - p;
+		const F32 centerDist = diff.getLength();
+		const F32 dist = centerDist - r;
+		if(dist <= tolerance)
+		{
+			toi = t;
+			return true;
+		}
+
+		const F32 speed = translation.dot(diff / centerDist);
+		if(speed <= 0.0f)
+		{
+			return false;
+		}
+
+		t += dist / speed;
+		if(t > tFar)
+		{
+			return false;
+		}
+	}
+
+	toi = t;
+	return true;
+}
+
+Bool sweepCollision(const Sphere& a, const Vec4& translation, const Obb& b, F32& toi)
+{
+	// Move the sphere to the space of the box
+	const Mat3 invRot = b.getRotation().getRotationPart().getTransposed();
+	const Vec4 center = (invRot * (a.getCenter() - b.getCenter()).xyz()).xyz0();
+	const Vec4 localTranslation = (invRot * translation.xyz()).xyz0();
+
+	return sweepCollision(Sphere(center, a.getRadius()), localTranslation, Aabb(-b.getExtend(), b.getExtend()), toi);
+}
+
+Bool sweepCollision(const Aabb& a, const Vec4& translation, const Aabb& b, F32& toi)
+{
+	// Find the time interval the boxes overlap in every axis
+	F32 tFirst = 0.0f;
+	F32 tLast = 1.0f;
+	for(U i = 0; i < 3; ++i)
+	{
+		const F32 v = translation[i];
+		const F32 mina = a.getMin()[i];
+		const F32 maxa = a.getMax()[i];
+		const F32 minb = b.getMin()[i];
+		const F32 maxb = b.getMax()[i];
+
+		if(v < 0.0f)
+		{
+			if(maxa < minb)
+			{
+				return false;
+			}
+
+			if(maxb < mina)
+			{
+				tFirst = max((maxb - mina) / v, tFirst);
+			}
+
+			tLast = min((minb - maxa) / v, tLast);
+		}
+		else if(v > 0.0f)
+		{
+			if(mina > maxb)
+			{
+				return false;
+			}
+
+			if(maxa < minb)
+			{
+				tFirst = max((minb - maxa) / v, tFirst);
+			}
+
+			tLast = min((maxb - mina) / v, tLast);
+		}
+		else if(maxa < minb || mina > maxb)
+		{
+			return false;
+		}
+
+		if(tFirst > tLast)
+		{
+			return false;
+		}
+	}
+
+	toi = tFirst;
+	return true;
+}
+
+Bool sweepCollision(const Obb& a, const Vec4& translation, const Obb& b, F32& toi)
+{
+	return computeTimeOfImpact(a, translation, b, toi);
+}
+
+Bool sweepCollision(const Obb& a, const Vec4& translation, const Aabb& b, F32& toi)
+{
+	return computeTimeOfImpact(a, translation, b, toi);
+}
+
+} // end namespace anki
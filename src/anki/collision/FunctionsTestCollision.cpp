@@ -14,18 +14,6 @@
 namespace anki
 {
 
-template<typename T, typename Y>
-static Bool testCollisionGjk(const T& a, const Y& b)
-{
-	auto callbackA = [](const void* shape, const Vec4& dir) {
-		return static_cast<const T*>(shape)->computeSupport(dir);
-	};
-	auto callbackB = [](const void* shape, const Vec4& dir) {
-		return static_cast<const Y*>(shape)->computeSupport(dir);
-	};
-	return gjkIntersection(&a, callbackA, &b, callbackB);
-}
-
 Bool testCollision(const Aabb& a, const Aabb& b)
 {
 #if ANKI_SIMD_SSE
@@ -164,8 +152,7 @@ Bool testCollision(const Aabb& aabb, const LineSegment& ls)
 
 Bool testCollision(const Aabb& aabb, const Cone& cone)
 {
-	ANKI_ASSERT(!"TODO");
-	return false;
+	return testCollisionGjk(aabb, cone);
 }
 
 Bool testCollision(const Sphere& a, const Sphere& b)
@@ -297,8 +284,7 @@ Bool testCollision(const Obb& obb, const LineSegment& ls)
 
 Bool testCollision(const Obb& obb, const Cone& cone)
 {
-	ANKI_ASSERT(!"TODO");
-	return false;
+	return testCollisionGjk(obb, cone);
 }
 
 Bool testCollision(const ConvexHullShape& a, const ConvexHullShape& b)
@@ -314,8 +300,7 @@ Bool testCollision(const ConvexHullShape& hull, const LineSegment& ls)
 
 Bool testCollision(const ConvexHullShape& hull, const Cone& cone)
 {
-	ANKI_ASSERT(!"TODO");
-	return false;
+	return testCollisionGjk(hull, cone);
 }
 
 Bool testCollision(const LineSegment& a, const LineSegment& b)
@@ -326,8 +311,7 @@ Bool testCollision(const LineSegment& a, const LineSegment& b)
 
 Bool testCollision(const Cone& a, const Cone& b)
 {
-	ANKI_ASSERT(!"TODO");
-	return false;
+	return testCollisionGjk(a, b);
 }
 
 Bool testCollision(const Plane& plane, const Ray& ray, Vec4& intersection)
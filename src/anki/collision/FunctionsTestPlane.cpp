@@ -117,6 +117,26 @@ F32 testPlane(const Plane& plane, const Obb& obb)
 
 F32 testPlane(const Plane& plane, const ConvexHullShape& hull)
 {
+	if(hull.usesHillClimbing())
+	{
+		// The supports give the points closest and furthest from the plane
+		const F32 minDist = testPlane(plane, hull.computeSupport(-plane.getNormal()));
+		const F32 maxDist = testPlane(plane, hull.computeSupport(plane.getNormal()));
+
+		if(minDist > 0.0f)
+		{
+			return minDist;
+		}
+		else if(maxDist < 0.0f)
+		{
+			return maxDist;
+		}
+		else
+		{
+			return 0.0f;
+		}
+	}
+
 	// Compute the invert transformation of the plane instead
 	const Plane pa = (hull.isTransformIdentity()) ? plane : plane.getTransformed(hull.getInvertTransform());
 
@@ -16,6 +16,7 @@ public:
 	Vec4 m_v;
 	Vec4 m_v0;
 	Vec4 m_v1;
+	Vec4 m_dir; ///< The search direction that produced this support. Used to warm start.
 
 	Bool operator==(const GjkSupport& b) const
 	{
@@ -34,6 +35,7 @@ public:
 	Array<GjkSupport, 4> m_simplex;
 	U32 m_count; ///< Simplex count
 	Vec4 m_dir;
+	U32 m_iterationCount = 0;
 };
 
 /// Helper of (axb)xa
@@ -46,6 +48,7 @@ static Vec4 crossAba(const Vec4& a, const Vec4& b)
 
 static void support(const GjkContext& ctx, GjkSupport& support)
 {
+	support.m_dir = ctx.m_dir;
 	support.m_v0 = ctx.m_shape0Callback(ctx.m_shape0, ctx.m_dir);
 	support.m_v1 = ctx.m_shape1Callback(ctx.m_shape1, -ctx.m_dir);
 	support.m_v = support.m_v0 - support.m_v1;
@@ -210,19 +213,66 @@ static Bool update(GjkContext& ctx, const GjkSupport& a)
 	return true;
 }
 
-Bool gjkIntersection(const void* shape0, GjkSupportCallback shape0Callback, const void* shape1,
-					 GjkSupportCallback shape1Callback)
+/// Return true if the origin is inside or on the surface of the tetrahedron.
+static Bool originInsideTetrahedron(const Vec4& a, const Vec4& b, const Vec4& c, const Vec4& d)
 {
-	ANKI_ASSERT(shape0 && shape0Callback && shape1 && shape1Callback);
+	const Array<const Vec4*, 4> v = {{&a, &b, &c, &d}};
+	for(U32 i = 0; i < 4; ++i)
+	{
+		// Face (i, j, k) and the opposite vertex l
+		const Vec4& p0 = *v[i];
+		const Vec4& p1 = *v[(i + 1) % 4];
+		const Vec4& p2 = *v[(i + 2) % 4];
+		const Vec4& p3 = *v[(i + 3) % 4];
+
+		const Vec4 n = (p1 - p0).cross(p2 - p0);
+		const F32 opposite = n.dot(p3 - p0);
+		if(absolute(opposite) < EPSILON)
+		{
+			// Degenerate
+			return false;
+		}
 
-	GjkContext ctx;
-	ctx.m_shape0 = shape0;
-	ctx.m_shape1 = shape1;
-	ctx.m_shape0Callback = shape0Callback;
-	ctx.m_shape1Callback = shape1Callback;
+		const F32 origin = -n.dot(p0);
+		if(origin * opposite < 0.0f)
+		{
+			return false;
+		}
+	}
 
-	// Chose random direction
-	ctx.m_dir = Vec4(1.0, 0.0, 0.0, 0.0);
+	return true;
+}
+
+/// Try to enclose the origin using the search directions of the previous query.
+static Bool warmStart(GjkContext& ctx, const GjkCache& cache)
+{
+	ANKI_ASSERT(cache.m_simplexCount == 4);
+	for(U32 i = 0; i < 4; ++i)
+	{
+		ctx.m_dir = cache.m_simplexDirs[i];
+		support(ctx, ctx.m_simplex[i]);
+	}
+
+	if(originInsideTetrahedron(ctx.m_simplex[0].m_v, ctx.m_simplex[1].m_v, ctx.m_simplex[2].m_v,
+							   ctx.m_simplex[3].m_v))
+	{
+		ctx.m_count = 4;
+		return true;
+	}
+
+	return false;
+}
+
+static Bool gjk(GjkContext& ctx, GjkCache* cache)
+{
+	if(cache && cache->m_simplexCount == 4 && warmStart(ctx, *cache))
+	{
+		return true;
+	}
+
+	// Chose the last known separating axis or a random direction
+	ctx.m_dir = (cache && cache->m_dir.getLengthSquared() > EPSILON) ? cache->m_dir : Vec4(1.0, 0.0, 0.0, 0.0);
+	ctx.m_count = 0;
 
 	// Do cases 1, 2
 	support(ctx, ctx.m_simplex[2]);
@@ -232,6 +282,13 @@ Bool gjkIntersection(const void* shape0, GjkSupportCallback shape0Callback, cons
 	}
 
 	ctx.m_dir = -ctx.m_simplex[2].m_v;
+	if(ctx.m_dir.getLengthSquared() < EPSILON * EPSILON)
+	{
+		// Touching
+		ctx.m_count = 1;
+		return true;
+	}
+
 	support(ctx, ctx.m_simplex[1]);
 
 	if(ctx.m_simplex[1].m_v.dot(ctx.m_dir) < 0.0)
@@ -245,8 +302,15 @@ Bool gjkIntersection(const void* shape0, GjkSupportCallback shape0Callback, cons
 	U iterations = 20;
 	while(iterations--)
 	{
+		if(ctx.m_dir.getLengthSquared() < EPSILON * EPSILON)
+		{
+			// The origin lies on the simplex, consider it touching
+			return true;
+		}
+
 		GjkSupport a;
 		support(ctx, a);
+		++ctx.m_iterationCount;
 
 		if(a.m_v.dot(ctx.m_dir) < 0.0)
 		{
@@ -259,6 +323,574 @@ Bool gjkIntersection(const void* shape0, GjkSupportCallback shape0Callback, cons
 		}
 	}
 
+	// Out of iterations. It happens when the simplex cycles around an origin that is very close to the surface of the
+	// Minkowski difference. Let the distance query decide instead of guessing
+	Vec4 normal;
+	if(gjkDistance(ctx.m_shape0, ctx.m_shape0Callback, ctx.m_shape1, ctx.m_shape1Callback, normal) > 0.0f)
+	{
+		ctx.m_dir = normal;
+		return false;
+	}
+
+	return true;
+}
+
+static void updateCache(const GjkContext& ctx, Bool intersect, GjkCache& cache)
+{
+	cache.m_iterationCount = ctx.m_iterationCount;
+
+	if(!intersect)
+	{
+		cache.m_dir = ctx.m_dir;
+		cache.m_simplexCount = 0;
+	}
+	else if(ctx.m_count == 4)
+	{
+		for(U32 i = 0; i < 4; ++i)
+		{
+			cache.m_simplexDirs[i] = ctx.m_simplex[i].m_dir;
+		}
+		cache.m_simplexCount = 4;
+	}
+	else
+	{
+		cache.m_simplexCount = 0;
+	}
+}
+
+Bool gjkIntersection(const void* shape0, GjkSupportCallback shape0Callback, const void* shape1,
+					 GjkSupportCallback shape1Callback, GjkCache* cache)
+{
+	ANKI_ASSERT(shape0 && shape0Callback && shape1 && shape1Callback);
+
+	GjkContext ctx;
+	ctx.m_shape0 = shape0;
+	ctx.m_shape1 = shape1;
+	ctx.m_shape0Callback = shape0Callback;
+	ctx.m_shape1Callback = shape1Callback;
+
+	const Bool intersect = gjk(ctx, cache);
+
+	if(cache)
+	{
+		updateCache(ctx, intersect, *cache);
+	}
+
+	return intersect;
+}
+
+/// EPA polytope face.
+class EpaFace
+{
+public:
+	Vec4 m_normal;
+	F32 m_dist;
+	Array<U8, 3> m_idx;
+};
+
+/// EPA polytope.
+class EpaContext
+{
+public:
+	static constexpr U32 MAX_VERTICES = 128;
+	static constexpr U32 MAX_FACES = 2 * MAX_VERTICES;
+	static constexpr U32 MAX_EDGES = 2 * MAX_VERTICES;
+	static constexpr U32 MAX_ITERATIONS = MAX_VERTICES - 4;
+	static constexpr F32 TOLERANCE = 1.0e-4f;
+
+	Array<GjkSupport, MAX_VERTICES> m_verts;
+	Array<EpaFace, MAX_FACES> m_faces;
+	Array<Array<U8, 2>, MAX_EDGES> m_edges;
+	Vec4 m_interior; ///< A point inside the polytope. Used to orient the faces.
+	U32 m_vertCount = 0;
+	U32 m_faceCount = 0;
+	U32 m_edgeCount = 0;
+};
+
+/// Return true if the triangle is too thin to have a reliable normal.
+static Bool isDegenerateFace(const EpaContext& ctx, U8 a, U8 b, U8 c)
+{
+	const Vec4& va = ctx.m_verts[a].m_v;
+	return (ctx.m_verts[b].m_v - va).cross(ctx.m_verts[c].m_v - va).getLengthSquared() < EPSILON * EPSILON;
+}
+
+/// Add a face that points away from the interior of the polytope. The face shouldn't be degenerate.
+static Bool addFace(EpaContext& ctx, U8 a, U8 b, U8 c)
+{
+	ANKI_ASSERT(!isDegenerateFace(ctx, a, b, c));
+	if(ctx.m_faceCount == EpaContext::MAX_FACES)
+	{
+		return false;
+	}
+
+	const Vec4& va = ctx.m_verts[a].m_v;
+	Vec4 n = (ctx.m_verts[b].m_v - va).cross(ctx.m_verts[c].m_v - va);
+	n /= n.getLength();
+
+	EpaFace& face = ctx.m_faces[ctx.m_faceCount++];
+	if(n.dot(va - ctx.m_interior) < 0.0f)
+	{
+		n = -n;
+		face.m_idx = {{a, c, b}};
+	}
+	else
+	{
+		face.m_idx = {{a, b, c}};
+	}
+
+	face.m_normal = n;
+	face.m_dist = n.dot(va);
+	return true;
+}
+
+/// Add an edge of a removed face. If the opposite edge was already added then both are internal and get dropped.
+static Bool addEdge(EpaContext& ctx, U8 a, U8 b)
+{
+	for(U32 i = 0; i < ctx.m_edgeCount; ++i)
+	{
+		if(ctx.m_edges[i][0] == b && ctx.m_edges[i][1] == a)
+		{
+			ctx.m_edges[i] = ctx.m_edges[--ctx.m_edgeCount];
+			return true;
+		}
+	}
+
+	if(ctx.m_edgeCount == EpaContext::MAX_EDGES)
+	{
+		return false;
+	}
+
+	ctx.m_edges[ctx.m_edgeCount++] = {{a, b}};
+	return true;
+}
+
+static U32 findClosestFace(const EpaContext& ctx)
+{
+	ANKI_ASSERT(ctx.m_faceCount > 0);
+	U32 closest = 0;
+	for(U32 i = 1; i < ctx.m_faceCount; ++i)
+	{
+		if(ctx.m_faces[i].m_dist < ctx.m_faces[closest].m_dist)
+		{
+			closest = i;
+		}
+	}
+
+	return closest;
+}
+
+/// Compute the barycentric coordinates of p in the triangle abc.
+static Vec3 computeBarycentric(const Vec4& p, const Vec4& a, const Vec4& b, const Vec4& c)
+{
+	const Vec4 v0 = b - a;
+	const Vec4 v1 = c - a;
+	const Vec4 v2 = p - a;
+	const F32 d00 = v0.dot(v0);
+	const F32 d01 = v0.dot(v1);
+	const F32 d11 = v1.dot(v1);
+	const F32 d20 = v2.dot(v0);
+	const F32 d21 = v2.dot(v1);
+	const F32 denom = d00 * d11 - d01 * d01;
+	if(absolute(denom) < EPSILON * EPSILON)
+	{
+		return Vec3(1.0f, 0.0f, 0.0f);
+	}
+
+	const F32 v = (d11 * d20 - d01 * d21) / denom;
+	const F32 w = (d00 * d21 - d01 * d20) / denom;
+	return Vec3(1.0f - v - w, v, w);
+}
+
+/// Expand the GJK tetrahedron until its closest face to the origin is on the surface of the Minkowski difference.
+/// @return False if the tetrahedron is too flat to start from.
+static Bool epa(GjkContext& gjkCtx, CollisionContact& contact)
+{
+	EpaContext ctx;
+	for(U32 i = 0; i < 4; ++i)
+	{
+		ctx.m_verts[i] = gjkCtx.m_simplex[i];
+	}
+	ctx.m_vertCount = 4;
+	ctx.m_interior = (ctx.m_verts[0].m_v + ctx.m_verts[1].m_v + ctx.m_verts[2].m_v + ctx.m_verts[3].m_v) / 4.0f;
+
+	const Vec4& v0 = ctx.m_verts[0].m_v;
+	const F32 volume = (ctx.m_verts[1].m_v - v0).cross(ctx.m_verts[2].m_v - v0).dot(ctx.m_verts[3].m_v - v0);
+	if(absolute(volume) < EPSILON || isDegenerateFace(ctx, 0, 1, 2) || isDegenerateFace(ctx, 0, 3, 1)
+	   || isDegenerateFace(ctx, 0, 2, 3) || isDegenerateFace(ctx, 1, 3, 2))
+	{
+		return false;
+	}
+
+	addFace(ctx, 0, 1, 2);
+	addFace(ctx, 0, 3, 1);
+	addFace(ctx, 0, 2, 3);
+	addFace(ctx, 1, 3, 2);
+
+	for(U32 iteration = 0; iteration < EpaContext::MAX_ITERATIONS && ctx.m_vertCount < EpaContext::MAX_VERTICES;
+		++iteration)
+	{
+		const EpaFace& closest = ctx.m_faces[findClosestFace(ctx)];
+
+		GjkSupport p;
+		gjkCtx.m_dir = closest.m_normal;
+		support(gjkCtx, p);
+
+		if(p.m_v.dot(closest.m_normal) - closest.m_dist < EpaContext::TOLERANCE)
+		{
+			// Can't expand any further
+			break;
+		}
+
+		const U8 newIdx = U8(ctx.m_vertCount);
+		ctx.m_verts[newIdx] = p;
+
+		// Gather the faces that are visible from the new point and their horizon edges. Faces that are almost coplanar
+		// with the point are not visible, that keeps the point away from the horizon edges
+		const F32 visibilityTolerance = EPSILON * max(1.0f, p.m_v.getLength());
+		Array<U16, EpaContext::MAX_FACES> visibleFaces;
+		U32 visibleFaceCount = 0;
+		Bool overflow = false;
+		ctx.m_edgeCount = 0;
+		for(U32 i = 0; i < ctx.m_faceCount; ++i)
+		{
+			const EpaFace& face = ctx.m_faces[i];
+			if(face.m_normal.dot(p.m_v - ctx.m_verts[face.m_idx[0]].m_v) > visibilityTolerance)
+			{
+				visibleFaces[visibleFaceCount++] = U16(i);
+
+				overflow = overflow || !addEdge(ctx, face.m_idx[0], face.m_idx[1]);
+				overflow = overflow || !addEdge(ctx, face.m_idx[1], face.m_idx[2]);
+				overflow = overflow || !addEdge(ctx, face.m_idx[2], face.m_idx[0]);
+			}
+		}
+
+		overflow = overflow || ctx.m_faceCount - visibleFaceCount + ctx.m_edgeCount > EpaContext::MAX_FACES;
+
+		// The new point needs to form a proper face with every horizon edge. If it doesn't it's practically on the
+		// surface of the polytope and expanding would leave a hole. Stop before touching the polytope
+		Bool degenerate = false;
+		for(U32 i = 0; i < ctx.m_edgeCount && !overflow && !degenerate; ++i)
+		{
+			degenerate = isDegenerateFace(ctx, ctx.m_edges[i][0], ctx.m_edges[i][1], newIdx);
+		}
+
+		if(overflow || degenerate)
+		{
+			break;
+		}
+
+		++ctx.m_vertCount;
+
+		// Remove the visible faces starting from the back so the faces that get moved in their place are not visible
+		for(U32 i = visibleFaceCount; i-- > 0;)
+		{
+			ctx.m_faces[visibleFaces[i]] = ctx.m_faces[--ctx.m_faceCount];
+		}
+
+		// Patch the hole
+		for(U32 i = 0; i < ctx.m_edgeCount; ++i)
+		{
+			addFace(ctx, ctx.m_edges[i][0], ctx.m_edges[i][1], newIdx);
+		}
+	}
+
+	// Project the origin to the closest face and use the barycentrics to find the points on the shapes
+	const EpaFace& face = ctx.m_faces[findClosestFace(ctx)];
+	const GjkSupport& a = ctx.m_verts[face.m_idx[0]];
+	const GjkSupport& b = ctx.m_verts[face.m_idx[1]];
+	const GjkSupport& c = ctx.m_verts[face.m_idx[2]];
+
+	const Vec3 bary = computeBarycentric(face.m_normal * face.m_dist, a.m_v, b.m_v, c.m_v);
+
+	contact.m_normal = face.m_normal;
+	contact.m_depth = max(0.0f, face.m_dist);
+	contact.m_point0 = a.m_v0 * bary.x() + b.m_v0 * bary.y() + c.m_v0 * bary.z();
+	contact.m_point1 = a.m_v1 * bary.x() + b.m_v1 * bary.y() + c.m_v1 * bary.z();
+	return true;
+}
+
+Bool gjkEpa(const void* shape0, GjkSupportCallback shape0Callback, const void* shape1,
+			GjkSupportCallback shape1Callback, CollisionContact& contact, GjkCache* cache)
+{
+	ANKI_ASSERT(shape0 && shape0Callback && shape1 && shape1Callback);
+
+	GjkContext ctx;
+	ctx.m_shape0 = shape0;
+	ctx.m_shape1 = shape1;
+	ctx.m_shape0Callback = shape0Callback;
+	ctx.m_shape1Callback = shape1Callback;
+
+	const Bool intersect = gjk(ctx, cache);
+
+	if(cache)
+	{
+		updateCache(ctx, intersect, *cache);
+	}
+
+	if(!intersect)
+	{
+		return false;
+	}
+
+	if(ctx.m_count < 4 || !epa(ctx, contact))
+	{
+		// GJK gave up before building a proper tetrahedron. The shapes are barely touching
+		contact.m_normal = (ctx.m_dir.getLengthSquared() > EPSILON * EPSILON) ? ctx.m_dir.getNormalized()
+																			   : Vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		contact.m_depth = 0.0f;
+		contact.m_point0 = ctx.m_shape0Callback(ctx.m_shape0, contact.m_normal);
+		contact.m_point1 = ctx.m_shape1Callback(ctx.m_shape1, -contact.m_normal);
+	}
+
+	if(cache)
+	{
+		cache->m_dir = contact.m_normal;
+	}
+
+	return true;
+}
+
+/// Find the point of a triangle that is closest to the origin and reduce the triangle to the feature that holds it.
+/// From Real-Time Collision Detection.
+static Vec4 closestToOriginTriangle(Array<Vec4, 4>& simplex, U32& count)
+{
+	const Vec4 a = simplex[0];
+	const Vec4 b = simplex[1];
+	const Vec4 c = simplex[2];
+	const Vec4 ab = b - a;
+	const Vec4 ac = c - a;
+
+	const F32 d1 = -ab.dot(a);
+	const F32 d2 = -ac.dot(a);
+	if(d1 <= 0.0f && d2 <= 0.0f)
+	{
+		count = 1;
+		return a;
+	}
+
+	const F32 d3 = -ab.dot(b);
+	const F32 d4 = -ac.dot(b);
+	if(d3 >= 0.0f && d4 <= d3)
+	{
+		simplex[0] = b;
+		count = 1;
+		return b;
+	}
+
+	const F32 vc = d1 * d4 - d3 * d2;
+	if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		count = 2;
+		return a + ab * (d1 / (d1 - d3));
+	}
+
+	const F32 d5 = -ab.dot(c);
+	const F32 d6 = -ac.dot(c);
+	if(d6 >= 0.0f && d5 <= d6)
+	{
+		simplex[0] = c;
+		count = 1;
+		return c;
+	}
+
+	const F32 vb = d5 * d2 - d1 * d6;
+	if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		simplex[1] = c;
+		count = 2;
+		return a + ac * (d2 / (d2 - d6));
+	}
+
+	const F32 va = d3 * d6 - d5 * d4;
+	if(va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		simplex[0] = c;
+		count = 2;
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	const F32 denom = 1.0f / (va + vb + vc);
+	count = 3;
+	return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+/// Find the point of a simplex that is closest to the origin and reduce the simplex to the feature that holds it.
+static Vec4 closestToOrigin(Array<Vec4, 4>& simplex, U32& count)
+{
+	switch(count)
+	{
+	case 1:
+		return simplex[0];
+	case 2:
+	{
+		const Vec4 ab = simplex[1] - simplex[0];
+		const F32 t = -simplex[0].dot(ab) / max(ab.dot(ab), EPSILON);
+		if(t <= 0.0f)
+		{
+			count = 1;
+			return simplex[0];
+		}
+		else if(t >= 1.0f)
+		{
+			simplex[0] = simplex[1];
+			count = 1;
+			return simplex[0];
+		}
+		return simplex[0] + ab * t;
+	}
+	case 3:
+		return closestToOriginTriangle(simplex, count);
+	default:
+	{
+		ANKI_ASSERT(count == 4);
+
+		// Check the faces that have the origin in front of them. If there is none the origin is inside
+		const Array<Array<U8, 4>, 4> faces = {{{{0, 1, 2, 3}}, {{0, 2, 3, 1}}, {{0, 3, 1, 2}}, {{1, 3, 2, 0}}}};
+		F32 minDistSq = MAX_F32;
+		Vec4 closest(0.0f);
+		Array<Vec4, 4> bestSimplex;
+		U32 bestCount = 4;
+		for(const Array<U8, 4>& face : faces)
+		{
+			const Vec4& a = simplex[face[0]];
+			const Vec4 n = (simplex[face[1]] - a).cross(simplex[face[2]] - a);
+			const F32 originSide = -a.dot(n);
+			const F32 oppositeSide = (simplex[face[3]] - a).dot(n);
+			if(originSide * oppositeSide > 0.0f)
+			{
+				continue;
+			}
+
+			Array<Vec4, 4> tri = {{a, simplex[face[1]], simplex[face[2]], Vec4(0.0f)}};
+			U32 triCount = 3;
+			const Vec4 p = closestToOriginTriangle(tri, triCount);
+			const F32 distSq = p.dot(p);
+			if(distSq < minDistSq)
+			{
+				minDistSq = distSq;
+				closest = p;
+				bestSimplex = tri;
+				bestCount = triCount;
+			}
+		}
+
+		if(bestCount < 4)
+		{
+			simplex = bestSimplex;
+			count = bestCount;
+		}
+
+		return closest;
+	}
+	}
+}
+
+F32 gjkDistance(const void* shape0, GjkSupportCallback shape0Callback, const void* shape1,
+				GjkSupportCallback shape1Callback, Vec4& normal)
+{
+	ANKI_ASSERT(shape0 && shape0Callback && shape1 && shape1Callback);
+
+	constexpr U32 MAX_ITERATIONS = 64;
+	constexpr F32 TOLERANCE = 1.0e-4f;
+	constexpr F32 ABSOLUTE_TOLERANCE = 1.0e-6f; // Below that the float precision of the supports takes over
+
+	auto support = [&](const Vec4& dir) { return shape0Callback(shape0, dir) - shape1Callback(shape1, -dir); };
+
+	Array<Vec4, 4> simplex;
+	simplex[0] = support(Vec4(1.0f, 0.0f, 0.0f, 0.0f));
+	U32 count = 1;
+	Vec4 v = simplex[0];
+
+	for(U32 iteration = 0; iteration < MAX_ITERATIONS; ++iteration)
+	{
+		const F32 vv = v.dot(v);
+		if(vv <= EPSILON * EPSILON)
+		{
+			// The origin is in the Minkowski difference
+			return 0.0f;
+		}
+
+		// Stop if the new support can't get closer to the origin
+		const Vec4 w = support(-v);
+		if(vv - v.dot(w) <= max(TOLERANCE * vv, ABSOLUTE_TOLERANCE))
+		{
+			break;
+		}
+
+		simplex[count++] = w;
+		const Vec4 newV = closestToOrigin(simplex, count);
+
+		if(count == 4)
+		{
+			// The origin is inside the tetrahedron
+			return 0.0f;
+		}
+
+		if(newV.dot(newV) >= vv)
+		{
+			// Numerical issues with an almost degenerate simplex. Keep the previous v that was closer
+			break;
+		}
+
+		v = newV;
+	}
+
+	const F32 dist = sqrt(v.dot(v));
+	normal = -v / dist;
+	return dist;
+}
+
+Bool gjkTimeOfImpact(const void* shape0, GjkSupportCallback shape0Callback, const Vec4& translation0,
+					 const void* shape1, GjkSupportCallback shape1Callback, F32 tolerance, F32& toi)
+{
+	ANKI_ASSERT(tolerance > 0.0f && translation0.w() == 0.0f);
+
+	constexpr U32 MAX_ITERATIONS = 32;
+
+	// Wrap the 1st shape to move it
+	class MovedShape
+	{
+	public:
+		const void* m_shape;
+		GjkSupportCallback m_callback;
+		Vec4 m_offset;
+	};
+
+	MovedShape moved = {shape0, shape0Callback, Vec4(0.0f)};
+	auto movedCallback = [](const void* shape, const Vec4& dir) {
+		const MovedShape& moved = *static_cast<const MovedShape*>(shape);
+		return moved.m_callback(moved.m_shape, dir) + moved.m_offset;
+	};
+
+	F32 t = 0.0f;
+	for(U32 iteration = 0; iteration < MAX_ITERATIONS; ++iteration)
+	{
+		moved.m_offset = translation0 * t;
+
+		Vec4 normal;
+		const F32 dist = gjkDistance(&moved, movedCallback, shape1, shape1Callback, normal);
+		if(dist <= tolerance)
+		{
+			toi = t;
+			return true;
+		}
+
+		// The 1st shape can't touch the 2nd before it crosses the separating plane so advance until the plane
+		const F32 closingSpeed = translation0.dot(normal);
+		if(closingSpeed <= EPSILON)
+		{
+			return false;
+		}
+
+		t += dist / closingSpeed;
+		if(t > 1.0f)
+		{
+			return false;
+		}
+	}
+
+	// Didn't converge but the shapes are very close
+	toi = t;
 	return true;
 }
 
@@ -17,8 +17,43 @@ namespace anki
 using GjkSupportCallback = Vec4 (*)(const void* shape, const Vec4& dir);
 
 /// Return true if the two convex shapes intersect.
+/// @param cache Optional cache to warm start the query. It will be updated.
 Bool gjkIntersection(const void* shape0, GjkSupportCallback shape0Callback, const void* shape1,
-					 GjkSupportCallback shape1Callback);
+					 GjkSupportCallback shape1Callback, GjkCache* cache = nullptr);
+
+/// Return true if the two convex shapes intersect and compute the penetration info using EPA.
+/// @param[out] contact The penetration info. Valid only if the function returned true.
+/// @param cache Optional cache to warm start the query. It will be updated.
+Bool gjkEpa(const void* shape0, GjkSupportCallback shape0Callback, const void* shape1,
+			GjkSupportCallback shape1Callback, CollisionContact& contact, GjkCache* cache = nullptr);
+
+/// Compute the distance of two convex shapes.
+/// @param[out] normal The direction from the 1st shape to the 2nd. Valid only if the distance is not zero.
+/// @return The distance or zero if they intersect.
+F32 gjkDistance(const void* shape0, GjkSupportCallback shape0Callback, const void* shape1,
+				GjkSupportCallback shape1Callback, Vec4& normal);
+
+/// Find the time of impact of a convex shape that moves towards a static one using conservative advancement.
+/// @param translation0 The 1st shape moves by that in the time interval [0, 1].
+/// @param tolerance When the distance gets below that the shapes are considered touching.
+/// @param[out] toi The time of impact. Valid only if the function returned true.
+/// @return True if the shapes collide in the time interval.
+Bool gjkTimeOfImpact(const void* shape0, GjkSupportCallback shape0Callback, const Vec4& translation0,
+					 const void* shape1, GjkSupportCallback shape1Callback, F32 tolerance, F32& toi);
+
+/// Get the GJK support callback of a shape that has a computeSupport().
+template<typename T>
+GjkSupportCallback getGjkSupportCallback()
+{
+	return [](const void* shape, const Vec4& dir) { return static_cast<const T*>(shape)->computeSupport(dir); };
+}
+
+/// Test collision of two convex shapes (Aabb, Sphere, Obb, ConvexHullShape or Cone) using GJK.
+template<typename T, typename Y>
+Bool testCollisionGjk(const T& a, const Y& b, GjkCache* cache = nullptr)
+{
+	return gjkIntersection(&a, getGjkSupportCallback<T>(), &b, getGjkSupportCallback<Y>(), cache);
+}
 /// @}
 
 } // end namespace anki
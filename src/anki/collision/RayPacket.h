@@ -0,0 +1,87 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/collision/Ray.h>
+#include <anki/collision/Aabb.h>
+
+namespace anki
+{
+
+/// @addtogroup collision
+/// @{
+
+/// A packet of 4 rays stored in SoA layout so a box can be tested against all of them with a few SIMD instructions.
+class RayPacket
+{
+public:
+	static constexpr U32 SIZE = 4;
+
+	Vec4 m_originsX = Vec4(0.0f);
+	Vec4 m_originsY = Vec4(0.0f);
+	Vec4 m_originsZ = Vec4(0.0f);
+	Vec4 m_invDirsX = Vec4(0.0f);
+	Vec4 m_invDirsY = Vec4(0.0f);
+	Vec4 m_invDirsZ = Vec4(0.0f);
+
+	/// The max distance of every ray. Boxes further than that are not hit. A negative value disables the ray.
+	Vec4 m_maxDistances = Vec4(-1.0f);
+
+	/// Set a ray of the packet.
+	void setRay(U32 lane, const Ray& ray, F32 maxDistance)
+	{
+		ANKI_ASSERT(lane < SIZE);
+		const Vec4& o = ray.getOrigin();
+		const Vec4& d = ray.getDirection();
+		m_originsX[lane] = o.x();
+		m_originsY[lane] = o.y();
+		m_originsZ[lane] = o.z();
+
+		// Don't use a safe reciprocal, the infinities make the slab test work for axis aligned rays
+		m_invDirsX[lane] = 1.0f / d.x();
+		m_invDirsY[lane] = 1.0f / d.y();
+		m_invDirsZ[lane] = 1.0f / d.z();
+
+		m_maxDistances[lane] = maxDistance;
+	}
+
+	/// Slab test of all rays against a box.
+	/// @param[out] distances The distance of the entry points. Valid only for the rays that hit the box.
+	/// @return A bitmask of the rays that hit the box. The bit N is set if the Nth ray hit it.
+	U32 testAabb(const Vec3& aabbMin, const Vec3& aabbMax, Vec4& distances) const
+	{
+		const Vec4 t0x = (Vec4(aabbMin.x()) - m_originsX) * m_invDirsX;
+		const Vec4 t1x = (Vec4(aabbMax.x()) - m_originsX) * m_invDirsX;
+		const Vec4 t0y = (Vec4(aabbMin.y()) - m_originsY) * m_invDirsY;
+		const Vec4 t1y = (Vec4(aabbMax.y()) - m_originsY) * m_invDirsY;
+		const Vec4 t0z = (Vec4(aabbMin.z()) - m_originsZ) * m_invDirsZ;
+		const Vec4 t1z = (Vec4(aabbMax.z()) - m_originsZ) * m_invDirsZ;
+
+		const Vec4 tNear = t0x.min(t1x).max(t0y.min(t1y)).max(t0z.min(t1z).max(Vec4(0.0f)));
+		const Vec4 tFar = t0x.max(t1x).min(t0y.max(t1y)).min(t0z.max(t1z).min(m_maxDistances));
+
+		distances = tNear;
+
+#if ANKI_SIMD_SSE
+		return U32(_mm_movemask_ps(_mm_cmple_ps(tNear.getSimd(), tFar.getSimd())));
+#else
+		U32 mask = 0;
+		for(U32 i = 0; i < SIZE; ++i)
+		{
+			mask |= U32(tNear[i] <= tFar[i]) << i;
+		}
+		return mask;
+#endif
+	}
+
+	U32 testAabb(const Aabb& aabb, Vec4& distances) const
+	{
+		return testAabb(aabb.getMin().xyz(), aabb.getMax().xyz(), distances);
+	}
+};
+/// @}
+
+} // end namespace anki
@@ -76,6 +76,8 @@ public:
 	BufferedValue<Second> m_sceneUpdateTime;
 	BufferedValue<Second> m_visTestsTime;
 	BufferedValue<Second> m_physicsTime;
+	BufferedValue<Second> m_physicsWaitTime;
+	BufferedValue<Second> m_userUpdateTime;
 	BufferedValue<Second> m_gpuTime;
 
 	PtrSize m_allocatedCpuMem = 0;
@@ -87,6 +89,7 @@ public:
 	U32 m_vkCmdbCount = 0;
 
 	PtrSize m_drawableCount = 0;
+	U64 m_drawnTriangleCount = 0;
 
 	static const U32 BUFFERED_FRAMES = 16;
 	U32 m_bufferedFrames = 0;
@@ -120,11 +123,13 @@ public:
 
 			ImGui::Text("CPU Time:");
 			labelTime(m_frameTime.get(flush), "Total frame");
+			labelTime(m_userUpdateTime.get(flush), "User update");
 			labelTime(m_renderTime.get(flush) - m_lightBinTime.get(flush), "Renderer");
 			labelTime(m_lightBinTime.get(false), "Light bin");
 			labelTime(m_sceneUpdateTime.get(flush), "Scene update");
 			labelTime(m_visTestsTime.get(flush), "Visibility");
 			labelTime(m_physicsTime.get(flush), "Physics");
+			labelTime(m_physicsWaitTime.get(flush), "Physics wait");
 
 			ImGui::Text("----");
 			ImGui::Text("GPU Time:");
@@ -145,6 +150,7 @@ public:
 			ImGui::Text("----");
 			ImGui::Text("Other:");
 			labelUint(m_drawableCount, "Drawbles");
+			labelUint(m_drawnTriangleCount, "Triangles");
 		}
 
 		ImGui::End();
@@ -560,8 +566,13 @@ Error App::mainLoop()
 			// Update
 			ANKI_CHECK(m_input->handleEvents());
 
+			// The physics may still step asynchronously. Sync before the user touches the physics objects
+			ANKI_CHECK(m_physics->waitUpdate());
+
 			// User update
+			Second userUpdateTime = HighRezTimer::getCurrentTime();
 			ANKI_CHECK(userMainLoop(quit, crntTime - prevUpdateTime));
+			userUpdateTime = HighRezTimer::getCurrentTime() - userUpdateTime;
 
 			ANKI_CHECK(m_scene->update(prevUpdateTime, crntTime));
 
@@ -614,6 +625,8 @@ Error App::mainLoop()
 				statsUi.m_sceneUpdateTime.set(m_scene->getStats().m_updateTime);
 				statsUi.m_visTestsTime.set(m_scene->getStats().m_visibilityTestsTime);
 				statsUi.m_physicsTime.set(m_scene->getStats().m_physicsUpdate);
+				statsUi.m_physicsWaitTime.set(m_scene->getStats().m_physicsWait);
+				statsUi.m_userUpdateTime.set(userUpdateTime);
 				statsUi.m_gpuTime.set(m_renderer->getStats().m_renderingGpuTime);
 				statsUi.m_allocatedCpuMem = m_memStats.m_allocatedMem.load();
 				statsUi.m_allocCount = m_memStats.m_allocCount.load();
@@ -625,6 +638,7 @@ Error App::mainLoop()
 				statsUi.m_vkCmdbCount = grStats.m_commandBufferCount;
 
 				statsUi.m_drawableCount = rqueue.countAllRenderables();
+				statsUi.m_drawnTriangleCount = m_renderer->getStats().m_drawnTriangleCount;
 			}
 
 #if ANKI_ENABLE_TRACE
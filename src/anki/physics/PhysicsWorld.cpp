@@ -8,6 +8,8 @@
 #include <anki/physics/PhysicsBody.h>
 #include <anki/physics/PhysicsTrigger.h>
 #include <anki/util/Rtti.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/Tracer.h>
 #include <BulletCollision/Gimpact/btGImpactCollisionAlgorithm.h>
 
 namespace anki
@@ -140,11 +142,27 @@ public:
 };
 
 PhysicsWorld::PhysicsWorld()
+	: m_updateThread("anki_physics")
 {
 }
 
 PhysicsWorld::~PhysicsWorld()
 {
+	if(m_updateThreadStarted)
+	{
+		Error err = waitUpdate();
+		(void)err;
+
+		{
+			LockGuard<Mutex> lock(m_updateMtx);
+			m_quitUpdateThread = true;
+			m_updateCondVar.notifyAll();
+		}
+
+		err = m_updateThread.join();
+		(void)err;
+	}
+
 #if ANKI_ENABLE_ASSERTS
 	for(PhysicsObjectType type = PhysicsObjectType::FIRST; type < PhysicsObjectType::COUNT; ++type)
 	{
@@ -194,24 +212,124 @@ Error PhysicsWorld::create(AllocAlignedCallback allocCb, void* allocCbData)
 
 Error PhysicsWorld::update(Second dt)
 {
+	ANKI_CHECK(step(dt));
+	processTriggerContacts();
+	return Error::NONE;
+}
+
+Error PhysicsWorld::step(Second dt)
+{
+	ANKI_TRACE_SCOPED_EVENT(PHYSICS_UPDATE);
+	const Second startTime = HighRezTimer::getCurrentTime();
+
 	// Update world
 	{
 		auto lock = lockBtWorld();
 		m_world->stepSimulation(F32(dt), 1, 1.0f / 60.0f);
 	}
 
-	// Process trigger contacts
+	// Reset the pool
+	m_tmpAlloc.getMemoryPool().reset();
+
+	m_lastUpdateDuration = HighRezTimer::getCurrentTime() - startTime;
+	return Error::NONE;
+}
+
+void PhysicsWorld::processTriggerContacts()
+{
+	LockGuard<Mutex> lock(m_objectListsMtx);
+
+	for(PhysicsObject& trigger : m_objectLists[PhysicsObjectType::TRIGGER])
+	{
+		static_cast<PhysicsTrigger&>(trigger).processContacts();
+	}
+}
+
+void PhysicsWorld::startUpdate(Second dt)
+{
+	if(!m_updateThreadStarted)
 	{
-		LockGuard<Mutex> lock(m_objectListsMtx);
+		m_updateThread.start(this, updateThreadCallback);
+		m_updateThreadStarted = true;
+	}
+
+	LockGuard<Mutex> lock(m_updateMtx);
+	ANKI_ASSERT(!m_asyncUpdatePending && "Forgot to wait for the previous update");
+	m_asyncUpdateDt = dt;
+	m_lastWaitDuration = 0.0;
+	m_asyncUpdatePending = true;
+	m_updateCondVar.notifyAll();
+}
+
+Error PhysicsWorld::waitUpdate()
+{
+	ANKI_TRACE_SCOPED_EVENT(PHYSICS_WAIT_UPDATE);
 
-		for(PhysicsObject& trigger : m_objectLists[PhysicsObjectType::TRIGGER])
+	Bool processContacts = false;
+	Error err = Error::NONE;
+	{
+		LockGuard<Mutex> lock(m_updateMtx);
+		if(m_asyncUpdatePending)
 		{
-			static_cast<PhysicsTrigger&>(trigger).processContacts();
+			const Second startTime = HighRezTimer::getCurrentTime();
+			while(m_asyncUpdatePending)
+			{
+				m_updateCondVar.wait(m_updateMtx);
+			}
+
+			m_lastWaitDuration += HighRezTimer::getCurrentTime() - startTime;
 		}
+
+		processContacts = m_asyncTriggerContactsPending;
+		m_asyncTriggerContactsPending = false;
+		err = m_asyncUpdateErr;
+		m_asyncUpdateErr = Error::NONE;
 	}
 
-	// Reset the pool
-	m_tmpAlloc.getMemoryPool().reset();
+	// The contact callbacks write to the users of the triggers so call them in the thread that syncs and not in the
+	// physics thread
+	if(processContacts)
+	{
+		processTriggerContacts();
+	}
+
+	return err;
+}
+
+Error PhysicsWorld::updateThreadCallback(ThreadCallbackInfo& info)
+{
+	PhysicsWorld& self = *static_cast<PhysicsWorld*>(info.m_userData);
+
+	while(true)
+	{
+		Second dt;
+
+		{
+			// Wait for something
+			LockGuard<Mutex> lock(self.m_updateMtx);
+			while(!self.m_asyncUpdatePending && !self.m_quitUpdateThread)
+			{
+				self.m_updateCondVar.wait(self.m_updateMtx);
+			}
+
+			if(self.m_quitUpdateThread)
+			{
+				break;
+			}
+
+			dt = self.m_asyncUpdateDt;
+		}
+
+		const Error err = self.step(dt);
+
+		{
+			LockGuard<Mutex> lock(self.m_updateMtx);
+			self.m_asyncUpdateErr = err;
+			self.m_asyncTriggerContactsPending = !err;
+			self.m_asyncUpdatePending = false;
+			self.m_updateCondVar.notifyAll();
+		}
+	}
 
 	return Error::NONE;
 }
@@ -10,6 +10,7 @@
 #include <anki/util/List.h>
 #include <anki/util/WeakArray.h>
 #include <anki/util/ClassWrapper.h>
+#include <anki/util/Thread.h>
 
 namespace anki
 {
@@ -61,6 +62,26 @@ public:
 	/// Do the update.
 	Error update(Second dt);
 
+	/// Start the update in the physics thread and return immediately. The physics objects can't be touched until
+	/// waitUpdate() returns.
+	void startUpdate(Second dt);
+
+	/// The sync point of startUpdate(). It does nothing if there is no update in flight. The contact callbacks of the
+	/// triggers are called from here and not from the physics thread.
+	ANKI_USE_RESULT Error waitUpdate();
+
+	/// How long the last update took, in any thread.
+	Second getLastUpdateDuration() const
+	{
+		return m_lastUpdateDuration;
+	}
+
+	/// How long waitUpdate() blocked for the last asynchronous update.
+	Second getLastWaitDuration() const
+	{
+		return m_lastWaitDuration;
+	}
+
 	HeapAllocator<U8> getAllocator() const
 	{
 		return m_alloc;
@@ -121,6 +142,29 @@ private:
 
 	Array<IntrusiveList<PhysicsObject>, U(PhysicsObjectType::COUNT)> m_objectLists;
 	mutable Mutex m_objectListsMtx;
+
+	Second m_lastUpdateDuration = 0.0;
+
+	/// @name Asynchronous update
+	/// @{
+	Thread m_updateThread;
+	Mutex m_updateMtx;
+	ConditionVariable m_updateCondVar;
+	Second m_asyncUpdateDt = 0.0;
+	Second m_lastWaitDuration = 0.0;
+	Error m_asyncUpdateErr = Error::NONE;
+	Bool m_updateThreadStarted = false;
+	Bool m_asyncUpdatePending = false;
+	Bool m_asyncTriggerContactsPending = false;
+	Bool m_quitUpdateThread = false;
+	/// @}
+
+	/// Step the simulation without processing the trigger contacts.
+	ANKI_USE_RESULT Error step(Second dt);
+
+	void processTriggerContacts();
+
+	static Error updateThreadCallback(ThreadCallbackInfo& info);
 };
 /// @}
 
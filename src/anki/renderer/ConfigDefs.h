@@ -3,8 +3,6 @@
 // Code licensed under the BSD License.
 // http://www.anki3d.org/LICENSE
 
-ANKI_CONFIG_OPTION(r_lodDistance0, 20.0, 1.0, MAX_F64, "Distance that will be used to calculate the LOD 0")
-ANKI_CONFIG_OPTION(r_lodDistance1, 40.0, 2.0, MAX_F64, "Distance that will be used to calculate the LOD 1")
 ANKI_CONFIG_OPTION(r_clusterSizeX, 32, 1, 256)
 ANKI_CONFIG_OPTION(r_clusterSizeY, 26, 1, 256)
 ANKI_CONFIG_OPTION(r_clusterSizeZ, 32, 1, 256)
@@ -12,9 +12,12 @@ namespace anki
 
 DepthDownscale::~DepthDownscale()
 {
-	if(m_copyToBuff.m_buffAddr)
+	for(U32 i = 0; i < CLIENT_BUFFER_COUNT; ++i)
 	{
-		m_copyToBuff.m_buff->unmap();
+		if(m_copyToBuff.m_buffAddrs[i])
+		{
+			m_copyToBuff.m_buffs[i]->unmap();
+		}
 	}
 }
 
@@ -54,19 +57,23 @@ Error DepthDownscale::initInternal(const ConfigSet&)
 		m_copyToBuff.m_lastMipWidth = lastMipWidth;
 		m_copyToBuff.m_lastMipHeight = lastMipHeight;
 
-		// Create buffer
+		// Create buffers
 		BufferInitInfo buffInit("HiZ Client");
 		buffInit.m_mapAccess = BufferMapAccessBit::READ;
 		buffInit.m_size = lastMipHeight * lastMipWidth * sizeof(F32);
 		buffInit.m_usage = BufferUsageBit::STORAGE_COMPUTE_WRITE;
-		m_copyToBuff.m_buff = getGrManager().newBuffer(buffInit);
+		for(U32 i = 0; i < CLIENT_BUFFER_COUNT; ++i)
+		{
+			m_copyToBuff.m_buffs[i] = getGrManager().newBuffer(buffInit);
+			m_copyToBuff.m_buffAddrs[i] = m_copyToBuff.m_buffs[i]->map(0, buffInit.m_size, BufferMapAccessBit::READ);
 
-		m_copyToBuff.m_buffAddr = m_copyToBuff.m_buff->map(0, buffInit.m_size, BufferMapAccessBit::READ);
+			// Fill the buffer with 1.0f
+			for(U32 j = 0; j < lastMipHeight * lastMipWidth; ++j)
+			{
+				static_cast<F32*>(m_copyToBuff.m_buffAddrs[i])[j] = 1.0f;
+			}
 
-		// Fill the buffer with 1.0f
-		for(U32 i = 0; i < lastMipHeight * lastMipWidth; ++i)
-		{
-			static_cast<F32*>(m_copyToBuff.m_buffAddr)[i] = 1.0f;
+			m_copyToBuff.m_viewProjMats[i] = Mat4::getIdentity();
 		}
 	}
 
@@ -107,6 +114,10 @@ void DepthDownscale::populateRenderGraph(RenderingContext& ctx)
 	RenderGraphDescription& rgraph = ctx.m_renderGraphDescr;
 	m_runCtx.m_mip = 0;
 
+	// This frame writes the next client buffer. Remember the matrix the depth is rendered with
+	m_copyToBuff.m_crntBuffIdx = m_r->getFrameCount() % CLIENT_BUFFER_COUNT;
+	m_copyToBuff.m_viewProjMats[m_copyToBuff.m_crntBuffIdx] = ctx.m_matrices.m_viewProjectionJitter;
+
 	static const Array<CString, 5> passNames = {"HiZ #0", "HiZ #1", "HiZ #2", "HiZ #3", "HiZ #4"};
 
 	// Every pass can do MIPS_WRITTEN_PER_PASS mips
@@ -205,7 +216,8 @@ void DepthDownscale::run(RenderPassWorkContext& rgraphCtx)
 	rgraphCtx.bindImage(0, 3, m_runCtx.m_hizRt, subresource);
 
 	// Client buffer
-	cmdb->bindStorageBuffer(0, 4, m_copyToBuff.m_buff, 0, m_copyToBuff.m_buff->getSize());
+	const BufferPtr& clientBuff = m_copyToBuff.m_buffs[m_copyToBuff.m_crntBuffIdx];
+	cmdb->bindStorageBuffer(0, 4, clientBuff, 0, clientBuff->getSize());
 
 	// Done
 	dispatchPPCompute(cmdb, 8, 8, level0Width, level0Height);
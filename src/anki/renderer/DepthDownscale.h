@@ -45,17 +45,26 @@ public:
 		return m_mipCount;
 	}
 
-	void getClientDepthMapInfo(F32*& depthValues, U32& width, U32& height) const
+	/// Get the last mip of an older frame that the GPU is done with.
+	/// @param[out] viewProjMat The view projection matrix the depth values were rendered with.
+	void getClientDepthMapInfo(F32*& depthValues, U32& width, U32& height, Mat4& viewProjMat) const
 	{
+		// The oldest buffer of the ring. The frames that write to the others may still be in flight
+		const U32 idx = (m_copyToBuff.m_crntBuffIdx + 1) % CLIENT_BUFFER_COUNT;
 		width = m_copyToBuff.m_lastMipWidth;
 		height = m_copyToBuff.m_lastMipHeight;
-		ANKI_ASSERT(m_copyToBuff.m_buffAddr);
-		depthValues = static_cast<F32*>(m_copyToBuff.m_buffAddr);
+		ANKI_ASSERT(m_copyToBuff.m_buffAddrs[idx]);
+		depthValues = static_cast<F32*>(m_copyToBuff.m_buffAddrs[idx]);
+		viewProjMat = m_copyToBuff.m_viewProjMats[idx];
 	}
 
 private:
 	static const U32 MIPS_WRITTEN_PER_PASS = 2;
 
+	/// Every frame writes the last mip to a different buffer. One more than the frames in flight so the CPU can read
+	/// one that isn't written.
+	static const U32 CLIENT_BUFFER_COUNT = MAX_FRAMES_IN_FLIGHT + 1;
+
 	TexturePtr m_hizTex;
 	Bool m_hizTexImportedOnce = false;
 	ShaderProgramResourcePtr m_prog;
@@ -72,8 +81,10 @@ private:
 	class
 	{
 	public:
-		BufferPtr m_buff;
-		void* m_buffAddr = nullptr;
+		Array<BufferPtr, CLIENT_BUFFER_COUNT> m_buffs;
+		Array<void*, CLIENT_BUFFER_COUNT> m_buffAddrs = {};
+		Array<Mat4, CLIENT_BUFFER_COUNT> m_viewProjMats; ///< The matrix the depth of every buffer was rendered with.
+		U32 m_crntBuffIdx = 0; ///< The buffer this frame writes to.
 		U32 m_lastMipWidth = MAX_U32, m_lastMipHeight = MAX_U32;
 	} m_copyToBuff; ///< Copy to buffer members.
 
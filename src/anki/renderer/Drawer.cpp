@@ -68,6 +68,9 @@ void RenderableDrawer::drawRange(Pass pass, const Mat4& viewMat, const Mat4& vie
 
 	// Flush the last drawcall
 	flushDrawcall(ctx);
+
+	ANKI_TRACE_INC_COUNTER(R_TRIANGLES, ctx.m_queueCtx.m_drawnTriangleCount);
+	m_drawnTriangleCount.fetchAdd(ctx.m_queueCtx.m_drawnTriangleCount);
 }
 
 void RenderableDrawer::flushDrawcall(DrawContext& ctx)
@@ -95,8 +98,8 @@ void RenderableDrawer::drawSingle(DrawContext& ctx)
 
 	const RenderableQueueElement& rqel = *ctx.m_renderableElement;
 
-	U32 lod = min(m_r->calculateLod(rqel.m_distanceFromCamera), MAX_LOD_COUNT - 1);
-	lod = max(lod, ctx.m_minLod);
+	ANKI_ASSERT(rqel.m_lod < MAX_LOD_COUNT);
+	const U32 lod = max<U32>(rqel.m_lod, ctx.m_minLod);
 
 	const Bool shouldFlush =
 		ctx.m_cachedRenderElementCount > 0
@@ -8,6 +8,7 @@
 #include <anki/renderer/Common.h>
 #include <anki/resource/RenderingKey.h>
 #include <anki/Gr.h>
+#include <anki/util/Atomic.h>
 
 namespace anki
 {
@@ -36,8 +37,16 @@ public:
 				   CommandBufferPtr cmdb, SamplerPtr sampler, const RenderableQueueElement* begin,
 				   const RenderableQueueElement* end, U32 minLod = 0);
 
+	/// Get the number of triangles drawn since the last call.
+	/// @note It's thread-safe.
+	U64 resetDrawnTriangleCount()
+	{
+		return m_drawnTriangleCount.exchange(0);
+	}
+
 private:
 	Renderer* m_r;
+	Atomic<U64> m_drawnTriangleCount = {0};
 
 	void flushDrawcall(DrawContext& ctx);
 
@@ -45,6 +45,9 @@ public:
 	StackAllocator<U8> m_frameAllocator;
 	Bool m_debugDraw; ///< If true the drawcall should be drawing some kind of debug mesh.
 	BitSet<U(RenderQueueDebugDrawFlag::COUNT), U32> m_debugDrawFlags = {false};
+	/// The callbacks add the triangles they draw. It's used for statistics. Only the triangle draws of the models and
+	/// the CPU particles are counted, the lines (like the GPU particles) and the debug draws are not.
+	U64 m_drawnTriangleCount = 0;
 };
 
 /// Draw callback for drawing.
@@ -63,6 +66,8 @@ public:
 
 	F32 m_distanceFromCamera; ///< Don't set this
 
+	U8 m_lod; ///< Don't set this. The visibility tests choose it from the size of the renderable on the screen.
+
 	RenderableQueueElement()
 	{
 	}
@@ -345,7 +350,9 @@ static_assert(std::is_trivially_destructible<FogDensityQueueElement>::value == t
 			  "Should be trivially destructible");
 
 /// A callback to fill a coverage buffer.
-using FillCoverageBufferCallback = void (*)(void* userData, F32* depthValues, U32 width, U32 height);
+/// @param viewProjMat The view projection matrix the depth values were rendered with.
+using FillCoverageBufferCallback = void (*)(void* userData, F32* depthValues, U32 width, U32 height,
+											const Mat4& viewProjMat);
 
 /// The render queue. This is what the renderer is fed to render.
 class RenderQueue : public RenderingMatrices
@@ -82,9 +82,6 @@ Error Renderer::initInternal(const ConfigSet& config)
 	m_height = config.getNumberU32("height");
 	ANKI_R_LOGI("Initializing offscreen renderer. Size %ux%u", m_width, m_height);
 
-	ANKI_ASSERT(m_lodDistances.getSize() == 2);
-	m_lodDistances[0] = config.getNumberF32("r_lodDistance0");
-	m_lodDistances[1] = config.getNumberF32("r_lodDistance1");
 	m_frameCount = 0;
 
 	m_clusterCount[0] = config.getNumberU32("r_clusterSizeX");
@@ -344,15 +341,19 @@ void Renderer::finalize(const RenderingContext& ctx)
 
 	m_prevMatrices = ctx.m_matrices;
 
+	// All the drawing is done at this point
+	m_stats.m_drawnTriangleCount = m_sceneDrawer.resetDrawnTriangleCount();
+
 	// Inform about the HiZ map. Do it as late as possible
 	if(ctx.m_renderQueue->m_fillCoverageBufferCallback)
 	{
 		F32* depthValues;
 		U32 width;
 		U32 height;
-		m_depth->getClientDepthMapInfo(depthValues, width, height);
+		Mat4 viewProjMat;
+		m_depth->getClientDepthMapInfo(depthValues, width, height, viewProjMat);
 		ctx.m_renderQueue->m_fillCoverageBufferCallback(ctx.m_renderQueue->m_fillCoverageBufferCallbackUserData,
-														depthValues, width, height);
+														depthValues, width, height, viewProjMat);
 	}
 }
 
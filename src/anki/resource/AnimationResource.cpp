@@ -203,7 +203,8 @@ Error AnimationResource::load(const ResourceFilename& filename, Bool async)
 	return Error::NONE;
 }
 
-void AnimationResource::interpolate(U32 channelIndex, Second time, Vec3& pos, Quat& rot, F32& scale) const
+void AnimationResource::interpolate(U32 channelIndex, Second time, AnimationChannelCursor& cursor, Vec3& pos,
+									Quat& rot, F32& scale) const
 {
 	pos = Vec3(0.0f);
 	rot = Quat::getIdentity();
@@ -226,51 +227,30 @@ void AnimationResource::interpolate(U32 channelIndex, Second time, Vec3& pos, Qu
 	const AnimationChannel& channel = m_channels[channelIndex];
 
 	// Position
-	if(channel.m_positions.getSize() > 1)
+	if(findAnimationKeyframes<Vec3>(channel.m_positions, time, cursor.m_positionIdx))
 	{
-		for(U32 i = 0; i < channel.m_positions.getSize() - 1; ++i)
-		{
-			const AnimationKeyframe<Vec3>& left = channel.m_positions[i];
-			const AnimationKeyframe<Vec3>& right = channel.m_positions[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				pos = linearInterpolate(left.m_value, right.m_value, F32(u));
-				break;
-			}
-		}
+		const AnimationKeyframe<Vec3>& left = channel.m_positions[cursor.m_positionIdx];
+		const AnimationKeyframe<Vec3>& right = channel.m_positions[cursor.m_positionIdx + 1];
+		const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+		pos = linearInterpolate(left.m_value, right.m_value, F32(u));
 	}
 
 	// Rotation
-	if(channel.m_rotations.getSize() > 1)
+	if(findAnimationKeyframes<Quat>(channel.m_rotations, time, cursor.m_rotationIdx))
 	{
-		for(U32 i = 0; i < channel.m_rotations.getSize() - 1; ++i)
-		{
-			const AnimationKeyframe<Quat>& left = channel.m_rotations[i];
-			const AnimationKeyframe<Quat>& right = channel.m_rotations[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				rot = left.m_value.slerp(right.m_value, F32(u));
-				break;
-			}
-		}
+		const AnimationKeyframe<Quat>& left = channel.m_rotations[cursor.m_rotationIdx];
+		const AnimationKeyframe<Quat>& right = channel.m_rotations[cursor.m_rotationIdx + 1];
+		const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+		rot = left.m_value.slerp(right.m_value, F32(u));
 	}
 
 	// Scale
-	if(channel.m_scales.getSize() > 1)
+	if(findAnimationKeyframes<F32>(channel.m_scales, time, cursor.m_scaleIdx))
 	{
-		for(U32 i = 0; i < channel.m_scales.getSize() - 1; ++i)
-		{
-			const AnimationKeyframe<F32>& left = channel.m_scales[i];
-			const AnimationKeyframe<F32>& right = channel.m_scales[i + 1];
-			if(time >= left.m_time && time <= right.m_time)
-			{
-				const Second u = (time - left.m_time) / (right.m_time - left.m_time);
-				scale = linearInterpolate(left.m_value, right.m_value, F32(u));
-				break;
-			}
-		}
+		const AnimationKeyframe<F32>& left = channel.m_scales[cursor.m_scaleIdx];
+		const AnimationKeyframe<F32>& right = channel.m_scales[cursor.m_scaleIdx + 1];
+		const Second u = (time - left.m_time) / (right.m_time - left.m_time);
+		scale = linearInterpolate(left.m_value, right.m_value, F32(u));
 	}
 }
 
@@ -8,6 +8,8 @@
 #include <anki/resource/ResourceObject.h>
 #include <anki/Math.h>
 #include <anki/util/String.h>
+#include <anki/util/WeakArray.h>
+#include <algorithm>
 
 namespace anki
 {
@@ -25,6 +27,14 @@ class AnimationKeyframe
 	friend class AnimationResource;
 
 public:
+	AnimationKeyframe() = default;
+
+	AnimationKeyframe(Second time, const T& value)
+		: m_time(time)
+		, m_value(value)
+	{
+	}
+
 	Second getTime() const
 	{
 		return m_time;
@@ -63,6 +73,54 @@ public:
 	}
 };
 
+/// Find the pair of keyframes around a time.
+/// @param keyframes The keyframes sorted on time.
+/// @param time The time.
+/// @param[in,out] idx Where to look first. On return it's the index of the left keyframe of the pair.
+/// @return False if the time is outside the keyframes.
+template<typename T>
+Bool findAnimationKeyframes(ConstWeakArray<AnimationKeyframe<T>> keyframes, Second time, U32& idx)
+{
+	const U32 count = keyframes.getSize();
+	if(count < 2 || time < keyframes[0].getTime() || time > keyframes[count - 1].getTime())
+	{
+		return false;
+	}
+
+	// Try the pair of the last search and the one after it. That's where the time is when the animation plays forward
+	if(idx + 1 < count && keyframes[idx].getTime() <= time)
+	{
+		if(time <= keyframes[idx + 1].getTime())
+		{
+			return true;
+		}
+
+		if(idx + 2 < count && time <= keyframes[idx + 2].getTime())
+		{
+			++idx;
+			return true;
+		}
+	}
+
+	// Binary search for the first keyframe that is not before the time. The left one is the one before it
+	const AnimationKeyframe<T>* it =
+		std::lower_bound(keyframes.getBegin(), keyframes.getEnd(), time,
+						 [](const AnimationKeyframe<T>& key, Second time) { return key.getTime() < time; });
+	idx = U32(max<PtrSize>(PtrSize(it - keyframes.getBegin()), 1) - 1);
+	return true;
+}
+
+/// Remembers where the interpolation of a channel found its keyframes so the next one can start from there.
+class AnimationChannelCursor
+{
+	friend class AnimationResource;
+
+private:
+	U32 m_positionIdx = 0;
+	U32 m_rotationIdx = 0;
+	U32 m_scaleIdx = 0;
+};
+
 /// Animation consists of keyframe data.
 class AnimationResource : public ResourceObject
 {
@@ -92,7 +150,16 @@ public:
 	}
 
 	/// Get the interpolated data
-	void interpolate(U32 channelIndex, Second time, Vec3& position, Quat& rotation, F32& scale) const;
+	void interpolate(U32 channelIndex, Second time, Vec3& position, Quat& rotation, F32& scale) const
+	{
+		AnimationChannelCursor cursor;
+		interpolate(channelIndex, time, cursor, position, rotation, scale);
+	}
+
+	/// Get the interpolated data. The cursor makes it cheap when the time moves forward a little between calls, like
+	/// it does when the animation plays. Use a different cursor for every channel.
+	void interpolate(U32 channelIndex, Second time, AnimationChannelCursor& cursor, Vec3& position, Quat& rotation,
+					 F32& scale) const;
 
 private:
 	DynamicArray<AnimationChannel> m_channels;
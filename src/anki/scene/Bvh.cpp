@@ -0,0 +1,435 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/Bvh.h>
+#include <anki/collision/Functions.h>
+
+namespace anki
+{
+
+Bvh::~Bvh()
+{
+	ANKI_ASSERT(m_placeableCount == 0);
+	m_nodes.destroy(m_alloc);
+}
+
+void Bvh::init(F32 fatMargin)
+{
+	ANKI_ASSERT(fatMargin > 0.0f);
+	m_fatMargin = fatMargin;
+}
+
+U32 Bvh::newNode()
+{
+	if(m_freeNodesHead == MAX_U32)
+	{
+		// Grow the storage and chain the new nodes to the free list
+		const U32 oldSize = U32(m_nodes.getSize());
+		const U32 newSize = max(64u, oldSize * 2);
+		m_nodes.resize(m_alloc, newSize);
+
+		for(U32 i = oldSize; i < newSize; ++i)
+		{
+			m_nodes[i].m_parent = (i + 1 < newSize) ? i + 1 : MAX_U32;
+			m_nodes[i].m_height = -1;
+		}
+
+		m_freeNodesHead = oldSize;
+	}
+
+	const U32 idx = m_freeNodesHead;
+	Node& node = m_nodes[idx];
+	m_freeNodesHead = node.m_parent;
+
+	node.m_parent = MAX_U32;
+	node.m_children = {{MAX_U32, MAX_U32}};
+	node.m_placeable = nullptr;
+	node.m_height = 0;
+	return idx;
+}
+
+void Bvh::releaseNode(U32 idx)
+{
+	Node& node = m_nodes[idx];
+	ANKI_ASSERT(node.m_height >= 0);
+	node.m_parent = m_freeNodesHead;
+	node.m_height = -1;
+	m_freeNodesHead = idx;
+}
+
+void Bvh::place(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds)
+{
+	ANKI_ASSERT(placeable);
+
+	LockGuard<Mutex> lock(m_globalMtx);
+
+	U32 leaf = placeable->m_bvhLeaf;
+	if(leaf != MAX_U32)
+	{
+		const Node& node = m_nodes[leaf];
+		if(volume.getMin().xyz() >= node.m_aabbMin && volume.getMax().xyz() <= node.m_aabbMax)
+		{
+			// Still inside the fat box, nothing to do
+			ANKI_TRACE_INC_COUNTER(BVH_REFITS_AVOIDED, 1);
+		}
+		else
+		{
+			removeLeaf(leaf);
+			m_nodes[leaf].m_aabbMin = volume.getMin().xyz() - m_fatMargin;
+			m_nodes[leaf].m_aabbMax = volume.getMax().xyz() + m_fatMargin;
+			insertLeaf(leaf);
+		}
+	}
+	else
+	{
+		leaf = newNode();
+		Node& node = m_nodes[leaf];
+		node.m_placeable = placeable;
+		node.m_aabbMin = volume.getMin().xyz() - m_fatMargin;
+		node.m_aabbMax = volume.getMax().xyz() + m_fatMargin;
+		insertLeaf(leaf);
+
+		placeable->m_bvhLeaf = leaf;
+		++m_placeableCount;
+	}
+
+	// Update the actual scene bounds
+	if(updateActualSceneBounds)
+	{
+		m_actualSceneAabbMin = m_actualSceneAabbMin.min(volume.getMin().xyz());
+		m_actualSceneAabbMax = m_actualSceneAabbMax.max(volume.getMax().xyz());
+	}
+}
+
+void Bvh::remove(OctreePlaceable& placeable)
+{
+	LockGuard<Mutex> lock(m_globalMtx);
+
+	const U32 leaf = placeable.m_bvhLeaf;
+	if(leaf != MAX_U32)
+	{
+		ANKI_ASSERT(m_nodes[leaf].m_placeable == &placeable);
+		removeLeaf(leaf);
+		releaseNode(leaf);
+		placeable.m_bvhLeaf = MAX_U32;
+
+		ANKI_ASSERT(m_placeableCount > 0);
+		--m_placeableCount;
+	}
+}
+
+void Bvh::insertLeaf(U32 leaf)
+{
+	if(m_root == MAX_U32)
+	{
+		m_root = leaf;
+		m_nodes[leaf].m_parent = MAX_U32;
+		return;
+	}
+
+	const Vec3 leafMin = m_nodes[leaf].m_aabbMin;
+	const Vec3 leafMax = m_nodes[leaf].m_aabbMax;
+
+	// Find the best sibling by descending towards the child that increases the surface area the least
+	U32 idx = m_root;
+	while(!m_nodes[idx].isLeaf())
+	{
+		const Node& node = m_nodes[idx];
+
+		const F32 area = computeSurfaceArea(node.m_aabbMin, node.m_aabbMax);
+		const F32 combinedArea = computeSurfaceArea(node.m_aabbMin.min(leafMin), node.m_aabbMax.max(leafMax));
+
+		// Cost of creating a new parent for this node and the new leaf
+		const F32 cost = 2.0f * combinedArea;
+
+		// Minimum cost of pushing the leaf further down the tree
+		const F32 inheritanceCost = 2.0f * (combinedArea - area);
+
+		Array<F32, 2> childCosts;
+		for(U32 i = 0; i < 2; ++i)
+		{
+			const Node& child = m_nodes[node.m_children[i]];
+			const F32 newArea = computeSurfaceArea(child.m_aabbMin.min(leafMin), child.m_aabbMax.max(leafMax));
+			childCosts[i] = (child.isLeaf()) ? newArea + inheritanceCost
+											 : newArea - computeSurfaceArea(child.m_aabbMin, child.m_aabbMax)
+												   + inheritanceCost;
+		}
+
+		if(cost < childCosts[0] && cost < childCosts[1])
+		{
+			break;
+		}
+
+		idx = (childCosts[0] < childCosts[1]) ? node.m_children[0] : node.m_children[1];
+	}
+
+	const U32 sibling = idx;
+
+	// Create a new parent
+	const U32 newParent = newNode();
+	Node& parent = m_nodes[newParent];
+	Node& siblingNode = m_nodes[sibling];
+	const U32 oldParent = siblingNode.m_parent;
+
+	parent.m_parent = oldParent;
+	parent.m_aabbMin = siblingNode.m_aabbMin.min(leafMin);
+	parent.m_aabbMax = siblingNode.m_aabbMax.max(leafMax);
+	parent.m_height = siblingNode.m_height + 1;
+	parent.m_children = {{sibling, leaf}};
+
+	if(oldParent != MAX_U32)
+	{
+		Node& oldParentNode = m_nodes[oldParent];
+		if(oldParentNode.m_children[0] == sibling)
+		{
+			oldParentNode.m_children[0] = newParent;
+		}
+		else
+		{
+			oldParentNode.m_children[1] = newParent;
+		}
+	}
+	else
+	{
+		m_root = newParent;
+	}
+
+	siblingNode.m_parent = newParent;
+	m_nodes[leaf].m_parent = newParent;
+
+	refitAncestors(newParent);
+}
+
+void Bvh::removeLeaf(U32 leaf)
+{
+	if(leaf == m_root)
+	{
+		m_root = MAX_U32;
+		return;
+	}
+
+	const U32 parent = m_nodes[leaf].m_parent;
+	const U32 grandParent = m_nodes[parent].m_parent;
+	const U32 sibling =
+		(m_nodes[parent].m_children[0] == leaf) ? m_nodes[parent].m_children[1] : m_nodes[parent].m_children[0];
+
+	if(grandParent != MAX_U32)
+	{
+		// Connect the sibling to the grand parent and destroy the parent
+		Node& grandParentNode = m_nodes[grandParent];
+		if(grandParentNode.m_children[0] == parent)
+		{
+			grandParentNode.m_children[0] = sibling;
+		}
+		else
+		{
+			grandParentNode.m_children[1] = sibling;
+		}
+
+		m_nodes[sibling].m_parent = grandParent;
+		releaseNode(parent);
+
+		refitAncestors(grandParent);
+	}
+	else
+	{
+		m_root = sibling;
+		m_nodes[sibling].m_parent = MAX_U32;
+		releaseNode(parent);
+	}
+
+	m_nodes[leaf].m_parent = MAX_U32;
+}
+
+void Bvh::refit(U32 idx)
+{
+	Node& node = m_nodes[idx];
+	ANKI_ASSERT(!node.isLeaf());
+	const Node& child0 = m_nodes[node.m_children[0]];
+	const Node& child1 = m_nodes[node.m_children[1]];
+
+	node.m_aabbMin = child0.m_aabbMin.min(child1.m_aabbMin);
+	node.m_aabbMax = child0.m_aabbMax.max(child1.m_aabbMax);
+	node.m_height = 1 + max(child0.m_height, child1.m_height);
+}
+
+void Bvh::refitAncestors(U32 idx)
+{
+	while(idx != MAX_U32)
+	{
+		refit(idx);
+		rotate(idx);
+		idx = m_nodes[idx].m_parent;
+	}
+}
+
+void Bvh::rotate(U32 idx)
+{
+	// Try to swap B or C with one of the grandchildren. A is the node, B and C its children, D and E the children of B,
+	// F and G the children of C
+	const Node& a = m_nodes[idx];
+	ANKI_ASSERT(!a.isLeaf());
+	if(a.m_height < 2)
+	{
+		return;
+	}
+
+	const U32 b = a.m_children[0];
+	const U32 c = a.m_children[1];
+	const Node& bNode = m_nodes[b];
+	const Node& cNode = m_nodes[c];
+
+	enum class Rotation : U8
+	{
+		NONE,
+		B_F,
+		B_G,
+		C_D,
+		C_E
+	};
+
+	Rotation bestRotation = Rotation::NONE;
+	F32 bestCostDiff = 0.0f;
+
+	if(!cNode.isLeaf())
+	{
+		const F32 areaC = computeSurfaceArea(cNode.m_aabbMin, cNode.m_aabbMax);
+		const Node& f = m_nodes[cNode.m_children[0]];
+		const Node& g = m_nodes[cNode.m_children[1]];
+
+		// B<->F makes C = B + G
+		const F32 costBF = computeSurfaceArea(bNode.m_aabbMin.min(g.m_aabbMin), bNode.m_aabbMax.max(g.m_aabbMax));
+		if(costBF - areaC < bestCostDiff)
+		{
+			bestRotation = Rotation::B_F;
+			bestCostDiff = costBF - areaC;
+		}
+
+		// B<->G makes C = B + F
+		const F32 costBG = computeSurfaceArea(bNode.m_aabbMin.min(f.m_aabbMin), bNode.m_aabbMax.max(f.m_aabbMax));
+		if(costBG - areaC < bestCostDiff)
+		{
+			bestRotation = Rotation::B_G;
+			bestCostDiff = costBG - areaC;
+		}
+	}
+
+	if(!bNode.isLeaf())
+	{
+		const F32 areaB = computeSurfaceArea(bNode.m_aabbMin, bNode.m_aabbMax);
+		const Node& d = m_nodes[bNode.m_children[0]];
+		const Node& e = m_nodes[bNode.m_children[1]];
+
+		// C<->D makes B = C + E
+		const F32 costCD = computeSurfaceArea(cNode.m_aabbMin.min(e.m_aabbMin), cNode.m_aabbMax.max(e.m_aabbMax));
+		if(costCD - areaB < bestCostDiff)
+		{
+			bestRotation = Rotation::C_D;
+			bestCostDiff = costCD - areaB;
+		}
+
+		// C<->E makes B = C + D
+		const F32 costCE = computeSurfaceArea(cNode.m_aabbMin.min(d.m_aabbMin), cNode.m_aabbMax.max(d.m_aabbMax));
+		if(costCE - areaB < bestCostDiff)
+		{
+			bestRotation = Rotation::C_E;
+			bestCostDiff = costCE - areaB;
+		}
+	}
+
+	if(bestRotation == Rotation::NONE)
+	{
+		return;
+	}
+
+	// Swap the child of A (in A's slot aSlot) with the grandchild (in the slot gSlot of the other child of A)
+	U32 aSlot, otherChild, gSlot;
+	switch(bestRotation)
+	{
+	case Rotation::B_F:
+		aSlot = 0;
+		otherChild = c;
+		gSlot = 0;
+		break;
+	case Rotation::B_G:
+		aSlot = 0;
+		otherChild = c;
+		gSlot = 1;
+		break;
+	case Rotation::C_D:
+		aSlot = 1;
+		otherChild = b;
+		gSlot = 0;
+		break;
+	default:
+		ANKI_ASSERT(bestRotation == Rotation::C_E);
+		aSlot = 1;
+		otherChild = b;
+		gSlot = 1;
+	}
+
+	const U32 child = m_nodes[idx].m_children[aSlot];
+	const U32 grandChild = m_nodes[otherChild].m_children[gSlot];
+
+	m_nodes[idx].m_children[aSlot] = grandChild;
+	m_nodes[grandChild].m_parent = idx;
+	m_nodes[otherChild].m_children[gSlot] = child;
+	m_nodes[child].m_parent = otherChild;
+
+	refit(otherChild);
+	refit(idx);
+}
+
+void Bvh::gatherVisibleRecursive(const Plane frustumPlanes[6], OctreeNodeVisibilityTestCallback testCallback,
+								 void* testCallbackUserData, U32 idx, DynamicArrayAuto<void*>& out) const
+{
+	const Node& node = m_nodes[idx];
+	const Aabb aabb(node.m_aabbMin, node.m_aabbMax);
+
+	for(U i = 0; i < 6; ++i)
+	{
+		if(testPlane(frustumPlanes[i], aabb) < 0.0f)
+		{
+			return;
+		}
+	}
+
+	if(testCallback != nullptr && !testCallback(testCallbackUserData, aabb))
+	{
+		return;
+	}
+
+	if(node.isLeaf())
+	{
+		// Every placeable lives in a single leaf so there is no need to check if it's already visited
+		ANKI_ASSERT(node.m_placeable->m_userData);
+		out.emplaceBack(node.m_placeable->m_userData);
+	}
+	else
+	{
+		gatherVisibleRecursive(frustumPlanes, testCallback, testCallbackUserData, node.m_children[0], out);
+		gatherVisibleRecursive(frustumPlanes, testCallback, testCallbackUserData, node.m_children[1], out);
+	}
+}
+
+void Bvh::debugDraw(OctreeDebugDrawer& drawer) const
+{
+	if(m_root == MAX_U32)
+	{
+		return;
+	}
+
+	const F32 rootHeight = F32(max(1, m_nodes[m_root].m_height));
+	for(const Node& node : m_nodes)
+	{
+		if(node.m_height >= 0)
+		{
+			const F32 factor = F32(node.m_height) / rootHeight;
+			drawer.drawCube(Aabb(node.m_aabbMin, node.m_aabbMax), Vec4(factor, 1.0f - factor, 0.0f, 1.0f));
+		}
+	}
+}
+
+} // end namespace anki
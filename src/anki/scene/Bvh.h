@@ -0,0 +1,259 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Octree.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/WeakArray.h>
+
+namespace anki
+{
+
+/// @addtogroup scene
+/// @{
+
+/// Dynamic AABB tree for visibility tests. An alternative to the Octree that doesn't need the scene bounds and keeps
+/// every placeable in a single leaf. The leafs hold fattened boxes so small movements don't touch the tree. It has the
+/// same interface as the Octree.
+class Bvh : public NonCopyable
+{
+public:
+	Bvh(SceneAllocator<U8> alloc)
+		: m_alloc(alloc)
+	{
+	}
+
+	~Bvh();
+
+	/// @param fatMargin How much to enlarge the boxes of the placeables.
+	void init(F32 fatMargin);
+
+	/// Place or re-place an element in the tree.
+	/// @note It's thread-safe against place and remove methods.
+	void place(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds);
+
+	/// Remove an element from the tree.
+	/// @note It's thread-safe against place and remove methods.
+	void remove(OctreePlaceable& placeable);
+
+	/// Gather visible placeables.
+	/// @copydetails Octree::gatherVisible
+	void gatherVisible(const Plane frustumPlanes[6], U32 testId, OctreeNodeVisibilityTestCallback testCallback,
+					   void* testCallbackUserData, DynamicArrayAuto<void*>& out)
+	{
+		if(m_root != MAX_U32)
+		{
+			gatherVisibleRecursive(frustumPlanes, testCallback, testCallbackUserData, m_root, out);
+		}
+	}
+
+	/// Walk the tree.
+	/// @copydetails Octree::walkTree
+	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+	void walkTree(U32 testId, TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc)
+	{
+		if(m_root != MAX_U32)
+		{
+			walkTreeInternal(m_root, testFunc, newPlaceableFunc);
+		}
+	}
+
+	/// Find the closest placeable every ray hits. RayPacket::SIZE rays at a time descend the binary tree into the
+	/// nearer child first. Every leaf is the enlarged box of a single placeable so exactHitFunc is called only for
+	/// the placeables whose box a ray enters.
+	/// @param rays The rays to cast.
+	/// @param maxDistance How far the rays travel.
+	/// @param exactHitFunc A functor with signature F32(void* placeableUserData, const Ray& ray, F32 boxDistance). It
+	///                     returns the distance of the exact hit or a negative value if the ray misses the placeable.
+	///                     The boxDistance is where the ray enters the enlarged box of the placeable.
+	/// @param[out] hits One hit per ray.
+	/// @note It's not thread-safe against place and remove methods.
+	template<typename TExactHitFunc>
+	void rayCast(ConstWeakArray<Ray> rays, F32 maxDistance, TExactHitFunc exactHitFunc,
+				 WeakArray<OctreeRayHit> hits) const;
+
+	/// Same as the above but the (enlarged) boxes of the placeables are the hits.
+	void rayCast(ConstWeakArray<Ray> rays, F32 maxDistance, WeakArray<OctreeRayHit> hits) const
+	{
+		rayCast(rays, maxDistance, [](void*, const Ray&, F32 boxDistance) { return boxDistance; }, hits);
+	}
+
+	/// Debug draw.
+	void debugDraw(OctreeDebugDrawer& drawer) const;
+
+	/// Get the bounds of the scene as calculated by the objects that were placed inside the Bvh.
+	void getActualSceneBounds(Vec3& min, Vec3& max) const
+	{
+		LockGuard<Mutex> lock(m_globalMtx);
+		ANKI_ASSERT(m_actualSceneAabbMin.x() < MAX_F32);
+		ANKI_ASSERT(m_actualSceneAabbMax.x() > MIN_F32);
+		min = m_actualSceneAabbMin;
+		max = m_actualSceneAabbMax;
+	}
+
+private:
+	/// Tree node. Leafs have a placeable and no children.
+	class Node
+	{
+	public:
+		Vec3 m_aabbMin;
+		Vec3 m_aabbMax;
+		OctreePlaceable* m_placeable;
+		Array<U32, 2> m_children;
+		U32 m_parent; ///< The parent or the next free node if it's not used.
+		I32 m_height; ///< Zero for leafs and -1 for free nodes.
+
+		Bool isLeaf() const
+		{
+			return m_children[0] == MAX_U32;
+		}
+	};
+
+	SceneAllocator<U8> m_alloc;
+	F32 m_fatMargin = 0.0f;
+	mutable Mutex m_globalMtx;
+
+	DynamicArray<Node> m_nodes;
+	U32 m_freeNodesHead = MAX_U32;
+	U32 m_root = MAX_U32;
+	U32 m_placeableCount = 0;
+
+	/// Compute the min of the scene bounds based on what is placed inside the tree.
+	Vec3 m_actualSceneAabbMin = Vec3(MAX_F32);
+	Vec3 m_actualSceneAabbMax = Vec3(MIN_F32);
+
+	U32 newNode();
+	void releaseNode(U32 idx);
+
+	void insertLeaf(U32 leaf);
+	void removeLeaf(U32 leaf);
+
+	/// Walk from a node to the root, recompute the boxes and rotate the nodes if that reduces the surface area.
+	void refitAncestors(U32 idx);
+
+	/// Swap a child of the node with a grandchild if that minimizes the surface area (SAH).
+	void rotate(U32 idx);
+
+	void refit(U32 idx);
+
+	void gatherVisibleRecursive(const Plane frustumPlanes[6], OctreeNodeVisibilityTestCallback testCallback,
+								void* testCallbackUserData, U32 idx, DynamicArrayAuto<void*>& out) const;
+
+	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+	void walkTreeInternal(U32 idx, TTestAabbFunc& testFunc, TNewPlaceableFunc& newPlaceableFunc);
+
+	template<typename TExactHitFunc>
+	void rayCastInternal(U32 idx, RayPacket& packet, const Ray* rays, TExactHitFunc& exactHitFunc,
+						 OctreeRayHit* hits) const;
+
+	static F32 computeSurfaceArea(const Vec3& min, const Vec3& max)
+	{
+		const Vec3 d = max - min;
+		return 2.0f * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+	}
+};
+
+template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+inline void Bvh::walkTreeInternal(U32 idx, TTestAabbFunc& testFunc, TNewPlaceableFunc& newPlaceableFunc)
+{
+	const Node& node = m_nodes[idx];
+	if(!testFunc(Aabb(node.m_aabbMin, node.m_aabbMax)))
+	{
+		return;
+	}
+
+	if(node.isLeaf())
+	{
+		ANKI_ASSERT(node.m_placeable->m_userData);
+		newPlaceableFunc(node.m_placeable->m_userData);
+	}
+	else
+	{
+		ANKI_TRACE_INC_COUNTER(BVH_VISIBLE_NODES, 1);
+		walkTreeInternal(node.m_children[0], testFunc, newPlaceableFunc);
+		walkTreeInternal(node.m_children[1], testFunc, newPlaceableFunc);
+	}
+}
+
+template<typename TExactHitFunc>
+inline void Bvh::rayCast(ConstWeakArray<Ray> rays, F32 maxDistance, TExactHitFunc exactHitFunc,
+						 WeakArray<OctreeRayHit> hits) const
+{
+	ANKI_ASSERT(hits.getSize() >= rays.getSize());
+	ANKI_TRACE_INC_COUNTER(BVH_RAYS, rays.getSize());
+
+	for(U32 first = 0; first < rays.getSize(); first += RayPacket::SIZE)
+	{
+		const U32 count = min<U32>(RayPacket::SIZE, U32(rays.getSize() - first));
+
+		RayPacket packet;
+		for(U32 lane = 0; lane < count; ++lane)
+		{
+			packet.setRay(lane, rays[first + lane], maxDistance);
+			hits[first + lane] = OctreeRayHit();
+		}
+
+		if(m_root != MAX_U32)
+		{
+			rayCastInternal(m_root, packet, &rays[first], exactHitFunc, &hits[first]);
+		}
+	}
+}
+
+template<typename TExactHitFunc>
+inline void Bvh::rayCastInternal(U32 idx, RayPacket& packet, const Ray* rays, TExactHitFunc& exactHitFunc,
+								 OctreeRayHit* hits) const
+{
+	const Node& node = m_nodes[idx];
+
+	Vec4 distances;
+	const U32 mask = packet.testAabb(node.m_aabbMin, node.m_aabbMax, distances);
+	if(mask == 0)
+	{
+		return;
+	}
+
+	if(node.isLeaf())
+	{
+		ANKI_ASSERT(node.m_placeable->m_userData);
+		for(U32 lane = 0; lane < RayPacket::SIZE; ++lane)
+		{
+			if(!(mask & (1u << lane)))
+			{
+				continue;
+			}
+
+			const F32 dist = exactHitFunc(node.m_placeable->m_userData, rays[lane], distances[lane]);
+			if(dist >= 0.0f && dist < packet.m_maxDistances[lane])
+			{
+				// Closer hit, shorten the ray to cull the rest of the tree
+				packet.m_maxDistances[lane] = dist;
+				hits[lane].m_userData = node.m_placeable->m_userData;
+				hits[lane].m_distance = dist;
+			}
+		}
+	}
+	else
+	{
+		// Visit the child that is closer to the origin of the 1st active ray first to shorten the rays early
+		const Node& child0 = m_nodes[node.m_children[0]];
+		const Node& child1 = m_nodes[node.m_children[1]];
+		U32 lane = 0;
+		while(!(mask & (1u << lane)))
+		{
+			++lane;
+		}
+
+		const Vec3 centerDiff = (child1.m_aabbMin + child1.m_aabbMax) - (child0.m_aabbMin + child0.m_aabbMax);
+		const U32 first = (centerDiff.dot(rays[lane].getDirection().xyz()) < 0.0f) ? 1 : 0;
+
+		rayCastInternal(node.m_children[first], packet, rays, exactHitFunc, hits);
+		rayCastInternal(node.m_children[1 - first], packet, rays, exactHitFunc, hits);
+	}
+}
+/// @}
+
+} // end namespace anki
@@ -5,6 +5,21 @@
 
 ANKI_CONFIG_OPTION(scene_earlyZDistance, 10.0, 0.0, MAX_F64,
 				   "Objects with distance lower than that will be used in early Z")
+ANKI_CONFIG_OPTION(scene_lodScreenSize0, 0.15, 0.0, MAX_F64,
+				   "Objects smaller than that fraction of the screen height will use LOD 1 or more")
+ANKI_CONFIG_OPTION(scene_lodScreenSize1, 0.07, 0.0, MAX_F64,
+				   "Objects smaller than that fraction of the screen height will use LOD 2")
+ANKI_CONFIG_OPTION(scene_lodHysteresis, 0.1, 0.0, 0.9,
+				   "How far past a LOD threshold an object has to go to change LOD. A fraction of the threshold")
 ANKI_CONFIG_OPTION(scene_reflectionProbeEffectiveDistance, 256.0, 1.0, MAX_F64, "How far reflection probes can look")
 ANKI_CONFIG_OPTION(scene_reflectionProbeShadowEffectiveDistance, 32.0, 1.0, MAX_F64,
 				   "How far to render shadows for reflection probes")
+ANKI_CONFIG_OPTION(scene_asyncPhysics, 0, 0, 1,
+				   "Step the physics in another thread while the previous frame renders. It adds a frame of latency")
+ANKI_CONFIG_OPTION(scene_bvh, 0, 0, 1, "Use a dynamic AABB tree instead of an octree for visibility")
+ANKI_CONFIG_OPTION(scene_bvhFatMargin, 0.1, 0.001, MAX_F64,
+				   "How much the BVH enlarges the boxes so small movements don't update the tree")
+ANKI_CONFIG_OPTION(scene_octreeCompactTraversal, 0, 0, 1,
+				   "Walk a compact copy of the octree that gets rebuilt when the tree changes")
+ANKI_CONFIG_OPTION(scene_octreeLooseness, 1.0, 1.0, 4.0,
+				   "If it's more than 1.0 the octree is loose and its leafs are scaled by that factor")
@@ -19,6 +19,7 @@ class SpatialComponent;
 class DecalComponent;
 class ReflectionProxyComponent;
 class ReflectionProbeComponent;
+class OccluderComponent;
 
 // Nodes
 class SceneNode;
@@ -41,6 +41,8 @@ public:
 GpuParticleEmitterNode::GpuParticleEmitterNode(SceneGraph* scene, CString name)
 	: SceneNode(scene, name)
 {
+	// The particles are simulated every frame
+	setUpdateEveryFrame(true);
 }
 
 GpuParticleEmitterNode::~GpuParticleEmitterNode()
@@ -233,7 +235,7 @@ void GpuParticleEmitterNode::draw(RenderQueueDrawContext& ctx) const
 		*extraUniforms = ctx.m_cameraTransform.getColumn(2);
 		cmdb->bindUniformBuffer(0, 2, token.m_buffer, token.m_offset, token.m_range);
 
-		// Draw
+		// Draw. They are lines so they don't add to the m_drawnTriangleCount
 		cmdb->setLineWidth(8.0f);
 		cmdb->drawArrays(PrimitiveTopology::LINES, m_particleCount * 2);
 	}
@@ -237,6 +237,7 @@ void ModelNode::draw(RenderQueueDrawContext& ctx, ConstWeakArray<void*> userData
 		// Draw
 		cmdb->drawElements(PrimitiveTopology::TRIANGLES, modelInf.m_indicesCountArray[0], userData.getSize(),
 						   U32(modelInf.m_indicesOffsetArray[0] / sizeof(U16)), 0, 0);
+		ctx.m_drawnTriangleCount += U64(modelInf.m_indicesCountArray[0] / 3) * userData.getSize();
 	}
 	else
 	{
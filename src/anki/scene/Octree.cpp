@@ -53,23 +53,44 @@ class Octree::GatherParallelTaskCtx
 public:
 	GatherParallelCtx* m_ctx = nullptr;
 	Leaf* m_leaf = nullptr;
+	U32 m_compactLeaf = MAX_U32; ///< Used instead of m_leaf if the traversal is compact.
 };
 
+/// Test a leaf box against the frustum planes and the callback.
+static Bool testLeafVisible(const Plane frustumPlanes[6], OctreeNodeVisibilityTestCallback testCallback,
+							void* testCallbackUserData, const Aabb& aabb)
+{
+	for(U i = 0; i < 6; ++i)
+	{
+		if(testPlane(frustumPlanes[i], aabb) < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return testCallback == nullptr || testCallback(testCallbackUserData, aabb);
+}
+
 Octree::~Octree()
 {
-	ANKI_ASSERT(m_placeableCount == 0);
+	ANKI_ASSERT(m_placeableCount.load() == 0);
 	cleanupInternal();
-	ANKI_ASSERT(m_rootLeaf == nullptr);
+	ANKI_ASSERT(getRootLeaf() == nullptr);
+
+	m_compactLeafs.destroy(m_alloc);
+	m_compactPlaceables.destroy(m_alloc);
 }
 
-void Octree::init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth)
+void Octree::init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth, F32 looseness)
 {
 	ANKI_ASSERT(sceneAabbMin < sceneAabbMax);
 	ANKI_ASSERT(maxDepth > 0);
+	ANKI_ASSERT(looseness >= 1.0f);
 
 	m_maxDepth = maxDepth;
 	m_sceneAabbMin = sceneAabbMin;
 	m_sceneAabbMax = sceneAabbMax;
+	m_looseness = looseness;
 }
 
 void Octree::place(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds)
@@ -77,26 +98,56 @@ void Octree::place(const Aabb& volume, OctreePlaceable* placeable, Bool updateAc
 	ANKI_ASSERT(placeable);
 	ANKI_ASSERT(testCollision(volume, Aabb(m_sceneAabbMin, m_sceneAabbMax)) && "volume is outside the scene");
 
-	LockGuard<Mutex> lock(m_globalMtx);
+	{
+		RWLockGuard<RWMutex, true> lock(m_treeMtx);
 
-	// Remove the placeable from the Octree
-	removeInternal(*placeable);
+		// Small movements usually keep the placeable in the same leafs. Skip the re-placement if that's the case
+		if(leafsUnchanged(volume, *placeable))
+		{
+			ANKI_TRACE_INC_COUNTER(OCTREE_REPLACEMENTS_AVOIDED, 1);
+		}
+		else
+		{
+			// Count it before removing it so the tree doesn't get deleted in the meantime
+			m_placeableCount.fetchAdd(1);
 
-	// Create the root leaf
-	if(!m_rootLeaf)
-	{
-		m_rootLeaf = newLeaf();
-		m_rootLeaf->m_aabbMin = m_sceneAabbMin;
-		m_rootLeaf->m_aabbMax = m_sceneAabbMax;
-	}
+			// Remove the placeable from the Octree
+			if(removeInternal(*placeable))
+			{
+				m_placeableCount.fetchSub(1);
+			}
+
+			// Create the root leaf
+			Leaf* root = getRootLeaf();
+			if(!root)
+			{
+				Leaf* newRoot = newLeaf();
+				newRoot->m_aabbMin = m_sceneAabbMin;
+				newRoot->m_aabbMax = m_sceneAabbMax;
+				if(isLoose())
+				{
+					loosenBounds(newRoot->m_aabbMin, newRoot->m_aabbMax);
+				}
+				root = publishLeaf(m_rootLeaf, newRoot);
+			}
 
-	// And re-place it
-	placeRecursive(volume, placeable, m_rootLeaf, 0);
-	++m_placeableCount;
+			// And re-place it
+			if(isLoose())
+			{
+				binPlaceable(*findLooseLeaf(volume, root, true), *placeable);
+			}
+			else
+			{
+				placeRecursive(volume, placeable, root, 0);
+			}
+			markCompactTreeDirty();
+		}
+	}
 
 	// Update the actual scene bounds
 	if(updateActualSceneBounds)
 	{
+		LockGuard<SpinLock> lock(m_actualSceneAabbLock);
 		m_actualSceneAabbMin = m_actualSceneAabbMin.min(volume.getMin().xyz());
 		m_actualSceneAabbMax = m_actualSceneAabbMax.max(volume.getMax().xyz());
 	}
@@ -104,61 +155,271 @@ void Octree::place(const Aabb& volume, OctreePlaceable* placeable, Bool updateAc
 
 void Octree::remove(OctreePlaceable& placeable)
 {
-	LockGuard<Mutex> lock(m_globalMtx);
-	removeInternal(placeable);
+	Bool lastPlaceable = false;
+	{
+		RWLockGuard<RWMutex, true> lock(m_treeMtx);
+		if(removeInternal(placeable))
+		{
+			lastPlaceable = m_placeableCount.fetchSub(1) == 1;
+			markCompactTreeDirty();
+		}
+	}
+
+	if(lastPlaceable)
+	{
+		cleanupIfEmpty();
+	}
 }
 
-Bool Octree::volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf)
+void Octree::cleanupIfEmpty()
 {
-	const Vec4& amin = volume.getMin();
-	const Vec4& amax = volume.getMax();
-	const Vec3& bmin = leaf.m_aabbMin;
-	const Vec3& bmax = leaf.m_aabbMax;
+	RWLockGuard<RWMutex, false> lock(m_treeMtx);
 
-	Bool superset = true;
-	superset = superset && amin.x() <= bmin.x();
-	superset = superset && amax.x() >= bmax.x();
-	superset = superset && amin.y() <= bmin.y();
-	superset = superset && amax.y() >= bmax.y();
-	superset = superset && amin.z() <= bmin.z();
-	superset = superset && amax.z() >= bmax.z();
+	// Some placeable might have been placed after the lock was released
+	if(m_placeableCount.load() == 0)
+	{
+		cleanupInternal();
+		ANKI_ASSERT(getRootLeaf() == nullptr);
+		markCompactTreeDirty();
+	}
+}
 
-	return superset;
+void Octree::updateCompactTree()
+{
+	if(!m_compactTreeDirty.load(AtomicMemoryOrder::ACQUIRE))
+	{
+		return;
+	}
+
+	LockGuard<Mutex> lock(m_compactTreeMtx);
+
+	// Some other thread might have done it while this one was waiting for the lock
+	if(!m_compactTreeDirty.load(AtomicMemoryOrder::ACQUIRE))
+	{
+		return;
+	}
+
+	const Leaf* root = getRootLeaf();
+	U32 leafCount = 0;
+	U32 placeableCount = 0;
+	if(root)
+	{
+		countLeafsRecursive(*root, leafCount, placeableCount);
+	}
+
+	m_compactLeafs.resize(m_alloc, leafCount);
+	m_compactPlaceables.resize(m_alloc, placeableCount);
+
+	if(root)
+	{
+		leafCount = 0;
+		placeableCount = 0;
+		buildCompactTreeRecursive(*root, leafCount, placeableCount);
+		ANKI_ASSERT(leafCount == m_compactLeafs.getSize() && placeableCount == m_compactPlaceables.getSize());
+	}
+
+	m_compactTreeDirty.store(false, AtomicMemoryOrder::RELEASE);
 }
 
-void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf* parent, U32 depth)
+void Octree::countLeafsRecursive(const Leaf& leaf, U32& leafCount, U32& placeableCount) const
 {
-	ANKI_ASSERT(placeable);
-	ANKI_ASSERT(parent);
-	ANKI_ASSERT(testCollision(volume, Aabb(parent->m_aabbMin, parent->m_aabbMax)) && "Should be inside");
+	++leafCount;
+	placeableCount += U32(leaf.m_placeables.getSize());
 
-	if(depth == m_maxDepth || volumeTotallyInsideLeaf(volume, *parent))
+	for(U32 i = 0; i < 8; ++i)
 	{
-		// Need to stop and bin the placeable to the leaf
+		const Leaf* child = leaf.getChild(i);
+		if(child)
+		{
+			countLeafsRecursive(*child, leafCount, placeableCount);
+		}
+	}
+}
 
-		// Checks
-#if ANKI_ENABLE_ASSERTS
-		for(const LeafNode& node : placeable->m_leafs)
+void Octree::buildCompactTreeRecursive(const Leaf& leaf, U32& leafCount, U32& placeableCount)
+{
+	const U32 idx = leafCount++;
+	CompactLeaf& out = m_compactLeafs[idx];
+	out.m_aabbMin = leaf.m_aabbMin;
+	out.m_aabbMax = leaf.m_aabbMax;
+	out.m_firstPlaceable = placeableCount;
+	for(const PlaceableNode& node : leaf.m_placeables)
+	{
+		m_compactPlaceables[placeableCount++] = node.m_placeable;
+	}
+	out.m_placeableCount = placeableCount - out.m_firstPlaceable;
+
+	// Visit the children in Morton order. The last child is the one in the negative side of all axes so go backwards
+	for(U32 i = 8; i-- > 0;)
+	{
+		const Leaf* child = leaf.getChild(i);
+		if(child)
+		{
+			buildCompactTreeRecursive(*child, leafCount, placeableCount);
+		}
+	}
+
+	out.m_skipIndex = leafCount;
+}
+
+void Octree::gatherVisibleCompact(const Plane frustumPlanes[6], U32 testId,
+								  OctreeNodeVisibilityTestCallback testCallback, void* testCallbackUserData,
+								  DynamicArrayAuto<void*>& out)
+{
+	updateCompactTree();
+	if(m_compactLeafs.getSize() == 0)
+	{
+		// Empty tree
+		return;
+	}
+
+	walkCompactTree(0, m_compactLeafs[0].m_skipIndex, testId,
+					[&](const Aabb& aabb) {
+						return testLeafVisible(frustumPlanes, testCallback, testCallbackUserData, aabb);
+					},
+					[&](void* placeableUserData) { out.emplaceBack(placeableUserData); });
+}
+
+Octree::Leaf* Octree::getOrCreateChild(Leaf& parent, U32 childIdx, const Vec3& parentCenter)
+{
+	Leaf* child = parent.getChild(childIdx);
+	if(child)
+	{
+		return child;
+	}
+
+	Leaf* newChild = newLeaf();
+	if(isLoose())
+	{
+		// The stored bounds are the loose ones. Split the tight ones and loosen the result
+		const Vec3 tightHalfSize = (parent.m_aabbMax - parent.m_aabbMin) / (2.0f * m_looseness);
+		computeChildAabb(LeafMask(1u << childIdx), parentCenter - tightHalfSize, parentCenter + tightHalfSize,
+						 parentCenter, newChild->m_aabbMin, newChild->m_aabbMax);
+		loosenBounds(newChild->m_aabbMin, newChild->m_aabbMax);
+	}
+	else
+	{
+		computeChildAabb(LeafMask(1u << childIdx), parent.m_aabbMin, parent.m_aabbMax, parentCenter,
+						 newChild->m_aabbMin, newChild->m_aabbMax);
+	}
+
+	return publishLeaf(parent.m_children[childIdx], newChild);
+}
+
+void Octree::loosenBounds(Vec3& aabbMin, Vec3& aabbMax) const
+{
+	const Vec3 center = (aabbMin + aabbMax) / 2.0f;
+	const Vec3 looseHalfSize = (aabbMax - aabbMin) * (m_looseness / 2.0f);
+	aabbMin = center - looseHalfSize;
+	aabbMax = center + looseHalfSize;
+}
+
+Octree::Leaf* Octree::findLooseLeaf(const Aabb& volume, Leaf* root, Bool createLeafs)
+{
+	ANKI_ASSERT(isLoose() && root);
+
+	// Every leaf that contains the center of the volume contains the whole volume in its loose bounds if the volume
+	// is small enough. Find the depth of the smallest such leaf
+	const Vec3 volumeHalfSize = (volume.getMax() - volume.getMin()).xyz() / 2.0f;
+	const F32 maxVolumeHalfSize = max(volumeHalfSize.x(), max(volumeHalfSize.y(), volumeHalfSize.z()));
+	const Vec3 sceneHalfSize = (m_sceneAabbMax - m_sceneAabbMin) / 2.0f;
+	F32 leafHalfSize = min(sceneHalfSize.x(), min(sceneHalfSize.y(), sceneHalfSize.z()));
+	U32 depth = 0;
+	while(depth < m_maxDepth && maxVolumeHalfSize <= (m_looseness - 1.0f) * leafHalfSize / 2.0f)
+	{
+		++depth;
+		leafHalfSize /= 2.0f;
+	}
+
+	// Descend by the center. Stop earlier if the volume sticks out of a leaf. It happens for volumes close to the
+	// edges of the scene
+	const Vec3 volumeCenter = (volume.getMin() + volume.getMax()).xyz() / 2.0f;
+	Leaf* leaf = root;
+	for(U32 d = 0; d < depth; ++d)
+	{
+		const Vec3 center = (leaf->m_aabbMax + leaf->m_aabbMin) / 2.0f;
+		U32 childIdx = 0;
+		childIdx |= (volumeCenter.x() > center.x()) ? 0u : 4u;
+		childIdx |= (volumeCenter.y() > center.y()) ? 0u : 2u;
+		childIdx |= (volumeCenter.z() > center.z()) ? 0u : 1u;
+
+		Leaf* child = (createLeafs) ? getOrCreateChild(*leaf, childIdx, center) : leaf->getChild(childIdx);
+		if(!child)
 		{
-			ANKI_ASSERT(node.m_leaf != parent && "Already binned. That's wrong");
+			return nullptr;
 		}
 
-		for(const PlaceableNode& node : parent->m_placeables)
+		const Vec3 vMin = volume.getMin().xyz();
+		const Vec3 vMax = volume.getMax().xyz();
+		if(vMin.x() < child->m_aabbMin.x() || vMin.y() < child->m_aabbMin.y() || vMin.z() < child->m_aabbMin.z()
+		   || vMax.x() > child->m_aabbMax.x() || vMax.y() > child->m_aabbMax.y() || vMax.z() > child->m_aabbMax.z())
 		{
-			ANKI_ASSERT(node.m_placeable != placeable);
+			break;
 		}
+
+		leaf = child;
+	}
+
+	return leaf;
+}
+
+void Octree::binPlaceable(Leaf& leaf, OctreePlaceable& placeable)
+{
+#if ANKI_ENABLE_ASSERTS
+	for(const LeafNode& node : placeable.m_leafs)
+	{
+		ANKI_ASSERT(node.m_leaf != &leaf && "Already binned. That's wrong");
+	}
 #endif
 
-		// Connect placeable and leaf
-		placeable->m_leafs.pushBack(newLeafNode(parent));
-		parent->m_placeables.pushBack(newPlaceableNode(placeable));
+	// Connect placeable and leaf
+	LeafNode* leafNode;
+	PlaceableNode* placeableNode;
+	newNodes(placeable, leaf, leafNode, placeableNode);
+	placeable.m_leafs.pushBack(leafNode);
 
-		return;
+	LockGuard<SpinLock> lock(leaf.m_placeablesLock);
+	leaf.m_placeables.pushBack(placeableNode);
+}
+
+Octree::Leaf* Octree::publishLeaf(Atomic<Leaf*>& slot, Leaf* newLeaf)
+{
+	Leaf* crntLeaf = nullptr;
+	while(!slot.compareExchange(crntLeaf, newLeaf, AtomicMemoryOrder::ACQ_REL, AtomicMemoryOrder::ACQUIRE))
+	{
+		if(crntLeaf)
+		{
+			// Some other thread created it first, use that
+			releaseLeaf(newLeaf);
+			return crntLeaf;
+		}
 	}
 
+	return newLeaf;
+}
+
+Bool Octree::volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf)
+{
+	const Vec4& amin = volume.getMin();
+	const Vec4& amax = volume.getMax();
+	const Vec3& bmin = leaf.m_aabbMin;
+	const Vec3& bmax = leaf.m_aabbMax;
+
+	Bool superset = true;
+	superset = superset && amin.x() <= bmin.x();
+	superset = superset && amax.x() >= bmax.x();
+	superset = superset && amin.y() <= bmin.y();
+	superset = superset && amax.y() >= bmax.y();
+	superset = superset && amin.z() <= bmin.z();
+	superset = superset && amax.z() >= bmax.z();
+
+	return superset;
+}
+
+Octree::LeafMask Octree::computeChildMask(const Aabb& volume, const Vec3& center)
+{
 	const Vec4& vMin = volume.getMin();
 	const Vec4& vMax = volume.getMax();
-	const Vec3 center = (parent->m_aabbMax + parent->m_aabbMin) / 2.0f;
 
 	LeafMask maskX;
 	if(vMin.x() > center.x())
@@ -210,32 +471,94 @@ void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf
 
 	const LeafMask maskUnion = maskX & maskY & maskZ;
 	ANKI_ASSERT(!!maskUnion && "Should be inside at least one leaf");
+	return maskUnion;
+}
+
+void Octree::placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf* parent, U32 depth)
+{
+	ANKI_ASSERT(placeable);
+	ANKI_ASSERT(parent);
+	ANKI_ASSERT(testCollision(volume, Aabb(parent->m_aabbMin, parent->m_aabbMax)) && "Should be inside");
+
+	if(depth == m_maxDepth || volumeTotallyInsideLeaf(volume, *parent))
+	{
+		// Need to stop and bin the placeable to the leaf
+		binPlaceable(*parent, *placeable);
+		return;
+	}
+
+	const Vec3 center = (parent->m_aabbMax + parent->m_aabbMin) / 2.0f;
+	const LeafMask maskUnion = computeChildMask(volume, center);
 
-	for(U i = 0; i < 8; ++i)
+	for(U32 i = 0; i < 8; ++i)
 	{
 		const LeafMask crntBit = LeafMask(1u << i);
 
 		if(!!(maskUnion & crntBit))
 		{
 			// Inside the leaf, move deeper
+			placeRecursive(volume, placeable, getOrCreateChild(*parent, i, center), depth + 1);
+		}
+	}
+}
 
-			// Create the leaf
-			if(parent->m_children[i] == nullptr)
-			{
-				Leaf* child = newLeaf();
+Bool Octree::leafsUnchanged(const Aabb& volume, const OctreePlaceable& placeable)
+{
+	if(placeable.m_leafs.isEmpty())
+	{
+		return false;
+	}
 
-				// Compute AABB
-				Vec3 childAabbMin, childAabbMax;
-				computeChildAabb(crntBit, parent->m_aabbMin, parent->m_aabbMax, center, child->m_aabbMin,
-								 child->m_aabbMax);
+	// A placed placeable means that the root is there
+	Leaf* root = getRootLeaf();
+	ANKI_ASSERT(root);
 
-				parent->m_children[i] = child;
+	if(isLoose())
+	{
+		return placeable.m_leafs.getSize() == 1
+			   && findLooseLeaf(volume, root, false) == placeable.m_leafs.getFront().m_leaf;
+	}
+
+	U32 leafCount = 0;
+	return leafsUnchangedRecursive(volume, placeable, *root, 0, leafCount)
+		   && leafCount == placeable.m_leafs.getSize();
+}
+
+Bool Octree::leafsUnchangedRecursive(const Aabb& volume, const OctreePlaceable& placeable, const Leaf& parent,
+									 U32 depth, U32& leafCount) const
+{
+	// Same walk as placeRecursive but check the leafs instead of binning
+	if(depth == m_maxDepth || volumeTotallyInsideLeaf(volume, parent))
+	{
+		for(const LeafNode& node : placeable.m_leafs)
+		{
+			if(node.m_leaf == &parent)
+			{
+				++leafCount;
+				return true;
 			}
+		}
+
+		return false;
+	}
+
+	const Vec3 center = (parent.m_aabbMax + parent.m_aabbMin) / 2.0f;
+	const LeafMask maskUnion = computeChildMask(volume, center);
 
-			// Move deeper
-			placeRecursive(volume, placeable, parent->m_children[i], depth + 1);
+	for(U32 i = 0; i < 8; ++i)
+	{
+		if(!!(maskUnion & LeafMask(1u << i)))
+		{
+			// A missing child means that the placeable is not there
+			const Leaf* child = parent.getChild(i);
+			if(!child || !leafsUnchangedRecursive(volume, placeable, *child, depth + 1, leafCount))
+			{
+				return false;
+			}
 		}
 	}
+
+	return true;
 }
 
 void Octree::computeChildAabb(LeafMask child, const Vec3& parentAabbMin, const Vec3& parentAabbMax,
@@ -287,45 +610,38 @@ void Octree::computeChildAabb(LeafMask child, const Vec3& parentAabbMin, const V
 	}
 }
 
-void Octree::removeInternal(OctreePlaceable& placeable)
+Bool Octree::removeInternal(OctreePlaceable& placeable)
 {
 	const Bool isPlaced = !placeable.m_leafs.isEmpty();
-	if(isPlaced)
+	while(!placeable.m_leafs.isEmpty())
 	{
-		while(!placeable.m_leafs.isEmpty())
+		// Pop a leaf node
+		LeafNode& leafNode = placeable.m_leafs.getFront();
+		placeable.m_leafs.popFront();
+		Leaf& leaf = *leafNode.m_leaf;
+
+		// Iterate the placeables of the leaf
+		PlaceableNode* placeableNode = nullptr;
 		{
-			// Pop a leaf node
-			LeafNode& leafNode = placeable.m_leafs.getFront();
-			placeable.m_leafs.popFront();
-
-			// Iterate the placeables of the leaf
-			Bool found = false;
-			(void)found;
-			for(PlaceableNode& placeableNode : leafNode.m_leaf->m_placeables)
+			LockGuard<SpinLock> lock(leaf.m_placeablesLock);
+			for(PlaceableNode& node : leaf.m_placeables)
 			{
-				if(placeableNode.m_placeable == &placeable)
+				if(node.m_placeable == &placeable)
 				{
-					found = true;
-					leafNode.m_leaf->m_placeables.erase(&placeableNode);
-					releasePlaceableNode(&placeableNode);
+					placeableNode = &node;
+					leaf.m_placeables.erase(&node);
 					break;
 				}
 			}
-			ANKI_ASSERT(found);
-
-			// Delete the leaf node
-			releaseLeafNode(&leafNode);
 		}
+		ANKI_ASSERT(placeableNode);
 
-		// Cleanup the tree if there are no placeables
-		ANKI_ASSERT(m_placeableCount > 0);
-		--m_placeableCount;
-		if(m_placeableCount == 0)
-		{
-			cleanupInternal();
-			ANKI_ASSERT(m_rootLeaf == nullptr);
-		}
+		// Delete the nodes
+		releaseNodes(placeable, &leafNode, placeableNode);
 	}
+
+	ANKI_ASSERT(!isPlaced || m_placeableCount.load() > 0);
+	return isPlaced;
 }
 
 void Octree::gatherVisibleRecursive(const Plane frustumPlanes[6], U32 testId,
@@ -346,8 +662,9 @@ void Octree::gatherVisibleRecursive(const Plane frustumPlanes[6], U32 testId,
 
 	// Move to children leafs
 	Aabb aabb;
-	for(Leaf* child : leaf->m_children)
+	for(U32 c = 0; c < 8; ++c)
 	{
+		Leaf* const child = leaf->getChild(c);
 		if(child)
 		{
 			aabb.setMin(child->m_aabbMin);
@@ -382,9 +699,9 @@ void Octree::cleanupRecursive(Leaf* leaf, Bool& canDeleteLeafUponReturn)
 	canDeleteLeafUponReturn = leaf->m_placeables.getSize() == 0;
 
 	// Do the children
-	for(U i = 0; i < 8; ++i)
+	for(U32 i = 0; i < 8; ++i)
 	{
-		Leaf* const child = leaf->m_children[i];
+		Leaf* const child = leaf->getChild(i);
 		if(child)
 		{
 			Bool canDeleteChild;
@@ -393,7 +710,7 @@ void Octree::cleanupRecursive(Leaf* leaf, Bool& canDeleteLeafUponReturn)
 			if(canDeleteChild)
 			{
 				releaseLeaf(child);
-				leaf->m_children[i] = nullptr;
+				leaf->m_children[i].store(nullptr);
 			}
 			else
 			{
@@ -405,15 +722,16 @@ void Octree::cleanupRecursive(Leaf* leaf, Bool& canDeleteLeafUponReturn)
 
 void Octree::cleanupInternal()
 {
-	if(m_rootLeaf)
+	Leaf* const root = getRootLeaf();
+	if(root)
 	{
 		Bool canDeleteLeaf;
-		cleanupRecursive(m_rootLeaf, canDeleteLeaf);
+		cleanupRecursive(root, canDeleteLeaf);
 
 		if(canDeleteLeaf)
 		{
-			releaseLeaf(m_rootLeaf);
-			m_rootLeaf = nullptr;
+			releaseLeaf(root);
+			m_rootLeaf.store(nullptr);
 		}
 	}
 }
@@ -426,9 +744,9 @@ void Octree::debugDrawRecursive(const Leaf& leaf, OctreeDebugDrawer& drawer) con
 	const Aabb box(leaf.m_aabbMin, leaf.m_aabbMax);
 	drawer.drawCube(box, Vec4(color, 1.0f));
 
-	for(U i = 0; i < 8; ++i)
+	for(U32 i = 0; i < 8; ++i)
 	{
-		Leaf* const child = leaf.m_children[i];
+		Leaf* const child = leaf.getChild(i);
 		if(child)
 		{
 			debugDrawRecursive(*child, drawer);
@@ -457,7 +775,18 @@ void Octree::gatherVisibleParallel(const Plane frustumPlanes[6], U32 testId,
 	GatherParallelTaskCtx* taskCtx = static_cast<GatherParallelTaskCtx*>(
 		hive.allocateScratchMemory(sizeof(GatherParallelTaskCtx), alignof(GatherParallelTaskCtx)));
 	taskCtx->m_ctx = ctx;
-	taskCtx->m_leaf = m_rootLeaf;
+	if(m_compactTraversal)
+	{
+		// Build it now since the tasks can't wait for each other
+		updateCompactTree();
+		taskCtx->m_leaf = nullptr;
+		taskCtx->m_compactLeaf = 0;
+	}
+	else
+	{
+		taskCtx->m_leaf = getRootLeaf();
+		taskCtx->m_compactLeaf = MAX_U32;
+	}
 
 	// Create signal semaphore
 	signalSemaphore = hive.newSemaphore(1);
@@ -476,7 +805,14 @@ void Octree::gatherVisibleTaskCallback(void* ud, U32 threadId, ThreadHive& hive,
 {
 	ANKI_ASSERT(ud);
 	GatherParallelTaskCtx* taskCtx = static_cast<GatherParallelTaskCtx*>(ud);
-	taskCtx->m_ctx->m_octree->gatherVisibleParallelTask(threadId, hive, sem, *taskCtx);
+	if(taskCtx->m_compactLeaf != MAX_U32)
+	{
+		taskCtx->m_ctx->m_octree->gatherVisibleParallelCompactTask(hive, sem, *taskCtx);
+	}
+	else if(taskCtx->m_leaf)
+	{
+		taskCtx->m_ctx->m_octree->gatherVisibleParallelTask(threadId, hive, sem, *taskCtx);
+	}
 }
 
 void Octree::gatherVisibleParallelTask(U32 threadId, ThreadHive& hive, ThreadHiveSemaphore* sem,
@@ -510,8 +846,9 @@ void Octree::gatherVisibleParallelTask(U32 threadId, ThreadHive& hive, ThreadHiv
 	Array<ThreadHiveTask, 8> tasks;
 	U32 taskCount = 0;
 	Aabb aabb;
-	for(Leaf* child : leaf->m_children)
+	for(U32 c = 0; c < 8; ++c)
 	{
+		Leaf* const child = leaf->getChild(c);
 		if(child)
 		{
 			aabb.setMin(child->m_aabbMin);
@@ -539,6 +876,7 @@ void Octree::gatherVisibleParallelTask(U32 threadId, ThreadHive& hive, ThreadHiv
 					hive.allocateScratchMemory(sizeof(GatherParallelTaskCtx), alignof(GatherParallelTaskCtx)));
 				newTaskCtx->m_ctx = taskCtx.m_ctx;
 				newTaskCtx->m_leaf = child;
+				newTaskCtx->m_compactLeaf = MAX_U32;
 
 				// Populate the task
 				ThreadHiveTask& task = tasks[taskCount++];
@@ -561,4 +899,90 @@ void Octree::gatherVisibleParallelTask(U32 threadId, ThreadHive& hive, ThreadHiv
 	}
 }
 
+void Octree::gatherVisibleParallelCompactTask(ThreadHive& hive, ThreadHiveSemaphore* sem,
+											   GatherParallelTaskCtx& taskCtx)
+{
+	ANKI_ASSERT(taskCtx.m_ctx);
+	GatherParallelCtx& ctx = *taskCtx.m_ctx;
+
+	if(m_compactLeafs.getSize() == 0)
+	{
+		return;
+	}
+
+	const U32 begin = taskCtx.m_compactLeaf;
+	const U32 end = m_compactLeafs[begin].m_skipIndex;
+
+	auto testFunc = [&](const Aabb& aabb) {
+		return testLeafVisible(&ctx.m_frustumPlanes[0], ctx.m_testCallback, ctx.m_testCallbackUserData, aabb);
+	};
+
+	// Gather to a small local array to avoid locking for every placeable
+	constexpr U32 LOCAL_PLACEABLE_COUNT = 64;
+	Array<void*, LOCAL_PLACEABLE_COUNT> localPlaceables;
+	U32 localPlaceableCount = 0;
+	auto flush = [&]() {
+		LockGuard<SpinLock> lock(ctx.m_lock);
+		for(U32 i = 0; i < localPlaceableCount; ++i)
+		{
+			ctx.m_out->emplaceBack(localPlaceables[i]);
+		}
+		localPlaceableCount = 0;
+	};
+
+	auto newPlaceableFunc = [&](void* placeableUserData) {
+		if(localPlaceableCount == LOCAL_PLACEABLE_COUNT)
+		{
+			flush();
+		}
+		localPlaceables[localPlaceableCount++] = placeableUserData;
+	};
+
+	// Small subtrees are walked by this task. Big ones spawn a task per visible child
+	constexpr U32 MAX_LEAFS_PER_TASK = 64;
+	if(end - begin <= MAX_LEAFS_PER_TASK)
+	{
+		walkCompactTree(begin, end, ctx.m_testId, testFunc, newPlaceableFunc);
+	}
+	else
+	{
+		// Only the placeables of the 1st leaf
+		walkCompactTree(begin, begin + 1, ctx.m_testId, testFunc, newPlaceableFunc);
+
+		Array<ThreadHiveTask, 8> tasks;
+		U32 taskCount = 0;
+		Aabb aabb;
+		for(U32 child = begin + 1; child < end; child = m_compactLeafs[child].m_skipIndex)
+		{
+			aabb.setMin(m_compactLeafs[child].m_aabbMin);
+			aabb.setMax(m_compactLeafs[child].m_aabbMax);
+			if(testFunc(aabb))
+			{
+				GatherParallelTaskCtx* newTaskCtx = static_cast<GatherParallelTaskCtx*>(
+					hive.allocateScratchMemory(sizeof(GatherParallelTaskCtx), alignof(GatherParallelTaskCtx)));
+				newTaskCtx->m_ctx = taskCtx.m_ctx;
+				newTaskCtx->m_leaf = nullptr;
+				newTaskCtx->m_compactLeaf = child;
+
+				ThreadHiveTask& task = tasks[taskCount++];
+				task.m_callback = gatherVisibleTaskCallback;
+				task.m_argument = newTaskCtx;
+				task.m_signalSemaphore = sem;
+			}
+		}
+
+		if(taskCount)
+		{
+			// Same trick as in gatherVisibleParallelTask
+			sem->increaseSemaphore(taskCount);
+			hive.submitTasks(&tasks[0], taskCount);
+		}
+	}
+
+	if(localPlaceableCount)
+	{
+		flush();
+	}
+}
+
 } // end namespace anki
@@ -8,6 +8,7 @@
 #include <anki/scene/Common.h>
 #include <anki/Math.h>
 #include <anki/collision/Aabb.h>
+#include <anki/collision/RayPacket.h>
 #include <anki/util/WeakArray.h>
 #include <anki/util/Enum.h>
 #include <anki/util/ObjectAllocator.h>
@@ -28,6 +29,14 @@ class ThreadHiveSemaphore;
 /// Callback to determine if an octree node is visible.
 using OctreeNodeVisibilityTestCallback = Bool (*)(void* userData, const Aabb& box);
 
+/// The result of Octree::rayCast and Bvh::rayCast.
+class OctreeRayHit
+{
+public:
+	void* m_userData = nullptr; ///< The user data of the placeable that got hit or nullptr if the ray hit nothing.
+	F32 m_distance = MAX_F32; ///< The distance of the hit from the ray origin.
+};
+
 /// Octree debug drawer.
 class OctreeDebugDrawer
 {
@@ -48,28 +57,54 @@ public:
 
 	~Octree();
 
-	void init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth);
+	/// @param sceneAabbMin The min of the scene bounds.
+	/// @param sceneAabbMax The max of the scene bounds.
+	/// @param maxDepth The max depth of the tree.
+	/// @param looseness If it's more than 1.0 the octree is loose. The bounds of the leafs are scaled by this factor
+	///                  and every placeable goes to a single leaf that is picked by its center and size.
+	void init(const Vec3& sceneAabbMin, const Vec3& sceneAabbMax, U32 maxDepth, F32 looseness = 1.0f);
+
+	/// Use a compact copy of the tree for the gathers and walks. The copy keeps the leafs in one array in Morton order
+	/// and the placeables in contiguous spans. It gets rebuilt lazily when the tree changes.
+	void setCompactTraversal(Bool enable)
+	{
+		m_compactTraversal = enable;
+		m_compactTreeDirty.store(true);
+	}
+
+	Bool getCompactTraversal() const
+	{
+		return m_compactTraversal;
+	}
 
 	/// Place or re-place an element in the tree.
-	/// @note It's thread-safe against place and remove methods.
+	/// @note It's thread-safe against place and remove methods as long as the same placeable is not placed or removed
+	///       concurrently. Threads that touch different parts of the tree don't wait for each other.
 	void place(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds);
 
 	/// Remove an element from the tree.
-	/// @note It's thread-safe against place and remove methods.
+	/// @note It's thread-safe against place and remove methods. See place.
 	void remove(OctreePlaceable& placeable);
 
 	/// Gather visible placeables.
 	/// @param frustumPlanes The frustum planes to test against.
-	/// @param testId A unique index for this test.
+	/// @param testId A unique index for this test. See OctreePlaceable::computeTestId.
 	/// @param testCallback A ptr to a function that will be used to perform an additional test to the box of the
 	///                     Octree node. Can be nullptr.
 	/// @param testCallbackUserData Parameter to the testCallback. Can be nullptr.
 	/// @param out The output of the tests.
-	/// @note It's thread-safe against other gatherVisible calls.
+	/// @note It's thread-safe against other gatherVisible calls but not against place and remove.
 	void gatherVisible(const Plane frustumPlanes[6], U32 testId, OctreeNodeVisibilityTestCallback testCallback,
 					   void* testCallbackUserData, DynamicArrayAuto<void*>& out)
 	{
-		gatherVisibleRecursive(frustumPlanes, testId, testCallback, testCallbackUserData, m_rootLeaf, out);
+		if(m_compactTraversal)
+		{
+			gatherVisibleCompact(frustumPlanes, testId, testCallback, testCallbackUserData, out);
+		}
+		else if(getRootLeaf())
+		{
+			gatherVisibleRecursive(frustumPlanes, testId, testCallback, testCallbackUserData, getRootLeaf(), out);
+		}
 	}
 
 	/// Similar to gatherVisible but it spawns ThreadHive tasks.
@@ -87,21 +122,46 @@ public:
 	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
 	void walkTree(U32 testId, TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc)
 	{
-		ANKI_ASSERT(m_rootLeaf);
-		walkTreeInternal(*m_rootLeaf, testId, testFunc, newPlaceableFunc);
+		if(m_compactTraversal)
+		{
+			updateCompactTree();
+			if(m_compactLeafs.getSize() > 0)
+			{
+				walkCompactTree(0, m_compactLeafs[0].m_skipIndex, testId, testFunc, newPlaceableFunc);
+			}
+		}
+		else if(getRootLeaf())
+		{
+			walkTreeInternal(*getRootLeaf(), testId, testFunc, newPlaceableFunc);
+		}
 	}
 
+	/// Find the closest placeable every ray hits. RayPacket::SIZE rays at a time walk the octants they cross, nearest
+	/// octant first, and every hit shortens its ray so the farther octants get culled. The placeables of a leaf are
+	/// only tested through exactHitFunc since a leaf holds many of them and has no box per placeable.
+	/// @param rays The rays to cast.
+	/// @param maxDistance How far the rays travel.
+	/// @param exactHitFunc A functor with signature F32(void* placeableUserData, const Ray& ray, F32 leafDistance). It
+	///                     returns the distance of the exact hit or a negative value if the ray misses the placeable.
+	///                     The leafDistance is the distance of the leaf box the placeable was found in.
+	/// @param[out] hits One hit per ray.
+	/// @note It's not thread-safe against place and remove methods.
+	template<typename TExactHitFunc>
+	void rayCast(ConstWeakArray<Ray> rays, F32 maxDistance, TExactHitFunc exactHitFunc, WeakArray<OctreeRayHit> hits);
+
 	/// Debug draw.
 	void debugDraw(OctreeDebugDrawer& drawer) const
 	{
-		ANKI_ASSERT(m_rootLeaf);
-		debugDrawRecursive(*m_rootLeaf, drawer);
+		if(getRootLeaf())
+		{
+			debugDrawRecursive(*getRootLeaf(), drawer);
+		}
 	}
 
 	/// Get the bounds of the scene as calculated by the objects that were placed inside the Octree.
 	void getActualSceneBounds(Vec3& min, Vec3& max) const
 	{
-		LockGuard<Mutex> lock(m_globalMtx);
+		LockGuard<SpinLock> lock(m_actualSceneAabbLock);
 		ANKI_ASSERT(m_actualSceneAabbMin.x() < MAX_F32);
 		ANKI_ASSERT(m_actualSceneAabbMax.x() > MIN_F32);
 		min = m_actualSceneAabbMin;
@@ -134,22 +194,47 @@ private:
 		IntrusiveList<PlaceableNode> m_placeables;
 		Vec3 m_aabbMin;
 		Vec3 m_aabbMax;
-		Array<Leaf*, 8> m_children = {};
+
+		/// The children are published with a compare-and-swap so the placement can walk the tree without locks.
+		Array<Atomic<Leaf*>, 8> m_children;
+
+		SpinLock m_placeablesLock; ///< Protects m_placeables.
+
+		Leaf()
+		{
+			for(Atomic<Leaf*>& child : m_children)
+			{
+				child.setNonAtomically(nullptr);
+			}
+		}
 
 #if ANKI_ENABLE_ASSERTS
 		~Leaf()
 		{
 			ANKI_ASSERT(m_placeables.isEmpty());
-			m_children = {};
+			for(Atomic<Leaf*>& child : m_children)
+			{
+				child.setNonAtomically(nullptr);
+			}
 			m_aabbMin = m_aabbMax = Vec3(0.0f);
 		}
 #endif
 
+		Leaf* getChild(U32 i) const
+		{
+			return m_children[i].load(AtomicMemoryOrder::ACQUIRE);
+		}
+
 		Bool hasChildren() const
 		{
-			return m_children[0] != nullptr || m_children[1] != nullptr || m_children[2] != nullptr
-				   || m_children[3] != nullptr || m_children[4] != nullptr || m_children[5] != nullptr
-				   || m_children[6] != nullptr || m_children[7] != nullptr;
+			for(U32 i = 0; i < 8; ++i)
+			{
+				if(getChild(i))
+				{
+					return true;
+				}
+			}
+			return false;
 		}
 	};
 
@@ -167,6 +252,17 @@ private:
 #endif
 	};
 
+	/// A leaf of the compact tree. The leafs are stored depth first so the 1st child of a leaf is the next leaf.
+	class CompactLeaf
+	{
+	public:
+		Vec3 m_aabbMin;
+		Vec3 m_aabbMax;
+		U32 m_firstPlaceable;
+		U32 m_placeableCount;
+		U32 m_skipIndex; ///< The index of the next leaf that is not a descendant. Used to skip the subtree.
+	};
+
 	/// P: Stands for positive and N: Negative
 	enum class LeafMask : U8
 	{
@@ -190,60 +286,126 @@ private:
 	};
 	ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS_FRIEND(LeafMask)
 
+	/// The allocators of the nodes that connect placeables and leafs. Every placeable always uses the same group so
+	/// threads that place different placeables rarely contend.
+	class alignas(ANKI_CACHE_LINE_SIZE) NodeAllocatorGroup
+	{
+	public:
+		SpinLock m_lock;
+		ObjectAllocatorSameType<LeafNode, 128> m_leafNodeAlloc;
+		ObjectAllocatorSameType<PlaceableNode, 256> m_placeableNodeAlloc;
+	};
+
+	static constexpr U32 NODE_ALLOCATOR_GROUP_COUNT = 16;
+
 	SceneAllocator<U8> m_alloc;
 	U32 m_maxDepth = 0;
 	Vec3 m_sceneAabbMin = Vec3(0.0f);
 	Vec3 m_sceneAabbMax = Vec3(0.0f);
-	mutable Mutex m_globalMtx;
+	F32 m_looseness = 1.0f;
+
+	/// Place and remove lock it for reading. Only deleting leafs locks it for writing.
+	RWMutex m_treeMtx;
 
+	SpinLock m_leafAllocLock;
 	ObjectAllocatorSameType<Leaf, 256> m_leafAlloc;
-	ObjectAllocatorSameType<LeafNode, 128> m_leafNodeAlloc;
-	ObjectAllocatorSameType<PlaceableNode, 256> m_placeableNodeAlloc;
+	Array<NodeAllocatorGroup, NODE_ALLOCATOR_GROUP_COUNT> m_nodeAllocGroups;
 
-	Leaf* m_rootLeaf = nullptr;
-	U32 m_placeableCount = 0;
+	Atomic<Leaf*> m_rootLeaf = {nullptr};
+	Atomic<U32> m_placeableCount = {0};
 
 	/// Compute the min of the scene bounds based on what is placed inside the octree.
 	Vec3 m_actualSceneAabbMin = Vec3(MAX_F32);
 	Vec3 m_actualSceneAabbMax = Vec3(MIN_F32);
+	mutable SpinLock m_actualSceneAabbLock;
+
+	/// @name Compact tree
+	/// @{
+	Bool m_compactTraversal = false;
+	Atomic<Bool> m_compactTreeDirty = {true};
+	Mutex m_compactTreeMtx;
+	DynamicArray<CompactLeaf> m_compactLeafs;
+	DynamicArray<OctreePlaceable*> m_compactPlaceables;
+	/// @}
+
+	Leaf* getRootLeaf() const
+	{
+		return m_rootLeaf.load(AtomicMemoryOrder::ACQUIRE);
+	}
 
 	Leaf* newLeaf()
 	{
+		LockGuard<SpinLock> lock(m_leafAllocLock);
 		return m_leafAlloc.newInstance(m_alloc);
 	}
 
 	void releaseLeaf(Leaf* leaf)
 	{
+		LockGuard<SpinLock> lock(m_leafAllocLock);
 		m_leafAlloc.deleteInstance(m_alloc, leaf);
 	}
 
-	PlaceableNode* newPlaceableNode(OctreePlaceable* placeable)
+	/// Get a child of a leaf and create it if it's not there.
+	/// @note It's thread-safe.
+	Leaf* getOrCreateChild(Leaf& parent, U32 childIdx, const Vec3& parentCenter);
+
+	/// Store a new leaf to an empty slot. If some other thread stored one first then delete the new one.
+	/// @return The leaf that ended up in the slot.
+	Leaf* publishLeaf(Atomic<Leaf*>& slot, Leaf* newLeaf);
+
+	NodeAllocatorGroup& getNodeAllocatorGroup(const OctreePlaceable& placeable)
 	{
-		ANKI_ASSERT(placeable);
-		PlaceableNode* out = m_placeableNodeAlloc.newInstance(m_alloc);
-		out->m_placeable = placeable;
-		return out;
+		// Skip the low bits because the placeables are aligned
+		const PtrSize addr = ptrToNumber(&placeable);
+		return m_nodeAllocGroups[(addr / sizeof(void*)) % NODE_ALLOCATOR_GROUP_COUNT];
 	}
 
-	void releasePlaceableNode(PlaceableNode* placeable)
+	/// Allocate the nodes that connect a placeable with a leaf.
+	void newNodes(OctreePlaceable& placeable, Leaf& leaf, LeafNode*& leafNode, PlaceableNode*& placeableNode)
 	{
-		m_placeableNodeAlloc.deleteInstance(m_alloc, placeable);
+		NodeAllocatorGroup& group = getNodeAllocatorGroup(placeable);
+		LockGuard<SpinLock> lock(group.m_lock);
+		leafNode = group.m_leafNodeAlloc.newInstance(m_alloc);
+		leafNode->m_leaf = &leaf;
+		placeableNode = group.m_placeableNodeAlloc.newInstance(m_alloc);
+		placeableNode->m_placeable = &placeable;
 	}
 
-	LeafNode* newLeafNode(Leaf* leaf)
+	void releaseNodes(OctreePlaceable& placeable, LeafNode* leafNode, PlaceableNode* placeableNode)
 	{
-		ANKI_ASSERT(leaf);
-		LeafNode* out = m_leafNodeAlloc.newInstance(m_alloc);
-		out->m_leaf = leaf;
-		return out;
+		NodeAllocatorGroup& group = getNodeAllocatorGroup(placeable);
+		LockGuard<SpinLock> lock(group.m_lock);
+		group.m_leafNodeAlloc.deleteInstance(m_alloc, leafNode);
+		group.m_placeableNodeAlloc.deleteInstance(m_alloc, placeableNode);
 	}
 
-	void releaseLeafNode(LeafNode* node)
+	void placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf* parent, U32 depth);
+
+	/// Connect a placeable with a leaf.
+	void binPlaceable(Leaf& leaf, OctreePlaceable& placeable);
+
+	Bool isLoose() const
 	{
-		m_leafNodeAlloc.deleteInstance(m_alloc, node);
+		return m_looseness > 1.0f;
 	}
 
-	void placeRecursive(const Aabb& volume, OctreePlaceable* placeable, Leaf* parent, U32 depth);
+	/// Scale some bounds by the looseness.
+	void loosenBounds(Vec3& aabbMin, Vec3& aabbMax) const;
+
+	/// Find the leaf of a volume in a loose octree.
+	/// @param createLeafs If it's false and a leaf is missing return nullptr.
+	/// @note It's thread-safe.
+	Leaf* findLooseLeaf(const Aabb& volume, Leaf* root, Bool createLeafs);
+
+	/// Check if placing the volume would bin the placeable to the leafs it's already in.
+	/// @note It's thread-safe against place and remove of other placeables.
+	Bool leafsUnchanged(const Aabb& volume, const OctreePlaceable& placeable);
+
+	Bool leafsUnchangedRecursive(const Aabb& volume, const OctreePlaceable& placeable, const Leaf& parent, U32 depth,
+								 U32& leafCount) const;
+
+	/// Compute the children of a leaf that a volume overlaps.
+	static LeafMask computeChildMask(const Aabb& volume, const Vec3& center);
 
 	static Bool volumeTotallyInsideLeaf(const Aabb& volume, const Leaf& leaf);
 
@@ -251,7 +413,38 @@ private:
 								 const Vec3& parentAabbCenter, Vec3& childAabbMin, Vec3& childAabbMax);
 
 	/// Remove a placeable from the tree.
-	void removeInternal(OctreePlaceable& placeable);
+	/// @return True if the placeable was placed.
+	Bool removeInternal(OctreePlaceable& placeable);
+
+	/// Delete the tree if it's empty.
+	void cleanupIfEmpty();
+
+	void markCompactTreeDirty()
+	{
+		if(m_compactTraversal && !m_compactTreeDirty.load())
+		{
+			m_compactTreeDirty.store(true);
+		}
+	}
+
+	/// Rebuild the compact tree if the tree changed.
+	/// @note It's thread-safe.
+	void updateCompactTree();
+
+	void countLeafsRecursive(const Leaf& leaf, U32& leafCount, U32& placeableCount) const;
+
+	void buildCompactTreeRecursive(const Leaf& leaf, U32& leafCount, U32& placeableCount);
+
+	/// Walk a range of the compact tree without a stack.
+	/// @param begin The first leaf of the range. It's considered visible.
+	/// @param end One past the last leaf of the range.
+	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+	void walkCompactTree(U32 begin, U32 end, U32 testId, TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc);
+
+	void gatherVisibleCompact(const Plane frustumPlanes[6], U32 testId, OctreeNodeVisibilityTestCallback testCallback,
+							  void* testCallbackUserData, DynamicArrayAuto<void*>& out);
+
+	void gatherVisibleParallelCompactTask(ThreadHive& hive, ThreadHiveSemaphore* sem, GatherParallelTaskCtx& taskCtx);
 
 	static void gatherVisibleRecursive(const Plane frustumPlanes[6], U32 testId,
 									   OctreeNodeVisibilityTestCallback testCallback, void* testCallbackUserData,
@@ -274,31 +467,71 @@ private:
 
 	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
 	void walkTreeInternal(Leaf& leaf, U32 testId, TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc);
+
+	template<typename TExactHitFunc>
+	static void rayCastPlaceables(void* placeableUserData, U32 mask, const Vec4& leafDistances, RayPacket& packet,
+								  const Ray* rays, TExactHitFunc& exactHitFunc, OctreeRayHit* hits);
+
+	template<typename TExactHitFunc>
+	void rayCastInternal(const Leaf& leaf, RayPacket& packet, const Ray* rays, TExactHitFunc& exactHitFunc,
+						 OctreeRayHit* hits) const;
+
+	template<typename TExactHitFunc>
+	void rayCastCompact(RayPacket& packet, const Ray* rays, TExactHitFunc& exactHitFunc, OctreeRayHit* hits) const;
 };
 
-/// An entity that can be placed in octrees.
+/// An entity that can be placed in octrees or in a Bvh.
 class OctreePlaceable : public NonCopyable
 {
 	friend class Octree;
+	friend class Bvh;
 
 public:
+	/// The number of tests that can share an epoch.
+	static constexpr U32 MAX_TESTS_PER_EPOCH = 64;
+
 	void* m_userData = nullptr;
 
+	/// Forget all the tests. Not needed if every batch of tests uses a new epoch. See computeTestId.
 	void reset()
 	{
 		m_visitedMask.setNonAtomically(0);
+		m_visitedEpoch.setNonAtomically(0);
+	}
+
+	/// Combine an epoch and the index of a test into the testId the trees take. The placeables forget the tests of
+	/// the older epochs the first time a newer one visits them.
+	static U32 computeTestId(U32 epoch, U32 testIdx)
+	{
+		ANKI_ASSERT(testIdx < MAX_TESTS_PER_EPOCH);
+		ANKI_ASSERT(epoch <= MAX_U32 / MAX_TESTS_PER_EPOCH);
+		return epoch * MAX_TESTS_PER_EPOCH + testIdx;
 	}
 
 private:
 	Atomic<U64> m_visitedMask = {0u};
+	Atomic<U32> m_visitedEpoch = {0u};
+	SpinLock m_visitedEpochLock;
 	IntrusiveList<Octree::LeafNode> m_leafs; ///< A list of leafs this placeable belongs.
+	U32 m_bvhLeaf = MAX_U32; ///< The Bvh leaf this placeable belongs.
 
 	/// Check if already visited.
 	/// @note It's thread-safe.
 	Bool alreadyVisited(U32 testId)
 	{
-		ANKI_ASSERT(testId < 64);
-		const U64 testMask = U64(1u) << U64(testId);
+		const U32 epoch = testId / MAX_TESTS_PER_EPOCH;
+		if(m_visitedEpoch.load() != epoch)
+		{
+			// The first visit of a new epoch. Clear the mask before anyone sets the bits of the new tests
+			LockGuard<SpinLock> lock(m_visitedEpochLock);
+			if(m_visitedEpoch.load() != epoch)
+			{
+				m_visitedMask.store(0);
+				m_visitedEpoch.store(epoch);
+			}
+		}
+
+		const U64 testMask = U64(1u) << U64(testId % MAX_TESTS_PER_EPOCH);
 		const U64 prev = m_visitedMask.fetchOr(testMask);
 		return !!(testMask & prev);
 	}
@@ -320,8 +553,9 @@ inline void Octree::walkTreeInternal(Leaf& leaf, U32 testId, TTestAabbFunc testF
 	Aabb aabb;
 	U visibleLeafs = 0;
 	(void)visibleLeafs;
-	for(Leaf* child : leaf.m_children)
+	for(U32 i = 0; i < 8; ++i)
 	{
+		Leaf* const child = leaf.getChild(i);
 		if(child)
 		{
 			aabb.setMin(child->m_aabbMin);
@@ -336,6 +570,173 @@ inline void Octree::walkTreeInternal(Leaf& leaf, U32 testId, TTestAabbFunc testF
 
 	ANKI_TRACE_INC_COUNTER(OCTREE_VISIBLE_LEAFS, visibleLeafs);
 }
+
+template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+inline void Octree::walkCompactTree(U32 begin, U32 end, U32 testId, TTestAabbFunc testFunc,
+									TNewPlaceableFunc newPlaceableFunc)
+{
+	ANKI_ASSERT(begin < end && end <= m_compactLeafs.getSize());
+
+	Aabb aabb;
+	U visibleLeafs = 0;
+	(void)visibleLeafs;
+	U32 i = begin;
+	while(i < end)
+	{
+		const CompactLeaf& leaf = m_compactLeafs[i];
+
+		if(i != begin)
+		{
+			aabb.setMin(leaf.m_aabbMin);
+			aabb.setMax(leaf.m_aabbMax);
+			if(!testFunc(aabb))
+			{
+				// Skip the whole subtree
+				i = leaf.m_skipIndex;
+				continue;
+			}
+
+			++visibleLeafs;
+		}
+
+		// Visit the placeables that belong to that leaf
+		for(U32 p = leaf.m_firstPlaceable; p < leaf.m_firstPlaceable + leaf.m_placeableCount; ++p)
+		{
+			OctreePlaceable* placeable = m_compactPlaceables[p];
+			if(!placeable->alreadyVisited(testId))
+			{
+				ANKI_ASSERT(placeable->m_userData);
+				newPlaceableFunc(placeable->m_userData);
+			}
+		}
+
+		// Move to the 1st child or to the next sibling if there are no children
+		++i;
+	}
+
+	ANKI_TRACE_INC_COUNTER(OCTREE_VISIBLE_LEAFS, visibleLeafs);
+}
+
+template<typename TExactHitFunc>
+inline void Octree::rayCast(ConstWeakArray<Ray> rays, F32 maxDistance, TExactHitFunc exactHitFunc,
+							WeakArray<OctreeRayHit> hits)
+{
+	ANKI_ASSERT(hits.getSize() >= rays.getSize());
+	ANKI_TRACE_INC_COUNTER(OCTREE_RAYS, rays.getSize());
+
+	if(m_compactTraversal)
+	{
+		updateCompactTree();
+	}
+
+	for(U32 first = 0; first < rays.getSize(); first += RayPacket::SIZE)
+	{
+		const U32 count = min<U32>(RayPacket::SIZE, U32(rays.getSize() - first));
+
+		RayPacket packet;
+		for(U32 lane = 0; lane < count; ++lane)
+		{
+			packet.setRay(lane, rays[first + lane], maxDistance);
+			hits[first + lane] = OctreeRayHit();
+		}
+
+		if(m_compactTraversal)
+		{
+			rayCastCompact(packet, &rays[first], exactHitFunc, &hits[first]);
+		}
+		else if(getRootLeaf())
+		{
+			rayCastInternal(*getRootLeaf(), packet, &rays[first], exactHitFunc, &hits[first]);
+		}
+	}
+}
+
+template<typename TExactHitFunc>
+inline void Octree::rayCastPlaceables(void* placeableUserData, U32 mask, const Vec4& leafDistances,
+									  RayPacket& packet, const Ray* rays, TExactHitFunc& exactHitFunc,
+									  OctreeRayHit* hits)
+{
+	ANKI_ASSERT(placeableUserData);
+	for(U32 lane = 0; lane < RayPacket::SIZE; ++lane)
+	{
+		if(!(mask & (1u << lane)))
+		{
+			continue;
+		}
+
+		const F32 dist = exactHitFunc(placeableUserData, rays[lane], leafDistances[lane]);
+		if(dist >= 0.0f && dist < packet.m_maxDistances[lane])
+		{
+			// Closer hit, shorten the ray to cull the rest of the tree
+			packet.m_maxDistances[lane] = dist;
+			hits[lane].m_userData = placeableUserData;
+			hits[lane].m_distance = dist;
+		}
+	}
+}
+
+template<typename TExactHitFunc>
+inline void Octree::rayCastInternal(const Leaf& leaf, RayPacket& packet, const Ray* rays,
+									TExactHitFunc& exactHitFunc, OctreeRayHit* hits) const
+{
+	Vec4 distances;
+	const U32 mask = packet.testAabb(leaf.m_aabbMin, leaf.m_aabbMax, distances);
+	if(mask == 0)
+	{
+		return;
+	}
+
+	for(const PlaceableNode& placeableNode : leaf.m_placeables)
+	{
+		rayCastPlaceables(placeableNode.m_placeable->m_userData, mask, distances, packet, rays, exactHitFunc, hits);
+	}
+
+	// Visit the children that are closer to the origin of the 1st active ray first to shorten the rays early. The 3
+	// bits of the child index are set when the child is in the negative side of X, Y and Z
+	U32 lane = 0;
+	while(!(mask & (1u << lane)))
+	{
+		++lane;
+	}
+
+	const Vec4& dir = rays[lane].getDirection();
+	const U32 nearest = ((dir.x() > 0.0f) ? 4u : 0u) | ((dir.y() > 0.0f) ? 2u : 0u) | ((dir.z() > 0.0f) ? 1u : 0u);
+	for(U32 i = 0; i < 8; ++i)
+	{
+		const Leaf* child = leaf.getChild(nearest ^ i);
+		if(child)
+		{
+			rayCastInternal(*child, packet, rays, exactHitFunc, hits);
+		}
+	}
+}
+
+template<typename TExactHitFunc>
+inline void Octree::rayCastCompact(RayPacket& packet, const Ray* rays, TExactHitFunc& exactHitFunc,
+								   OctreeRayHit* hits) const
+{
+	U32 i = 0;
+	while(i < m_compactLeafs.getSize())
+	{
+		const CompactLeaf& leaf = m_compactLeafs[i];
+
+		Vec4 distances;
+		const U32 mask = packet.testAabb(leaf.m_aabbMin, leaf.m_aabbMax, distances);
+		if(mask == 0)
+		{
+			// Skip the whole subtree
+			i = leaf.m_skipIndex;
+			continue;
+		}
+
+		for(U32 p = leaf.m_firstPlaceable; p < leaf.m_firstPlaceable + leaf.m_placeableCount; ++p)
+		{
+			rayCastPlaceables(m_compactPlaceables[p]->m_userData, mask, distances, packet, rays, exactHitFunc, hits);
+		}
+
+		++i;
+	}
+}
 /// @}
 
 } // end namespace anki
@@ -225,6 +225,8 @@ public:
 ParticleEmitterNode::ParticleEmitterNode(SceneGraph* scene, CString name)
 	: SceneNode(scene, name)
 {
+	// The particles are simulated every frame
+	setUpdateEveryFrame(true);
 }
 
 ParticleEmitterNode::~ParticleEmitterNode()
@@ -326,6 +328,7 @@ void ParticleEmitterNode::drawCallback(RenderQueueDrawContext& ctx, ConstWeakArr
 
 		// Draw
 		cmdb->drawArrays(PrimitiveTopology::TRIANGLE_STRIP, 4, self.m_aliveParticlesCount, 0, 0);
+		ctx.m_drawnTriangleCount += U64(self.m_aliveParticlesCount) * 2;
 	}
 	else
 	{
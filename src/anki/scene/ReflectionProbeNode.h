@@ -22,6 +22,8 @@ public:
 	ReflectionProbeNode(SceneGraph* scene, CString name)
 		: SceneNode(scene, name)
 	{
+		// The renderer marks the probe for rendering every frame
+		setUpdateEveryFrame(true);
 	}
 
 	~ReflectionProbeNode();
@@ -0,0 +1,78 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/SceneComponentPool.h>
+#include <anki/util/Functions.h>
+
+namespace anki
+{
+
+SceneComponentPool::~SceneComponentPool()
+{
+	ANKI_ASSERT(m_objectCount == 0 && "Forgot to free");
+
+	for(U8* chunk : m_chunks)
+	{
+		m_alloc.getMemoryPool().free(chunk);
+	}
+
+	m_chunks.destroy(m_alloc);
+}
+
+void SceneComponentPool::init(SceneAllocator<U8> alloc, PtrSize objectSize, U32 objectAlignment)
+{
+	ANKI_ASSERT(!isInitialized());
+	ANKI_ASSERT(objectSize > 0 && objectAlignment > 0);
+	m_alloc = alloc;
+	m_objectAlignment = max<U32>(objectAlignment, alignof(FreeSlot));
+	m_objectSize = getAlignedRoundUp(m_objectAlignment, max<PtrSize>(objectSize, sizeof(FreeSlot)));
+}
+
+void* SceneComponentPool::allocate(PtrSize size, U32 alignment)
+{
+	ANKI_ASSERT(isInitialized());
+
+	if(size > m_objectSize || alignment > m_objectAlignment)
+	{
+		return nullptr;
+	}
+
+	LockGuard<SpinLock> lock(m_lock);
+
+	if(m_freeList == nullptr)
+	{
+		// Out of slots, get a new chunk and put its slots in the list in memory order
+		U8* chunk = static_cast<U8*>(
+			m_alloc.getMemoryPool().allocate(m_objectSize * OBJECTS_PER_CHUNK, m_objectAlignment));
+		m_chunks.emplaceBack(m_alloc, chunk);
+
+		for(U32 i = OBJECTS_PER_CHUNK; i-- > 0;)
+		{
+			FreeSlot* slot = reinterpret_cast<FreeSlot*>(chunk + m_objectSize * i);
+			slot->m_next = m_freeList;
+			m_freeList = slot;
+		}
+	}
+
+	FreeSlot* slot = m_freeList;
+	m_freeList = slot->m_next;
+	++m_objectCount;
+	return slot;
+}
+
+void SceneComponentPool::free(void* ptr)
+{
+	ANKI_ASSERT(ptr);
+	ANKI_ASSERT(m_objectCount > 0);
+
+	LockGuard<SpinLock> lock(m_lock);
+
+	FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+	slot->m_next = m_freeList;
+	m_freeList = slot;
+	--m_objectCount;
+}
+
+} // end namespace anki
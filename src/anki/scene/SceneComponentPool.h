@@ -0,0 +1,76 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/scene/Common.h>
+#include <anki/util/DynamicArray.h>
+#include <anki/util/Thread.h>
+
+namespace anki
+{
+
+/// @addtogroup scene
+/// @{
+
+/// Keeps the scene components of a single type close in memory. The memory comes in chunks and the free slots are kept
+/// in a list so allocate and free are O(1). It only manages the memory, the construction and destruction of the
+/// components is up to the caller. The chunks are given back when the pool is destroyed.
+class SceneComponentPool : public NonCopyable
+{
+public:
+	static constexpr U32 OBJECTS_PER_CHUNK = 256;
+
+	SceneComponentPool() = default;
+
+	~SceneComponentPool();
+
+	/// @param objectSize The max size of the components. Derived types that are larger than that can't be stored.
+	void init(SceneAllocator<U8> alloc, PtrSize objectSize, U32 objectAlignment);
+
+	Bool isInitialized() const
+	{
+		return m_objectSize > 0;
+	}
+
+	/// Allocate the memory of a component.
+	/// @return nullptr if the component is bigger or more aligned than the objects of the pool.
+	/// @note It's thread-safe against allocate and free.
+	void* allocate(PtrSize size, U32 alignment);
+
+	/// Free memory returned by allocate.
+	/// @note It's thread-safe against allocate and free.
+	void free(void* ptr);
+
+	/// The number of live components.
+	U32 getObjectCount() const
+	{
+		return m_objectCount;
+	}
+
+	U32 getChunkCount() const
+	{
+		return m_chunks.getSize();
+	}
+
+private:
+	/// A free slot holds a pointer to the next free slot.
+	class FreeSlot
+	{
+	public:
+		FreeSlot* m_next;
+	};
+
+	SceneAllocator<U8> m_alloc;
+	DynamicArray<U8*> m_chunks;
+	FreeSlot* m_freeList = nullptr;
+	PtrSize m_objectSize = 0;
+	U32 m_objectAlignment = 0;
+	U32 m_objectCount = 0;
+	SpinLock m_lock;
+};
+/// @}
+
+} // end namespace anki
@@ -7,8 +7,10 @@
 #include <anki/scene/CameraNode.h>
 #include <anki/scene/PhysicsDebugNode.h>
 #include <anki/scene/ModelNode.h>
-#include <anki/scene/Octree.h>
 #include <anki/scene/components/FrustumComponent.h>
+#include <anki/scene/components/SpatialComponent.h>
+#include <anki/scene/components/MoveComponent.h>
+#include <anki/scene/components/OccluderComponent.h>
 #include <anki/physics/PhysicsWorld.h>
 #include <anki/resource/ResourceManager.h>
 #include <anki/renderer/MainRenderer.h>
@@ -21,13 +23,60 @@ namespace anki
 
 const U NODE_UPDATE_BATCH = 10;
 
+/// When the children of a node are updated in parallel a task will get at least that many nodes.
+const U32 NODES_PER_SUBTREE_TASK = 32;
+
+/// The number of marked spatials a task of the spatial pass takes at a time.
+const U32 SPATIALS_PER_UPDATE_TASK = 64;
+
+/// The components that updateNode skips because they have their own pass.
+const SceneComponentTypeMask SEPARATELY_UPDATED_COMPONENTS = getSceneComponentTypeBit(SceneComponentType::SPATIAL);
+
+/// The components that change without anyone marking their node for update so their nodes are updated every frame.
+const SceneComponentTypeMask EVERY_FRAME_COMPONENTS =
+	getSceneComponentTypeBit(SceneComponentType::SCRIPT) | getSceneComponentTypeBit(SceneComponentType::SKIN)
+	| getSceneComponentTypeBit(SceneComponentType::BODY) | getSceneComponentTypeBit(SceneComponentType::JOINT)
+	| getSceneComponentTypeBit(SceneComponentType::PLAYER_CONTROLLER);
+
 class SceneGraph::UpdateSceneNodesCtx
 {
 public:
 	SceneGraph* m_scene = nullptr;
 
-	IntrusiveList<SceneNode>::Iterator m_crntNode;
-	SpinLock m_crntNodeLock;
+	WeakArray<SceneNode*> m_roots;
+	U32 m_crntRoot = 0;
+	SpinLock m_crntRootLock;
+
+	Second m_prevUpdateTime;
+	Second m_crntTime;
+};
+
+/// Some sibling subtrees that are updated by a single task.
+class SceneGraph::UpdateSubtreesCtx
+{
+public:
+	WeakArray<SceneNode*> m_nodes;
+	ThreadHiveSemaphore* m_childrenSem; ///< The parent of the m_nodes finishes when it reaches zero.
+
+	Second m_prevUpdateTime;
+	Second m_crntTime;
+};
+
+class SceneGraph::FinishNodeUpdateCtx
+{
+public:
+	SceneNode* m_node;
+	Timestamp m_componentTimestamp;
+
+	Second m_prevUpdateTime;
+	Second m_crntTime;
+};
+
+class SceneGraph::UpdateSpatialsCtx
+{
+public:
+	SceneGraph* m_scene = nullptr;
+	Atomic<U32> m_crntIdx = {0};
 
 	Second m_prevUpdateTime;
 	Second m_crntTime;
@@ -39,6 +88,13 @@ SceneGraph::SceneGraph()
 
 SceneGraph::~SceneGraph()
 {
+	// The nodes own physics objects
+	if(m_asyncPhysics)
+	{
+		Error err = m_physics->waitUpdate();
+		(void)err;
+	}
+
 	Error err = iterateSceneNodes([&](SceneNode& s) -> Error {
 		s.setMarkedForDeletion();
 		return Error::NONE;
@@ -51,6 +107,17 @@ SceneGraph::~SceneGraph()
 	{
 		m_alloc.deleteInstance(m_octree);
 	}
+
+	if(m_bvh)
+	{
+		m_alloc.deleteInstance(m_bvh);
+	}
+
+	m_updatedSpatials.destroy(m_alloc);
+	m_spatialsToUpdate.destroy(m_alloc);
+	m_rootsToUpdate.destroy(m_alloc);
+	m_everyFrameNodes.destroy(m_alloc);
+	m_occluders.destroy(m_alloc);
 }
 
 Error SceneGraph::init(AllocAlignedCallback allocCb, void* allocCbData, ThreadHive* threadHive,
@@ -68,16 +135,37 @@ Error SceneGraph::init(AllocAlignedCallback allocCb, void* allocCbData, ThreadHi
 	m_alloc = SceneAllocator<U8>(allocCb, allocCbData);
 	m_frameAlloc = SceneFrameAllocator<U8>(allocCb, allocCbData, 1 * 1024 * 1024);
 
+	m_asyncPhysics = config.getNumberU8("scene_asyncPhysics");
+
+	// Component pools. The move and spatial components are the most common and the update touches them the most
+	m_componentPools[SceneComponentType::MOVE].init(m_alloc, sizeof(MoveComponent), alignof(MoveComponent));
+	const PtrSize spatialSize = max(sizeof(SpatialComponent), sizeof(ObbSpatialComponent));
+	const U32 spatialAlignment = U32(max(alignof(SpatialComponent), alignof(ObbSpatialComponent)));
+	m_componentPools[SceneComponentType::SPATIAL].init(m_alloc, spatialSize, spatialAlignment);
+
 	// Limits
 	m_limits.m_earlyZDistance = config.getNumberF32("scene_earlyZDistance");
 	m_limits.m_reflectionProbeEffectiveDistance = config.getNumberF32("scene_reflectionProbeEffectiveDistance");
 	m_limits.m_reflectionProbeShadowEffectiveDistance =
 		config.getNumberF32("scene_reflectionProbeShadowEffectiveDistance");
+	ANKI_ASSERT(m_limits.m_lodScreenSizes.getSize() == 2);
+	m_limits.m_lodScreenSizes[0] = config.getNumberF32("scene_lodScreenSize0");
+	m_limits.m_lodScreenSizes[1] = config.getNumberF32("scene_lodScreenSize1");
+	m_limits.m_lodHysteresis = config.getNumberF32("scene_lodHysteresis");
 
 	ANKI_CHECK(m_events.init(this));
 
-	m_octree = m_alloc.newInstance<Octree>(m_alloc);
-	m_octree->init(m_sceneMin, m_sceneMax, 5); // TODO
+	if(config.getNumberU8("scene_bvh"))
+	{
+		m_bvh = m_alloc.newInstance<Bvh>(m_alloc);
+		m_bvh->init(config.getNumberF32("scene_bvhFatMargin"));
+	}
+	else
+	{
+		m_octree = m_alloc.newInstance<Octree>(m_alloc);
+		m_octree->init(m_sceneMin, m_sceneMax, 5, config.getNumberF32("scene_octreeLooseness")); // TODO
+		m_octree->setCompactTraversal(config.getNumberU8("scene_octreeCompactTraversal"));
+	}
 
 	// Init the default main camera
 	ANKI_CHECK(newSceneNode<PerspectiveCameraNode>("mainCamera", m_defaultMainCam));
@@ -112,15 +200,109 @@ Error SceneGraph::registerNode(SceneNode* node)
 	m_nodes.pushBack(node);
 	++m_nodesCount;
 
+	// Update it at least once and keep updating the ones that can't tell when they change
+	node->m_registered = true;
+	updateEveryFrameNodes(*node);
+
+	// Keep the occluders in a list
+	if(node->getComponentTypeMask() & getSceneComponentTypeBit(SceneComponentType::OCCLUDER))
+	{
+		ANKI_CHECK(node->iterateComponentsOfType<OccluderComponent>([&](OccluderComponent& occluder) -> Error {
+			addOccluder(occluder);
+			return Error::NONE;
+		}));
+	}
+
+	node->markForUpdate();
+
 	return Error::NONE;
 }
 
+void SceneGraph::registerComponent(SceneNode& node, SceneComponent& comp)
+{
+	ANKI_ASSERT(node.m_registered);
+
+	updateEveryFrameNodes(node);
+
+	if(comp.getType() == SceneComponentType::OCCLUDER)
+	{
+		addOccluder(static_cast<OccluderComponent&>(comp));
+	}
+
+	// The new component needs an update
+	node.markForUpdate();
+}
+
+void SceneGraph::updateEveryFrameNodes(SceneNode& node)
+{
+	const Bool everyFrame = node.m_registered
+							&& (node.getUpdateEveryFrame() || (node.getComponentTypeMask() & EVERY_FRAME_COMPONENTS));
+	const Bool listed = node.m_everyFrameNodeIdx != MAX_U32;
+
+	if(everyFrame && !listed)
+	{
+		node.m_everyFrameNodeIdx = m_everyFrameNodes.getSize();
+		m_everyFrameNodes.emplaceBack(m_alloc, &node);
+	}
+	else if(!everyFrame && listed)
+	{
+		ANKI_ASSERT(m_everyFrameNodes[node.m_everyFrameNodeIdx] == &node);
+		SceneNode* last = m_everyFrameNodes.getBack();
+		m_everyFrameNodes[node.m_everyFrameNodeIdx] = last;
+		last->m_everyFrameNodeIdx = node.m_everyFrameNodeIdx;
+		m_everyFrameNodes.popBack(m_alloc);
+		node.m_everyFrameNodeIdx = MAX_U32;
+	}
+}
+
+void SceneGraph::addOccluder(OccluderComponent& occluder)
+{
+	ANKI_ASSERT(occluder.m_occluderIdx == MAX_U32);
+	occluder.m_occluderIdx = m_occluders.getSize();
+	m_occluders.emplaceBack(m_alloc, &occluder);
+}
+
+void SceneGraph::removeOccluder(OccluderComponent& occluder)
+{
+	ANKI_ASSERT(m_occluders[occluder.m_occluderIdx] == &occluder);
+	OccluderComponent* last = m_occluders.getBack();
+	m_occluders[occluder.m_occluderIdx] = last;
+	last->m_occluderIdx = occluder.m_occluderIdx;
+	m_occluders.popBack(m_alloc);
+	occluder.m_occluderIdx = MAX_U32;
+}
+
 void SceneGraph::unregisterNode(SceneNode* node)
 {
 	// Remove from the graph
 	m_nodes.erase(node);
 	--m_nodesCount;
 
+	// Remove from the update lists
+	node->m_registered = false;
+	updateEveryFrameNodes(*node);
+
+	if(node->getComponentTypeMask() & getSceneComponentTypeBit(SceneComponentType::OCCLUDER))
+	{
+		Error err = node->iterateComponentsOfType<OccluderComponent>([&](OccluderComponent& occluder) -> Error {
+			removeOccluder(occluder);
+			return Error::NONE;
+		});
+		(void)err;
+	}
+
+	if(node->m_inUpdateList.load())
+	{
+		for(U32 i = 0; i < m_rootsToUpdateCount; ++i)
+		{
+			if(m_rootsToUpdate[i] == node)
+			{
+				m_rootsToUpdate[i] = m_rootsToUpdate[--m_rootsToUpdateCount];
+				break;
+			}
+		}
+	}
+
 	if(m_mainCam != m_defaultMainCam && m_mainCam == node)
 	{
 		m_mainCam = m_defaultMainCam;
@@ -184,12 +366,27 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 
 	m_stats.m_updateTime = HighRezTimer::getCurrentTime();
 
+	m_prevTimestamp = m_timestamp;
 	m_timestamp = *m_globalTimestamp;
 	ANKI_ASSERT(m_timestamp > 0);
+	m_updatedSpatialCount = 0;
 
 	// Reset the framepool
 	m_frameAlloc.getMemoryPool().reset();
 
+	// The physics step of the previous frame has to finish before the nodes touch their physics objects. The bodies
+	// will see the results of that step in this update
+	if(m_asyncPhysics)
+	{
+		ANKI_CHECK(m_physics->waitUpdate());
+
+		// Someone else may have waited already so get the times from the PhysicsWorld
+		m_stats.m_physicsUpdate = m_physics->getLastUpdateDuration();
+		m_stats.m_physicsWait = m_physics->getLastWaitDuration();
+		ANKI_TRACE_INC_COUNTER(SCENE_PHYSICS_OVERLAP_US,
+							   U64(max(0.0, m_stats.m_physicsUpdate - m_stats.m_physicsWait) * 1000000.0));
+	}
+
 	// Delete stuff
 	{
 		ANKI_TRACE_SCOPED_EVENT(SCENE_MARKED_FOR_DELETION);
@@ -198,22 +395,24 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 	}
 
 	// Update
+	if(!m_asyncPhysics)
 	{
 		ANKI_TRACE_SCOPED_EVENT(SCENE_PHYSICS_UPDATE);
 		m_stats.m_physicsUpdate = HighRezTimer::getCurrentTime();
 		m_physics->update(crntTime - prevUpdateTime);
 		m_stats.m_physicsUpdate = HighRezTimer::getCurrentTime() - m_stats.m_physicsUpdate;
+		m_stats.m_physicsWait = 0.0;
 	}
 
 	{
 		ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
 		ANKI_CHECK(m_events.updateAllEvents(prevUpdateTime, crntTime));
 
-		// Then the rest
+		// Then the rest. Only the hierarchies that something marked for update are visited
 		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> tasks;
 		UpdateSceneNodesCtx updateCtx;
 		updateCtx.m_scene = this;
-		updateCtx.m_crntNode = m_nodes.getBegin();
+		updateCtx.m_roots = gatherRootsToUpdate();
 		updateCtx.m_prevUpdateTime = prevUpdateTime;
 		updateCtx.m_crntTime = crntTime;
 
@@ -233,6 +432,48 @@ Error SceneGraph::update(Second prevUpdateTime, Second crntTime)
 		m_threadHive->waitAllTasks();
 	}
 
+	{
+		ANKI_TRACE_SCOPED_EVENT(SCENE_SPATIALS_UPDATE);
+
+		// The spatials go last because the other components of the nodes are the ones that mark them for update
+		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> tasks;
+		UpdateSpatialsCtx updateCtx;
+		updateCtx.m_scene = this;
+		updateCtx.m_prevUpdateTime = prevUpdateTime;
+		updateCtx.m_crntTime = crntTime;
+
+		for(U i = 0; i < m_threadHive->getThreadCount(); i++)
+		{
+			tasks[i] = ANKI_THREAD_HIVE_TASK(
+				{
+					if(self->m_scene->updateSpatials(*self))
+					{
+						ANKI_SCENE_LOGF("Will not recover");
+					}
+				},
+				&updateCtx, nullptr, nullptr);
+		}
+
+		m_threadHive->submitTasks(&tasks[0], m_threadHive->getThreadCount());
+		m_threadHive->waitAllTasks();
+		m_spatialsToUpdateCount = 0;
+
+		// Some spatials got updated without the rest of their node so bump the node timestamps. Do it here and not
+		// in the tasks because a node may have spatials in more than one chunk
+		for(U32 i = 0; i < m_updatedSpatialCount; ++i)
+		{
+			m_updatedSpatials[i]->getSceneNode().setComponentMaxTimestamp(m_timestamp);
+		}
+	}
+
+	if(m_asyncPhysics)
+	{
+		// Step while the frame renders. The physics thread writes to the bodies so their users have to call
+		// PhysicsWorld::waitUpdate() first, like App::mainLoop and the next update do. The trigger contacts are
+		// dispatched by waitUpdate() in the thread that calls it
+		m_physics->startUpdate(crntTime - prevUpdateTime);
+	}
+
 	m_stats.m_updateTime = HighRezTimer::getCurrentTime() - m_stats.m_updateTime;
 	return Error::NONE;
 }
@@ -244,7 +485,7 @@ void SceneGraph::doVisibilityTests(RenderQueue& rqueue)
 	m_stats.m_visibilityTestsTime = HighRezTimer::getCurrentTime() - m_stats.m_visibilityTestsTime;
 }
 
-Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
+Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node, ThreadHiveSemaphore** parentSem)
 {
 	ANKI_TRACE_INC_COUNTER(SCENE_NODES_UPDATED, 1);
 
@@ -253,6 +494,11 @@ Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
 	// Components update
 	Timestamp componentTimestamp = 0;
 	err = node.iterateComponents([&](SceneComponent& comp) -> Error {
+		if(getSceneComponentTypeBit(comp.getType()) & SEPARATELY_UPDATED_COMPONENTS)
+		{
+			return Error::NONE;
+		}
+
 		Bool updated = false;
 		Error e = comp.update(node, prevTime, crntTime, updated);
 
@@ -267,46 +513,402 @@ Error SceneGraph::updateNode(Second prevTime, Second crntTime, SceneNode& node)
 	});
 
 	// Update children
+	ThreadHiveSemaphore* childrenSem = nullptr;
 	if(!err)
 	{
+		if(updateChildrenInParallel(prevTime, crntTime, node, componentTimestamp, parentSem))
+		{
+			// The tasks will finish the update of this node
+			return Error::NONE;
+		}
+
 		err = node.visitChildrenMaxDepth(
-			0, [&](SceneNode& child) -> Error { return updateNode(prevTime, crntTime, child); });
+			0, [&](SceneNode& child) -> Error { return updateNode(prevTime, crntTime, child, &childrenSem); });
+	}
+
+	if(!err && childrenSem)
+	{
+		// Some descendants split their children to tasks. Finish this node after them
+		submitFinishNodeUpdate(prevTime, crntTime, node, componentTimestamp, childrenSem, parentSem);
+		return Error::NONE;
+	}
+
+	if(!err)
+	{
+		err = finishNodeUpdate(prevTime, crntTime, node, componentTimestamp);
+	}
+
+	return err;
+}
+
+Error SceneGraph::finishNodeUpdate(Second prevTime, Second crntTime, SceneNode& node, Timestamp componentTimestamp)
+{
+	Error err = Error::NONE;
+
+	if(componentTimestamp != 0)
+	{
+		node.setComponentMaxTimestamp(componentTimestamp);
+
+		// Visit it in the next frame as well because some components compare with the values of the previous frame
+		// (eg the previous world transform of the MoveComponent)
+		node.markForUpdate();
+
+		// Inform the visibility caches
+		err = node.iterateComponentsOfType<SpatialComponent>([&](SpatialComponent& sp) -> Error {
+			node.getSceneGraph().addUpdatedSpatial(&sp);
+			return Error::NONE;
+		});
+	}
+	else
+	{
+		// No components or nothing updated, don't change the timestamp
 	}
 
 	// Frame update
 	if(!err)
 	{
-		if(componentTimestamp != 0)
+		err = node.frameUpdate(prevTime, crntTime);
+	}
+
+	return err;
+}
+
+/// Count the nodes of a subtree. Stop when the count reaches maxCount.
+static U32 countSubtreeNodes(SceneNode& root, U32 maxCount)
+{
+	U32 count = 1;
+	Error err = root.visitChildren([&](SceneNode&) -> Error {
+		++count;
+		return (count < maxCount) ? Error::NONE : Error::FUNCTION_FAILED; // Not an error, it just stops the walk
+	});
+	(void)err;
+	return count;
+}
+
+void SceneGraph::submitFinishNodeUpdate(Second prevTime, Second crntTime, SceneNode& node,
+										Timestamp componentTimestamp, ThreadHiveSemaphore* waitSem,
+										ThreadHiveSemaphore** parentSem)
+{
+	ThreadHive& hive = node.getSceneGraph().getThreadHive();
+
+	// Hold the parent back until this node finishes. Roots have no parent to hold
+	ThreadHiveSemaphore* signalSem = nullptr;
+	if(parentSem)
+	{
+		if(*parentSem)
 		{
-			node.setComponentMaxTimestamp(componentTimestamp);
+			(*parentSem)->increaseSemaphore(1);
 		}
 		else
 		{
-			// No components or nothing updated, don't change the timestamp
+			*parentSem = hive.newSemaphore(1);
 		}
 
-		err = node.frameUpdate(prevTime, crntTime);
+		signalSem = *parentSem;
 	}
 
-	return err;
+	FinishNodeUpdateCtx* finishCtx = node.getFrameAllocator().newInstance<FinishNodeUpdateCtx>();
+	finishCtx->m_node = &node;
+	finishCtx->m_componentTimestamp = componentTimestamp;
+	finishCtx->m_prevUpdateTime = prevTime;
+	finishCtx->m_crntTime = crntTime;
+
+	ThreadHiveTask finishTask = ANKI_THREAD_HIVE_TASK(
+		{
+			if(finishNodeUpdate(self->m_prevUpdateTime, self->m_crntTime, *self->m_node,
+								self->m_componentTimestamp))
+			{
+				ANKI_SCENE_LOGF("Will not recover");
+			}
+		},
+		finishCtx, waitSem, signalSem);
+	hive.submitTasks(&finishTask, 1);
+}
+
+Bool SceneGraph::updateChildrenInParallel(Second prevTime, Second crntTime, SceneNode& node,
+										  Timestamp componentTimestamp, ThreadHiveSemaphore** parentSem)
+{
+	ThreadHive& hive = node.getSceneGraph().getThreadHive();
+	if(hive.getThreadCount() < 2)
+	{
+		return false;
+	}
+
+	U32 childCount = 0;
+	Error err = node.visitChildrenMaxDepth(0, [&](SceneNode& child) -> Error {
+		++childCount;
+		return Error::NONE;
+	});
+	(void)err;
+
+	if(childCount < 2)
+	{
+		// Chains can't be split
+		return false;
+	}
+
+	// Split the children to groups of subtrees with enough nodes to be worth a task
+	U32 groupCount = 0;
+	U32 groupNodeCount = 0;
+	err = node.visitChildrenMaxDepth(0, [&](SceneNode& child) -> Error {
+		groupNodeCount += countSubtreeNodes(child, NODES_PER_SUBTREE_TASK);
+		if(groupNodeCount >= NODES_PER_SUBTREE_TASK)
+		{
+			++groupCount;
+			groupNodeCount = 0;
+		}
+		return Error::NONE;
+	});
+	(void)err;
+
+	if(groupNodeCount > 0)
+	{
+		++groupCount;
+	}
+
+	if(groupCount < 2)
+	{
+		return false;
+	}
+
+	ANKI_TRACE_INC_COUNTER(SCENE_SUBTREE_TASKS, groupCount);
+
+	// Populate the groups. The memory lives until the end of the frame
+	SceneFrameAllocator<U8> alloc = node.getFrameAllocator();
+	SceneNode** children = alloc.newArray<SceneNode*>(childCount);
+	UpdateSubtreesCtx* groups = alloc.newArray<UpdateSubtreesCtx>(groupCount);
+
+	U32 childIdx = 0;
+	U32 groupIdx = 0;
+	U32 groupFirstChild = 0;
+	groupNodeCount = 0;
+	err = node.visitChildrenMaxDepth(0, [&](SceneNode& child) -> Error {
+		children[childIdx++] = &child;
+		groupNodeCount += countSubtreeNodes(child, NODES_PER_SUBTREE_TASK);
+		if(groupNodeCount >= NODES_PER_SUBTREE_TASK || childIdx == childCount)
+		{
+			UpdateSubtreesCtx& group = groups[groupIdx++];
+			group.m_nodes = WeakArray<SceneNode*>(children + groupFirstChild, childIdx - groupFirstChild);
+			group.m_prevUpdateTime = prevTime;
+			group.m_crntTime = crntTime;
+
+			groupFirstChild = childIdx;
+			groupNodeCount = 0;
+		}
+		return Error::NONE;
+	});
+	(void)err;
+	ANKI_ASSERT(groupIdx == groupCount);
+
+	// Submit the tasks. The node needs to finish after all the children. The children that split their own children
+	// increase the semaphore from inside the group tasks so it can't reach zero before their subtrees finish
+	ThreadHiveSemaphore* sem = hive.newSemaphore(groupCount);
+	for(U32 i = 0; i < groupCount; ++i)
+	{
+		groups[i].m_childrenSem = sem;
+
+		ThreadHiveTask task = ANKI_THREAD_HIVE_TASK(
+			{
+				for(SceneNode* subtreeRoot : self->m_nodes)
+				{
+					ThreadHiveSemaphore* childrenSem = self->m_childrenSem;
+					if(updateNode(self->m_prevUpdateTime, self->m_crntTime, *subtreeRoot, &childrenSem))
+					{
+						ANKI_SCENE_LOGF("Will not recover");
+					}
+					ANKI_ASSERT(childrenSem == self->m_childrenSem);
+				}
+			},
+			&groups[i], nullptr, sem);
+
+		hive.submitTasks(&task, 1);
+	}
+
+	submitFinishNodeUpdate(prevTime, crntTime, node, componentTimestamp, sem, parentSem);
+
+	return true;
+}
+
+void SceneGraph::markNodeForUpdate(SceneNode& node)
+{
+	// Updating the root updates the whole hierarchy
+	SceneNode* root = &node;
+	while(root->getParent())
+	{
+		root = root->getParent();
+	}
+
+	// Load first because the same roots are marked many times and the exchange would bounce the cache line around
+	if(root->m_inUpdateList.load() || root->m_inUpdateList.exchange(1))
+	{
+		return;
+	}
+
+	LockGuard<SpinLock> lock(m_rootsToUpdateLock);
+
+	if(m_rootsToUpdateCount == m_rootsToUpdate.getSize())
+	{
+		m_rootsToUpdate.emplaceBack(m_alloc, root);
+	}
+	else
+	{
+		m_rootsToUpdate[m_rootsToUpdateCount] = root;
+	}
+
+	++m_rootsToUpdateCount;
+}
+
+WeakArray<SceneNode*> SceneGraph::gatherRootsToUpdate()
+{
+	for(SceneNode* node : m_everyFrameNodes)
+	{
+		markNodeForUpdate(*node);
+	}
+
+	ANKI_TRACE_INC_COUNTER(SCENE_ROOTS_TO_UPDATE, m_rootsToUpdateCount);
+
+	if(m_rootsToUpdateCount == 0)
+	{
+		return WeakArray<SceneNode*>();
+	}
+
+	// Move them to the frame memory because the nodes will be marked again for the next frame during the update
+	WeakArray<SceneNode*> roots(m_frameAlloc.newArray<SceneNode*>(m_rootsToUpdateCount), m_rootsToUpdateCount);
+	for(U32 i = 0; i < m_rootsToUpdateCount; ++i)
+	{
+		roots[i] = m_rootsToUpdate[i];
+		roots[i]->m_inUpdateList.store(0);
+	}
+
+	m_rootsToUpdateCount = 0;
+	return roots;
+}
+
+void SceneGraph::addUpdatedSpatial(SpatialComponent* sp)
+{
+	ANKI_ASSERT(sp);
+	LockGuard<SpinLock> lock(m_updatedSpatialsLock);
+
+	if(m_updatedSpatialCount == m_updatedSpatials.getSize())
+	{
+		m_updatedSpatials.emplaceBack(m_alloc, sp);
+	}
+	else
+	{
+		m_updatedSpatials[m_updatedSpatialCount] = sp;
+	}
+
+	++m_updatedSpatialCount;
+}
+
+void SceneGraph::markSpatialForUpdate(SpatialComponent& sp)
+{
+	LockGuard<SpinLock> lock(m_spatialsToUpdateLock);
+
+	sp.m_spatialsToUpdateIdx = m_spatialsToUpdateCount;
+	if(m_spatialsToUpdateCount == m_spatialsToUpdate.getSize())
+	{
+		m_spatialsToUpdate.emplaceBack(m_alloc, &sp);
+	}
+	else
+	{
+		m_spatialsToUpdate[m_spatialsToUpdateCount] = &sp;
+	}
+
+	++m_spatialsToUpdateCount;
+}
+
+void SceneGraph::removeSpatialToUpdate(SpatialComponent& sp)
+{
+	LockGuard<SpinLock> lock(m_spatialsToUpdateLock);
+
+	ANKI_ASSERT(sp.m_spatialsToUpdateIdx < m_spatialsToUpdateCount);
+	ANKI_ASSERT(m_spatialsToUpdate[sp.m_spatialsToUpdateIdx] == &sp);
+	SpatialComponent* last = m_spatialsToUpdate[--m_spatialsToUpdateCount];
+	m_spatialsToUpdate[sp.m_spatialsToUpdateIdx] = last;
+	last->m_spatialsToUpdateIdx = sp.m_spatialsToUpdateIdx;
+	sp.m_spatialsToUpdateIdx = MAX_U32;
+}
+
+Error SceneGraph::updateSpatials(UpdateSpatialsCtx& ctx)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_SPATIALS_UPDATE);
+
+	U32 begin;
+	while((begin = ctx.m_crntIdx.fetchAdd(SPATIALS_PER_UPDATE_TASK)) < m_spatialsToUpdateCount)
+	{
+		const U32 end = min(begin + SPATIALS_PER_UPDATE_TASK, m_spatialsToUpdateCount);
+		for(U32 i = begin; i < end; ++i)
+		{
+			SpatialComponent& sp = *m_spatialsToUpdate[i];
+			sp.m_spatialsToUpdateIdx = MAX_U32;
+
+			SceneNode& node = sp.getSceneNode();
+			Bool updated = false;
+			ANKI_CHECK(sp.update(node, ctx.m_prevUpdateTime, ctx.m_crntTime, updated));
+			ANKI_ASSERT(updated);
+
+			sp.setTimestamp(m_timestamp);
+
+			// The spatials of the nodes that had other components updated are already in the list
+			if(node.getComponentMaxTimestamp() != m_timestamp)
+			{
+				addUpdatedSpatial(&sp);
+			}
+		}
+
+		ANKI_TRACE_INC_COUNTER(SCENE_SPATIALS_UPDATED, end - begin);
+	}
+
+	return Error::NONE;
+}
+
+void* SceneGraph::allocateComponentMemory(SceneComponentType type, PtrSize size, U32 alignment, Bool& pooledMemory)
+{
+	// Derived components that don't fit in the pool of their type go to the heap
+	SceneComponentPool& pool = m_componentPools[type];
+	void* mem = (pool.isInitialized()) ? pool.allocate(size, alignment) : nullptr;
+	pooledMemory = mem != nullptr;
+
+	if(!pooledMemory)
+	{
+		mem = m_alloc.getMemoryPool().allocate(size, alignment);
+	}
+
+	return mem;
+}
+
+void SceneGraph::deleteComponent(SceneComponent* comp)
+{
+	ANKI_ASSERT(comp);
+	const SceneComponentType type = comp->getType();
+	const Bool pooledMemory = comp->m_pooledMemory;
+	comp->~SceneComponent();
+
+	if(pooledMemory)
+	{
+		m_componentPools[type].free(comp);
+	}
+	else
+	{
+		m_alloc.getMemoryPool().free(comp);
+	}
 }
 
 Error SceneGraph::updateNodes(UpdateSceneNodesCtx& ctx) const
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_NODES_UPDATE);
 
-	IntrusiveList<SceneNode>::ConstIterator end = m_nodes.getEnd();
-
 	Bool quit = false;
 	Error err = Error::NONE;
 	while(!quit && !err)
 	{
-		// Fetch a batch of scene nodes that don't have parent
+		// Fetch a batch of scene nodes that don't have parent. Some roots may have got a parent after they were marked
 		Array<SceneNode*, NODE_UPDATE_BATCH> batch;
 		U batchSize = 0;
 
 		{
-			LockGuard<SpinLock> lock(ctx.m_crntNodeLock);
+			LockGuard<SpinLock> lock(ctx.m_crntRootLock);
 
 			while(1)
 			{
@@ -315,26 +917,26 @@ Error SceneGraph::updateNodes(UpdateSceneNodesCtx& ctx) const
 					break;
 				}
 
-				if(ctx.m_crntNode == end)
+				if(ctx.m_crntRoot == ctx.m_roots.getSize())
 				{
 					quit = true;
 					break;
 				}
 
-				SceneNode& node = *ctx.m_crntNode;
+				SceneNode& node = *ctx.m_roots[ctx.m_crntRoot];
 				if(node.getParent() == nullptr)
 				{
 					batch[batchSize++] = &node;
 				}
 
-				++ctx.m_crntNode;
+				++ctx.m_crntRoot;
 			}
 		}
 
 		// Process nodes
 		for(U i = 0; i < batchSize && !err; ++i)
 		{
-			err = updateNode(ctx.m_prevUpdateTime, ctx.m_crntTime, *batch[i]);
+			err = updateNode(ctx.m_prevUpdateTime, ctx.m_crntTime, *batch[i], nullptr);
 		}
 	}
 
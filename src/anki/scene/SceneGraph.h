@@ -7,12 +7,15 @@
 
 #include <anki/scene/Common.h>
 #include <anki/scene/SceneNode.h>
+#include <anki/scene/SceneComponentPool.h>
 #include <anki/Math.h>
 #include <anki/util/Singleton.h>
 #include <anki/util/HighRezTimer.h>
 #include <anki/util/HashMap.h>
 #include <anki/core/App.h>
 #include <anki/scene/events/EventManager.h>
+#include <anki/scene/Bvh.h>
+#include <anki/resource/Common.h>
 
 namespace anki
 {
@@ -25,7 +28,6 @@ class Input;
 class ConfigSet;
 class PerspectiveCameraNode;
 class UpdateSceneNodesCtx;
-class Octree;
 
 /// @addtogroup scene
 /// @{
@@ -37,6 +39,7 @@ public:
 	Second m_updateTime ANKI_DEBUG_CODE(= 0.0);
 	Second m_visibilityTestsTime ANKI_DEBUG_CODE(= 0.0);
 	Second m_physicsUpdate ANKI_DEBUG_CODE(= 0.0);
+	Second m_physicsWait ANKI_DEBUG_CODE(= 0.0); ///< How long the frame waited for the asynchronous physics step.
 };
 
 /// SceneGraph limits.
@@ -46,12 +49,17 @@ public:
 	F32 m_earlyZDistance = -1.0f; ///< Objects with distance lower than that will be used in early Z.
 	F32 m_reflectionProbeEffectiveDistance = -1.0f; ///< How far reflection probes can look.
 	F32 m_reflectionProbeShadowEffectiveDistance = -1.0f; ///< How far to render shadows for reflection probes.
+
+	/// The size of an object on the screen (a fraction of the screen height) below which it switches to the next LOD.
+	Array<F32, MAX_LOD_COUNT - 1> m_lodScreenSizes = {{-1.0f, -1.0f}};
+	F32 m_lodHysteresis = -1.0f; ///< How far past a threshold an object has to go to change LOD.
 };
 
 /// The scene graph that  all the scene entities
 class SceneGraph
 {
 	friend class SceneNode;
+	friend class SpatialComponent;
 	friend class UpdateSceneNodesTask;
 
 public:
@@ -68,6 +76,12 @@ public:
 		return m_timestamp;
 	}
 
+	/// The timestamp of the previous update.
+	Timestamp getPreviousGlobalTimestamp() const
+	{
+		return m_prevTimestamp;
+	}
+
 	/// @note Return a copy
 	SceneAllocator<U8> getAllocator() const
 	{
@@ -223,11 +237,114 @@ public:
 		return *m_octree;
 	}
 
+	Bvh& getBvh()
+	{
+		ANKI_ASSERT(m_bvh);
+		return *m_bvh;
+	}
+
+	/// Place a placeable in the Octree or the Bvh, whatever the scene uses.
+	void placeSpatial(const Aabb& volume, OctreePlaceable* placeable, Bool updateActualSceneBounds)
+	{
+		if(m_bvh)
+		{
+			m_bvh->place(volume, placeable, updateActualSceneBounds);
+		}
+		else
+		{
+			m_octree->place(volume, placeable, updateActualSceneBounds);
+		}
+	}
+
+	/// Remove a placeable from the Octree or the Bvh.
+	void removeSpatial(OctreePlaceable& placeable)
+	{
+		if(m_bvh)
+		{
+			m_bvh->remove(placeable);
+		}
+		else
+		{
+			m_octree->remove(placeable);
+		}
+
+		m_spatialRemovalTimestamp = m_timestamp;
+	}
+
+	/// The last time a spatial was removed from the scene.
+	Timestamp getSpatialRemovalTimestamp() const
+	{
+		return m_spatialRemovalTimestamp;
+	}
+
+	/// Get the spatial components of the nodes that had some component updated in this frame.
+	ConstWeakArray<SpatialComponent*> getUpdatedSpatials() const
+	{
+		return (m_updatedSpatialCount) ? ConstWeakArray<SpatialComponent*>(&m_updatedSpatials[0], m_updatedSpatialCount)
+									   : ConstWeakArray<SpatialComponent*>();
+	}
+
+	/// Get the OccluderComponents of all the nodes.
+	ConstWeakArray<OccluderComponent*> getOccluders() const
+	{
+		return (m_occluders.getSize()) ? ConstWeakArray<OccluderComponent*>(&m_occluders[0], m_occluders.getSize())
+									   : ConstWeakArray<OccluderComponent*>();
+	}
+
+	/// Walk the Octree or the Bvh.
+	/// @copydetails Octree::walkTree
+	template<typename TTestAabbFunc, typename TNewPlaceableFunc>
+	void walkSpatialTree(U32 testId, TTestAabbFunc testFunc, TNewPlaceableFunc newPlaceableFunc)
+	{
+		if(m_bvh)
+		{
+			m_bvh->walkTree(testId, testFunc, newPlaceableFunc);
+		}
+		else
+		{
+			m_octree->walkTree(testId, testFunc, newPlaceableFunc);
+		}
+	}
+
+	/// Cast rays against the Octree or the Bvh.
+	/// @copydetails Octree::rayCast
+	template<typename TExactHitFunc>
+	void rayCastSpatialTree(ConstWeakArray<Ray> rays, F32 maxDistance, TExactHitFunc exactHitFunc,
+							WeakArray<OctreeRayHit> hits)
+	{
+		if(m_bvh)
+		{
+			m_bvh->rayCast(rays, maxDistance, exactHitFunc, hits);
+		}
+		else
+		{
+			m_octree->rayCast(rays, maxDistance, exactHitFunc, hits);
+		}
+	}
+
+	/// Get the bounds of the scene as calculated by the objects that were placed in the Octree or the Bvh.
+	void getActualSceneBounds(Vec3& min, Vec3& max) const
+	{
+		if(m_bvh)
+		{
+			m_bvh->getActualSceneBounds(min, max);
+		}
+		else
+		{
+			m_octree->getActualSceneBounds(min, max);
+		}
+	}
+
 private:
 	class UpdateSceneNodesCtx;
+	class UpdateSubtreesCtx;
+	class FinishNodeUpdateCtx;
+	class UpdateSpatialsCtx;
 
 	const Timestamp* m_globalTimestamp = nullptr;
 	Timestamp m_timestamp = 0; ///< Cached timestamp
+	Timestamp m_prevTimestamp = 0;
+	Timestamp m_spatialRemovalTimestamp = 0;
 
 	// Sub-systems
 	ThreadHive* m_threadHive = nullptr;
@@ -250,15 +367,41 @@ private:
 
 	EventManager m_events;
 
-	Octree* m_octree = nullptr;
+	/// Storage for the component types that are plenty so they are close in memory and cheap to allocate.
+	Array<SceneComponentPool, U32(SceneComponentType::COUNT)> m_componentPools;
+
+	Octree* m_octree = nullptr; ///< Only one of m_octree and m_bvh is present.
+	Bvh* m_bvh = nullptr;
+
+	DynamicArray<SpatialComponent*> m_updatedSpatials; ///< Its size only grows. The valid count is the one below.
+	U32 m_updatedSpatialCount = 0;
+	SpinLock m_updatedSpatialsLock;
+
+	/// The spatials that got marked for update. Its size only grows. The valid count is the one below.
+	DynamicArray<SpatialComponent*> m_spatialsToUpdate;
+	U32 m_spatialsToUpdateCount = 0;
+	SpinLock m_spatialsToUpdateLock;
+
+	/// The roots of the hierarchies that got marked for update. Its size only grows. The valid count is the one below.
+	DynamicArray<SceneNode*> m_rootsToUpdate;
+	U32 m_rootsToUpdateCount = 0;
+	SpinLock m_rootsToUpdateLock;
+
+	DynamicArray<SceneNode*> m_everyFrameNodes; ///< The nodes that are updated even if nothing marks them.
+
+	DynamicArray<OccluderComponent*> m_occluders; ///< All the occluders so the visibility doesn't walk all the nodes.
 
 	Vec3 m_sceneMin = {-1000.0f, -200.0f, -1000.0f};
 	Vec3 m_sceneMax = {1000.0f, 200.0f, 1000.0f};
 
 	Atomic<U32> m_objectsMarkedForDeletionCount = {0};
 
+	Bool m_asyncPhysics = false; ///< The physics step overlaps with the rendering of the frame.
+
 	Atomic<U64> m_nodesUuid = {1};
 
+	U32 m_visibilityTestsEpoch = 0;
+
 	SceneGraphLimits m_limits;
 	SceneGraphStats m_stats;
 
@@ -266,11 +409,70 @@ private:
 	ANKI_USE_RESULT Error registerNode(SceneNode* node);
 	void unregisterNode(SceneNode* node);
 
+	/// Put a component that was created after its node got registered in the appropriate containers.
+	void registerComponent(SceneNode& node, SceneComponent& comp);
+
+	/// Put the node in m_everyFrameNodes or take it out depending on its flags and components.
+	void updateEveryFrameNodes(SceneNode& node);
+
+	void addOccluder(OccluderComponent& occluder);
+	void removeOccluder(OccluderComponent& occluder);
+
 	/// Delete the nodes that are marked for deletion
 	void deleteNodesMarkedForDeletion();
 
+	/// @copydoc SceneNode::markForUpdate
+	void markNodeForUpdate(SceneNode& node);
+
+	/// Gather the roots of the hierarchies that will be updated this frame.
+	WeakArray<SceneNode*> gatherRootsToUpdate();
+
 	ANKI_USE_RESULT Error updateNodes(UpdateSceneNodesCtx& ctx) const;
-	ANKI_USE_RESULT static Error updateNode(Second prevTime, Second crntTime, SceneNode& node);
+
+	/// Update a node and its subtree.
+	/// @param[in,out] parentSem If the node finishes its update in another task it holds its parent back with that
+	///                semaphore. It's created if it's nullptr. Pass nullptr for roots.
+	ANKI_USE_RESULT static Error updateNode(Second prevTime, Second crntTime, SceneNode& node,
+											ThreadHiveSemaphore** parentSem);
+
+	/// Update the children of a node in other ThreadHive tasks if there is enough work.
+	/// @return true if the tasks were submitted. The tasks will also call finishNodeUpdate for the node.
+	static Bool updateChildrenInParallel(Second prevTime, Second crntTime, SceneNode& node,
+										 Timestamp componentTimestamp, ThreadHiveSemaphore** parentSem);
+
+	/// Submit a task that calls finishNodeUpdate when waitSem reaches zero.
+	/// @param[in,out] parentSem See updateNode.
+	static void submitFinishNodeUpdate(Second prevTime, Second crntTime, SceneNode& node, Timestamp componentTimestamp,
+									   ThreadHiveSemaphore* waitSem, ThreadHiveSemaphore** parentSem);
+
+	/// The part of the update that has to run after the children of the node are updated.
+	ANKI_USE_RESULT static Error finishNodeUpdate(Second prevTime, Second crntTime, SceneNode& node,
+												  Timestamp componentTimestamp);
+
+	/// @copydoc SpatialComponent::markForUpdate
+	void markSpatialForUpdate(SpatialComponent& sp);
+
+	/// Remove a spatial that gets deleted from the spatials to update.
+	void removeSpatialToUpdate(SpatialComponent& sp);
+
+	/// Update the SpatialComponents that got marked for update.
+	ANKI_USE_RESULT Error updateSpatials(UpdateSpatialsCtx& ctx);
+
+	/// @copydoc SceneNode::allocateComponentMemory
+	void* allocateComponentMemory(SceneComponentType type, PtrSize size, U32 alignment, Bool& pooledMemory);
+	void deleteComponent(SceneComponent* comp);
+
+	void addUpdatedSpatial(SpatialComponent* sp);
+
+	/// Every doVisibilityTests gets a new epoch for its test ids so the spatials don't have to be reset every frame.
+	U32 newVisibilityTestsEpoch()
+	{
+		// Epoch 0 is what OctreePlaceable::reset sets
+		m_visibilityTestsEpoch = (m_visibilityTestsEpoch < MAX_U32 / OctreePlaceable::MAX_TESTS_PER_EPOCH)
+									 ? m_visibilityTestsEpoch + 1
+									 : 1;
+		return m_visibilityTestsEpoch;
+	}
 
 	/// Do visibility tests.
 	static void doVisibilityTests(SceneNode& frustumable, SceneGraph& scene, RenderQueue& rqueue);
@@ -5,6 +5,7 @@
 
 #include <anki/scene/SceneNode.h>
 #include <anki/scene/SceneGraph.h>
+#include <anki/scene/components/MoveComponent.h>
 
 namespace anki
 {
@@ -13,6 +14,11 @@ SceneNode::SceneNode(SceneGraph* scene, CString name)
 	: m_scene(scene)
 	, m_uuid(scene->getNewUuid())
 {
+	for(U8& idx : m_componentIndices)
+	{
+		idx = MAX_U8;
+	}
+
 	if(name)
 	{
 		m_name.create(getAllocator(), name);
@@ -28,7 +34,7 @@ SceneNode::~SceneNode()
 	for(; it != end; ++it)
 	{
 		SceneComponent* comp = *it;
-		alloc.deleteInstance(comp);
+		m_scene->deleteComponent(comp);
 	}
 
 	Base::destroy(alloc);
@@ -53,6 +59,53 @@ void SceneNode::setMarkedForDeletion()
 	(void)err;
 }
 
+void SceneNode::addChild(SceneNode* obj)
+{
+	Base::addChild(getAllocator(), obj);
+	parentChanged(*obj);
+}
+
+void SceneNode::removeChild(SceneNode* obj)
+{
+	Base::removeChild(getAllocator(), obj);
+	parentChanged(*obj);
+}
+
+void SceneNode::parentChanged(SceneNode& child)
+{
+	// The world transform of the child depends on the parent
+	MoveComponent* move = child.tryGetComponent<MoveComponent>();
+	if(move)
+	{
+		move->markForUpdate();
+	}
+
+	child.markForUpdate();
+}
+
+void SceneNode::markForUpdate()
+{
+	m_scene->markNodeForUpdate(*this);
+}
+
+void SceneNode::setUpdateEveryFrame(Bool updateEveryFrame)
+{
+	m_updateEveryFrame = updateEveryFrame;
+
+	if(m_registered)
+	{
+		m_scene->updateEveryFrameNodes(*this);
+	}
+}
+
+void SceneNode::componentAdded(SceneComponent& comp)
+{
+	if(m_registered)
+	{
+		m_scene->registerComponent(*this, comp);
+	}
+}
+
 Timestamp SceneNode::getGlobalTimestamp() const
 {
 	return m_scene->getGlobalTimestamp();
@@ -70,6 +123,11 @@ SceneFrameAllocator<U8> SceneNode::getFrameAllocator() const
 	return m_scene->getFrameAllocator();
 }
 
+void* SceneNode::allocateComponentMemory(SceneComponentType type, PtrSize size, U32 alignment, Bool& pooledMemory)
+{
+	return m_scene->allocateComponentMemory(type, size, alignment, pooledMemory);
+}
+
 ResourceManager& SceneNode::getResourceManager()
 {
 	return m_scene->getResourceManager();
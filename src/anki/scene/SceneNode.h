@@ -11,6 +11,7 @@
 #include <anki/util/BitSet.h>
 #include <anki/util/List.h>
 #include <anki/util/Enum.h>
+#include <anki/util/Atomic.h>
 #include <anki/scene/components/SceneComponent.h>
 
 namespace anki
@@ -25,6 +26,8 @@ class ResourceManager;
 /// Interface class backbone of scene
 class SceneNode : public Hierarchy<SceneNode>, public IntrusiveListEnabled<SceneNode>
 {
+	friend class SceneGraph;
+
 public:
 	using Base = Hierarchy<SceneNode>;
 
@@ -81,9 +84,19 @@ public:
 
 	SceneFrameAllocator<U8> getFrameAllocator() const;
 
-	void addChild(SceneNode* obj)
+	void addChild(SceneNode* obj);
+
+	void removeChild(SceneNode* obj);
+
+	/// Ask the SceneGraph to update the node in the next SceneGraph::update. The nodes that are not marked and don't
+	/// update every frame are skipped. The components mark their node when they get dirty.
+	/// @note It's thread-safe.
+	void markForUpdate();
+
+	/// The node has logic that needs to run every frame no matter if something marked it.
+	Bool getUpdateEveryFrame() const
 	{
-		Base::addChild(getAllocator(), obj);
+		return m_updateEveryFrame;
 	}
 
 	/// This is called by the scene every frame after logic and before rendering. By default it does nothing.
@@ -130,36 +143,26 @@ public:
 		return err;
 	}
 
-	/// Try geting a pointer to the first component of the requested type
+	/// Try geting a pointer to the last component of the requested type
 	template<typename Component>
 	Component* tryGetComponent()
 	{
-		U32 count = m_components.getSize();
-		while(count-- != 0)
-		{
-			SceneComponent* comp = m_components[count];
-			if(comp->getType() == Component::CLASS_TYPE)
-			{
-				return static_cast<Component*>(comp);
-			}
-		}
-		return nullptr;
+		const U8 idx = m_componentIndices[Component::CLASS_TYPE];
+		return (idx != MAX_U8) ? static_cast<Component*>(m_components[idx]) : nullptr;
 	}
 
-	/// Try geting a pointer to the first component of the requested type
+	/// Try geting a pointer to the last component of the requested type
 	template<typename Component>
 	const Component* tryGetComponent() const
 	{
-		U32 count = m_components.getSize();
-		while(count-- != 0)
-		{
-			const SceneComponent* comp = m_components[count];
-			if(comp->getType() == Component::CLASS_TYPE)
-			{
-				return static_cast<const Component*>(comp);
-			}
-		}
-		return nullptr;
+		const U8 idx = m_componentIndices[Component::CLASS_TYPE];
+		return (idx != MAX_U8) ? static_cast<const Component*>(m_components[idx]) : nullptr;
+	}
+
+	/// A mask with the bits of the types of all the components of the node. See getSceneComponentTypeBit().
+	SceneComponentTypeMask getComponentTypeMask() const
+	{
+		return m_componentTypeMask;
 	}
 
 	/// Get a pointer to the first component of the requested type
@@ -206,13 +209,27 @@ protected:
 	template<typename TComponent, typename... TArgs>
 	TComponent* newComponent(TArgs&&... args)
 	{
-		TComponent* comp = getAllocator().newInstance<TComponent>(std::forward<TArgs>(args)...);
+		Bool pooledMemory;
+		void* mem = allocateComponentMemory(getComponentClassType<TComponent>(nullptr), sizeof(TComponent),
+											alignof(TComponent), pooledMemory);
+		TComponent* comp = ::new(mem) TComponent(std::forward<TArgs>(args)...);
+		comp->m_ownerNode = this;
+		comp->m_pooledMemory = pooledMemory;
+
+		ANKI_ASSERT(m_components.getSize() < MAX_U8);
+		m_componentIndices[comp->getType()] = U8(m_components.getSize());
+		m_componentTypeMask |= getSceneComponentTypeBit(comp->getType());
+
 		m_components.emplaceBack(getAllocator(), comp);
+		componentAdded(*comp);
 		return comp;
 	}
 
 	ResourceManager& getResourceManager();
 
+	/// Set it in the constructor of the nodes that have per frame logic in frameUpdate.
+	void setUpdateEveryFrame(Bool updateEveryFrame);
+
 private:
 	SceneGraph* m_scene = nullptr;
 	U64 m_uuid;
@@ -220,9 +237,45 @@ private:
 
 	DynamicArray<SceneComponent*> m_components;
 
+	/// The index in m_components of the last component of every type. MAX_U8 if there is no component of that type.
+	Array<U8, U32(SceneComponentType::COUNT)> m_componentIndices;
+	SceneComponentTypeMask m_componentTypeMask = 0;
+
 	Timestamp m_maxComponentTimestamp = 0;
 
 	Bool m_markedForDeletion = false;
+	Bool m_updateEveryFrame = false;
+	Bool m_registered = false; ///< The SceneGraph has put it in its containers.
+
+	/// Set if the node is in the list of the roots that will be updated. Only the roots of hierarchies use it.
+	Atomic<U32> m_inUpdateList = {0};
+
+	/// The index of the node in SceneGraph's list of nodes that are updated every frame. MAX_U32 if it's not there.
+	U32 m_everyFrameNodeIdx = MAX_U32;
+
+	/// Get memory for a component. Some component types live in the pools of the SceneGraph.
+	/// @param[out] pooledMemory True if the memory came from a pool.
+	void* allocateComponentMemory(SceneComponentType type, PtrSize size, U32 alignment, Bool& pooledMemory);
+
+	/// Inform the SceneGraph about a component that was created after the node got registered.
+	void componentAdded(SceneComponent& comp);
+
+	/// Mark the world transform of a child that got a new parent or lost its parent.
+	static void parentChanged(SceneNode& child);
+
+	/// Get the CLASS_TYPE of a component.
+	template<typename TComponent>
+	static constexpr SceneComponentType getComponentClassType(decltype(&TComponent::CLASS_TYPE))
+	{
+		return TComponent::CLASS_TYPE;
+	}
+
+	/// The node specific components don't have a CLASS_TYPE.
+	template<typename TComponent>
+	static constexpr SceneComponentType getComponentClassType(...)
+	{
+		return SceneComponentType::NONE;
+	}
 };
 /// @}
 
@@ -11,6 +11,40 @@
 namespace anki
 {
 
+// The SIMD code reads the depths directly
+static_assert(sizeof(Atomic<U32>) == sizeof(U32), "See file");
+
+/// Convert a depth to the representation of the z buffer.
+static U32 quantizeDepth(F32 depth)
+{
+	// Clamp it to a bit less that 1.0f because 1.0f will produce a 0 depthi
+	depth = clamp(depth, 0.0f, 1.0f - EPSILON);
+	return U32(depth * F32(MAX_U32));
+}
+
+#if ANKI_SIMD_SSE
+static __m128i quantizeDepth(__m128 depth)
+{
+	depth = _mm_min_ps(_mm_max_ps(depth, _mm_setzero_ps()), _mm_set1_ps(1.0f - EPSILON));
+
+	// There is no unsigned conversion so move the range to the signed one and flip the sign bit back
+	const __m128 offseted = _mm_sub_ps(_mm_mul_ps(depth, _mm_set1_ps(F32(MAX_U32))), _mm_set1_ps(2147483648.0f));
+	return _mm_xor_si128(_mm_cvttps_epi32(offseted), _mm_set1_epi32(I32(0x80000000)));
+}
+#endif
+
+/// Store the min of the current depth and the new one.
+/// @return True if the depth changed.
+static Bool storeMinDepth(Atomic<U32>& pixel, U32 depth)
+{
+	U32 prev = pixel.load();
+	while(depth < prev && !pixel.compareExchange(prev, depth))
+	{
+	}
+
+	return depth < prev;
+}
+
 void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U32 width, U32 height)
 {
 	m_mv = mv;
@@ -24,13 +58,35 @@ void SoftwareRasterizer::prepare(const Mat4& mv, const Mat4& p, U32 width, U32 h
 	ANKI_ASSERT(width > 0 && height > 0);
 	m_width = width;
 	m_height = height;
-	U32 size = width * height;
+	m_tileCountX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	m_tileCountY = (height + TILE_SIZE - 1) / TILE_SIZE;
+
+	const U32 tileCount = m_tileCountX * m_tileCountY;
+	const U32 size = tileCount * TILE_PIXEL_COUNT;
 	if(m_zbuffer.getSize() < size)
 	{
 		m_zbuffer.destroy(m_alloc);
 		m_zbuffer.create(m_alloc, size);
 	}
 	memset(&m_zbuffer[0], 0xFF, sizeof(m_zbuffer[0]) * size);
+
+	if(m_tileMaxDepths.getSize() < tileCount)
+	{
+		m_tileMaxDepths.destroy(m_alloc);
+		m_tileMaxDepths.create(m_alloc, tileCount);
+	}
+	memset(&m_tileMaxDepths[0], 0xFF, sizeof(m_tileMaxDepths[0]) * tileCount);
+
+	// Zero the pixels of the partial tiles that are outside the window
+	const U32 paddedWidth = m_tileCountX * TILE_SIZE;
+	const U32 paddedHeight = m_tileCountY * TILE_SIZE;
+	for(U32 y = 0; y < paddedHeight; ++y)
+	{
+		for(U32 x = (y < height) ? width : 0; x < paddedWidth; ++x)
+		{
+			m_zbuffer[getPixelIndex(x, y)].setNonAtomically(0);
+		}
+	}
 }
 
 void SoftwareRasterizer::clipTriangle(const Vec4* inVerts, Vec4* outVerts, U& outVertCount) const
@@ -164,7 +220,9 @@ void SoftwareRasterizer::clipTriangle(const Vec4* inVerts, Vec4* outVerts, U& ou
 	}
 }
 
-void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling)
+template<typename TFunc>
+void SoftwareRasterizer::processTriangles(const F32* verts, U vertCount, U stride, Bool backfaceCulling,
+										  TFunc func) const
 {
 	ANKI_ASSERT(verts && vertCount > 0 && (vertCount % 3) == 0);
 	ANKI_ASSERT(stride >= sizeof(F32) * 3 && (stride % sizeof(F32)) == 0);
@@ -204,7 +262,7 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 			continue;
 		}
 
-		// Rasterize
+		// To clip space
 		Array<Vec4, 3> clip;
 		for(U j = 0; j < clippedCount; j += 3)
 		{
@@ -214,52 +272,43 @@ void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool back
 				ANKI_ASSERT(clip[k].w() > 0.0f);
 			}
 
-			rasterizeTriangle(&clip[0]);
+			func(&clip[0]);
 		}
 	}
 }
 
-Bool SoftwareRasterizer::computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const
+void SoftwareRasterizer::draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling)
 {
-	Vec2 dca = c - a;
-	Vec2 dba = b - a;
-	Vec2 dap = a - p;
-
-	Vec3 n(dca.x(), dba.x(), dap.x());
-	Vec3 m(dca.y(), dba.y(), dap.y());
-
-	Vec3 k = n.cross(m);
-
-	Bool skip = false;
-	if(!isZero(k.z()))
-	{
-		uvw = Vec3(1.0f - (k.x() + k.y()) / k.z(), k.y() / k.z(), k.x() / k.z());
-
-		if(uvw.x() < 0.0f || uvw.y() < 0.0f || uvw.z() < 0.0f)
+	processTriangles(verts, vertCount, stride, backfaceCulling, [this](const Vec4* tri) {
+		TriangleSetup setup;
+		if(!setupTriangle(tri, setup))
 		{
-			skip = true;
+			return;
 		}
-	}
-	else
-	{
-		skip = true;
-	}
 
-	return skip;
+		for(U32 tileY = setup.m_firstTileY; tileY <= setup.m_lastTileY; ++tileY)
+		{
+			for(U32 tileX = setup.m_firstTileX; tileX <= setup.m_lastTileX; ++tileX)
+			{
+				rasterizeTriangleInTile(setup, tileX, tileY);
+			}
+		}
+	});
 }
 
-void SoftwareRasterizer::rasterizeTriangle(const Vec4* tri)
+Bool SoftwareRasterizer::setupTriangle(const Vec4* tri, TriangleSetup& setup) const
 {
 	ANKI_ASSERT(tri);
 
 	const Vec2 windowSize{F32(m_width), F32(m_height)};
-	Array<Vec3, 3> ndc;
+	Array<F32, 3> depths;
 	Array<Vec2, 3> window;
 	Vec2 bboxMin(MAX_F32), bboxMax(MIN_F32);
 	for(U i = 0; i < 3; i++)
 	{
-		ndc[i] = tri[i].xyz() / tri[i].w();
-		window[i] = (ndc[i].xy() / 2.0f + 0.5f) * windowSize;
+		const Vec3 ndc = tri[i].xyz() / tri[i].w();
+		depths[i] = ndc.z();
+		window[i] = (ndc.xy() / 2.0f + 0.5f) * windowSize;
 
 		for(U j = 0; j < 2; j++)
 		{
@@ -271,30 +320,209 @@ void SoftwareRasterizer::rasterizeTriangle(const Vec4* tri)
 		}
 	}
 
-	for(F32 y = bboxMin.y() + 0.5f; y < bboxMax.y() + 0.5f; y += 1.0f)
+	if(bboxMin.x() >= bboxMax.x() || bboxMin.y() >= bboxMax.y())
 	{
-		for(F32 x = bboxMin.x() + 0.5f; x < bboxMax.x() + 0.5f; x += 1.0f)
+		return false;
+	}
+
+	// Setup the edge functions
+	for(U32 i = 0; i < 3; ++i)
+	{
+		const Vec2& v0 = window[(i + 1) % 3];
+		const Vec2& v1 = window[(i + 2) % 3];
+		setup.m_edgeA[i] = v0.y() - v1.y();
+		setup.m_edgeB[i] = v1.x() - v0.x();
+		setup.m_edgeC[i] = -(setup.m_edgeA[i] * v0.x() + setup.m_edgeB[i] * v0.y());
+	}
+
+	F32 area = setup.m_edgeA[0] * window[0].x() + setup.m_edgeB[0] * window[0].y() + setup.m_edgeC[0];
+	if(isZero(area))
+	{
+		return false;
+	}
+
+	// Make the edge functions positive inside the triangle no matter the winding
+	if(area < 0.0f)
+	{
+		area = -area;
+		for(U32 i = 0; i < 3; ++i)
+		{
+			setup.m_edgeA[i] = -setup.m_edgeA[i];
+			setup.m_edgeB[i] = -setup.m_edgeB[i];
+			setup.m_edgeC[i] = -setup.m_edgeC[i];
+		}
+	}
+
+	// The barycentrics are the edge functions divided by the area
+	setup.m_depthA = setup.m_depthB = setup.m_depthC = 0.0f;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		const F32 f = depths[i] / area;
+		setup.m_depthA += setup.m_edgeA[i] * f;
+		setup.m_depthB += setup.m_edgeB[i] * f;
+		setup.m_depthC += setup.m_edgeC[i] * f;
+	}
+
+	setup.m_minDepth = quantizeDepth(min(depths[0], min(depths[1], depths[2])));
+
+	setup.m_firstTileX = U32(bboxMin.x()) / TILE_SIZE;
+	setup.m_lastTileX = (U32(bboxMax.x()) - 1) / TILE_SIZE;
+	setup.m_firstTileY = U32(bboxMin.y()) / TILE_SIZE;
+	setup.m_lastTileY = (U32(bboxMax.y()) - 1) / TILE_SIZE;
+
+	return true;
+}
+
+Bool SoftwareRasterizer::TriangleSetup::touchesTile(U32 tileX, U32 tileY, Bool& fullyCovered) const
+{
+	// Test the edges against the centers of the corner pixels
+	const F32 x0 = F32(tileX * TILE_SIZE) + 0.5f;
+	const F32 x1 = x0 + F32(TILE_SIZE - 1);
+	const F32 y0 = F32(tileY * TILE_SIZE) + 0.5f;
+	const F32 y1 = y0 + F32(TILE_SIZE - 1);
+
+	fullyCovered = true;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		const F32 maxEdge =
+			m_edgeA[i] * ((m_edgeA[i] >= 0.0f) ? x1 : x0) + m_edgeB[i] * ((m_edgeB[i] >= 0.0f) ? y1 : y0) + m_edgeC[i];
+		if(maxEdge < 0.0f)
+		{
+			return false;
+		}
+
+		const F32 minEdge =
+			m_edgeA[i] * ((m_edgeA[i] >= 0.0f) ? x0 : x1) + m_edgeB[i] * ((m_edgeB[i] >= 0.0f) ? y0 : y1) + m_edgeC[i];
+		fullyCovered = fullyCovered && minEdge >= 0.0f;
+	}
+
+	return true;
+}
+
+void SoftwareRasterizer::rasterizeTriangleInTile(const TriangleSetup& setup, U32 tileX, U32 tileY)
+{
+	const U32 tileIdx = tileY * m_tileCountX + tileX;
+
+	// Skip the tile if the triangle is behind everything in it
+	if(setup.m_minDepth >= m_tileMaxDepths[tileIdx].load())
+	{
+		return;
+	}
+
+	Bool fullyCovered;
+	if(!setup.touchesTile(tileX, tileY, fullyCovered))
+	{
+		return;
+	}
+
+	const F32 x0 = F32(tileX * TILE_SIZE) + 0.5f;
+	const F32 y0 = F32(tileY * TILE_SIZE) + 0.5f;
+
+#if ANKI_SIMD_SSE
+	const __m128 laneOffsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 allOnes = _mm_castsi128_ps(_mm_set1_epi32(-1));
+#endif
+
+	// Rasterize the tile 4 pixels at a time
+	Bool tileChanged = false;
+	Atomic<U32>* tilePixels = &m_zbuffer[tileIdx * TILE_PIXEL_COUNT];
+	for(U32 row = 0; row < TILE_SIZE; ++row)
+	{
+		const F32 y = y0 + F32(row);
+
+		for(U32 col = 0; col < TILE_SIZE; col += 4)
 		{
-			Vec2 p(x, y);
-			Vec3 bc;
-			if(!computeBarycetrinc(window[0], window[1], window[2], p, bc))
+			Atomic<U32>* pixels = tilePixels + row * TILE_SIZE + col;
+
+#if ANKI_SIMD_SSE
+			const __m128 x = _mm_add_ps(_mm_set1_ps(x0 + F32(col)), laneOffsets);
+
+			__m128 inside = allOnes;
+			if(!fullyCovered)
 			{
-				const F32 z0 = ndc[0].z();
-				const F32 z1 = ndc[1].z();
-				const F32 z2 = ndc[2].z();
+				for(U32 i = 0; i < 3; ++i)
+				{
+					const __m128 edge = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(setup.m_edgeA[i]), x),
+												   _mm_set1_ps(setup.m_edgeB[i] * y + setup.m_edgeC[i]));
+					inside = _mm_and_ps(inside, _mm_cmpge_ps(edge, zero));
+				}
+			}
 
-				F32 depth = z0 * bc[0] + z1 * bc[1] + z2 * bc[2];
-				ANKI_ASSERT(depth >= 0.0 && depth <= 1.0);
+			const U32 mask = U32(_mm_movemask_ps(inside));
+			if(mask == 0)
+			{
+				continue;
+			}
+
+			const __m128 depth = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(setup.m_depthA), x),
+											_mm_set1_ps(setup.m_depthB * y + setup.m_depthC));
+
+			alignas(16) Array<U32, 4> depthsi;
+			_mm_store_si128(reinterpret_cast<__m128i*>(&depthsi[0]), quantizeDepth(depth));
+
+			for(U32 lane = 0; lane < 4; ++lane)
+			{
+				if(mask & (1u << lane))
+				{
+					tileChanged = storeMinDepth(pixels[lane], depthsi[lane]) || tileChanged;
+				}
+			}
+#else
+			for(U32 lane = 0; lane < 4; ++lane)
+			{
+				const F32 x = x0 + F32(col + lane);
+
+				Bool inside = true;
+				for(U32 i = 0; i < 3 && !fullyCovered; ++i)
+				{
+					inside = inside && setup.m_edgeA[i] * x + setup.m_edgeB[i] * y + setup.m_edgeC[i] >= 0.0f;
+				}
 
-				// Clamp it to a bit less that 1.0f because 1.0f will produce a 0 depthi
-				depth = min(depth, 1.0f - EPSILON);
+				if(!inside)
+				{
+					continue;
+				}
 
-				// Store the min of the current value and new one
-				const U32 depthi = U32(depth * F32(MAX_U32));
-				m_zbuffer[U32(y) * m_width + U32(x)].min(depthi);
+				const U32 depthi = quantizeDepth(setup.m_depthA * x + setup.m_depthB * y + setup.m_depthC);
+				tileChanged = storeMinDepth(pixels[lane], depthi) || tileChanged;
 			}
+#endif
 		}
 	}
+
+	// Update the HiZ
+	if(tileChanged)
+	{
+		// Other threads may write at the same time but the depths only decrease so the max that was computed is always
+		// conservative
+		m_tileMaxDepths[tileIdx].min(computeTileMaxDepth(tileIdx));
+	}
+}
+
+U32 SoftwareRasterizer::computeTileMaxDepth(U32 tileIdx) const
+{
+	const Atomic<U32>* pixels = &m_zbuffer[tileIdx * TILE_PIXEL_COUNT];
+
+#if ANKI_SIMD_SSE
+	__m128i maxDepths = _mm_setzero_si128();
+	for(U32 i = 0; i < TILE_PIXEL_COUNT; i += 4)
+	{
+		maxDepths = _mm_max_epu32(maxDepths, _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pixels[i])));
+	}
+
+	maxDepths = _mm_max_epu32(maxDepths, _mm_shuffle_epi32(maxDepths, _MM_SHUFFLE(1, 0, 3, 2)));
+	maxDepths = _mm_max_epu32(maxDepths, _mm_shuffle_epi32(maxDepths, _MM_SHUFFLE(2, 3, 0, 1)));
+	return U32(_mm_cvtsi128_si32(maxDepths));
+#else
+	U32 maxDepth = 0;
+	for(U32 i = 0; i < TILE_PIXEL_COUNT; ++i)
+	{
+		maxDepth = max(maxDepth, pixels[i].load());
+	}
+
+	return maxDepth;
+#endif
 }
 
 Bool SoftwareRasterizer::visibilityTest(const Aabb& aabb) const
@@ -371,19 +599,84 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 	bboxMax.y() = ceilf(bboxMax.y());
 	bboxMax.y() = clamp(bboxMax.y(), 0.0f, F32(m_height));
 
+	if(bboxMin.x() >= bboxMax.x() || bboxMin.y() >= bboxMax.y())
+	{
+		return false;
+	}
+
+	const U32 minX = U32(bboxMin.x());
+	const U32 maxX = U32(bboxMax.x());
+	const U32 minY = U32(bboxMin.y());
+	const U32 maxY = U32(bboxMax.y());
+	const U32 minZ = quantizeDepth(bboxMin.z());
+
+#if ANKI_SIMD_SSE
+	const __m128i signBit = _mm_set1_epi32(I32(0x80000000));
+	const __m128i minZSigned = _mm_xor_si128(_mm_set1_epi32(I32(minZ)), signBit);
+#endif
+
 	// Loop the tiles
-	F32 minZ = bboxMin.z();
-	for(F32 y = bboxMin.y(); y < bboxMax.y(); y += 1.0f)
+	for(U32 tileY = minY / TILE_SIZE; tileY <= (maxY - 1) / TILE_SIZE; ++tileY)
 	{
-		for(F32 x = bboxMin.x(); x < bboxMax.x(); x += 1.0f)
+		for(U32 tileX = minX / TILE_SIZE; tileX <= (maxX - 1) / TILE_SIZE; ++tileX)
 		{
-			const U32 idx = U32(y) * m_width + U32(x);
-			const U32 depthi = m_zbuffer[idx].getNonAtomically();
-			const F32 depthf = F32(depthi) / F32(MAX_U32);
-			if(minZ < depthf)
+			const U32 tileIdx = tileY * m_tileCountX + tileX;
+			if(m_tileMaxDepths[tileIdx].getNonAtomically() <= minZ)
+			{
+				// The whole tile is in front of the box
+				continue;
+			}
+
+			// The part of the tile that the box covers
+			const U32 beginX = max(minX, tileX * TILE_SIZE) - tileX * TILE_SIZE;
+			const U32 endX = min(maxX, (tileX + 1) * TILE_SIZE) - tileX * TILE_SIZE;
+			const U32 beginY = max(minY, tileY * TILE_SIZE) - tileY * TILE_SIZE;
+			const U32 endY = min(maxY, (tileY + 1) * TILE_SIZE) - tileY * TILE_SIZE;
+
+			if(beginX == 0 && endX == TILE_SIZE && beginY == 0 && endY == TILE_SIZE)
 			{
+				// The box covers the whole tile so the pixel with the max depth is behind it
 				return true;
 			}
+
+			// Test the pixels
+			const Atomic<U32>* tilePixels = &m_zbuffer[tileIdx * TILE_PIXEL_COUNT];
+			for(U32 row = beginY; row < endY; ++row)
+			{
+				const Atomic<U32>* pixels = tilePixels + row * TILE_SIZE;
+
+#if ANKI_SIMD_SSE
+				for(U32 col = 0; col < TILE_SIZE; col += 4)
+				{
+					if(col + 4 <= beginX || col >= endX)
+					{
+						continue;
+					}
+
+					// There is no unsigned compare so flip the sign bits and do a signed one
+					const __m128i depths =
+						_mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&pixels[col])), signBit);
+					const __m128i behind = _mm_cmpgt_epi32(depths, minZSigned);
+
+					const __m128i cols = _mm_add_epi32(_mm_set1_epi32(I32(col)), _mm_set_epi32(3, 2, 1, 0));
+					const __m128i inBox = _mm_and_si128(_mm_cmpgt_epi32(cols, _mm_set1_epi32(I32(beginX) - 1)),
+														_mm_cmplt_epi32(cols, _mm_set1_epi32(I32(endX))));
+
+					if(_mm_movemask_ps(_mm_castsi128_ps(_mm_and_si128(behind, inBox))))
+					{
+						return true;
+					}
+				}
+#else
+				for(U32 col = beginX; col < endX; ++col)
+				{
+					if(pixels[col].getNonAtomically() > minZ)
+					{
+						return true;
+					}
+				}
+#endif
+			}
 		}
 	}
 
@@ -392,18 +685,120 @@ Bool SoftwareRasterizer::visibilityTestInternal(const Aabb& aabb) const
 
 void SoftwareRasterizer::fillDepthBuffer(ConstWeakArray<F32> depthValues)
 {
-	ANKI_ASSERT(m_zbuffer.getSize() == depthValues.getSize());
+	ANKI_ASSERT(depthValues.getSize() == m_width * m_height);
+
+	for(U32 y = 0; y < m_height; ++y)
+	{
+		for(U32 x = 0; x < m_width; ++x)
+		{
+			const F32 depth = depthValues[y * m_width + x];
+			ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
+			m_zbuffer[getPixelIndex(x, y)].setNonAtomically(quantizeDepth(depth));
+		}
+	}
+
+	for(U32 tileIdx = 0; tileIdx < m_tileCountX * m_tileCountY; ++tileIdx)
+	{
+		m_tileMaxDepths[tileIdx].setNonAtomically(computeTileMaxDepth(tileIdx));
+	}
+}
+
+void SoftwareRasterizer::fillDepthBufferReprojected(ConstWeakArray<F32> depthValues, const Mat4& prevViewProjMat)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_RASTERIZER_REPROJECT);
+	ANKI_ASSERT(depthValues.getSize() == m_width * m_height);
+
+	// From the NDC of the old frame to the clip space of the new one
+	const Mat4 reprojMat = m_mvp * prevViewProjMat.getInverse();
 
-	U32 count = depthValues.getSize();
-	while(count--)
+	// Scatter the old samples to the new window. Many samples may land on the same pixel, keep the max of them since
+	// the coverage buffer holds the max depth of every pixel. Zero marks the pixels that didn't get any sample
+	DynamicArrayAuto<U32> splatted(m_alloc);
+	splatted.create(m_width * m_height, 0);
+	const Vec2 windowSize{F32(m_width), F32(m_height)};
+	for(U32 y = 0; y < m_height; ++y)
 	{
-		F32 depth = depthValues[count];
-		ANKI_ASSERT(depth >= 0.0f && depth <= 1.0f);
+		for(U32 x = 0; x < m_width; ++x)
+		{
+			// The sample lands somewhere between the new pixel centers. Take the max depth of its neighbourhood so the
+			// samples on the edges of the occluders don't cover pixels that see the background
+			F32 depth = 0.0f;
+			for(U32 ny = (y > 0) ? y - 1 : 0; ny <= min(y + 1, m_height - 1); ++ny)
+			{
+				for(U32 nx = (x > 0) ? x - 1 : 0; nx <= min(x + 1, m_width - 1); ++nx)
+				{
+					ANKI_ASSERT(depthValues[ny * m_width + nx] >= 0.0f && depthValues[ny * m_width + nx] <= 1.0f);
+					depth = max(depth, depthValues[ny * m_width + nx]);
+				}
+			}
+
+			if(depth >= 1.0f)
+			{
+				// Nothing was rendered there so it can't occlude anything wherever it lands
+				continue;
+			}
+
+			const Vec2 ndc = (Vec2(F32(x), F32(y)) + 0.5f) / windowSize * 2.0f - 1.0f;
+			const Vec4 clip = reprojMat * Vec4(ndc, depth, 1.0f);
+			if(clip.w() <= EPSILON)
+			{
+				// Behind the new eye
+				continue;
+			}
 
-		depth = min(depth, 1.0f - EPSILON); // See a few lines above why is that
+			const Vec3 newNdc = clip.xyz() / clip.w();
+			const Vec2 window = (newNdc.xy() / 2.0f + 0.5f) * windowSize;
+			if(newNdc.z() < 0.0f || newNdc.z() > 1.0f || window.x() < 0.0f || window.y() < 0.0f
+			   || window.x() >= windowSize.x() || window.y() >= windowSize.y())
+			{
+				continue;
+			}
+
+			U32& pixel = splatted[U32(window.y()) * m_width + U32(window.x())];
+			pixel = max(pixel, max(quantizeDepth(newNdc.z()), 1u));
+		}
+	}
+
+	// Fill the holes. A hole between two samples on opposite sides is most likely a crack of the magnification so it
+	// gets the max of its neighbours. The rest are disocclusions or areas without data and they occlude nothing
+	auto fillHole = [&](U32 x, U32 y) -> U32 {
+		static const Array<I32, 8> offsetsX = {-1, 1, 0, 0, -1, 1, 1, -1};
+		static const Array<I32, 8> offsetsY = {0, 0, -1, 1, -1, 1, -1, 1};
+
+		U32 maxDepth = 0;
+		Bool opposite = false;
+		for(U32 i = 0; i < offsetsX.getSize(); i += 2)
+		{
+			Array<U32, 2> neighbours = {};
+			for(U32 j = 0; j < 2; ++j)
+			{
+				const I32 nx = I32(x) + offsetsX[i + j];
+				const I32 ny = I32(y) + offsetsY[i + j];
+				if(nx >= 0 && ny >= 0 && nx < I32(m_width) && ny < I32(m_height))
+				{
+					neighbours[j] = splatted[U32(ny) * m_width + U32(nx)];
+				}
+			}
+
+			opposite = opposite || (neighbours[0] != 0 && neighbours[1] != 0);
+			maxDepth = max(maxDepth, max(neighbours[0], neighbours[1]));
+		}
+
+		return (opposite) ? maxDepth : MAX_U32;
+	};
+
+	for(U32 y = 0; y < m_height; ++y)
+	{
+		for(U32 x = 0; x < m_width; ++x)
+		{
+			const U32 depth = splatted[y * m_width + x];
+			m_zbuffer[getPixelIndex(x, y)].setNonAtomically((depth != 0) ? depth : fillHole(x, y));
+		}
+	}
 
-		const U32 depthi = U32(depth * F32(MAX_U32));
-		m_zbuffer[count].setNonAtomically(depthi);
+	for(U32 tileIdx = 0; tileIdx < m_tileCountX * m_tileCountY; ++tileIdx)
+	{
+		m_tileMaxDepths[tileIdx].setNonAtomically(computeTileMaxDepth(tileIdx));
 	}
 }
 
@@ -16,10 +16,15 @@ namespace anki
 /// @addtogroup scene
 /// @{
 
-/// Software rasterizer for visibility tests.
+/// Software rasterizer for visibility tests. It's a half-space rasterizer that works on tiles of
+/// TILE_SIZE x TILE_SIZE pixels. Every tile keeps a conservative max depth (a single level HiZ) that is used to reject
+/// whole tiles.
 class SoftwareRasterizer
 {
 public:
+	static constexpr U32 TILE_SIZE = 8;
+	static constexpr U32 TILE_PIXEL_COUNT = TILE_SIZE * TILE_SIZE;
+
 	SoftwareRasterizer()
 	{
 	}
@@ -27,6 +32,7 @@ public:
 	~SoftwareRasterizer()
 	{
 		m_zbuffer.destroy(m_alloc);
+		m_tileMaxDepths.destroy(m_alloc);
 	}
 
 	/// Initialize.
@@ -47,14 +53,46 @@ public:
 	void draw(const F32* verts, U vertCount, U stride, Bool backfaceCulling);
 
 	/// Fill the depth buffer with some values.
+	/// @param depthValues The depth values in rows of m_width pixels.
 	void fillDepthBuffer(ConstWeakArray<F32> depthValues);
 
+	/// Fill the depth buffer with the depth of an older frame. The depth values are warped to the current view and the
+	/// holes that the warping leaves behind are filled conservatively.
+	/// @param depthValues The depth values in rows of m_width pixels.
+	/// @param prevViewProjMat The view projection matrix the depth values were rendered with.
+	void fillDepthBufferReprojected(ConstWeakArray<F32> depthValues, const Mat4& prevViewProjMat);
+
 	/// Perform visibility tests.
 	/// @param aabb The Aabb in of the cs in world space.
 	/// @return Return true if it's visible and false otherwise.
 	Bool visibilityTest(const Aabb& aabb) const;
 
 private:
+	/// A triangle in window space that is ready to be rasterized.
+	class TriangleSetup
+	{
+	public:
+		/// The edge functions. The edge i is opposite to the vertex i and its function is E(p) = a * p.x + b * p.y + c
+		Array<F32, 3> m_edgeA;
+		Array<F32, 3> m_edgeB;
+		Array<F32, 3> m_edgeC;
+
+		/// The depth is a plane in window space. depth = a * p.x + b * p.y + c
+		F32 m_depthA;
+		F32 m_depthB;
+		F32 m_depthC;
+
+		U32 m_minDepth;
+		U32 m_firstTileX;
+		U32 m_lastTileX;
+		U32 m_firstTileY;
+		U32 m_lastTileY;
+
+		/// Test the triangle against a tile.
+		/// @return False if the triangle doesn't touch the tile.
+		Bool touchesTile(U32 tileX, U32 tileY, Bool& fullyCovered) const;
+	};
+
 	GenericMemoryPoolAllocator<U8> m_alloc;
 	Mat4 m_mv; ///< ModelView.
 	Mat4 m_p; ///< Projection.
@@ -63,12 +101,35 @@ private:
 	Array<Plane, 6> m_planesW; ///< In world space.
 	U32 m_width;
 	U32 m_height;
+	U32 m_tileCountX;
+	U32 m_tileCountY;
+
+	/// The depth values stored tile after tile. The pixels of the partial tiles that fall outside the window are
+	/// zero so they never write or reject anything.
 	DynamicArray<Atomic<U32>> m_zbuffer;
 
+	/// The max depth of every tile. It's conservative, it can be greater than the actual max.
+	DynamicArray<Atomic<U32>> m_tileMaxDepths;
+
+	/// Transform, cull and clip triangles and pass them to a functor in clip space.
+	template<typename TFunc>
+	void processTriangles(const F32* verts, U vertCount, U stride, Bool backfaceCulling, TFunc func) const;
+
 	/// @param tri In clip space.
-	void rasterizeTriangle(const Vec4* tri);
+	/// @return False if the triangle doesn't need to be rasterized.
+	Bool setupTriangle(const Vec4* tri, TriangleSetup& setup) const;
+
+	/// Rasterize a triangle in a tile. It's thread-safe against other writes in the same tile.
+	void rasterizeTriangleInTile(const TriangleSetup& setup, U32 tileX, U32 tileY);
+
+	/// Compute the max depth of a tile out of its pixels.
+	U32 computeTileMaxDepth(U32 tileIdx) const;
 
-	Bool computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw) const;
+	U32 getPixelIndex(U32 x, U32 y) const
+	{
+		const U32 tileIdx = (y / TILE_SIZE) * m_tileCountX + x / TILE_SIZE;
+		return tileIdx * TILE_PIXEL_COUNT + (y % TILE_SIZE) * TILE_SIZE + x % TILE_SIZE;
+	}
 
 	/// Clip triangle in the near plane.
 	/// @note Triangles in view space.
@@ -50,10 +50,90 @@ void VisibilityContext::submitNewWork(const FrustumComponent& frc, RenderQueue&
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_SUBMIT_WORK);
 
+	FrustumVisibilityContext* frcCtx = newFrustumContext(frc, rqueue, hive);
+	if(frcCtx)
+	{
+		submitFrustumTasks(frcCtx, hive);
+	}
+}
+
+void VisibilityContext::submitNewWork(ConstWeakArray<const FrustumComponent*> frcs, WeakArray<RenderQueue> rqueues,
+									  ThreadHive& hive)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_SUBMIT_WORK);
+	ANKI_ASSERT(frcs.getSize() == rqueues.getSize());
+
+	auto alloc = m_scene->getFrameAllocator();
+	MultiFrustumVisibilityContext* multiCtx = nullptr;
+	for(U32 i = 0; i < frcs.getSize(); ++i)
+	{
+		FrustumVisibilityContext* frcCtx = newFrustumContext(*frcs[i], rqueues[i], hive);
+		if(!frcCtx)
+		{
+			continue;
+		}
+
+		// The ones that hit the visibility cache test much less so leave them alone
+		if(!canTestWithOtherFrustums(*frcs[i]) || frcCtx->m_visibilityCacheHit
+		   || (multiCtx && multiCtx->m_frcCount == MAX_FRUSTUMS_PER_MULTI_TEST))
+		{
+			submitFrustumTasks(frcCtx, hive);
+			continue;
+		}
+
+		if(!multiCtx)
+		{
+			multiCtx = alloc.newInstance<MultiFrustumVisibilityContext>();
+			multiCtx->m_visCtx = this;
+		}
+
+		multiCtx->m_frcCtxs[multiCtx->m_frcCount++] = frcCtx;
+	}
+
+	if(!multiCtx)
+	{
+		return;
+	}
+
+	if(multiCtx->m_frcCount == 1)
+	{
+		submitFrustumTasks(multiCtx->m_frcCtxs[0], hive);
+		return;
+	}
+
+	ANKI_TRACE_INC_COUNTER(SCENE_VIS_MULTI_FRUSTUMS, multiCtx->m_frcCount);
+
+	// All the frustums wait for the same tests
+	multiCtx->m_visTestsSignalSem = hive.newSemaphore(1);
+	for(U32 i = 0; i < multiCtx->m_frcCount; ++i)
+	{
+		FrustumVisibilityContext& frcCtx = *multiCtx->m_frcCtxs[i];
+		frcCtx.m_visTestsSignalSem = multiCtx->m_visTestsSignalSem;
+
+		// Some frustums may see nothing. Set the timestamp the combine expects
+		frcCtx.m_queueViews[0].m_timestamp = frcCtx.m_frc->getSceneNode().getComponentMaxTimestamp();
+	}
+
+	ThreadHiveTask gatherTask = ANKI_THREAD_HIVE_TASK(
+		{ self->gather(hive); }, alloc.newInstance<GatherVisiblesFromOctreeTask>(multiCtx), nullptr, nullptr);
+	hive.submitTasks(&gatherTask, 1);
+
+	for(U32 i = 0; i < multiCtx->m_frcCount; ++i)
+	{
+		CombineResultsTask* combine = alloc.newInstance<CombineResultsTask>(multiCtx->m_frcCtxs[i]);
+		ThreadHiveTask combineTask =
+			ANKI_THREAD_HIVE_TASK({ self->combine(hive); }, combine, multiCtx->m_visTestsSignalSem, nullptr);
+		hive.submitTasks(&combineTask, 1);
+	}
+}
+
+FrustumVisibilityContext* VisibilityContext::newFrustumContext(const FrustumComponent& frc, RenderQueue& rqueue,
+															   ThreadHive& hive)
+{
 	// Check enabled and make sure that the results are null (this can happen on multiple on circular viewing)
 	if(ANKI_UNLIKELY(!frc.anyVisibilityTestEnabled()))
 	{
-		return;
+		return nullptr;
 	}
 
 	rqueue.m_cameraTransform = Mat4(frc.getTransform());
@@ -85,7 +165,7 @@ void VisibilityContext::submitNewWork(const FrustumComponent& frc, RenderQueue&
 		{
 			if(x == &frc)
 			{
-				return;
+				return nullptr;
 			}
 		}
 
@@ -101,17 +181,36 @@ void VisibilityContext::submitNewWork(const FrustumComponent& frc, RenderQueue&
 	frcCtx->m_visTestsSignalSem = hive.newSemaphore(1);
 	frcCtx->m_renderQueue = &rqueue;
 
-	// Submit new work
-	//
+	if(frc.getVisibilityCacheEnabled())
+	{
+		frcCtx->m_visibilityCacheHit = frc.getCachedVisibles(*m_scene, frcCtx->m_cachedVisibles);
+		if(frcCtx->m_visibilityCacheHit)
+		{
+			ANKI_TRACE_INC_COUNTER(SCENE_VIS_CACHE_HITS, 1);
+		}
+		else
+		{
+			ANKI_TRACE_INC_COUNTER(SCENE_VIS_CACHE_MISSES, 1);
+		}
+	}
+
+	return frcCtx;
+}
+
+void VisibilityContext::submitFrustumTasks(FrustumVisibilityContext* frcCtx, ThreadHive& hive)
+{
+	const FrustumComponent& frc = *frcCtx->m_frc;
+	RenderQueue& rqueue = *frcCtx->m_renderQueue;
+	auto alloc = m_scene->getFrameAllocator();
 
 	// Software rasterizer task
 	ThreadHiveSemaphore* prepareRasterizerSem = nullptr;
 	if(frc.visibilityTestsEnabled(FrustumComponentVisibilityTestFlag::OCCLUDERS) && frc.hasCoverageBuffer())
 	{
 		// Gather triangles task
-		ThreadHiveTask fillDepthTask =
-			ANKI_THREAD_HIVE_TASK({ self->fill(); }, alloc.newInstance<FillRasterizerWithCoverageTask>(frcCtx), nullptr,
-								  hive.newSemaphore(1));
+		ThreadHiveTask fillDepthTask = ANKI_THREAD_HIVE_TASK({ self->fill(hive, signalSemaphore); },
+															 alloc.newInstance<FillRasterizerWithCoverageTask>(frcCtx),
+															 nullptr, hive.newSemaphore(1));
 
 		hive.submitTasks(&fillDepthTask, 1);
 
@@ -133,11 +232,11 @@ void VisibilityContext::submitNewWork(const FrustumComponent& frc, RenderQueue&
 	// Combind results task
 	ANKI_ASSERT(frcCtx->m_visTestsSignalSem);
 	ThreadHiveTask combineTask = ANKI_THREAD_HIVE_TASK(
-		{ self->combine(); }, alloc.newInstance<CombineResultsTask>(frcCtx), frcCtx->m_visTestsSignalSem, nullptr);
+		{ self->combine(hive); }, alloc.newInstance<CombineResultsTask>(frcCtx), frcCtx->m_visTestsSignalSem, nullptr);
 	hive.submitTasks(&combineTask, 1);
 }
 
-void FillRasterizerWithCoverageTask::fill()
+void FillRasterizerWithCoverageTask::fill(ThreadHive& hive, ThreadHiveSemaphore* signalSemaphore)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_FILL_DEPTH);
 
@@ -147,7 +246,8 @@ void FillRasterizerWithCoverageTask::fill()
 	ConstWeakArray<F32> depthBuff;
 	U32 width;
 	U32 height;
-	m_frcCtx->m_frc->getCoverageBufferInfo(depthBuff, width, height);
+	Mat4 depthBuffViewProjMat;
+	m_frcCtx->m_frc->getCoverageBufferInfo(depthBuff, width, height, depthBuffViewProjMat);
 	ANKI_ASSERT(width > 0 && height > 0 && depthBuff.getSize() > 0);
 
 	// Init the rasterizer
@@ -155,49 +255,161 @@ void FillRasterizerWithCoverageTask::fill()
 	m_frcCtx->m_r->init(alloc);
 	m_frcCtx->m_r->prepare(m_frcCtx->m_frc->getViewMatrix(), m_frcCtx->m_frc->getProjectionMatrix(), width, height);
 
-	// Do the work
-	m_frcCtx->m_r->fillDepthBuffer(depthBuff);
+	// The C-Buffer is from an older frame. Warp it to the current view so the moving camera doesn't cull wrong
+	m_frcCtx->m_r->fillDepthBufferReprojected(depthBuff, depthBuffViewProjMat);
+
+	// Rasterize the occluders on top of the coverage buffer
+	gatherOccluders();
+	const U32 occluderCount = m_frcCtx->m_occluders.getSize();
+	if(occluderCount == 0)
+	{
+		return;
+	}
+
+	// Every task draws some of the occluders. Increase the semaphore of this task to block the gather until they are
+	// done
+	const U32 drawTaskCount = min(hive.getThreadCount(), occluderCount);
+	signalSemaphore->increaseSemaphore(drawTaskCount);
+	for(U32 i = 0; i < drawTaskCount; ++i)
+	{
+		ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({ self->draw(); },
+													alloc.newInstance<DrawOccludersTask>(m_frcCtx, i, drawTaskCount),
+													nullptr, signalSemaphore);
+		hive.submitTasks(&task, 1);
+	}
+}
+
+void FillRasterizerWithCoverageTask::gatherOccluders()
+{
+	auto alloc = m_frcCtx->m_visCtx->m_scene->getFrameAllocator();
+
+	for(const OccluderComponent* occluder : m_frcCtx->m_visCtx->m_scene->getOccluders())
+	{
+		if(m_frcCtx->m_frc->insideFrustum(occluder->getBoundingVolume()))
+		{
+			m_frcCtx->m_occluders.emplaceBack(alloc, occluder);
+		}
+	}
+}
+
+void DrawOccludersTask::draw()
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_RASTERIZE_OCCLUDERS);
+
+	for(U32 i = m_taskIdx; i < m_frcCtx->m_occluders.getSize(); i += m_taskCount)
+	{
+		const Vec3* verts;
+		U32 vertCount, stride;
+		m_frcCtx->m_occluders[i]->getVertices(verts, vertCount, stride);
+		m_frcCtx->m_r->draw(&verts[0][0], vertCount, stride, true);
+	}
 }
 
 void GatherVisiblesFromOctreeTask::gather(ThreadHive& hive)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_OCTREE);
 
-	U32 testIdx = m_frcCtx->m_visCtx->m_testsCount.fetchAdd(1);
+	if(m_multiFrcCtx)
+	{
+		gatherMulti(hive);
+	}
+	else if(m_frcCtx->m_visibilityCacheHit)
+	{
+		gatherFromCache(hive);
+	}
+	else
+	{
+		const U32 testIdx = m_frcCtx->m_visCtx->m_testsCount.fetchAdd(1);
+
+		// Walk the tree
+		m_frcCtx->m_visCtx->m_scene->walkSpatialTree(
+			OctreePlaceable::computeTestId(m_frcCtx->m_visCtx->m_testEpoch, testIdx),
+			[&](const Aabb& box) {
+				Bool visible = m_frcCtx->m_frc->insideFrustum(box);
+				if(visible && m_frcCtx->m_r)
+				{
+					visible = m_frcCtx->m_r->visibilityTest(box);
+				}
+
+				return visible;
+			},
+			[&](void* placeableUserData) {
+				ANKI_ASSERT(placeableUserData);
+				pushSpatial(static_cast<SpatialComponent*>(placeableUserData), hive);
+			});
+	}
+
+	// Flush the remaining
+	flush(hive);
+
+	// Fire an additional dummy task to decrease the semaphore to zero
+	GatherVisiblesFromOctreeTask* pself = this; // MSVC workaround
+	ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({}, pself, nullptr, getVisTestsSignalSemaphore());
+	hive.submitTasks(&task, 1);
+}
 
-	// Walk the tree
-	m_frcCtx->m_visCtx->m_scene->getOctree().walkTree(
-		testIdx,
+void GatherVisiblesFromOctreeTask::gatherMulti(ThreadHive& hive)
+{
+	const MultiFrustumVisibilityContext& multiCtx = *m_multiFrcCtx;
+	const U32 testIdx = multiCtx.m_visCtx->m_testsCount.fetchAdd(1);
+
+	// Walk the tree once. Go deeper if any of the frustums sees the box
+	multiCtx.m_visCtx->m_scene->walkSpatialTree(
+		OctreePlaceable::computeTestId(multiCtx.m_visCtx->m_testEpoch, testIdx),
 		[&](const Aabb& box) {
-			Bool visible = m_frcCtx->m_frc->insideFrustum(box);
-			if(visible && m_frcCtx->m_r)
+			for(U32 i = 0; i < multiCtx.m_frcCount; ++i)
 			{
-				visible = m_frcCtx->m_r->visibilityTest(box);
+				if(multiCtx.m_frcCtxs[i]->m_frc->insideFrustum(box))
+				{
+					return true;
+				}
 			}
 
-			return visible;
+			return false;
 		},
 		[&](void* placeableUserData) {
 			ANKI_ASSERT(placeableUserData);
-			SpatialComponent* scomp = static_cast<SpatialComponent*>(placeableUserData);
+			pushSpatial(static_cast<SpatialComponent*>(placeableUserData), hive);
+		});
+}
 
-			ANKI_ASSERT(m_spatialCount < m_spatials.getSize());
+void GatherVisiblesFromOctreeTask::pushSpatial(SpatialComponent* sp, ThreadHive& hive)
+{
+	ANKI_ASSERT(sp);
+	ANKI_ASSERT(m_spatialCount < m_spatials.getSize());
 
-			m_spatials[m_spatialCount++] = scomp;
+	m_spatials[m_spatialCount++] = sp;
 
-			if(m_spatialCount == m_spatials.getSize())
-			{
-				flush(hive);
-			}
-		});
+	if(m_spatialCount == m_spatials.getSize())
+	{
+		flush(hive);
+	}
+}
 
-	// Flush the remaining
-	flush(hive);
+void GatherVisiblesFromOctreeTask::gatherFromCache(ThreadHive& hive)
+{
+	const SceneGraph& scene = *m_frcCtx->m_visCtx->m_scene;
+	const Timestamp timestamp = scene.getGlobalTimestamp();
 
-	// Fire an additional dummy task to decrease the semaphore to zero
-	GatherVisiblesFromOctreeTask* pself = this; // MSVC workaround
-	ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({}, pself, nullptr, m_frcCtx->m_visTestsSignalSem);
-	hive.submitTasks(&task, 1);
+	// The visibles of the previous frame that didn't change are still inside the frustum. The VisibilityTestTask
+	// won't test them again
+	U32 reusedCount = 0;
+	for(SpatialComponent* sp : m_frcCtx->m_cachedVisibles)
+	{
+		if(sp->getSceneNode().getComponentMaxTimestamp() < timestamp)
+		{
+			pushSpatial(sp, hive);
+			++reusedCount;
+		}
+	}
+
+	ANKI_TRACE_INC_COUNTER(SCENE_VIS_CACHE_REUSED_SPATIALS, reusedCount);
+
+	// Whatever changed in this frame needs a test
+	for(SpatialComponent* sp : scene.getUpdatedSpatials())
+	{
+		pushSpatial(sp, hive);
+	}
 }
 
 void GatherVisiblesFromOctreeTask::flush(ThreadHive& hive)
@@ -205,17 +417,18 @@ void GatherVisiblesFromOctreeTask::flush(ThreadHive& hive)
 	if(m_spatialCount)
 	{
 		// Create the task
-		VisibilityTestTask* vis =
-			m_frcCtx->m_visCtx->m_scene->getFrameAllocator().newInstance<VisibilityTestTask>(m_frcCtx);
+		auto alloc = getVisibilityContext().m_scene->getFrameAllocator();
+		VisibilityTestTask* vis = (m_multiFrcCtx) ? alloc.newInstance<VisibilityTestTask>(m_multiFrcCtx)
+												  : alloc.newInstance<VisibilityTestTask>(m_frcCtx);
 		memcpy(&vis->m_spatialsToTest[0], &m_spatials[0], sizeof(m_spatials[0]) * m_spatialCount);
 		vis->m_spatialToTestCount = m_spatialCount;
 
 		// Increase the semaphore to block the CombineResultsTask
-		m_frcCtx->m_visTestsSignalSem->increaseSemaphore(1);
+		ThreadHiveSemaphore* sem = getVisTestsSignalSemaphore();
+		sem->increaseSemaphore(1);
 
 		// Submit task
-		ThreadHiveTask task =
-			ANKI_THREAD_HIVE_TASK({ self->test(hive, threadId); }, vis, nullptr, m_frcCtx->m_visTestsSignalSem);
+		ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({ self->test(hive, threadId); }, vis, nullptr, sem);
 		hive.submitTasks(&task, 1);
 
 		// Clear count
@@ -227,6 +440,12 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_TEST);
 
+	if(m_multiFrcCtx)
+	{
+		testMulti(taskId);
+		return;
+	}
+
 	const FrustumComponent& testedFrc = *m_frcCtx->m_frc;
 	ANKI_ASSERT(testedFrc.anyVisibilityTestEnabled());
 
@@ -265,6 +484,22 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 	const Bool wantsGenericComputeJobCoponents =
 		testedFrc.visibilityTestsEnabled(FrustumComponentVisibilityTestFlag::GENERIC_COMPUTE_JOB_COMPONENTS);
 
+	// The nodes need at least one of these components to be of interest
+	auto bit = [](Bool wanted, SceneComponentType type) -> SceneComponentTypeMask {
+		return (wanted) ? getSceneComponentTypeBit(type) : 0;
+	};
+	const SceneComponentTypeMask wantedComponents =
+		bit(wantsRenderComponents || wantsShadowCasters, SceneComponentType::RENDER)
+		| bit(wantsLightComponents, SceneComponentType::LIGHT)
+		| bit(wantsFlareComponents, SceneComponentType::LENS_FLARE)
+		| bit(wantsReflectionProbes, SceneComponentType::REFLECTION_PROBE) | bit(wantsDecals, SceneComponentType::DECAL)
+		| bit(wantsFogDensityComponents, SceneComponentType::FOG_DENSITY)
+		| bit(wantsGiProbeCoponents, SceneComponentType::GLOBAL_ILLUMINATION_PROBE)
+		| bit(wantsGenericComputeJobCoponents, SceneComponentType::GENERIC_GPU_COMPUTE_JOB_COMPONENT);
+
+	const Bool updateVisibilityCache = testedFrc.getVisibilityCacheEnabled();
+	const Timestamp sceneTimestamp = m_frcCtx->m_visCtx->m_scene->getGlobalTimestamp();
+
 	// Iterate
 	RenderQueueView& result = m_frcCtx->m_queueViews[taskId];
 	for(U i = 0; i < m_spatialToTestCount; ++i)
@@ -279,10 +514,16 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 			continue;
 		}
 
+		// Skip early if it doesn't have anything the frustum needs
+		if(!(node.getComponentTypeMask() & wantedComponents))
+		{
+			continue;
+		}
+
 		// Check what components the frustum needs
 		Bool wantNode = false;
 
-		const RenderComponent* rc = nullptr;
+		RenderComponent* rc = nullptr;
 		wantNode |= wantsRenderComponents && (rc = node.tryGetComponent<RenderComponent>());
 
 		wantNode |= wantsShadowCasters && (rc = node.tryGetComponent<RenderComponent>())
@@ -316,6 +557,9 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 			continue;
 		}
 
+		// If it's coming from the cache and didn't change it's still inside the frustum
+		const Bool knownVisible = m_frcCtx->m_visibilityCacheHit && node.getComponentMaxTimestamp() < sceneTimestamp;
+
 		// Test all spatial components of that node
 		struct SpatialTemp
 		{
@@ -328,7 +572,7 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 		U32 spIdx = 0;
 		U32 count = 0;
 		Error err = node.iterateComponentsOfType<SpatialComponent>([&](SpatialComponent& sp) {
-			if(spatialInsideFrustum(testedFrc, sp) && testAgainstRasterizer(sp.getAabb()))
+			if(knownVisible || (spatialInsideFrustum(testedFrc, sp) && testAgainstRasterizer(sp.getAabb())))
 			{
 				// Inside
 				ANKI_ASSERT(spIdx < MAX_U8);
@@ -348,6 +592,11 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 
 		ANKI_ASSERT(count == 1 && "TODO: Support sub-spatials");
 
+		if(updateVisibilityCache)
+		{
+			*result.m_visibleSpatials.newElement(alloc) = spatialC;
+		}
+
 		// Sort sub-spatials
 		const Vec4 origin = testedFrc.getTransform().getOrigin();
 		std::sort(sps.begin(), sps.begin() + count, [origin](const SpatialTemp& a, const SpatialTemp& b) -> Bool {
@@ -365,30 +614,7 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 
 		if(rc)
 		{
-			RenderableQueueElement* el;
-			if(!!(rc->getFlags() & RenderComponentFlag::FORWARD_SHADING))
-			{
-				el = result.m_forwardShadingRenderables.newElement(alloc);
-			}
-			else
-			{
-				el = result.m_renderables.newElement(alloc);
-			}
-
-			rc->setupRenderableQueueElement(*el);
-
-			// Compute distance from the frustum
-			const Plane& nearPlane = testedFrc.getViewPlanes()[FrustumPlaneType::NEAR];
-			el->m_distanceFromCamera = !!(rc->getFlags() & RenderComponentFlag::SORT_LAST)
-										   ? testedFrc.getFar()
-										   : max(0.0f, testPlane(nearPlane, sps[0].m_sp->getAabb()));
-
-			if(wantsEarlyZ && el->m_distanceFromCamera < m_frcCtx->m_visCtx->m_earlyZDist
-			   && !(rc->getFlags() & RenderComponentFlag::FORWARD_SHADING))
-			{
-				RenderableQueueElement* el2 = result.m_earlyZRenderables.newElement(alloc);
-				*el2 = *el;
-			}
+			pushRenderable(*rc, *sps[0].m_sp, *m_frcCtx, wantsEarlyZ, result);
 		}
 
 		if(lc)
@@ -599,12 +825,14 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 		// Add more frustums to the list
 		if(nextQueues.getSize() > 0)
 		{
+			Array<const FrustumComponent*, MAX_FRUSTUMS_PER_MULTI_TEST> nextFrcs;
 			count = 0;
 
 			if(ANKI_LIKELY(nextQueueFrustumComponents.getSize() == 0))
 			{
 				err = node.iterateComponentsOfType<FrustumComponent>([&](FrustumComponent& frc) {
-					m_frcCtx->m_visCtx->submitNewWork(frc, nextQueues[count++], hive);
+					ANKI_ASSERT(count < nextFrcs.getSize());
+					nextFrcs[count++] = &frc;
 					return Error::NONE;
 				});
 				(void)err;
@@ -613,9 +841,13 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 			{
 				for(FrustumComponent& frc : nextQueueFrustumComponents)
 				{
-					m_frcCtx->m_visCtx->submitNewWork(frc, nextQueues[count++], hive);
+					nextFrcs[count++] = &frc;
 				}
 			}
+
+			ANKI_ASSERT(count == nextQueues.getSize());
+			m_frcCtx->m_visCtx->submitNewWork(ConstWeakArray<const FrustumComponent*>(&nextFrcs[0], count), nextQueues,
+											  hive);
 		}
 
 		// Update timestamp
@@ -623,7 +855,106 @@ void VisibilityTestTask::test(ThreadHive& hive, U32 taskId)
 	} // end for
 }
 
-void CombineResultsTask::combine()
+void VisibilityTestTask::testMulti(U32 taskId)
+{
+	const MultiFrustumVisibilityContext& multiCtx = *m_multiFrcCtx;
+	auto alloc = multiCtx.m_visCtx->m_scene->getFrameAllocator();
+
+	for(U32 i = 0; i < m_spatialToTestCount; ++i)
+	{
+		SpatialComponent& sp = *m_spatialsToTest[i];
+		SceneNode& node = sp.getSceneNode();
+
+		// All the frustums want the shadow casters only
+		RenderComponent* rc = node.tryGetComponent<RenderComponent>();
+		if(!rc || !(rc->getFlags() & RenderComponentFlag::CASTS_SHADOW))
+		{
+			continue;
+		}
+
+		// Bin it to the results of all the frustums that see it
+		for(U32 f = 0; f < multiCtx.m_frcCount; ++f)
+		{
+			FrustumVisibilityContext& frcCtx = *multiCtx.m_frcCtxs[f];
+			const FrustumComponent& frc = *frcCtx.m_frc;
+			if(&frc.getSceneNode() == &node || !spatialInsideFrustum(frc, sp))
+			{
+				continue;
+			}
+
+			RenderQueueView& result = frcCtx.m_queueViews[taskId];
+			pushRenderable(*rc, sp, frcCtx, false, result);
+
+			if(frc.getVisibilityCacheEnabled())
+			{
+				*result.m_visibleSpatials.newElement(alloc) = m_spatialsToTest[i];
+			}
+
+			result.m_timestamp = max(result.m_timestamp, frc.getSceneNode().getComponentMaxTimestamp());
+			result.m_timestamp = max(result.m_timestamp, node.getComponentMaxTimestamp());
+		}
+	}
+}
+
+void VisibilityTestTask::pushRenderable(RenderComponent& rc, const SpatialComponent& sp,
+										const FrustumVisibilityContext& frcCtx, Bool wantsEarlyZ,
+										RenderQueueView& result)
+{
+	auto alloc = frcCtx.m_visCtx->m_scene->getFrameAllocator();
+	const FrustumComponent& frc = *frcCtx.m_frc;
+
+	RenderableQueueElement* el;
+	U64* sortKey;
+	const Bool forwardShading = !!(rc.getFlags() & RenderComponentFlag::FORWARD_SHADING);
+	if(forwardShading)
+	{
+		el = result.m_forwardShadingRenderables.newElement(alloc);
+		sortKey = result.m_forwardShadingRenderableSortKeys.newElement(alloc);
+	}
+	else
+	{
+		el = result.m_renderables.newElement(alloc);
+		sortKey = result.m_renderableSortKeys.newElement(alloc);
+	}
+
+	rc.setupRenderableQueueElement(*el);
+
+	// Compute distance from the frustum
+	const Plane& nearPlane = frc.getViewPlanes()[FrustumPlaneType::NEAR];
+	const F32 distFromNearPlane = max(0.0f, testPlane(nearPlane, sp.getAabb()));
+	el->m_distanceFromCamera = !!(rc.getFlags() & RenderComponentFlag::SORT_LAST) ? frc.getFar() : distFromNearPlane;
+
+	// Choose the LOD from the size of the bounding sphere on the screen. The closest point of the box gives the depth
+	const Aabb& box = sp.getAabb();
+	const F32 radius = (box.getMax() - box.getMin()).getLength() * 0.5f;
+	F32 screenSize = radius * frc.getProjectionMatrix()(1, 1) * rc.getLodScreenSizeScale();
+	if(frc.getFrustumType() == FrustumType::PERSPECTIVE)
+	{
+		screenSize /= distFromNearPlane + frc.getNear();
+	}
+
+	const VisibilityContext& visCtx = *frcCtx.m_visCtx;
+	const Bool keepsLodHistory = &frc == visCtx.m_lodHistoryFrc;
+	el->m_lod = computeLod(screenSize, visCtx.m_lodScreenSizes, visCtx.m_lodHysteresis,
+						   (keepsLodHistory) ? rc.getLodHistory() : MAX_U8);
+	if(keepsLodHistory)
+	{
+		rc.setLodHistory(el->m_lod);
+	}
+
+	// The forward shading renderables are blended so draw them back to front
+	*sortKey = (forwardShading) ? (computeDistanceSortKey(el->m_distanceFromCamera) ^ MAX_U32)
+								: computeMaterialDistanceSortKey(*el);
+
+	if(wantsEarlyZ && el->m_distanceFromCamera < frcCtx.m_visCtx->m_earlyZDist && !forwardShading)
+	{
+		RenderableQueueElement* el2 = result.m_earlyZRenderables.newElement(alloc);
+		*el2 = *el;
+		*result.m_earlyZRenderableSortKeys.newElement(alloc) = computeDistanceSortKey(el->m_distanceFromCamera);
+	}
+}
+
+void CombineResultsTask::combine(ThreadHive& hive)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_COMBINE_RESULTS);
 
@@ -665,9 +996,13 @@ void CombineResultsTask::combine()
 								 results.member_, &results.ptrMember_); \
 	}
 
-	ANKI_VIS_COMBINE(RenderableQueueElement, m_renderables);
-	ANKI_VIS_COMBINE(RenderableQueueElement, m_earlyZRenderables);
-	ANKI_VIS_COMBINE(RenderableQueueElement, m_forwardShadingRenderables);
+	combineAndSortRenderables(hive, alloc, &RenderQueueView::m_renderables, &RenderQueueView::m_renderableSortKeys,
+							  results.m_renderables);
+	combineAndSortRenderables(hive, alloc, &RenderQueueView::m_earlyZRenderables,
+							  &RenderQueueView::m_earlyZRenderableSortKeys, results.m_earlyZRenderables);
+	combineAndSortRenderables(hive, alloc, &RenderQueueView::m_forwardShadingRenderables,
+							  &RenderQueueView::m_forwardShadingRenderableSortKeys,
+							  results.m_forwardShadingRenderables);
 	ANKI_VIS_COMBINE_AND_PTR(PointLightQueueElement, m_pointLights, m_shadowPointLights);
 	ANKI_VIS_COMBINE_AND_PTR(SpotLightQueueElement, m_spotLights, m_shadowSpotLights);
 	ANKI_VIS_COMBINE(ReflectionProbeQueueElement, m_reflectionProbes);
@@ -700,16 +1035,27 @@ void CombineResultsTask::combine()
 	}
 #endif
 
-	// Sort some of the arrays
-	std::sort(results.m_renderables.getBegin(), results.m_renderables.getEnd(), MaterialDistanceSortFunctor(20.0f));
+	// Sort the rest of the arrays
+	std::sort(results.m_giProbes.getBegin(), results.m_giProbes.getEnd());
 
-	std::sort(results.m_earlyZRenderables.getBegin(), results.m_earlyZRenderables.getEnd(),
-			  DistanceSortFunctor<RenderableQueueElement>());
+	// Keep the visibles for the next frame
+	if(m_frcCtx->m_frc->getVisibilityCacheEnabled())
+	{
+		Array<TRenderQueueElementStorage<SpatialComponent*>, 64> subStorages;
+		for(U32 i = 0; i < threadCount; ++i)
+		{
+			subStorages[i] = m_frcCtx->m_queueViews[i].m_visibleSpatials;
+		}
 
-	std::sort(results.m_forwardShadingRenderables.getBegin(), results.m_forwardShadingRenderables.getEnd(),
-			  RevDistanceSortFunctor<RenderableQueueElement>());
+		WeakArray<SpatialComponent*> visibles;
+		combineQueueElements<SpatialComponent*>(
+			alloc, WeakArray<TRenderQueueElementStorage<SpatialComponent*>>(&subStorages[0], threadCount), nullptr,
+			visibles, nullptr);
 
-	std::sort(results.m_giProbes.getBegin(), results.m_giProbes.getEnd());
+		// The frustum is not touched by any other task at this point
+		const_cast<FrustumComponent*>(m_frcCtx->m_frc)
+			->setCachedVisibles(visibles, m_frcCtx->m_visCtx->m_scene->getGlobalTimestamp());
+	}
 
 	// Cleanup
 	if(m_frcCtx->m_r)
@@ -813,6 +1159,52 @@ void CombineResultsTask::combineQueueElements(SceneFrameAllocator<U8>& alloc,
 	}
 }
 
+void CombineResultsTask::combineAndSortRenderables(ThreadHive& hive, SceneFrameAllocator<U8>& alloc,
+												   RenderablesMember renderablesMember, SortKeysMember sortKeysMember,
+												   WeakArray<RenderableQueueElement>& sorted) const
+{
+	const U32 threadCount = m_frcCtx->m_queueViews.getSize();
+	U32 count = 0;
+	for(U32 i = 0; i < threadCount; ++i)
+	{
+		const RenderQueueView& view = m_frcCtx->m_queueViews[i];
+		ANKI_ASSERT((view.*renderablesMember).m_elementCount == (view.*sortKeysMember).m_elementCount);
+		count += (view.*renderablesMember).m_elementCount;
+	}
+
+	if(count == 0)
+	{
+		return;
+	}
+
+	// Gather the keys and pointers to the renderables of all threads. The 2nd halves are the scratch of the sort
+	U64* keys = alloc.newArray<U64>(count * 2);
+	const RenderableQueueElement** renderables = alloc.newArray<const RenderableQueueElement*>(count * 2);
+	U32 offset = 0;
+	for(U32 i = 0; i < threadCount; ++i)
+	{
+		const RenderQueueView& view = m_frcCtx->m_queueViews[i];
+		const TRenderQueueElementStorage<RenderableQueueElement>& storage = view.*renderablesMember;
+
+		memcpy(keys + offset, (view.*sortKeysMember).m_elements, sizeof(U64) * storage.m_elementCount);
+		for(U32 x = 0; x < storage.m_elementCount; ++x)
+		{
+			renderables[offset + x] = &storage.m_elements[x];
+		}
+
+		offset += storage.m_elementCount;
+	}
+
+	// The sort writes the renderables to their final place. No one reads them before the hive finishes
+	RenderableQueueElement* out = alloc.newArray<RenderableQueueElement>(count);
+	sorted = WeakArray<RenderableQueueElement>(out, count);
+
+	const U32 taskCount = clamp(count / MIN_RENDERABLES_PER_SORT_TASK, 1u, hive.getThreadCount());
+	ThreadHiveSemaphore* sortSem;
+	radixSortGatherParallel(hive, taskCount, keys, renderables, count, keys + count, renderables + count, out, nullptr,
+							sortSem);
+}
+
 void SceneGraph::doVisibilityTests(SceneNode& fsn, SceneGraph& scene, RenderQueue& rqueue)
 {
 	ANKI_TRACE_SCOPED_EVENT(SCENE_VIS_TESTS);
@@ -821,7 +1213,11 @@ void SceneGraph::doVisibilityTests(SceneNode& fsn, SceneGraph& scene, RenderQueu
 
 	VisibilityContext ctx;
 	ctx.m_scene = &scene;
+	ctx.m_testEpoch = scene.newVisibilityTestsEpoch();
 	ctx.m_earlyZDist = scene.getLimits().m_earlyZDistance;
+	ctx.m_lodScreenSizes = scene.getLimits().m_lodScreenSizes;
+	ctx.m_lodHysteresis = scene.getLimits().m_lodHysteresis;
+	ctx.m_lodHistoryFrc = &fsn.getComponent<FrustumComponent>();
 	ctx.submitNewWork(fsn.getComponent<FrustumComponent>(), rqueue, hive);
 
 	hive.waitAllTasks();
@@ -11,66 +11,46 @@
 #include <anki/scene/Octree.h>
 #include <anki/util/Thread.h>
 #include <anki/util/Tracer.h>
+#include <anki/util/RadixSort.h>
 #include <anki/renderer/RenderQueue.h>
 
 namespace anki
 {
 
+// Forward
+class RenderComponent;
+class FrustumVisibilityContext;
+
 /// @addtogroup scene
 /// @{
 
 static const U32 MAX_SPATIALS_PER_VIS_TEST = 48; ///< Num of spatials to test in a single ThreadHive task.
 static const U32 SW_RASTERIZER_WIDTH = 80;
 static const U32 SW_RASTERIZER_HEIGHT = 50;
+static const U32 MAX_FRUSTUMS_PER_MULTI_TEST = 6; ///< Enough for the faces of a point light and the shadow cascades.
 
-/// Sort objects on distance
-template<typename T>
-class DistanceSortFunctor
-{
-public:
-	Bool operator()(const T& a, const T& b)
-	{
-		return a.m_distanceFromCamera < b.m_distanceFromCamera;
-	}
-};
+static const U32 MIN_RENDERABLES_PER_SORT_TASK = 2048; ///< Less than that per task and the sort uses fewer tasks.
+static const F32 MATERIAL_SORT_DISTANCE_GRANULARITY = 20.0f; ///< The size of the distance classes of the material sort.
 
-template<typename T>
-class RevDistanceSortFunctor
+/// Sort key that sorts on distance. The distance is positive so its bits sort like an integer.
+inline U64 computeDistanceSortKey(F32 distance)
 {
-public:
-	Bool operator()(const T& a, const T& b)
-	{
-		return a.m_distanceFromCamera > b.m_distanceFromCamera;
-	}
-};
-
-/// Material and distance sort.
-class MaterialDistanceSortFunctor
+	ANKI_ASSERT(distance >= 0.0f);
+	U32 bits;
+	memcpy(&bits, &distance, sizeof(bits));
+	return bits;
+}
+
+/// Sort key that sorts on the distance class first, then it groups the renderables with the same material so they can
+/// be merged and then it sorts on the distance inside the class.
+inline U64 computeMaterialDistanceSortKey(const RenderableQueueElement& el)
 {
-public:
-	MaterialDistanceSortFunctor(F32 distanceGranularity)
-		: m_distGranularity(1.0f / distanceGranularity)
-	{
-	}
-
-	Bool operator()(const RenderableQueueElement& a, const RenderableQueueElement& b)
-	{
-		const U32 aClass = U32(a.m_distanceFromCamera * m_distGranularity);
-		const U32 bClass = U32(b.m_distanceFromCamera * m_distGranularity);
-
-		if(aClass == bClass && a.m_callback == b.m_callback)
-		{
-			return a.m_mergeKey < b.m_mergeKey;
-		}
-		else
-		{
-			return a.m_distanceFromCamera < b.m_distanceFromCamera;
-		}
-	}
-
-private:
-	F32 m_distGranularity;
-};
+	const F32 distClass = el.m_distanceFromCamera / MATERIAL_SORT_DISTANCE_GRANULARITY;
+	const U64 coarseDist = min<U64>(U64(distClass), 0xFFFF);
+	const U64 fineDist = U64((distClass - std::floor(distClass)) * F32(0xFFFF));
+	const U64 material = (el.m_mergeKey ^ (ptrToNumber(el.m_callback) * 0x9E3779B97F4A7C15)) >> 32;
+	return (coarseDist << 48) | (material << 16) | fineDist;
+}
 
 /// Storage for a single element type.
 template<typename T, U32 INITIAL_STORAGE_SIZE = 32, U32 STORAGE_GROW_RATE = 4>
@@ -106,6 +86,9 @@ public:
 	TRenderQueueElementStorage<RenderableQueueElement> m_renderables; ///< Deferred shading or shadow renderables.
 	TRenderQueueElementStorage<RenderableQueueElement> m_forwardShadingRenderables;
 	TRenderQueueElementStorage<RenderableQueueElement> m_earlyZRenderables;
+	TRenderQueueElementStorage<U64> m_renderableSortKeys; ///< One sort key for every element of m_renderables.
+	TRenderQueueElementStorage<U64> m_forwardShadingRenderableSortKeys;
+	TRenderQueueElementStorage<U64> m_earlyZRenderableSortKeys;
 	TRenderQueueElementStorage<PointLightQueueElement> m_pointLights;
 	TRenderQueueElementStorage<U32> m_shadowPointLights;
 	TRenderQueueElementStorage<SpotLightQueueElement> m_spotLights;
@@ -117,6 +100,7 @@ public:
 	TRenderQueueElementStorage<FogDensityQueueElement> m_fogDensityVolumes;
 	TRenderQueueElementStorage<GlobalIlluminationProbeQueueElement> m_giProbes;
 	TRenderQueueElementStorage<GenericGpuComputeJobQueueElement> m_genericGpuComputeJobs;
+	TRenderQueueElementStorage<SpatialComponent*> m_visibleSpatials; ///< To update the visibility cache.
 
 	Timestamp m_timestamp = 0;
 
@@ -134,13 +118,39 @@ class VisibilityContext
 public:
 	SceneGraph* m_scene = nullptr;
 	Atomic<U32> m_testsCount = {0};
+	U32 m_testEpoch = 0; ///< All the tests of this context share it. See OctreePlaceable::computeTestId.
 
 	F32 m_earlyZDist = -1.0f; ///< Cache this.
+	Array<F32, MAX_LOD_COUNT - 1> m_lodScreenSizes = {{-1.0f, -1.0f}}; ///< Cache this.
+	F32 m_lodHysteresis = 0.0f; ///< Cache this.
+
+	/// The frustum that keeps the LOD history of the renderables. Only its LODs have hysteresis.
+	const FrustumComponent* m_lodHistoryFrc = nullptr;
 
 	List<const FrustumComponent*> m_testedFrcs;
 	Mutex m_mtx;
 
 	void submitNewWork(const FrustumComponent& frc, RenderQueue& result, ThreadHive& hive);
+
+	/// Submit the work of many frustums. The frustums that only want the shadow casters (like the cascades of a
+	/// directional light or the faces of a point light) are tested together with a single octree walk.
+	void submitNewWork(ConstWeakArray<const FrustumComponent*> frcs, WeakArray<RenderQueue> results, ThreadHive& hive);
+
+private:
+	/// Create the context of a frustum. Returns nullptr if the frustum doesn't need to be tested.
+	FrustumVisibilityContext* newFrustumContext(const FrustumComponent& frc, RenderQueue& result, ThreadHive& hive);
+
+	/// Submit the tasks that will test a single frustum.
+	void submitFrustumTasks(FrustumVisibilityContext* frcCtx, ThreadHive& hive);
+
+	/// Can the frustum be tested with others in a single pass.
+	static Bool canTestWithOtherFrustums(const FrustumComponent& frc)
+	{
+		return frc.visibilityTestsEnabled(FrustumComponentVisibilityTestFlag::SHADOW_CASTERS)
+			   && !frc.visibilityTestsEnabled(FrustumComponentVisibilityTestFlag::ALL
+											  ^ FrustumComponentVisibilityTestFlag::SHADOW_CASTERS)
+			   && !frc.hasCoverageBuffer();
+	}
 };
 
 /// A context for a specific test of a frustum component.
@@ -155,6 +165,11 @@ public:
 	SoftwareRasterizer* m_r = nullptr;
 	DynamicArray<Vec3> m_verts;
 	Atomic<U32> m_rasterizedVertCount = {0}; ///< That will be used by the RasterizeTrianglesTask.
+	DynamicArray<const OccluderComponent*> m_occluders; ///< The occluders inside the frustum.
+
+	// Visibility cache members
+	ConstWeakArray<SpatialComponent*> m_cachedVisibles;
+	Bool m_visibilityCacheHit = false; ///< If true test only what changed since the previous frame.
 
 	// Visibility test members
 	DynamicArray<RenderQueueView> m_queueViews; ///< Sub result. Will be combined later.
@@ -164,6 +179,18 @@ public:
 	RenderQueue* m_renderQueue = nullptr;
 };
 
+/// A context for frustums that are tested together. The octree is walked once and every spatial is tested against all
+/// the frustums. The visibles are binned to the RenderQueueView of every frustum they are visible from.
+/// @note Should be trivially destructible.
+class MultiFrustumVisibilityContext
+{
+public:
+	VisibilityContext* m_visCtx = nullptr;
+	Array<FrustumVisibilityContext*, MAX_FRUSTUMS_PER_MULTI_TEST> m_frcCtxs;
+	U32 m_frcCount = 0;
+	ThreadHiveSemaphore* m_visTestsSignalSem = nullptr; ///< Shared with the contexts of all the frustums.
+};
+
 /// ThreadHive task to set the depth map of the S/W rasterizer.
 class FillRasterizerWithCoverageTask
 {
@@ -176,16 +203,42 @@ public:
 		ANKI_ASSERT(m_frcCtx);
 	}
 
-	void fill();
+	/// Fill the depth buffer and then spawn tasks to rasterize the occluders.
+	/// @param signalSemaphore The semaphore that this task signals. It's increased to wait for the new tasks.
+	void fill(ThreadHive& hive, ThreadHiveSemaphore* signalSemaphore);
+
+private:
+	void gatherOccluders();
 };
 static_assert(std::is_trivially_destructible<FillRasterizerWithCoverageTask>::value == true,
 			  "Should be trivially destructible");
 
+/// ThreadHive task that rasterizes a part of the occluders with SoftwareRasterizer::draw().
+class DrawOccludersTask
+{
+public:
+	FrustumVisibilityContext* m_frcCtx = nullptr;
+	U32 m_taskIdx = 0;
+	U32 m_taskCount = 0;
+
+	DrawOccludersTask(FrustumVisibilityContext* frcCtx, U32 taskIdx, U32 taskCount)
+		: m_frcCtx(frcCtx)
+		, m_taskIdx(taskIdx)
+		, m_taskCount(taskCount)
+	{
+		ANKI_ASSERT(m_frcCtx);
+	}
+
+	void draw();
+};
+static_assert(std::is_trivially_destructible<DrawOccludersTask>::value == true, "Should be trivially destructible");
+
 /// ThreadHive task to get visible nodes from the octree.
 class GatherVisiblesFromOctreeTask
 {
 public:
 	FrustumVisibilityContext* m_frcCtx = nullptr;
+	MultiFrustumVisibilityContext* m_multiFrcCtx = nullptr;
 
 	GatherVisiblesFromOctreeTask(FrustumVisibilityContext* frcCtx)
 		: m_frcCtx(frcCtx)
@@ -193,12 +246,37 @@ public:
 		ANKI_ASSERT(m_frcCtx);
 	}
 
+	GatherVisiblesFromOctreeTask(MultiFrustumVisibilityContext* multiFrcCtx)
+		: m_multiFrcCtx(multiFrcCtx)
+	{
+		ANKI_ASSERT(m_multiFrcCtx);
+	}
+
 	void gather(ThreadHive& hive);
 
 private:
 	Array<SpatialComponent*, MAX_SPATIALS_PER_VIS_TEST> m_spatials;
 	U32 m_spatialCount = 0;
 
+	/// Add a spatial to m_spatials and flush if it's full.
+	void pushSpatial(SpatialComponent* sp, ThreadHive& hive);
+
+	/// Gather the visibles of the previous frame and the spatials that changed since then.
+	void gatherFromCache(ThreadHive& hive);
+
+	/// Walk the octree once for all the frustums of m_multiFrcCtx.
+	void gatherMulti(ThreadHive& hive);
+
+	VisibilityContext& getVisibilityContext() const
+	{
+		return (m_multiFrcCtx) ? *m_multiFrcCtx->m_visCtx : *m_frcCtx->m_visCtx;
+	}
+
+	ThreadHiveSemaphore* getVisTestsSignalSemaphore() const
+	{
+		return (m_multiFrcCtx) ? m_multiFrcCtx->m_visTestsSignalSem : m_frcCtx->m_visTestsSignalSem;
+	}
+
 	/// Submit tasks to test the m_spatials.
 	void flush(ThreadHive& hive);
 };
@@ -210,6 +288,7 @@ class VisibilityTestTask
 {
 public:
 	FrustumVisibilityContext* m_frcCtx = nullptr;
+	MultiFrustumVisibilityContext* m_multiFrcCtx = nullptr;
 
 	Array<SpatialComponent*, MAX_SPATIALS_PER_VIS_TEST> m_spatialsToTest;
 	U32 m_spatialToTestCount = 0;
@@ -220,9 +299,22 @@ public:
 		ANKI_ASSERT(m_frcCtx);
 	}
 
+	VisibilityTestTask(MultiFrustumVisibilityContext* multiFrcCtx)
+		: m_multiFrcCtx(multiFrcCtx)
+	{
+		ANKI_ASSERT(m_multiFrcCtx);
+	}
+
 	void test(ThreadHive& hive, U32 taskId);
 
 private:
+	/// Test the shadow casters against all the frustums of m_multiFrcCtx.
+	void testMulti(U32 taskId);
+
+	/// Append a renderable to the results of a frustum.
+	static void pushRenderable(RenderComponent& rc, const SpatialComponent& sp,
+							   const FrustumVisibilityContext& frcCtx, Bool wantsEarlyZ, RenderQueueView& result);
+
 	ANKI_USE_RESULT Bool testAgainstRasterizer(const Aabb& aabb) const
 	{
 		return (m_frcCtx->m_r) ? m_frcCtx->m_r->visibilityTest(aabb) : true;
@@ -231,6 +323,9 @@ private:
 static_assert(std::is_trivially_destructible<VisibilityTestTask>::value == true, "Should be trivially destructible");
 
 /// Task that combines and sorts the results.
+/// @note The visibility test tasks are spawned while the octree is walked and they append to the RenderQueueView of
+///       their thread, so the final counts are known only after all of them finish. The renderables are written to
+///       the RenderQueue by the sort tasks, at the offsets of their prefix sums. The rest of the results are copied.
 class CombineResultsTask
 {
 public:
@@ -242,7 +337,7 @@ public:
 		ANKI_ASSERT(m_frcCtx);
 	}
 
-	void combine();
+	void combine(ThreadHive& hive);
 
 private:
 	template<typename T>
@@ -250,6 +345,17 @@ private:
 									 WeakArray<TRenderQueueElementStorage<T>> subStorages,
 									 WeakArray<TRenderQueueElementStorage<U32>>* ptrSubStorage, WeakArray<T>& combined,
 									 WeakArray<T*>* ptrCombined);
+
+	using RenderablesMember = TRenderQueueElementStorage<RenderableQueueElement> RenderQueueView::*;
+	using SortKeysMember = TRenderQueueElementStorage<U64> RenderQueueView::*;
+
+	/// Combine the renderables of all the threads and sort them using the sort keys computed by the visibility tests.
+	/// Only the keys and pointers are combined. The sort tasks write every renderable once, from its thread straight to
+	/// its sorted place in @a sorted, so @a sorted is filled when the hive finishes. The rest of the element types go
+	/// through combineQueueElements, which copies all the threads but the one with the biggest storage.
+	void combineAndSortRenderables(ThreadHive& hive, SceneFrameAllocator<U8>& alloc,
+								   RenderablesMember renderablesMember, SortKeysMember sortKeysMember,
+								   WeakArray<RenderableQueueElement>& sorted) const;
 };
 static_assert(std::is_trivially_destructible<CombineResultsTask>::value == true, "Should be trivially destructible");
 /// @}
@@ -42,6 +42,7 @@ public:
 	{
 		m_sizes = Vec3(width, height, depth);
 		m_markedForUpdate = true;
+		markNodeForUpdate();
 	}
 
 	F32 getWidth() const
@@ -69,6 +70,7 @@ public:
 		ANKI_ASSERT(trf.getScale() == 1.0f);
 		m_trf = trf;
 		m_markedForUpdate = true;
+		markNodeForUpdate();
 	}
 
 	void setDrawCallback(RenderQueueDrawCallback callback, const void* userData)
@@ -5,6 +5,7 @@
 
 #include <anki/scene/components/FrustumComponent.h>
 #include <anki/scene/SceneNode.h>
+#include <anki/scene/SceneGraph.h>
 #include <anki/scene/components/SpatialComponent.h>
 
 namespace anki
@@ -35,6 +36,7 @@ FrustumComponent::FrustumComponent(SceneNode* node, FrustumType frustumType)
 FrustumComponent::~FrustumComponent()
 {
 	m_coverageBuff.m_depthMap.destroy(m_node->getAllocator());
+	m_visCache.m_visibles.destroy(m_node->getAllocator());
 }
 
 Bool FrustumComponent::updateInternal()
@@ -137,7 +139,8 @@ Bool FrustumComponent::updateInternal()
 	return updated;
 }
 
-void FrustumComponent::fillCoverageBufferCallback(void* userData, F32* depthValues, U32 width, U32 height)
+void FrustumComponent::fillCoverageBufferCallback(void* userData, F32* depthValues, U32 width, U32 height,
+												  const Mat4& viewProjMat)
 {
 	ANKI_ASSERT(userData && depthValues && width > 0 && height > 0);
 	FrustumComponent& self = *static_cast<FrustumComponent*>(userData);
@@ -148,6 +151,44 @@ void FrustumComponent::fillCoverageBufferCallback(void* userData, F32* depthValu
 
 	self.m_coverageBuff.m_depthMapWidth = width;
 	self.m_coverageBuff.m_depthMapHeight = height;
+	self.m_coverageBuff.m_depthMapViewProjMat = viewProjMat;
+}
+
+Bool FrustumComponent::getCachedVisibles(const SceneGraph& scene, ConstWeakArray<SpatialComponent*>& visibles) const
+{
+	// Only the updates of the current frame are known so the cache has to be from the previous one. It's also stale if
+	// the frustum changed since then, if a spatial got deleted or if the tests are different. The occlusion changes
+	// every frame so don't bother with the frustums that test against occluders
+	const Bool valid = m_visCache.m_enabled && m_visCache.m_timestamp > 0
+					   && m_visCache.m_timestamp == scene.getPreviousGlobalTimestamp()
+					   && getTimestamp() <= m_visCache.m_timestamp
+					   && scene.getSpatialRemovalTimestamp() <= m_visCache.m_timestamp && m_visCache.m_flags == m_flags
+					   && !visibilityTestsEnabled(FrustumComponentVisibilityTestFlag::OCCLUDERS);
+
+	if(valid && m_visCache.m_visibles.getSize() > 0)
+	{
+		visibles = ConstWeakArray<SpatialComponent*>(&m_visCache.m_visibles[0], m_visCache.m_visibles.getSize());
+	}
+	else
+	{
+		visibles = ConstWeakArray<SpatialComponent*>();
+	}
+
+	return valid;
+}
+
+void FrustumComponent::setCachedVisibles(ConstWeakArray<SpatialComponent*> visibles, Timestamp timestamp)
+{
+	ANKI_ASSERT(m_visCache.m_enabled && timestamp > 0);
+
+	m_visCache.m_visibles.resize(m_node->getAllocator(), visibles.getSize());
+	if(visibles.getSize() > 0)
+	{
+		memcpy(&m_visCache.m_visibles[0], &visibles[0], visibles.getSizeInBytes());
+	}
+
+	m_visCache.m_timestamp = timestamp;
+	m_visCache.m_flags = m_flags;
 }
 
 void FrustumComponent::setEnabledVisibilityTests(FrustumComponentVisibilityTestFlag bits)
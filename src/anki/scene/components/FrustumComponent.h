@@ -82,6 +82,7 @@ public:
 		m_perspective.m_fovX = fovX;
 		m_perspective.m_fovY = fovY;
 		m_shapeMarkedForUpdate = true;
+		markNodeForUpdate();
 	}
 
 	void setOrthographic(F32 near, F32 far, F32 right, F32 left, F32 top, F32 bottom)
@@ -96,12 +97,14 @@ public:
 		m_ortho.m_top = top;
 		m_ortho.m_bottom = bottom;
 		m_shapeMarkedForUpdate = true;
+		markNodeForUpdate();
 	}
 
 	void setNear(F32 near)
 	{
 		m_common.m_near = near;
 		m_shapeMarkedForUpdate = true;
+		markNodeForUpdate();
 	}
 
 	F32 getNear() const
@@ -113,6 +116,7 @@ public:
 	{
 		m_common.m_far = far;
 		m_shapeMarkedForUpdate = true;
+		markNodeForUpdate();
 	}
 
 	F32 getFar() const
@@ -124,6 +128,7 @@ public:
 	{
 		ANKI_ASSERT(m_frustumType == FrustumType::PERSPECTIVE);
 		m_shapeMarkedForUpdate = true;
+		markNodeForUpdate();
 		m_perspective.m_fovX = fovx;
 	}
 
@@ -137,6 +142,7 @@ public:
 	{
 		ANKI_ASSERT(m_frustumType == FrustumType::PERSPECTIVE);
 		m_shapeMarkedForUpdate = true;
+		markNodeForUpdate();
 		m_perspective.m_fovY = fovy;
 	}
 
@@ -160,6 +166,7 @@ public:
 	{
 		m_trf = trf;
 		m_trfMarkedForUpdate = true;
+		markNodeForUpdate();
 	}
 
 	const Mat4& getProjectionMatrix() const
@@ -217,28 +224,53 @@ public:
 	}
 
 	/// The type is FillCoverageBufferCallback.
-	static void fillCoverageBufferCallback(void* userData, F32* depthValues, U32 width, U32 height);
+	static void fillCoverageBufferCallback(void* userData, F32* depthValues, U32 width, U32 height,
+										   const Mat4& viewProjMat);
 
 	Bool hasCoverageBuffer() const
 	{
 		return m_coverageBuff.m_depthMap.getSize() > 0;
 	}
 
-	void getCoverageBufferInfo(ConstWeakArray<F32>& depthBuff, U32& width, U32& height) const
+	/// @param[out] viewProjMat The view projection matrix the coverage buffer was rendered with.
+	void getCoverageBufferInfo(ConstWeakArray<F32>& depthBuff, U32& width, U32& height, Mat4& viewProjMat) const
 	{
 		if(m_coverageBuff.m_depthMap.getSize() > 0)
 		{
 			depthBuff = ConstWeakArray<F32>(&m_coverageBuff.m_depthMap[0], m_coverageBuff.m_depthMap.getSize());
 			width = m_coverageBuff.m_depthMapWidth;
 			height = m_coverageBuff.m_depthMapHeight;
+			viewProjMat = m_coverageBuff.m_depthMapViewProjMat;
 		}
 		else
 		{
 			depthBuff = ConstWeakArray<F32>();
 			width = height = 0;
+			viewProjMat = Mat4::getIdentity();
 		}
 	}
 
+	/// Keep the visibility results of this frustum between frames. The frustums that rarely move (like the ones of the
+	/// shadow casting lights) can then skip most of the visibility tests.
+	void setVisibilityCacheEnabled(Bool enable)
+	{
+		m_visCache.m_enabled = enable;
+		m_visCache.m_timestamp = 0;
+	}
+
+	Bool getVisibilityCacheEnabled() const
+	{
+		return m_visCache.m_enabled;
+	}
+
+	/// Get the visibles of the previous frame if they are still usable.
+	/// @param[out] visibles The spatials that were inside the frustum in the previous frame.
+	/// @return False if the cache is disabled or stale.
+	Bool getCachedVisibles(const SceneGraph& scene, ConstWeakArray<SpatialComponent*>& visibles) const;
+
+	/// Replace the cached visibles. The visibility tests call it at the end of every frame.
+	void setCachedVisibles(ConstWeakArray<SpatialComponent*> visibles, Timestamp timestamp);
+
 	/// Set how far to render shadows for this frustum or set to negative if you want to use the m_frustun's far.
 	void setEffectiveShadowDistance(F32 distance)
 	{
@@ -351,8 +383,18 @@ private:
 		DynamicArray<F32> m_depthMap;
 		U32 m_depthMapWidth = 0;
 		U32 m_depthMapHeight = 0;
+		Mat4 m_depthMapViewProjMat = Mat4::getIdentity();
 	} m_coverageBuff; ///< Coverage buffer for extra visibility tests.
 
+	class
+	{
+	public:
+		DynamicArray<SpatialComponent*> m_visibles;
+		Timestamp m_timestamp = 0; ///< The frame the visibles were computed. Zero if never.
+		FrustumComponentVisibilityTestFlag m_flags = FrustumComponentVisibilityTestFlag::NONE;
+		Bool m_enabled = false;
+	} m_visCache; ///< Visibility results of the previous frame.
+
 	FrustumComponentVisibilityTestFlag m_flags = FrustumComponentVisibilityTestFlag::NONE;
 	Bool m_shapeMarkedForUpdate = true;
 	Bool m_trfMarkedForUpdate = true;
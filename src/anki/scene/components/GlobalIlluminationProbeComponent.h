@@ -40,6 +40,7 @@ public:
 		m_aabbMax = max.xyz();
 		updateMembers();
 		m_dirty = true;
+		markNodeForUpdate();
 	}
 
 	/// Set the cell size in meters.
@@ -49,6 +50,7 @@ public:
 		m_cellSize = cellSize;
 		updateMembers();
 		m_dirty = true;
+		markNodeForUpdate();
 	}
 
 	F32 getCellSize() const
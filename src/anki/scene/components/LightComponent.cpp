@@ -72,7 +72,7 @@ Error LightComponent::update(SceneNode& node, Second prevTime, Second crntTime,
 	// Update the scene bounds always
 	if(m_type == LightComponentType::DIRECTIONAL)
 	{
-		node.getSceneGraph().getOctree().getActualSceneBounds(m_dir.m_sceneMin, m_dir.m_sceneMax);
+		node.getSceneGraph().getActualSceneBounds(m_dir.m_sceneMin, m_dir.m_sceneMax);
 	}
 
 	return Error::NONE;
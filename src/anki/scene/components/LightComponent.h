@@ -44,6 +44,7 @@ public:
 	{
 		m_trf = trf;
 		m_trfDirty = true;
+		markNodeForUpdate();
 	}
 
 	const Vec4& getDiffuseColor() const
@@ -60,6 +61,7 @@ public:
 	{
 		m_point.m_radius = x;
 		m_componentDirty = true;
+		markNodeForUpdate();
 	}
 
 	F32 getRadius() const
@@ -71,6 +73,7 @@ public:
 	{
 		m_spot.m_distance = x;
 		m_componentDirty = true;
+		markNodeForUpdate();
 	}
 
 	F32 getDistance() const
@@ -83,6 +86,7 @@ public:
 		m_spot.m_innerAngleCos = cos(ang / 2.0f);
 		m_spot.m_innerAngle = ang;
 		m_componentDirty = true;
+		markNodeForUpdate();
 	}
 
 	F32 getInnerAngleCos() const
@@ -100,6 +104,7 @@ public:
 		m_spot.m_outerAngleCos = cos(ang / 2.0f);
 		m_spot.m_outerAngle = ang;
 		m_componentDirty = true;
+		markNodeForUpdate();
 	}
 
 	F32 getOuterAngle() const
@@ -120,6 +125,7 @@ public:
 	void setShadowEnabled(const Bool x)
 	{
 		m_shadow = x;
+		markNodeForUpdate(); // The light nodes update their frustums
 	}
 
 	void setDrawCallback(RenderQueueDrawCallback callback, const void* userData)
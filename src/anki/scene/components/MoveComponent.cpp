@@ -13,7 +13,7 @@ MoveComponent::MoveComponent(MoveComponentFlag flags)
 	: SceneComponent(CLASS_TYPE)
 	, m_flags(flags)
 {
-	markForUpdate();
+	m_flags.set(MoveComponentFlag::MARKED_FOR_UPDATE);
 }
 
 MoveComponent::~MoveComponent()
@@ -69,12 +69,13 @@ Bool MoveComponent::updateWorldTransform(SceneNode& node)
 		m_flags.unset(MoveComponentFlag::MARKED_FOR_UPDATE);
 	}
 
-	// If this is dirty then make children dirty as well. Don't walk the whole tree because you will re-walk it later
+	// If this is dirty then make children dirty as well. Don't walk the whole tree because you will re-walk it later.
+	// Don't mark the nodes for update, the children of an updated node are updated anyway
 	if(dirty)
 	{
 		Error err = node.visitChildrenMaxDepth(1, [](SceneNode& childNode) -> Error {
 			Error e = childNode.iterateComponentsOfType<MoveComponent>([](MoveComponent& mov) -> Error {
-				mov.markForUpdate();
+				mov.m_flags.set(MoveComponentFlag::MARKED_FOR_UPDATE);
 				return Error::NONE;
 			});
 
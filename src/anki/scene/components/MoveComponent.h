@@ -35,6 +35,8 @@ ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(MoveComponentFlag)
 /// Interface for movable scene nodes
 class MoveComponent : public SceneComponent
 {
+	friend class SceneNode;
+
 public:
 	static const SceneComponentType CLASS_TYPE = SceneComponentType::MOVE;
 
@@ -163,6 +165,7 @@ private:
 	void markForUpdate()
 	{
 		m_flags.set(MoveComponentFlag::MARKED_FOR_UPDATE);
+		markNodeForUpdate();
 	}
 
 	/// Called every frame. It updates the @a m_wtrf if @a shouldUpdateWTrf is true. Then it moves to the children.
@@ -45,10 +45,13 @@ public:
 	}
 
 private:
+	friend class SceneGraph;
+
 	const Vec3* m_begin = nullptr;
 	U32 m_count = 0;
 	U32 m_stride = 0;
 	Aabb m_aabb;
+	U32 m_occluderIdx = MAX_U32; ///< The index in the occluder list of the SceneGraph.
 };
 /// @}
 
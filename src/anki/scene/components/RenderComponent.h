@@ -26,6 +26,34 @@ enum class RenderComponentFlag : U8
 };
 ANKI_ENUM_ALLOW_NUMERIC_OPERATIONS(RenderComponentFlag)
 
+/// Choose the LOD of a renderable from its size on the screen.
+/// @param screenSize The size of the renderable as a fraction of the screen height.
+/// @param lodScreenSizes The sizes below which the renderables switch to the next LOD.
+/// @param hysteresis To move away from prevLod the size has to go past a threshold by that fraction of it.
+/// @param prevLod The LOD the renderable had in the previous frame. MAX_U8 if it's not known.
+inline U8 computeLod(F32 screenSize, const Array<F32, MAX_LOD_COUNT - 1>& lodScreenSizes, F32 hysteresis, U8 prevLod)
+{
+	U8 lod = 0;
+	while(lod < MAX_LOD_COUNT - 1)
+	{
+		// Coming from a coarser LOD it takes a bigger size to cross the threshold and from a finer a smaller one
+		F32 threshold = lodScreenSizes[lod];
+		if(prevLod != MAX_U8)
+		{
+			threshold *= (prevLod > lod) ? (1.0f + hysteresis) : (1.0f - hysteresis);
+		}
+
+		if(screenSize >= threshold)
+		{
+			break;
+		}
+
+		++lod;
+	}
+
+	return lod;
+}
+
 /// Render component interface. Implemented by renderable scene nodes
 class RenderComponent : public SceneComponent
 {
@@ -57,6 +85,31 @@ public:
 		m_mergeKey = mergeKey;
 	}
 
+	/// Scale the size of the renderable on the screen before choosing its LOD. Values bigger than 1.0 keep the detailed
+	/// LODs for longer. Use them on objects that show their simplification more.
+	void setLodScreenSizeScale(F32 scale)
+	{
+		ANKI_ASSERT(scale > 0.0f);
+		m_lodScreenSizeScale = scale;
+	}
+
+	F32 getLodScreenSizeScale() const
+	{
+		return m_lodScreenSizeScale;
+	}
+
+	/// The LOD the camera chose the last time it saw the renderable. MAX_U8 if it never saw it.
+	U8 getLodHistory() const
+	{
+		return m_lodHistory;
+	}
+
+	void setLodHistory(U8 lod)
+	{
+		ANKI_ASSERT(lod < MAX_LOD_COUNT);
+		m_lodHistory = lod;
+	}
+
 	void setupRenderableQueueElement(RenderableQueueElement& el) const
 	{
 		ANKI_ASSERT(el.m_callback != nullptr);
@@ -71,7 +124,9 @@ private:
 	RenderQueueDrawCallback m_callback ANKI_DEBUG_CODE(= nullptr);
 	const void* m_userData ANKI_DEBUG_CODE(= nullptr);
 	U64 m_mergeKey ANKI_DEBUG_CODE(= MAX_U64);
+	F32 m_lodScreenSizeScale = 1.0f;
 	RenderComponentFlag m_flags = RenderComponentFlag::NONE;
+	U8 m_lodHistory = MAX_U8;
 };
 
 /// A wrapper on top of MaterialVariable
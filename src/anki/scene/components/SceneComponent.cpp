@@ -0,0 +1,21 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <anki/scene/components/SceneComponent.h>
+#include <anki/scene/SceneNode.h>
+
+namespace anki
+{
+
+void SceneComponent::markNodeForUpdate()
+{
+	// It's null while the component is constructed. The node will be updated when it's registered anyway
+	if(m_ownerNode)
+	{
+		m_ownerNode->markForUpdate();
+	}
+}
+
+} // end namespace anki
@@ -42,9 +42,22 @@ enum class SceneComponentType : U16
 	LAST_COMPONENT_ID = PLAYER_CONTROLLER
 };
 
+/// A mask with one bit for every SceneComponentType.
+using SceneComponentTypeMask = U32;
+static_assert(U32(SceneComponentType::COUNT) <= sizeof(SceneComponentTypeMask) * 8, "Won't fit");
+
+/// Get the bit of a component type in a SceneComponentTypeMask.
+inline constexpr SceneComponentTypeMask getSceneComponentTypeBit(SceneComponentType type)
+{
+	return SceneComponentTypeMask(1) << SceneComponentTypeMask(type);
+}
+
 /// Scene node component
 class SceneComponent
 {
+	friend class SceneNode;
+	friend class SceneGraph;
+
 public:
 	/// Construct the scene component.
 	SceneComponent(SceneComponentType type)
@@ -88,7 +101,14 @@ public:
 		m_timestamp = timestamp;
 	}
 
+protected:
+	/// The components should call it when they get dirty so the SceneGraph will visit their node in the next update.
+	/// @note It's thread-safe.
+	void markNodeForUpdate();
+
 private:
+	SceneNode* m_ownerNode = nullptr; ///< Set by SceneNode::newComponent.
+	Bool m_pooledMemory = false; ///< Set by SceneNode::newComponent if the memory came from a SceneComponentPool.
 	Timestamp m_timestamp = 1; ///< Indicates when an update happened
 	SceneComponentType m_type;
 };
@@ -7,7 +7,6 @@
 #include <anki/scene/SceneNode.h>
 #include <anki/resource/SkeletonResource.h>
 #include <anki/resource/AnimationResource.h>
-#include <anki/util/BitSet.h>
 
 namespace anki
 {
@@ -23,6 +22,7 @@ SkinComponent::SkinComponent(SceneNode* node, SkeletonResourcePtr skeleton)
 	m_boneTrfs[1].create(m_node->getAllocator(), m_skeleton->getBones().getSize(), Mat4::getIdentity());
 	m_animationTrfs.create(m_node->getAllocator(), m_skeleton->getBones().getSize(),
 						   {Vec3(0.0f), Quat::getIdentity(), 1.0f});
+	m_bonesAnimated.create(m_node->getAllocator(), m_skeleton->getBones().getSize(), false);
 }
 
 SkinComponent::~SkinComponent()
@@ -30,6 +30,13 @@ SkinComponent::~SkinComponent()
 	m_boneTrfs[0].destroy(m_node->getAllocator());
 	m_boneTrfs[1].destroy(m_node->getAllocator());
 	m_animationTrfs.destroy(m_node->getAllocator());
+	m_bonesAnimated.destroy(m_node->getAllocator());
+
+	for(Track& track : m_tracks)
+	{
+		track.m_channelCursors.destroy(m_node->getAllocator());
+		track.m_channelBones.destroy(m_node->getAllocator());
+	}
 }
 
 void SkinComponent::playAnimation(U32 track, AnimationResourcePtr anim, const AnimationPlayInfo& info)
@@ -37,6 +44,24 @@ void SkinComponent::playAnimation(U32 track, AnimationResourcePtr anim, const An
 	const Second animDuration = anim->getDuration();
 
 	m_tracks[track].m_anim = anim;
+	m_tracks[track].m_channelCursors.destroy(m_node->getAllocator());
+	m_tracks[track].m_channelCursors.create(m_node->getAllocator(), anim->getChannels().getSize());
+
+	// Find the bones of the channels once instead of every update
+	m_tracks[track].m_channelBones.destroy(m_node->getAllocator());
+	m_tracks[track].m_channelBones.create(m_node->getAllocator(), anim->getChannels().getSize());
+	for(U32 i = 0; i < anim->getChannels().getSize(); ++i)
+	{
+		const AnimationChannel& channel = anim->getChannels()[i];
+		const Bone* bone = m_skeleton->tryFindBone(channel.m_name.toCString());
+		if(!bone)
+		{
+			ANKI_SCENE_LOGW("Animation is referencing unknown bone \"%s\"", &channel.m_name[0]);
+		}
+
+		m_tracks[track].m_channelBones[i] = (bone) ? bone->getIndex() : MAX_U32;
+	}
+
 	m_tracks[track].m_absoluteStartTime = m_absoluteTime + info.m_startTime;
 	m_tracks[track].m_relativeTimePassed = 0.0;
 	if(info.m_repeatTimes > 0.0)
@@ -62,7 +87,7 @@ Error SkinComponent::update(SceneNode& node, Second prevTime, Second crntTime, B
 	Vec4 minExtend(MAX_F32, MAX_F32, MAX_F32, 0.0f);
 	Vec4 maxExtend(MIN_F32, MIN_F32, MIN_F32, 0.0f);
 
-	BitSet<128> bonesAnimated(false);
+	memset(&m_bonesAnimated[0], 0, m_bonesAnimated.getSizeInBytes());
 
 	for(Track& track : m_tracks)
 	{
@@ -94,23 +119,20 @@ Error SkinComponent::update(SceneNode& node, Second prevTime, Second crntTime, B
 		// Iterate the animation channels and interpolate
 		for(U32 i = 0; i < track.m_anim->getChannels().getSize(); ++i)
 		{
-			const AnimationChannel& channel = track.m_anim->getChannels()[i];
-			const Bone* bone = m_skeleton->tryFindBone(channel.m_name.toCString());
-			if(!bone)
+			const U32 boneIdx = track.m_channelBones[i];
+			if(boneIdx == MAX_U32)
 			{
-				ANKI_SCENE_LOGW("Animation is referencing unknown bone \"%s\"", &channel.m_name[0]);
 				continue;
 			}
-			const U32 boneIdx = bone->getIndex();
 
 			// Interpolate
 			Vec3 position;
 			Quat rotation;
 			F32 scale;
-			track.m_anim->interpolate(i, animTime, position, rotation, scale);
+			track.m_anim->interpolate(i, animTime, track.m_channelCursors[i], position, rotation, scale);
 
 			// Blend with previous track
-			if(bonesAnimated.get(boneIdx) && (track.m_blendInTime > 0.0 || track.m_blendOutTime > 0.0))
+			if(m_bonesAnimated[boneIdx] && (track.m_blendInTime > 0.0 || track.m_blendOutTime > 0.0))
 			{
 				F32 blendInFactor;
 				if(track.m_blendInTime > 0.0)
@@ -145,7 +167,7 @@ Error SkinComponent::update(SceneNode& node, Second prevTime, Second crntTime, B
 			}
 
 			// Store
-			bonesAnimated.set(boneIdx);
+			m_bonesAnimated[boneIdx] = true;
 			m_animationTrfs[boneIdx] = {position, rotation, scale};
 		}
 	}
@@ -159,7 +181,7 @@ Error SkinComponent::update(SceneNode& node, Second prevTime, Second crntTime, B
 		m_crntBoneTrfs = m_crntBoneTrfs ^ 1;
 
 		// Walk the bone hierarchy to add additional transforms
-		visitBones(m_skeleton->getRootBone(), Mat4::getIdentity(), bonesAnimated, minExtend, maxExtend);
+		visitBones(m_skeleton->getRootBone(), Mat4::getIdentity(), minExtend, maxExtend);
 
 		const Vec4 E(EPSILON, EPSILON, EPSILON, 0.0f);
 		m_boneBoundingVolume.setMin(minExtend - E);
@@ -175,12 +197,11 @@ Error SkinComponent::update(SceneNode& node, Second prevTime, Second crntTime, B
 	return Error::NONE;
 }
 
-void SkinComponent::visitBones(const Bone& bone, const Mat4& parentTrf, const BitSet<128>& bonesAnimated,
-							   Vec4& minExtend, Vec4& maxExtend)
+void SkinComponent::visitBones(const Bone& bone, const Mat4& parentTrf, Vec4& minExtend, Vec4& maxExtend)
 {
 	Mat4 outMat;
 
-	if(bonesAnimated.get(bone.getIndex()))
+	if(m_bonesAnimated[bone.getIndex()])
 	{
 		const Trf& t = m_animationTrfs[bone.getIndex()];
 		outMat = parentTrf * Mat4(t.m_translation.xyz1(), Mat3(t.m_rotation), t.m_scale);
@@ -199,7 +220,7 @@ void SkinComponent::visitBones(const Bone& bone, const Mat4& parentTrf, const Bi
 
 	for(const Bone* child : bone.getChildren())
 	{
-		visitBones(*child, outMat, bonesAnimated, minExtend, maxExtend);
+		visitBones(*child, outMat, minExtend, maxExtend);
 	}
 }
 
@@ -15,6 +15,9 @@
 namespace anki
 {
 
+// Forward
+class AnimationChannelCursor;
+
 /// @addtogroup scene
 /// @{
 
@@ -75,6 +78,8 @@ private:
 	{
 	public:
 		AnimationResourcePtr m_anim;
+		DynamicArray<AnimationChannelCursor> m_channelCursors; ///< One for each channel of m_anim.
+		DynamicArray<U32> m_channelBones; ///< The bone of each channel of m_anim. MAX_U32 if there is no such bone.
 		Second m_absoluteStartTime = 0.0;
 		Second m_relativeTimePassed = 0.0;
 		Second m_blendInTime = 0.0;
@@ -94,14 +99,14 @@ private:
 	SkeletonResourcePtr m_skeleton;
 	Array<DynamicArray<Mat4>, 2> m_boneTrfs;
 	DynamicArray<Trf> m_animationTrfs;
+	DynamicArray<Bool> m_bonesAnimated; ///< The bones that some track animated in the current update.
 	Aabb m_boneBoundingVolume{Vec3(-1.0f), Vec3(1.0f)};
 	Array<Track, MAX_ANIMATION_TRACKS> m_tracks;
 	Second m_absoluteTime = 0.0;
 	U8 m_crntBoneTrfs = 0;
 	U8 m_prevBoneTrfs = 1;
 
-	void visitBones(const Bone& bone, const Mat4& parentTrf, const BitSet<128, U8>& bonesAnimated, Vec4& minExtend,
-					Vec4& maxExtend);
+	void visitBones(const Bone& bone, const Mat4& parentTrf, Vec4& minExtend, Vec4& maxExtend);
 };
 /// @}
 
@@ -60,9 +60,23 @@ SpatialComponent::SpatialComponent(SceneNode* node, const ConvexHullShape* hull)
 
 SpatialComponent::~SpatialComponent()
 {
+	if(m_spatialsToUpdateIdx != MAX_U32)
+	{
+		m_node->getSceneGraph().removeSpatialToUpdate(*this);
+	}
+
 	if(m_placed)
 	{
-		m_node->getSceneGraph().getOctree().remove(m_octreeInfo);
+		m_node->getSceneGraph().removeSpatial(m_octreeInfo);
+	}
+}
+
+void SpatialComponent::markForUpdate()
+{
+	if(!m_markedForUpdate)
+	{
+		m_markedForUpdate = true;
+		m_node->getSceneGraph().markSpatialForUpdate(*this);
 	}
 }
 
@@ -94,12 +108,10 @@ Error SpatialComponent::update(SceneNode& node, Second prevTime, Second crntTime
 
 		m_markedForUpdate = false;
 
-		m_node->getSceneGraph().getOctree().place(m_derivedAabb, &m_octreeInfo, m_updateOctreeBounds);
+		m_node->getSceneGraph().placeSpatial(m_derivedAabb, &m_octreeInfo, m_updateOctreeBounds);
 		m_placed = true;
 	}
 
-	m_octreeInfo.reset();
-
 	return Error::NONE;
 }
 
@@ -21,6 +21,8 @@ namespace anki
 /// Spatial component. It is used by scene nodes that need to be placed inside the visibility structures.
 class SpatialComponent : public SceneComponent
 {
+	friend class SceneGraph;
+
 public:
 	static const SceneComponentType CLASS_TYPE = SceneComponentType::SPATIAL;
 
@@ -74,11 +76,10 @@ public:
 		m_origin = origin;
 	}
 
-	/// The derived class has to manually call this method when the collision shape got updated.
-	void markForUpdate()
-	{
-		m_markedForUpdate = true;
-	}
+	/// The derived class has to manually call this method when the collision shape got updated. It puts the spatial in
+	/// a list of the SceneGraph and only the spatials of that list are updated.
+	/// @note It's thread-safe against the marks of other spatials.
+	void markForUpdate();
 
 	/// Update the "actual scene bounds" of the octree or not.
 	void setUpdateOctreeBounds(Bool update)
@@ -110,6 +111,8 @@ private:
 
 	OctreePlaceable m_octreeInfo;
 
+	U32 m_spatialsToUpdateIdx = MAX_U32; ///< The index in the SceneGraph's list of spatials to update.
+
 	Bool m_markedForUpdate = false;
 	Bool m_placed = false;
 	Bool m_updateOctreeBounds = true;
@@ -24,6 +24,7 @@ Error AnimationEvent::init(const AnimationResourcePtr& anim, SceneNode* movableS
 	Event::init(m_anim->getStartingTime(), m_anim->getDuration());
 	m_reanimate = true;
 	m_associatedNodes.emplaceBack(getAllocator(), movableSceneNode);
+	m_touchesOnlyAssociatedNodes = true;
 
 	return Error::NONE;
 }
@@ -33,7 +34,7 @@ Error AnimationEvent::update(Second prevUpdateTime, Second crntTime)
 	Vec3 pos;
 	Quat rot;
 	F32 scale = 1.0;
-	m_anim->interpolate(0, crntTime, pos, rot, scale);
+	m_anim->interpolate(0, crntTime, m_cursor, pos, rot, scale);
 
 	Transform trf;
 	trf.setOrigin(pos.xyz0());
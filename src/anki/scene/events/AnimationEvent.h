@@ -25,6 +25,7 @@ public:
 
 private:
 	AnimationResourcePtr m_anim;
+	AnimationChannelCursor m_cursor;
 };
 /// @}
 
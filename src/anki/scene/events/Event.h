@@ -88,6 +88,13 @@ public:
 		m_associatedNodes.emplaceBack(getAllocator(), node);
 	}
 
+	/// If true the event touches nothing but its associated nodes and the EventManager can update it in parallel with
+	/// the events of other nodes.
+	Bool getTouchesOnlyAssociatedNodes() const
+	{
+		return m_touchesOnlyAssociatedNodes;
+	}
+
 	/// This method should be implemented by the derived classes
 	/// @param prevUpdateTime The time of the previous update (sec)
 	/// @param crntTime The current time (sec)
@@ -111,6 +118,7 @@ protected:
 
 	Bool m_markedForDeletion = false;
 	Bool m_reanimate = false;
+	Bool m_touchesOnlyAssociatedNodes = false;
 
 	DynamicArray<SceneNode*> m_associatedNodes;
 
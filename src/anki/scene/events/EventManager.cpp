@@ -6,10 +6,32 @@
 #include <anki/scene/events/EventManager.h>
 #include <anki/scene/events/Event.h>
 #include <anki/scene/SceneGraph.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/Tracer.h>
 
 namespace anki
 {
 
+/// With fewer events than that the update is serial.
+const U32 MIN_EVENTS_FOR_PARALLEL_UPDATE = 128;
+
+/// The events of the same node go to the same bucket. The buckets are the unit of work of the parallel update.
+const U32 EVENT_BUCKET_COUNT = 64;
+
+class EventManager::UpdateEventsCtx
+{
+public:
+	WeakArray<Event*> m_events; ///< Sorted by bucket.
+	Array<U32, EVENT_BUCKET_COUNT + 1> m_bucketOffsets;
+	Atomic<U32> m_crntBucket = {0};
+
+	Error m_err = Error::NONE;
+	SpinLock m_errLock;
+
+	Second m_prevUpdateTime;
+	Second m_crntTime;
+};
+
 EventManager::EventManager()
 {
 }
@@ -42,68 +64,221 @@ SceneFrameAllocator<U8> EventManager::getFrameAllocator() const
 	return m_scene->getFrameAllocator();
 }
 
+/// Get the bucket of an event or MAX_U32 if it may touch other things than the nodes of a single bucket.
+static U32 computeEventBucket(Event& event)
+{
+	const WeakArray<SceneNode*> associatedNodes = event.getAssociatedSceneNodes();
+	if(!event.getTouchesOnlyAssociatedNodes() || associatedNodes.getSize() == 0)
+	{
+		return MAX_U32;
+	}
+
+	const U32 bucket = U32(associatedNodes[0]->getUuid() % EVENT_BUCKET_COUNT);
+	for(const SceneNode* node : associatedNodes)
+	{
+		if(node->getUuid() % EVENT_BUCKET_COUNT != bucket)
+		{
+			return MAX_U32;
+		}
+	}
+
+	return bucket;
+}
+
 Error EventManager::updateAllEvents(Second prevUpdateTime, Second crntTime)
 {
-	Error err = Error::NONE;
+	ANKI_TRACE_SCOPED_EVENT(SCENE_EVENTS_UPDATE);
+
+	// Gather the events first because the dead ones leave the list during the update
+	const U32 eventCount = U32(m_events.getSize());
+	if(eventCount == 0)
+	{
+		return Error::NONE;
+	}
+
+	SceneFrameAllocator<U8> alloc = getFrameAllocator();
+	Event** events = alloc.newArray<Event*>(eventCount);
+	U32 count = 0;
+	for(Event& event : m_events)
+	{
+		events[count++] = &event;
+	}
 
-	auto it = m_events.getBegin();
-	auto end = m_events.getEnd();
-	for(; it != end && !err; ++it)
+	ThreadHive& hive = m_scene->getThreadHive();
+	if(hive.getThreadCount() < 2 || eventCount < MIN_EVENTS_FOR_PARALLEL_UPDATE)
 	{
-		Event& event = *it;
+		for(U32 i = 0; i < eventCount; ++i)
+		{
+			ANKI_CHECK(updateEvent(*events[i], prevUpdateTime, crntTime));
+		}
+
+		return Error::NONE;
+	}
+
+	// The events that may touch anything split the list into phases. The events of a phase are updated in parallel,
+	// one bucket per task. The phases and the events between them are updated in list order so every node sees its
+	// events in the same order as in the serial update
+	U32* eventBuckets = alloc.newArray<U32>(eventCount);
+	for(U32 i = 0; i < eventCount; ++i)
+	{
+		eventBuckets[i] = computeEventBucket(*events[i]);
+	}
 
-		// If event or the node's event is marked for deletion then dont do anything else for that event
-		if(event.getMarkedForDeletion())
+	U32 serialCount = 0;
+	U32 phaseBegin = 0;
+	for(U32 i = 0; i <= eventCount; ++i)
+	{
+		if(i < eventCount && eventBuckets[i] != MAX_U32)
 		{
 			continue;
 		}
 
-		// Check if the associated scene nodes are marked for deletion
-		for(SceneNode* node : event.m_associatedNodes)
+		ANKI_CHECK(updateEventPhase(WeakArray<Event*>(events + phaseBegin, i - phaseBegin), eventBuckets + phaseBegin,
+									prevUpdateTime, crntTime));
+
+		if(i < eventCount)
+		{
+			ANKI_CHECK(updateEvent(*events[i], prevUpdateTime, crntTime));
+			++serialCount;
+		}
+
+		phaseBegin = i + 1;
+	}
+
+	ANKI_TRACE_INC_COUNTER(SCENE_SERIAL_EVENTS, serialCount);
+	return Error::NONE;
+}
+
+Error EventManager::updateEventPhase(WeakArray<Event*> events, const U32* eventBuckets, Second prevUpdateTime,
+									 Second crntTime)
+{
+	// Not worth going wide
+	if(events.getSize() < MIN_EVENTS_FOR_PARALLEL_UPDATE)
+	{
+		for(Event* event : events)
+		{
+			ANKI_CHECK(updateEvent(*event, prevUpdateTime, crntTime));
+		}
+
+		return Error::NONE;
+	}
+
+	// Sort by bucket. Keep the order of the list inside the buckets so the events of a node run in the same order
+	Array<U32, EVENT_BUCKET_COUNT> bucketSizes;
+	memset(&bucketSizes[0], 0, sizeof(bucketSizes));
+	for(U32 i = 0; i < events.getSize(); ++i)
+	{
+		++bucketSizes[eventBuckets[i]];
+	}
+
+	UpdateEventsCtx ctx;
+	ctx.m_prevUpdateTime = prevUpdateTime;
+	ctx.m_crntTime = crntTime;
+	ctx.m_bucketOffsets[0] = 0;
+	for(U32 b = 0; b < EVENT_BUCKET_COUNT; ++b)
+	{
+		ctx.m_bucketOffsets[b + 1] = ctx.m_bucketOffsets[b] + bucketSizes[b];
+	}
+
+	Event** sortedEvents = getFrameAllocator().newArray<Event*>(events.getSize());
+	Array<U32, EVENT_BUCKET_COUNT> bucketFill;
+	memcpy(&bucketFill[0], &ctx.m_bucketOffsets[0], sizeof(bucketFill));
+	for(U32 i = 0; i < events.getSize(); ++i)
+	{
+		sortedEvents[bucketFill[eventBuckets[i]]++] = events[i];
+	}
+
+	ctx.m_events = WeakArray<Event*>(sortedEvents, events.getSize());
+
+	// Update the buckets
+	ThreadHive& hive = m_scene->getThreadHive();
+	Array<ThreadHiveTask, ThreadHive::MAX_THREADS> tasks;
+	for(U32 i = 0; i < hive.getThreadCount(); ++i)
+	{
+		tasks[i] = ANKI_THREAD_HIVE_TASK({ updateEventBuckets(*self); }, &ctx, nullptr, nullptr);
+	}
+
+	hive.submitTasks(&tasks[0], hive.getThreadCount());
+	hive.waitAllTasks();
+
+	return ctx.m_err;
+}
+
+void EventManager::updateEventBuckets(UpdateEventsCtx& ctx)
+{
+	ANKI_TRACE_SCOPED_EVENT(SCENE_EVENTS_UPDATE);
+
+	U32 bucket;
+	while((bucket = ctx.m_crntBucket.fetchAdd(1)) < EVENT_BUCKET_COUNT)
+	{
+		for(U32 i = ctx.m_bucketOffsets[bucket]; i < ctx.m_bucketOffsets[bucket + 1]; ++i)
 		{
-			if(node->getMarkedForDeletion())
+			const Error err = updateEvent(*ctx.m_events[i], ctx.m_prevUpdateTime, ctx.m_crntTime);
+			if(err)
 			{
-				event.setMarkedForDeletion();
+				LockGuard<SpinLock> lock(ctx.m_errLock);
+				ctx.m_err = err;
+				return;
 			}
 		}
+	}
+}
+
+Error EventManager::updateEvent(Event& event, Second prevUpdateTime, Second crntTime)
+{
+	Error err = Error::NONE;
+
+	// If event or the node's event is marked for deletion then dont do anything else for that event
+	if(event.getMarkedForDeletion())
+	{
+		return err;
+	}
 
-		if(event.getMarkedForDeletion())
+	// Check if the associated scene nodes are marked for deletion
+	for(SceneNode* node : event.m_associatedNodes)
+	{
+		if(node->getMarkedForDeletion())
 		{
-			continue;
+			event.setMarkedForDeletion();
 		}
+	}
+
+	if(event.getMarkedForDeletion())
+	{
+		return err;
+	}
+
+	// Audjust starting time
+	if(event.m_startTime < 0.0)
+	{
+		event.m_startTime = crntTime;
+	}
+
+	// Check if dead
+	if(!event.isDead(crntTime))
+	{
+		// If not dead update it
 
-		// Audjust starting time
-		if(event.m_startTime < 0.0)
+		if(event.getStartTime() <= crntTime)
 		{
-			event.m_startTime = crntTime;
+			err = event.update(prevUpdateTime, crntTime);
 		}
+	}
+	else
+	{
+		// Dead
 
-		// Check if dead
-		if(!event.isDead(crntTime))
+		if(event.getReanimate())
 		{
-			// If not dead update it
-
-			if(event.getStartTime() <= crntTime)
-			{
-				err = event.update(prevUpdateTime, crntTime);
-			}
+			event.m_startTime = prevUpdateTime;
+			err = event.update(prevUpdateTime, crntTime);
 		}
 		else
 		{
-			// Dead
-
-			if(event.getReanimate())
+			err = event.onKilled(prevUpdateTime, crntTime);
+			if(err || !event.getReanimate())
 			{
-				event.m_startTime = prevUpdateTime;
-				err = event.update(prevUpdateTime, crntTime);
-			}
-			else
-			{
-				err = event.onKilled(prevUpdateTime, crntTime);
-				if(err || !event.getReanimate())
-				{
-					event.setMarkedForDeletion();
-				}
+				event.setMarkedForDeletion();
 			}
 		}
 	}
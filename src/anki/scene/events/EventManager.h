@@ -7,6 +7,7 @@
 
 #include <anki/scene/Common.h>
 #include <anki/util/List.h>
+#include <anki/util/WeakArray.h>
 #include <anki/Math.h>
 
 namespace anki
@@ -66,11 +67,22 @@ public:
 	void markEventForDeletion(Event* event);
 
 private:
+	class UpdateEventsCtx;
+
 	SceneGraph* m_scene = nullptr;
 
 	IntrusiveList<Event> m_events;
 	IntrusiveList<Event> m_eventsMarkedForDeletion;
 	Mutex m_mtx;
+
+	ANKI_USE_RESULT static Error updateEvent(Event& event, Second prevUpdateTime, Second crntTime);
+
+	/// Update events that don't touch each other's nodes. See updateAllEvents.
+	ANKI_USE_RESULT Error updateEventPhase(WeakArray<Event*> events, const U32* eventBuckets, Second prevUpdateTime,
+										   Second crntTime);
+
+	/// Update some buckets of events. Called by the ThreadHive tasks.
+	static void updateEventBuckets(UpdateEventsCtx& ctx);
 };
 /// @}
 
@@ -16,6 +16,7 @@ Error JitterMoveEvent::init(Second startTime, Second duration, SceneNode* node)
 	ANKI_ASSERT(node);
 	Event::init(startTime, duration);
 	m_associatedNodes.emplaceBack(getAllocator(), node);
+	m_touchesOnlyAssociatedNodes = true;
 
 	const MoveComponent& move = node->getComponent<MoveComponent>();
 
@@ -14,6 +14,7 @@ Error LightEvent::init(Second startTime, Second duration, SceneNode* light)
 {
 	Event::init(startTime, duration);
 	m_associatedNodes.emplaceBack(getAllocator(), light);
+	m_touchesOnlyAssociatedNodes = true;
 
 	LightComponent& lightc = light->getComponent<LightComponent>();
 
@@ -12,7 +12,7 @@ void Hierarchy<T>::destroy(TAllocator alloc)
 {
 	if(m_parent != nullptr)
 	{
-		m_parent->removeChild(alloc, getSelf());
+		m_parent->Hierarchy::removeChild(alloc, getSelf());
 		m_parent = nullptr;
 	}
 
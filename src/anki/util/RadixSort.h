@@ -0,0 +1,432 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <anki/util/Array.h>
+#include <anki/util/Functions.h>
+#include <anki/util/ThreadHive.h>
+
+namespace anki
+{
+
+/// @addtogroup util_other
+/// @{
+
+/// Sort 64bit keys with a least significant digit radix sort. Every key carries a value that follows it. The sort is
+/// stable and it skips the digits that are the same in all the keys so small keys cost less.
+/// @param[in,out] keys The keys to sort.
+/// @param[in,out] values The values of the keys.
+/// @param count The number of keys.
+/// @param tmpKeys Scratch memory of count keys.
+/// @param tmpValues Scratch memory of count values.
+template<typename TValue>
+void radixSort(U64* keys, TValue* values, PtrSize count, U64* tmpKeys, TValue* tmpValues)
+{
+	static_assert(std::is_trivially_copyable<TValue>::value, "The values are memcpy'ed");
+	ANKI_ASSERT(keys && values && tmpKeys && tmpValues);
+	constexpr U32 DIGIT_COUNT = sizeof(U64);
+	constexpr U32 BUCKET_COUNT = 256;
+
+	// Compute the histograms of all the digits in one go
+	Array2d<U32, DIGIT_COUNT, BUCKET_COUNT> histograms;
+	memset(&histograms[0][0], 0, sizeof(histograms));
+	for(PtrSize i = 0; i < count; ++i)
+	{
+		const U64 key = keys[i];
+		for(U32 digit = 0; digit < DIGIT_COUNT; ++digit)
+		{
+			++histograms[digit][(key >> (digit * 8u)) & 0xFFu];
+		}
+	}
+
+	U64* srcKeys = keys;
+	TValue* srcValues = values;
+	U64* dstKeys = tmpKeys;
+	TValue* dstValues = tmpValues;
+	for(U32 digit = 0; digit < DIGIT_COUNT && count > 0; ++digit)
+	{
+		Array<U32, BUCKET_COUNT>& histogram = histograms[digit];
+
+		// All the keys have the same digit, nothing to do
+		if(histogram[(srcKeys[0] >> (digit * 8u)) & 0xFFu] == count)
+		{
+			continue;
+		}
+
+		// Histogram to offsets
+		U32 offset = 0;
+		for(U32& bucket : histogram)
+		{
+			const U32 bucketCount = bucket;
+			bucket = offset;
+			offset += bucketCount;
+		}
+
+		// Scatter
+		for(PtrSize i = 0; i < count; ++i)
+		{
+			const U32 dstIdx = histogram[(srcKeys[i] >> (digit * 8u)) & 0xFFu]++;
+			dstKeys[dstIdx] = srcKeys[i];
+			dstValues[dstIdx] = srcValues[i];
+		}
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcValues, dstValues);
+	}
+
+	// The sorted keys may have ended up in the scratch memory
+	if(srcKeys != keys)
+	{
+		memcpy(keys, srcKeys, sizeof(U64) * count);
+		memcpy(values, srcValues, sizeof(TValue) * count);
+	}
+}
+/// @}
+
+namespace detail
+{
+
+/// How the last pass of a radixSortParallel() writes a value to its output.
+/// @internal
+template<typename TValue, typename TOut>
+class RadixSortOutput
+{
+public:
+	/// The values point to the elements to copy.
+	static void write(TOut& out, const TValue& value)
+	{
+		out = *value;
+	}
+};
+
+/// @internal
+template<typename TValue>
+class RadixSortOutput<TValue, TValue>
+{
+public:
+	static void write(TValue& out, const TValue& value)
+	{
+		out = value;
+	}
+};
+
+/// The state of a radixSortParallel() that all its tasks share.
+/// @internal
+template<typename TValue, typename TOut>
+class RadixSortParallelCtx
+{
+public:
+	static constexpr U32 DIGIT_COUNT = sizeof(U64);
+	static constexpr U32 BUCKET_COUNT = 256;
+
+	Array<U64*, 2> m_keys; ///< The keys and the scratch keys. Every pass reads from the one and writes to the other.
+	Array<TValue*, 2> m_values;
+	TOut* m_out; ///< If not nullptr the last pass writes here instead of the keys and values.
+	U32 m_count;
+	U32 m_taskCount;
+	ThreadHiveSemaphore* m_signalSemaphore;
+
+	U64* m_taskDiffs; ///< Per task the bits of its keys that differ from the 1st key.
+	/// A histogram per task. The prefix sum turns them to the scatter offsets of every task.
+	Array<U32*, ThreadHive::MAX_THREADS> m_histograms;
+	Array<U8, DIGIT_COUNT> m_passDigits; ///< The digits that are not the same in all the keys.
+	U32 m_passCount;
+
+	void getTaskRange(U32 taskIdx, U32& begin, U32& end) const
+	{
+		begin = U32(U64(m_count) * taskIdx / m_taskCount);
+		end = U32(U64(m_count) * (taskIdx + 1) / m_taskCount);
+	}
+
+	U32* getHistogram(U32 taskIdx) const
+	{
+		return m_histograms[taskIdx];
+	}
+};
+
+/// The argument of a radixSortParallel() task. Every task works on its own range of the keys.
+/// @internal
+template<typename TValue, typename TOut>
+class RadixSortParallelTask
+{
+public:
+	using Ctx = RadixSortParallelCtx<TValue, TOut>;
+
+	Ctx* m_ctx;
+	U32 m_taskIdx;
+	U32 m_pass;
+
+	static void submitSort(ThreadHive& hive, U32 taskCount, U64* keys, TValue* values, U32 count, U64* tmpKeys,
+						   TValue* tmpValues, TOut* out, ThreadHiveSemaphore* waitSemaphore,
+						   ThreadHiveSemaphore*& signalSemaphore)
+	{
+		static_assert(std::is_trivially_copyable<TValue>::value, "The values are memcpy'ed");
+		ANKI_ASSERT(keys && values && tmpKeys && tmpValues && count > 0);
+		ANKI_ASSERT(taskCount > 0 && taskCount <= ThreadHive::MAX_THREADS);
+
+		taskCount = min(taskCount, count);
+		signalSemaphore = hive.newSemaphore(1);
+
+		Ctx& ctx = *static_cast<Ctx*>(hive.allocateScratchMemory(sizeof(Ctx), alignof(Ctx)));
+		ctx.m_keys = {{keys, tmpKeys}};
+		ctx.m_values = {{values, tmpValues}};
+		ctx.m_out = out;
+		ctx.m_count = count;
+		ctx.m_taskCount = taskCount;
+		ctx.m_signalSemaphore = signalSemaphore;
+		ctx.m_taskDiffs = static_cast<U64*>(hive.allocateScratchMemory(sizeof(U64) * taskCount, alignof(U64)));
+		for(U32 i = 0; i < taskCount; ++i)
+		{
+			// Separate allocations because the scratch memory comes in small chunks
+			ctx.m_histograms[i] =
+				static_cast<U32*>(hive.allocateScratchMemory(sizeof(U32) * Ctx::BUCKET_COUNT, alignof(U32)));
+		}
+
+		// Find the digits to sort in parallel. The passes are submitted when it's known how many they are
+		RadixSortParallelTask* tasks = newTasks(hive, ctx, 0);
+		ThreadHiveSemaphore* diffSem = hive.newSemaphore(taskCount);
+		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> hiveTasks;
+		for(U32 i = 0; i < taskCount; ++i)
+		{
+			hiveTasks[i] = ANKI_THREAD_HIVE_TASK({ self->computeDiff(); }, &tasks[i], waitSemaphore, diffSem);
+		}
+		hive.submitTasks(&hiveTasks[0], taskCount);
+
+		hiveTasks[0] = ANKI_THREAD_HIVE_TASK({ self->submitPasses(hive); }, &tasks[0], diffSem, signalSemaphore);
+		hive.submitTasks(&hiveTasks[0], 1);
+	}
+
+private:
+	static RadixSortParallelTask* newTasks(ThreadHive& hive, Ctx& ctx, U32 pass)
+	{
+		RadixSortParallelTask* tasks = static_cast<RadixSortParallelTask*>(hive.allocateScratchMemory(
+			sizeof(RadixSortParallelTask) * ctx.m_taskCount, alignof(RadixSortParallelTask)));
+		for(U32 i = 0; i < ctx.m_taskCount; ++i)
+		{
+			tasks[i].m_ctx = &ctx;
+			tasks[i].m_taskIdx = i;
+			tasks[i].m_pass = pass;
+		}
+		return tasks;
+	}
+
+	/// Find the key bits that vary. The digits without any are skipped.
+	void computeDiff() const
+	{
+		U32 begin, end;
+		m_ctx->getTaskRange(m_taskIdx, begin, end);
+		const U64* keys = m_ctx->m_keys[0];
+		const U64 firstKey = keys[0];
+		U64 diff = 0;
+		for(U32 i = begin; i < end; ++i)
+		{
+			diff |= keys[i] ^ firstKey;
+		}
+		m_ctx->m_taskDiffs[m_taskIdx] = diff;
+	}
+
+	/// Submit the tasks of all the passes. They wait for each other with semaphores so nothing blocks.
+	void submitPasses(ThreadHive& hive) const
+	{
+		Ctx& ctx = *m_ctx;
+		const U32 taskCount = ctx.m_taskCount;
+
+		U64 diff = 0;
+		for(U32 i = 0; i < taskCount; ++i)
+		{
+			diff |= ctx.m_taskDiffs[i];
+		}
+
+		ctx.m_passCount = 0;
+		for(U32 digit = 0; digit < Ctx::DIGIT_COUNT; ++digit)
+		{
+			if((diff >> (digit * 8u)) & 0xFFu)
+			{
+				ctx.m_passDigits[ctx.m_passCount++] = U8(digit);
+			}
+		}
+
+		// The last phase is the scatter of the last pass if that one writes to the output. If not the output is
+		// written by a copy
+		const Bool lastPhaseIsScatter = ctx.m_passCount > 0 && (ctx.m_out || (ctx.m_passCount & 1) == 0);
+		if(ctx.m_passCount == 0 && !ctx.m_out)
+		{
+			return;
+		}
+
+		// The tasks of the last phase signal the semaphore of the sort. Increase it to block until they are done
+		ctx.m_signalSemaphore->increaseSemaphore(taskCount);
+
+		Array<ThreadHiveTask, ThreadHive::MAX_THREADS> hiveTasks;
+		ThreadHiveSemaphore* waitSem = nullptr;
+		for(U32 pass = 0; pass < ctx.m_passCount; ++pass)
+		{
+			RadixSortParallelTask* tasks = newTasks(hive, ctx, pass);
+
+			// 1st phase, every task computes the histogram of its keys
+			ThreadHiveSemaphore* histogramSem = hive.newSemaphore(taskCount);
+			for(U32 i = 0; i < taskCount; ++i)
+			{
+				hiveTasks[i] = ANKI_THREAD_HIVE_TASK({ self->computeHistogram(); }, &tasks[i], waitSem, histogramSem);
+			}
+			hive.submitTasks(&hiveTasks[0], taskCount);
+
+			// 2nd phase, a single task turns the histograms to offsets
+			ThreadHiveSemaphore* prefixSumSem = hive.newSemaphore(1);
+			hiveTasks[0] = ANKI_THREAD_HIVE_TASK({ self->prefixSum(); }, &tasks[0], histogramSem, prefixSumSem);
+			hive.submitTasks(&hiveTasks[0], 1);
+
+			// 3rd phase, every task scatters its keys to the offsets it got
+			const Bool lastPhase = pass == ctx.m_passCount - 1 && lastPhaseIsScatter;
+			ThreadHiveSemaphore* scatterSem = (lastPhase) ? ctx.m_signalSemaphore : hive.newSemaphore(taskCount);
+			for(U32 i = 0; i < taskCount; ++i)
+			{
+				hiveTasks[i] = ANKI_THREAD_HIVE_TASK({ self->scatter(); }, &tasks[i], prefixSumSem, scatterSem);
+			}
+			hive.submitTasks(&hiveTasks[0], taskCount);
+
+			waitSem = scatterSem;
+		}
+
+		// The sorted keys ended up in the scratch memory or there was nothing to sort. Copy them to the output
+		if(!lastPhaseIsScatter)
+		{
+			RadixSortParallelTask* tasks = newTasks(hive, ctx, ctx.m_passCount);
+			for(U32 i = 0; i < taskCount; ++i)
+			{
+				hiveTasks[i] = ANKI_THREAD_HIVE_TASK({ self->copyOut(); }, &tasks[i], waitSem, ctx.m_signalSemaphore);
+			}
+			hive.submitTasks(&hiveTasks[0], taskCount);
+		}
+	}
+
+	void computeHistogram() const
+	{
+		U32 begin, end;
+		m_ctx->getTaskRange(m_taskIdx, begin, end);
+		const U64* keys = m_ctx->m_keys[m_pass & 1];
+		const U32 shift = m_ctx->m_passDigits[m_pass] * 8u;
+		U32* histogram = m_ctx->getHistogram(m_taskIdx);
+		memset(histogram, 0, sizeof(U32) * Ctx::BUCKET_COUNT);
+		for(U32 i = begin; i < end; ++i)
+		{
+			++histogram[(keys[i] >> shift) & 0xFFu];
+		}
+	}
+
+	/// The offsets go bucket by bucket and inside a bucket task by task. That keeps the sort stable.
+	void prefixSum() const
+	{
+		U32 offset = 0;
+		for(U32 bucket = 0; bucket < Ctx::BUCKET_COUNT; ++bucket)
+		{
+			for(U32 i = 0; i < m_ctx->m_taskCount; ++i)
+			{
+				U32& taskBucket = m_ctx->getHistogram(i)[bucket];
+				const U32 bucketCount = taskBucket;
+				taskBucket = offset;
+				offset += bucketCount;
+			}
+		}
+	}
+
+	void scatter() const
+	{
+		U32 begin, end;
+		m_ctx->getTaskRange(m_taskIdx, begin, end);
+		const U32 src = m_pass & 1;
+		const U64* srcKeys = m_ctx->m_keys[src];
+		const TValue* srcValues = m_ctx->m_values[src];
+		const U32 shift = m_ctx->m_passDigits[m_pass] * 8u;
+		U32* offsets = m_ctx->getHistogram(m_taskIdx);
+
+		if(m_ctx->m_out && m_pass == m_ctx->m_passCount - 1)
+		{
+			// The last pass writes straight to the output
+			for(U32 i = begin; i < end; ++i)
+			{
+				const U32 dstIdx = offsets[(srcKeys[i] >> shift) & 0xFFu]++;
+				RadixSortOutput<TValue, TOut>::write(m_ctx->m_out[dstIdx], srcValues[i]);
+			}
+			return;
+		}
+
+		U64* dstKeys = m_ctx->m_keys[!src];
+		TValue* dstValues = m_ctx->m_values[!src];
+		for(U32 i = begin; i < end; ++i)
+		{
+			const U32 dstIdx = offsets[(srcKeys[i] >> shift) & 0xFFu]++;
+			dstKeys[dstIdx] = srcKeys[i];
+			dstValues[dstIdx] = srcValues[i];
+		}
+	}
+
+	void copyOut() const
+	{
+		U32 begin, end;
+		m_ctx->getTaskRange(m_taskIdx, begin, end);
+		const U32 src = m_pass & 1;
+		if(m_ctx->m_out)
+		{
+			const TValue* values = m_ctx->m_values[src];
+			for(U32 i = begin; i < end; ++i)
+			{
+				RadixSortOutput<TValue, TOut>::write(m_ctx->m_out[i], values[i]);
+			}
+		}
+		else
+		{
+			ANKI_ASSERT(src == 1);
+			memcpy(m_ctx->m_keys[0] + begin, m_ctx->m_keys[1] + begin, sizeof(U64) * (end - begin));
+			memcpy(m_ctx->m_values[0] + begin, m_ctx->m_values[1] + begin, sizeof(TValue) * (end - begin));
+		}
+	}
+};
+
+} // end namespace detail
+
+/// @addtogroup util_other
+/// @{
+
+/// The same sort as radixSort() split to ThreadHive tasks. Every pass has 3 phases. The tasks compute the histograms
+/// of their own keys, a single task turns them to the offsets where every task writes its keys and then the tasks
+/// scatter. The function doesn't block, all the tasks are submitted with semaphores between the phases.
+/// @param hive The hive. It can be called from its tasks.
+/// @param taskCount The number of tasks that share a phase.
+/// @param[in,out] keys The keys to sort. Can't be empty.
+/// @param[in,out] values The values of the keys.
+/// @param count The number of keys.
+/// @param tmpKeys Scratch memory of count keys.
+/// @param tmpValues Scratch memory of count values.
+/// @param waitSemaphore The sort starts after this is signaled. Can be nullptr.
+/// @param[out] signalSemaphore Signaled when the sort is done.
+template<typename TValue>
+void radixSortParallel(ThreadHive& hive, U32 taskCount, U64* keys, TValue* values, U32 count, U64* tmpKeys,
+					   TValue* tmpValues, ThreadHiveSemaphore* waitSemaphore, ThreadHiveSemaphore*& signalSemaphore)
+{
+	detail::RadixSortParallelTask<TValue, TValue>::submitSort(hive, taskCount, keys, values, count, tmpKeys, tmpValues,
+															   nullptr, waitSemaphore, signalSemaphore);
+}
+
+/// Like radixSortParallel() but the keys carry pointers to elements and the elements end up sorted in @a sorted. The
+/// last pass copies every element from where its pointer points straight to its sorted place, so the elements are
+/// copied once and no task copies them after the sort. The keys and the pointers are left in some scratch order.
+/// @param[in,out] keys The keys to sort. Can't be empty.
+/// @param[in,out] elements Pointers to the elements of the keys.
+/// @param[out] sorted Memory for count elements.
+/// @see radixSortParallel for the rest.
+template<typename T>
+void radixSortGatherParallel(ThreadHive& hive, U32 taskCount, U64* keys, const T** elements, U32 count, U64* tmpKeys,
+							 const T** tmpElements, T* sorted, ThreadHiveSemaphore* waitSemaphore,
+							 ThreadHiveSemaphore*& signalSemaphore)
+{
+	ANKI_ASSERT(sorted);
+	detail::RadixSortParallelTask<const T*, T>::submitSort(hive, taskCount, keys, elements, count, tmpKeys,
+															tmpElements, sorted, waitSemaphore, signalSemaphore);
+}
+/// @}
+
+} // end namespace anki
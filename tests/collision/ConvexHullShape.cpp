@@ -0,0 +1,207 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/Collision.h>
+#include <anki/util/HighRezTimer.h>
+
+namespace anki
+{
+
+/// Create an ellipsoid like hull out of rings of points.
+static void createEllipsoidHull(U32 ringCount, U32 ringPointCount, const Vec3& scale, DynamicArrayAuto<Vec4>& points,
+								DynamicArrayAuto<U32>& indices)
+{
+	ANKI_ASSERT(ringCount >= 1 && ringPointCount >= 3);
+
+	// The 2 poles and then the rings from top to bottom
+	points.create(2 + ringCount * ringPointCount);
+	points[0] = Vec4(0.0f, scale.y(), 0.0f, 0.0f);
+	points[1] = Vec4(0.0f, -scale.y(), 0.0f, 0.0f);
+	for(U32 ring = 0; ring < ringCount; ++ring)
+	{
+		const F32 theta = PI * F32(ring + 1) / F32(ringCount + 1);
+		for(U32 i = 0; i < ringPointCount; ++i)
+		{
+			const F32 phi = 2.0f * PI * F32(i) / F32(ringPointCount);
+			points[2 + ring * ringPointCount + i] = Vec4(sin(theta) * cos(phi) * scale.x(), cos(theta) * scale.y(),
+														 sin(theta) * sin(phi) * scale.z(), 0.0f);
+		}
+	}
+
+	auto pointIdx = [&](U32 ring, U32 i) { return 2 + ring * ringPointCount + (i % ringPointCount); };
+
+	indices.create(ringPointCount * 2 * 3 + (ringCount - 1) * ringPointCount * 6);
+	U32 count = 0;
+	for(U32 i = 0; i < ringPointCount; ++i)
+	{
+		indices[count++] = 0;
+		indices[count++] = pointIdx(0, i);
+		indices[count++] = pointIdx(0, i + 1);
+
+		indices[count++] = 1;
+		indices[count++] = pointIdx(ringCount - 1, i + 1);
+		indices[count++] = pointIdx(ringCount - 1, i);
+	}
+
+	for(U32 ring = 0; ring + 1 < ringCount; ++ring)
+	{
+		for(U32 i = 0; i < ringPointCount; ++i)
+		{
+			indices[count++] = pointIdx(ring, i);
+			indices[count++] = pointIdx(ring + 1, i);
+			indices[count++] = pointIdx(ring + 1, i + 1);
+
+			indices[count++] = pointIdx(ring, i);
+			indices[count++] = pointIdx(ring + 1, i + 1);
+			indices[count++] = pointIdx(ring, i + 1);
+		}
+	}
+
+	ANKI_ASSERT(count == indices.getSize());
+}
+
+static F32 bruteForceSupportDot(const ConvexHullShape& hull, const Vec4& dir)
+{
+	F32 m = MIN_F32;
+	for(const Vec4& p : hull.getPoints())
+	{
+		const Vec4 o = (hull.isTransformIdentity()) ? p : hull.getTransform().transform(p);
+		m = max(m, o.dot(dir));
+	}
+	return m;
+}
+
+static Vec4 randomDirection()
+{
+	Vec4 dir(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), 0.0f);
+	return (dir.getLengthSquared() > EPSILON) ? dir.getNormalized() : Vec4(1.0f, 0.0f, 0.0f, 0.0f);
+}
+
+ANKI_TEST(Collision, ConvexHullSupport)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	DynamicArrayAuto<Vec4> points(alloc);
+	DynamicArrayAuto<U32> indices(alloc);
+	createEllipsoidHull(12, 24, Vec3(2.0f, 1.0f, 3.0f), points, indices);
+
+	DynamicArrayAuto<U32> offsets(alloc);
+	DynamicArrayAuto<U32> adjacency(alloc);
+	computeConvexHullAdjacency(U32(points.getSize()), ConstWeakArray<U32>(&indices[0], indices.getSize()), offsets,
+							   adjacency);
+
+	// Every point has at least 3 neighbours
+	for(U32 i = 0; i < points.getSize(); ++i)
+	{
+		ANKI_TEST_EXPECT_GEQ(offsets[i + 1] - offsets[i], 3u);
+	}
+
+	ConvexHullShape scanHull(&points[0], U32(points.getSize()));
+	ConvexHullShape climbingHull(&points[0], U32(points.getSize()));
+	climbingHull.setAdjacency(&offsets[0], &adjacency[0]);
+
+	for(U32 iteration = 0; iteration < 100; ++iteration)
+	{
+		// Some tests with a transform
+		if(iteration == 50)
+		{
+			const Transform trf(Vec4(1.0f, -2.0f, 3.0f, 0.0f), Mat3x4(Vec3(0.0f), Mat3(Euler(0.3f, 1.2f, -0.7f)), 1.0f),
+								1.0f);
+			scanHull.setTransform(trf);
+			climbingHull.setTransform(trf);
+		}
+
+		// Coherent directions like GJK does
+		Vec4 dir = randomDirection();
+		for(U32 i = 0; i < 20; ++i)
+		{
+			dir = (dir + randomDirection() * 0.1f).getNormalized();
+
+			const F32 expected = bruteForceSupportDot(scanHull, dir);
+			ANKI_TEST_EXPECT_NEAR(scanHull.computeSupport(dir).dot(dir), expected, 0.0001f);
+			ANKI_TEST_EXPECT_NEAR(climbingHull.computeSupport(dir).dot(dir), expected, 0.0001f);
+		}
+
+		// Random jumps
+		dir = randomDirection();
+		const F32 expected = bruteForceSupportDot(scanHull, dir);
+		ANKI_TEST_EXPECT_NEAR(climbingHull.computeSupport(dir).dot(dir), expected, 0.0001f);
+	}
+
+	// The functions that use the support should match the brute force ones
+	for(U32 i = 0; i < 20; ++i)
+	{
+		const Plane plane(randomDirection(), getRandomRange(-4.0f, 4.0f));
+		ANKI_TEST_EXPECT_NEAR(testPlane(plane, climbingHull), testPlane(plane, scanHull), 0.0001f);
+	}
+
+	const Aabb scanAabb = computeAabb(scanHull);
+	const Aabb climbingAabb = computeAabb(climbingHull);
+	for(U32 i = 0; i < 3; ++i)
+	{
+		ANKI_TEST_EXPECT_NEAR(scanAabb.getMin()[i], climbingAabb.getMin()[i], 0.0001f);
+		ANKI_TEST_EXPECT_NEAR(scanAabb.getMax()[i], climbingAabb.getMax()[i], 0.0001f);
+	}
+
+	// GJK should give the same results
+	const Sphere sphere(Vec4(1.0f, 0.5f, 0.0f, 0.0f), 0.5f);
+	for(U32 i = 0; i < 50; ++i)
+	{
+		const Transform trf(Vec4(getRandomRange(-6.0f, 6.0f), getRandomRange(-6.0f, 6.0f),
+								 getRandomRange(-6.0f, 6.0f), 0.0f),
+							Mat3x4::getIdentity(), 1.0f);
+		ANKI_TEST_EXPECT_EQ(testCollision(sphere, scanHull.getTransformed(trf)),
+							testCollision(sphere, climbingHull.getTransformed(trf)));
+	}
+}
+
+ANKI_TEST(Collision, ConvexHullSupportBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	DynamicArrayAuto<Vec4> points(alloc);
+	DynamicArrayAuto<U32> indices(alloc);
+	createEllipsoidHull(30, 32, Vec3(2.0f, 1.0f, 3.0f), points, indices);
+
+	DynamicArrayAuto<U32> offsets(alloc);
+	DynamicArrayAuto<U32> adjacency(alloc);
+	computeConvexHullAdjacency(U32(points.getSize()), ConstWeakArray<U32>(&indices[0], indices.getSize()), offsets,
+							   adjacency);
+
+	ConvexHullShape scanHull(&points[0], U32(points.getSize()));
+	ConvexHullShape climbingHull(&points[0], U32(points.getSize()));
+	climbingHull.setAdjacency(&offsets[0], &adjacency[0]);
+
+	const U32 QUERY_COUNT = 100000;
+	std::vector<Vec4> dirs(QUERY_COUNT);
+	Vec4 dir = randomDirection();
+	for(Vec4& d : dirs)
+	{
+		dir = (dir + randomDirection() * 0.2f).getNormalized();
+		d = dir;
+	}
+
+	auto bench = [&](const ConvexHullShape& hull) -> Second {
+		HighRezTimer timer;
+		timer.start();
+		Vec4 sum(0.0f);
+		for(const Vec4& d : dirs)
+		{
+			sum += hull.computeSupport(d);
+		}
+		timer.stop();
+		ANKI_TEST_EXPECT_NEQ(sum.x(), MAX_F32); // Don't let the compiler throw the loop away
+		return timer.getElapsedTime();
+	};
+
+	const Second scanTime = bench(scanHull);
+	const Second climbingTime = bench(climbingHull);
+
+	ANKI_TEST_LOGI("%u support queries against %u points. Scan %fms, hill climbing %fms", QUERY_COUNT,
+				   U32(points.getSize()), scanTime * 1000.0, climbingTime * 1000.0);
+}
+
+} // end namespace anki
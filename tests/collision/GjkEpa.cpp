@@ -0,0 +1,260 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/Collision.h>
+#include <anki/util/HighRezTimer.h>
+
+namespace anki
+{
+
+ANKI_TEST(Collision, GjkEpaSpheres)
+{
+	const Sphere a(Vec4(0.0f), 1.0f);
+
+	for(U32 i = 0; i < 100; ++i)
+	{
+		const Vec4 dir =
+			Vec4(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), 0.0f)
+				.getNormalized();
+		const F32 radius = getRandomRange(0.5f, 2.0f);
+		// Keep the centers apart, when they are close the normal is ill-conditioned
+		const F32 dist = getRandomRange(0.5f, 1.0f + radius - 0.1f);
+		const Sphere b(dir * dist, radius);
+
+		CollisionContact contact;
+		ANKI_TEST_EXPECT_EQ(computeContact(a, b, contact), true);
+
+		const F32 depth = 1.0f + radius - dist;
+		ANKI_TEST_EXPECT_NEAR(contact.m_depth, depth, 0.02f);
+		ANKI_TEST_EXPECT_GT(contact.m_normal.dot(dir), 0.98f);
+		ANKI_TEST_EXPECT_NEAR((contact.m_point0 - dir).getLength(), 0.0f, 0.1f);
+		ANKI_TEST_EXPECT_NEAR((contact.m_point1 - (dir * (dist - radius))).getLength(), 0.0f, 0.1f);
+	}
+
+	// Separated
+	{
+		const Sphere b(Vec4(2.5f, 0.0f, 0.0f, 0.0f), 1.0f);
+		CollisionContact contact;
+		ANKI_TEST_EXPECT_EQ(computeContact(a, b, contact), false);
+	}
+}
+
+ANKI_TEST(Collision, GjkEpaBoxes)
+{
+	// Aabb vs Aabb. The depth is the smallest overlap of the 3 axis
+	{
+		const Aabb a(Vec4(-1.0f, -1.0f, -1.0f, 0.0f), Vec4(1.0f, 1.0f, 1.0f, 0.0f));
+		const Aabb b(Vec4(0.7f, -0.5f, -0.2f, 0.0f), Vec4(2.0f, 0.5f, 3.0f, 0.0f));
+
+		CollisionContact contact;
+		ANKI_TEST_EXPECT_EQ(computeContact(a, b, contact), true);
+		ANKI_TEST_EXPECT_NEAR(contact.m_depth, 0.3f, EPSILON * 100.0f);
+		ANKI_TEST_EXPECT_NEAR(contact.m_normal.x(), 1.0f, EPSILON * 100.0f);
+		ANKI_TEST_EXPECT_NEAR(contact.m_point0.x(), 1.0f, EPSILON * 100.0f);
+		ANKI_TEST_EXPECT_NEAR(contact.m_point1.x(), 0.7f, EPSILON * 100.0f);
+	}
+
+	// Rotated Obb vs Sphere. Transform the sphere to the box space to compute the distance analytically
+	{
+		const Mat3x4 rot(Vec3(0.0f), Mat3(Euler(0.3f, -0.7f, 1.1f)), 1.0f);
+		const Vec4 extend(1.0f, 2.0f, 0.5f, 0.0f);
+		const Vec4 center(1.0f, -2.0f, 3.0f, 0.0f);
+		const Obb obb(center, rot, extend);
+
+		const Vec4 localSphereCenter(0.0f, 0.0f, 0.5f + 0.4f, 0.0f);
+		const Sphere sphere(center + (rot * localSphereCenter).xyz0(), 0.6f);
+
+		CollisionContact contact;
+		ANKI_TEST_EXPECT_EQ(computeContact(obb, sphere, contact), true);
+		ANKI_TEST_EXPECT_NEAR(contact.m_depth, 0.2f, 0.01f);
+		ANKI_TEST_EXPECT_GT(contact.m_normal.dot(rot.getColumn(2).xyz0()), 0.99f);
+	}
+
+	// Convex hull cube vs Aabb
+	{
+		Array<Vec4, 8> points;
+		for(U32 i = 0; i < 8; ++i)
+		{
+			points[i] = Vec4((i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f, 0.0f);
+		}
+		ConvexHullShape hull(&points[0], points.getSize());
+		hull.setTransform(Transform(Vec4(0.0f, 1.5f, 0.0f, 0.0f), Mat3x4::getIdentity(), 1.0f));
+
+		const Aabb aabb(Vec4(-1.0f, -1.0f, -1.0f, 0.0f), Vec4(1.0f, 1.0f, 1.0f, 0.0f));
+
+		CollisionContact contact;
+		ANKI_TEST_EXPECT_EQ(computeContact(aabb, hull, contact), true);
+		ANKI_TEST_EXPECT_NEAR(contact.m_depth, 0.5f, EPSILON * 100.0f);
+		ANKI_TEST_EXPECT_NEAR(contact.m_normal.y(), 1.0f, EPSILON * 100.0f);
+	}
+
+	// Random Aabbs in different scales. The Minkowski difference of two boxes is full of coplanar and colinear points
+	// so this stresses the degenerate faces of EPA
+	for(F32 scale : {1.0f, 100.0f})
+	{
+		for(U32 i = 0; i < 1000; ++i)
+		{
+			auto randomAabb = [&]() {
+				const Vec4 center(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f),
+								  0.0f);
+				const Vec4 extend(getRandomRange(0.2f, 1.0f), getRandomRange(0.2f, 1.0f), getRandomRange(0.2f, 1.0f),
+								  0.0f);
+				return Aabb((center - extend) * scale, (center + extend) * scale);
+			};
+			const Aabb a = randomAabb();
+			const Aabb b = randomAabb();
+
+			CollisionContact contact;
+			const Bool hit = computeContact(a, b, contact);
+			ANKI_TEST_EXPECT_EQ(hit, testCollision(a, b));
+
+			if(hit)
+			{
+				F32 depth = MAX_F32;
+				for(U32 axis = 0; axis < 3; ++axis)
+				{
+					depth = min(depth, min(a.getMax()[axis] - b.getMin()[axis], b.getMax()[axis] - a.getMin()[axis]));
+				}
+				ANKI_TEST_EXPECT_NEAR(contact.m_depth, depth, 0.001f * scale);
+			}
+		}
+	}
+}
+
+ANKI_TEST(Collision, GjkCache)
+{
+	const Obb a(Vec4(0.0f), Mat3x4(Vec3(0.0f), Mat3(Euler(0.1f, 0.2f, 0.3f)), 1.0f), Vec4(1.0f, 1.0f, 1.0f, 0.0f));
+
+	// The cached results should match the cold ones
+	GjkCache cache;
+	for(U32 i = 0; i < 200; ++i)
+	{
+		const F32 t = F32(i) / 200.0f;
+		const Sphere b(Vec4(-3.0f + t * 6.0f, 0.2f, 0.1f, 0.0f), 1.0f);
+
+		CollisionContact cold, cached;
+		const Bool coldHit = computeContact(a, b, cold);
+		const Bool cachedHit = computeContact(a, b, cached, &cache);
+		ANKI_TEST_EXPECT_EQ(coldHit, cachedHit);
+		ANKI_TEST_EXPECT_EQ(testCollision(a, b), coldHit);
+
+		if(coldHit)
+		{
+			ANKI_TEST_EXPECT_NEAR(cold.m_depth, cached.m_depth, 0.01f);
+		}
+	}
+}
+
+ANKI_TEST(Collision, GjkCacheIterations)
+{
+	const U32 PAIR_COUNT = 500;
+	const U32 FRAME_COUNT = 30;
+
+	Array<Vec4, 32> points;
+	for(U32 i = 0; i < points.getSize(); ++i)
+	{
+		points[i] = Vec4(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), 0.0f);
+	}
+	const ConvexHullShape hull(&points[0], points.getSize());
+
+	// Objects that move a little every frame. Most of them overlap the hull at some point
+	std::vector<Vec4> origins(PAIR_COUNT);
+	std::vector<Vec4> velocities(PAIR_COUNT);
+	for(U32 i = 0; i < PAIR_COUNT; ++i)
+	{
+		origins[i] = Vec4(getRandomRange(-1.5f, 1.5f), getRandomRange(-1.5f, 1.5f), getRandomRange(-1.5f, 1.5f), 0.0f);
+		velocities[i] =
+			Vec4(getRandomRange(-0.02f, 0.02f), getRandomRange(-0.02f, 0.02f), getRandomRange(-0.02f, 0.02f), 0.0f);
+	}
+
+	std::vector<GjkCache> caches(PAIR_COUNT);
+	U32 queryCount = 0;
+	U32 settledCount = 0;
+	U32 coldIterations = 0, cachedIterations = 0;
+	for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		for(U32 i = 0; i < PAIR_COUNT; ++i)
+		{
+			const Obb obb(origins[i] + velocities[i] * F32(frame), Mat3x4::getIdentity(), Vec4(0.5f, 0.5f, 0.5f, 0.0f));
+			CollisionContact contact;
+			GjkCache cold;
+			computeContact(hull, obb, contact, &cold);
+			computeContact(hull, obb, contact, &caches[i]);
+
+			// The first frame is cold for both
+			if(frame > 0)
+			{
+				++queryCount;
+				settledCount += caches[i].m_iterationCount <= 2;
+				coldIterations += cold.m_iterationCount;
+				cachedIterations += caches[i].m_iterationCount;
+			}
+		}
+	}
+
+	// The warm started queries converge in 1-2 iterations. The rest are pairs that touch or cross the hull's surface
+	// between frames
+	ANKI_TEST_LOGI("GJK cache: %u of %u queries in <= 2 iterations. Iterations: cold %u cached %u", settledCount,
+				   queryCount, coldIterations, cachedIterations);
+	ANKI_TEST_EXPECT_GEQ(F32(settledCount), F32(queryCount) * 0.95f);
+	ANKI_TEST_EXPECT_LT(cachedIterations * 4, coldIterations);
+}
+
+ANKI_TEST(Collision, GjkCacheBench)
+{
+	const U32 PAIR_COUNT = 1000;
+	const U32 FRAME_COUNT = 60;
+
+	Array<Vec4, 32> points;
+	for(U32 i = 0; i < points.getSize(); ++i)
+	{
+		points[i] = Vec4(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), 0.0f);
+	}
+	const ConvexHullShape hull(&points[0], points.getSize());
+
+	std::vector<Vec4> origins(PAIR_COUNT);
+	std::vector<Vec4> velocities(PAIR_COUNT);
+	for(U32 i = 0; i < PAIR_COUNT; ++i)
+	{
+		origins[i] = Vec4(getRandomRange(-2.5f, 2.5f), getRandomRange(-2.5f, 2.5f), getRandomRange(-2.5f, 2.5f), 0.0f);
+		velocities[i] =
+			Vec4(getRandomRange(-0.02f, 0.02f), getRandomRange(-0.02f, 0.02f), getRandomRange(-0.02f, 0.02f), 0.0f);
+	}
+
+	std::vector<GjkCache> caches(PAIR_COUNT);
+	HighRezTimer coldTimer, cachedTimer;
+	Second coldTime = 0.0, cachedTime = 0.0;
+	U32 coldHits = 0, cachedHits = 0;
+
+	for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		coldTimer.start();
+		for(U32 i = 0; i < PAIR_COUNT; ++i)
+		{
+			const Obb obb(origins[i] + velocities[i] * F32(frame), Mat3x4::getIdentity(), Vec4(0.5f, 0.5f, 0.5f, 0.0f));
+			CollisionContact contact;
+			coldHits += computeContact(hull, obb, contact);
+		}
+		coldTimer.stop();
+		coldTime += coldTimer.getElapsedTime();
+
+		cachedTimer.start();
+		for(U32 i = 0; i < PAIR_COUNT; ++i)
+		{
+			const Obb obb(origins[i] + velocities[i] * F32(frame), Mat3x4::getIdentity(), Vec4(0.5f, 0.5f, 0.5f, 0.0f));
+			CollisionContact contact;
+			cachedHits += computeContact(hull, obb, contact, &caches[i]);
+		}
+		cachedTimer.stop();
+		cachedTime += cachedTimer.getElapsedTime();
+	}
+
+	ANKI_TEST_EXPECT_EQ(coldHits, cachedHits);
+	ANKI_TEST_LOGI("GJK/EPA bench: cold %fms cached %fms | %f%%", coldTime * 1000.0, cachedTime * 1000.0,
+				   coldTime / cachedTime * 100.0);
+}
+
+} // end namespace anki
@@ -0,0 +1,295 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/Collision.h>
+#include <anki/util/HighRezTimer.h>
+
+namespace anki
+{
+
+static Vec4 randomVec(F32 range)
+{
+	return Vec4(getRandomRange(-range, range), getRandomRange(-range, range), getRandomRange(-range, range), 0.0f);
+}
+
+static Mat3x4 randomRotation()
+{
+	return Mat3x4(Vec3(0.0f),
+				  Mat3(Euler(getRandomRange(0.0f, 2.0f * PI), getRandomRange(0.0f, 2.0f * PI),
+							 getRandomRange(0.0f, 2.0f * PI))),
+				  1.0f);
+}
+
+static Sphere translated(const Sphere& s, const Vec4& t)
+{
+	return Sphere(s.getCenter() + t, s.getRadius());
+}
+
+static Aabb translated(const Aabb& a, const Vec4& t)
+{
+	return Aabb(a.getMin() + t, a.getMax() + t);
+}
+
+static Obb translated(const Obb& o, const Vec4& t)
+{
+	return Obb(o.getCenter() + t, o.getRotation(), o.getExtend());
+}
+
+template<typename T, typename Y>
+static Bool overlap(const T& a, const Y& b)
+{
+	return testCollision(a, b);
+}
+
+static Bool overlap(const Sphere& a, const Plane& b)
+{
+	return testPlane(b, a) == 0.0f;
+}
+
+/// The GJK based test is not exact enough for the grazing cases so clamp to the box instead.
+static Bool overlap(const Sphere& a, const Obb& b)
+{
+	const Mat3 invRot = b.getRotation().getRotationPart().getTransposed();
+	const Vec3 center = invRot * (a.getCenter() - b.getCenter()).xyz();
+	const Vec3 closest = center.max(-b.getExtend().xyz()).min(b.getExtend().xyz());
+	return (center - closest).getLengthSquared() <= a.getRadius() * a.getRadius();
+}
+
+/// Same for the boxes. Use the separating axis theorem.
+static Bool overlap(const Obb& a, const Obb& b)
+{
+	Array<Vec3, 15> axes;
+	U32 axisCount = 0;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		axes[axisCount++] = a.getRotation().getColumn(i);
+		axes[axisCount++] = b.getRotation().getColumn(i);
+	}
+
+	for(U32 i = 0; i < 3; ++i)
+	{
+		for(U32 j = 0; j < 3; ++j)
+		{
+			axes[axisCount++] = a.getRotation().getColumn(i).cross(b.getRotation().getColumn(j));
+		}
+	}
+
+	auto projectedExtend = [](const Obb& obb, const Vec3& axis) {
+		F32 out = 0.0f;
+		for(U32 i = 0; i < 3; ++i)
+		{
+			out += absolute(obb.getRotation().getColumn(i).dot(axis)) * obb.getExtend()[i];
+		}
+		return out;
+	};
+
+	const Vec3 centerDiff = (b.getCenter() - a.getCenter()).xyz();
+	for(const Vec3& axis : axes)
+	{
+		if(axis.getLengthSquared() < EPSILON)
+		{
+			// Parallel edges
+			continue;
+		}
+
+		if(absolute(centerDiff.dot(axis)) > projectedExtend(a, axis) + projectedExtend(b, axis))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static Vec4 randomExtend(F32 minSize, F32 maxSize)
+{
+	return Vec4(getRandomRange(minSize, maxSize), getRandomRange(minSize, maxSize), getRandomRange(minSize, maxSize),
+				0.0f);
+}
+
+/// The sweeps stop when the shapes are closer than a tolerance so in grazing cases they report hits a bit earlier.
+template<typename T, typename Y>
+static Bool almostTouching(const T& a, const Y& b)
+{
+	Vec4 normal;
+	return computeDistance(a, b, normal) <= 0.005f;
+}
+
+static Bool almostTouching(const Sphere& a, const Plane& b)
+{
+	return absolute(testPlane(b, a.getCenter())) <= a.getRadius() + 0.005f;
+}
+
+/// Find the time of impact by taking small steps and testing the overlap.
+template<typename T, typename Y>
+static Bool substepTimeOfImpact(const T& a, const Vec4& translation, const Y& b, U32 stepCount, F32& toi)
+{
+	for(U32 i = 0; i <= stepCount; ++i)
+	{
+		const F32 t = F32(i) / F32(stepCount);
+		if(overlap(translated(a, translation * t), b))
+		{
+			toi = t;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/// Compare a swept test with substepping. Return false if the results differ.
+template<typename T, typename Y, typename TFunc>
+static Bool compareWithSubstepping(const T& a, const Vec4& translation, const Y& b, TFunc sweepFunc)
+{
+	const U32 STEP_COUNT = 1000;
+
+	F32 expectedToi = 0.0f;
+	const Bool expectedHit = substepTimeOfImpact(a, translation, b, STEP_COUNT, expectedToi);
+
+	F32 toi = 0.0f;
+	const Bool hit = sweepFunc(a, translation, b, toi);
+
+	if(hit != expectedHit)
+	{
+		// It may be a graze that falls between the steps
+		return hit && almostTouching(translated(a, translation * toi), b);
+	}
+
+	// The substepping finds the first step after the impact
+	return !hit || (toi <= expectedToi + 0.001f && toi >= expectedToi - 1.0f / F32(STEP_COUNT) - 0.001f)
+		   || (toi < expectedToi && almostTouching(translated(a, translation * toi), b));
+}
+
+ANKI_TEST(Collision, Sweep)
+{
+	const U32 ITERATION_COUNT = 500;
+
+	auto sweep = [](const auto& a, const Vec4& translation, const auto& b, F32& toi) {
+		return sweepCollision(a, translation, b, toi);
+	};
+
+	auto toi = [](const auto& a, const Vec4& translation, const auto& b, F32& toi) {
+		return computeTimeOfImpact(a, translation, b, toi);
+	};
+
+	// Sphere vs sphere
+	for(U32 i = 0; i < ITERATION_COUNT; ++i)
+	{
+		const Sphere a(randomVec(5.0f), getRandomRange(0.1f, 1.0f));
+		const Sphere b(randomVec(5.0f), getRandomRange(0.1f, 1.0f));
+		ANKI_TEST_EXPECT_EQ(compareWithSubstepping(a, randomVec(10.0f), b, sweep), true);
+	}
+
+	// Sphere vs plane
+	for(U32 i = 0; i < ITERATION_COUNT; ++i)
+	{
+		const Sphere a(randomVec(5.0f), getRandomRange(0.1f, 1.0f));
+		const Plane b(randomVec(1.0f).getNormalized(), getRandomRange(-2.0f, 2.0f));
+		ANKI_TEST_EXPECT_EQ(compareWithSubstepping(a, randomVec(10.0f), b, sweep), true);
+	}
+
+	// Sphere vs Aabb
+	for(U32 i = 0; i < ITERATION_COUNT; ++i)
+	{
+		const Sphere a(randomVec(5.0f), getRandomRange(0.1f, 1.0f));
+		const Vec4 min = randomVec(3.0f);
+		const Aabb b(min, min + randomExtend(0.1f, 3.0f));
+		ANKI_TEST_EXPECT_EQ(compareWithSubstepping(a, randomVec(10.0f), b, sweep), true);
+	}
+
+	// Aabb vs Aabb
+	for(U32 i = 0; i < ITERATION_COUNT; ++i)
+	{
+		const Vec4 mina = randomVec(5.0f);
+		const Aabb a(mina, mina + randomExtend(0.1f, 2.0f));
+		const Vec4 minb = randomVec(3.0f);
+		const Aabb b(minb, minb + randomExtend(0.1f, 3.0f));
+		ANKI_TEST_EXPECT_EQ(compareWithSubstepping(a, randomVec(10.0f), b, sweep), true);
+	}
+
+	// Sphere vs Obb
+	for(U32 i = 0; i < ITERATION_COUNT; ++i)
+	{
+		const Sphere a(randomVec(5.0f), getRandomRange(0.1f, 1.0f));
+		const Obb b(randomVec(3.0f), randomRotation(), randomExtend(0.1f, 2.0f));
+		ANKI_TEST_EXPECT_EQ(compareWithSubstepping(a, randomVec(10.0f), b, sweep), true);
+	}
+
+	// Obb vs Obb using conservative advancement
+	for(U32 i = 0; i < ITERATION_COUNT; ++i)
+	{
+		const Obb a(randomVec(5.0f), randomRotation(), randomExtend(0.1f, 1.0f));
+		const Obb b(randomVec(3.0f), randomRotation(), randomExtend(0.1f, 2.0f));
+		ANKI_TEST_EXPECT_EQ(compareWithSubstepping(a, randomVec(10.0f), b, toi), true);
+	}
+
+	// Distance
+	{
+		const Sphere a(Vec4(0.0f), 1.0f);
+		const Obb b(Vec4(4.0f, 0.0f, 0.0f, 0.0f), Mat3x4::getIdentity(), Vec4(1.0f, 1.0f, 1.0f, 0.0f));
+		Vec4 normal;
+		ANKI_TEST_EXPECT_NEAR(computeDistance(a, b, normal), 2.0f, 0.01f);
+		ANKI_TEST_EXPECT_NEAR(normal.x(), 1.0f, 0.01f);
+
+		ANKI_TEST_EXPECT_EQ(computeDistance(Sphere(Vec4(2.5f, 0.0f, 0.0f, 0.0f), 1.0f), b, normal), 0.0f);
+	}
+}
+
+ANKI_TEST(Collision, SweepVsSubsteppingBench)
+{
+	const U32 PAIR_COUNT = 10000;
+	const U32 STEP_COUNT = 32;
+
+	std::vector<Sphere> spheres(PAIR_COUNT);
+	std::vector<Obb> boxes(PAIR_COUNT);
+	std::vector<Vec4> translations(PAIR_COUNT);
+	for(U32 i = 0; i < PAIR_COUNT; ++i)
+	{
+		spheres[i] = Sphere(randomVec(5.0f), getRandomRange(0.1f, 0.5f));
+		boxes[i] = Obb(randomVec(3.0f), randomRotation(), randomExtend(0.1f, 2.0f));
+		translations[i] = randomVec(10.0f);
+	}
+
+	auto bench = [&](auto func, U32& hitCount) -> Second {
+		hitCount = 0;
+		HighRezTimer timer;
+		timer.start();
+		for(U32 i = 0; i < PAIR_COUNT; ++i)
+		{
+			F32 toi;
+			hitCount += func(spheres[i], translations[i], boxes[i], toi);
+		}
+		timer.stop();
+		return timer.getElapsedTime();
+	};
+
+	U32 sweepHits, toiHits, substepHits;
+	const Second sweepTime = bench(
+		[](const Sphere& a, const Vec4& translation, const Obb& b, F32& toi) {
+			return sweepCollision(a, translation, b, toi);
+		},
+		sweepHits);
+	const Second toiTime = bench(
+		[](const Sphere& a, const Vec4& translation, const Obb& b, F32& toi) {
+			return computeTimeOfImpact(a, translation, b, toi);
+		},
+		toiHits);
+	const Second substepTime = bench(
+		[&](const Sphere& a, const Vec4& translation, const Obb& b, F32& toi) {
+			return substepTimeOfImpact(a, translation, b, STEP_COUNT, toi);
+		},
+		substepHits);
+
+	// Substepping misses the fast moving objects
+	ANKI_TEST_EXPECT_LEQ(substepHits, sweepHits);
+
+	ANKI_TEST_LOGI("Sphere vs Obb %u pairs. Analytic sweep %fms (%u hits), conservative advancement %fms (%u hits), "
+				   "%u substeps %fms (%u hits)",
+				   PAIR_COUNT, sweepTime * 1000.0, sweepHits, toiTime * 1000.0, toiHits, STEP_COUNT,
+				   substepTime * 1000.0, substepHits);
+}
+
+} // end namespace anki
@@ -0,0 +1,132 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/resource/AnimationResource.h>
+#include <anki/util/HighRezTimer.h>
+#include <vector>
+#include <random>
+
+namespace anki
+{
+
+/// The linear scan the interpolation used to do.
+template<typename T>
+static Bool findKeyframesLinear(const std::vector<AnimationKeyframe<T>>& keyframes, Second time, U32& idx)
+{
+	for(U32 i = 0; i + 1 < keyframes.size(); ++i)
+	{
+		if(time >= keyframes[i].getTime() && time <= keyframes[i + 1].getTime())
+		{
+			idx = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+ANKI_TEST(Resource, AnimationKeyframes)
+{
+	std::vector<AnimationKeyframe<F32>> keyframes;
+	for(U32 i = 0; i < 10; ++i)
+	{
+		keyframes.push_back(AnimationKeyframe<F32>(Second(i) + 1.0, F32(i)));
+	}
+	const ConstWeakArray<AnimationKeyframe<F32>> keys(&keyframes[0], U32(keyframes.size()));
+
+	// Outside the keyframes
+	U32 idx = 0;
+	ANKI_TEST_EXPECT_EQ(findAnimationKeyframes(keys, 0.5, idx), false);
+	ANKI_TEST_EXPECT_EQ(findAnimationKeyframes(keys, 10.5, idx), false);
+	ANKI_TEST_EXPECT_EQ(findAnimationKeyframes(ConstWeakArray<AnimationKeyframe<F32>>(&keyframes[0], 1), 1.0, idx),
+						false);
+
+	// The edges
+	idx = 5;
+	ANKI_TEST_EXPECT_EQ(findAnimationKeyframes(keys, 1.0, idx), true);
+	ANKI_TEST_EXPECT_EQ(idx, 0u);
+	ANKI_TEST_EXPECT_EQ(findAnimationKeyframes(keys, 10.0, idx), true);
+	ANKI_TEST_EXPECT_EQ(idx, 8u);
+
+	// Random times with random hints should find the same pair as the linear scan
+	std::mt19937 rand(0x5678);
+	for(U32 i = 0; i < 1000; ++i)
+	{
+		const Second time = 1.0 + Second(rand() % 9000) / 1000.0;
+		U32 expectedIdx = 0;
+		ANKI_TEST_EXPECT_EQ(findKeyframesLinear(keyframes, time, expectedIdx), true);
+
+		idx = rand() % 12;
+		ANKI_TEST_EXPECT_EQ(findAnimationKeyframes(keys, time, idx), true);
+		ANKI_TEST_EXPECT_EQ(keys[idx].getTime() <= time && time <= keys[idx + 1].getTime(), true);
+		ANKI_TEST_EXPECT_EQ(idx == expectedIdx || keys[idx].getTime() == time, true);
+	}
+
+	// Playing forward the hint follows the time
+	idx = 0;
+	for(Second time = 1.0; time <= 10.0; time += 0.25)
+	{
+		U32 expectedIdx = 0;
+		findKeyframesLinear(keyframes, time, expectedIdx);
+		ANKI_TEST_EXPECT_EQ(findAnimationKeyframes(keys, time, idx), true);
+		ANKI_TEST_EXPECT_EQ(keys[idx].getTime() <= time && time <= keys[idx + 1].getTime(), true);
+	}
+}
+
+ANKI_TEST(Resource, AnimationKeyframesBench)
+{
+	// A 500 bone skeleton with a 20 second clip at 30 keyframes per second, sampled at 60 FPS
+	const U32 BONE_COUNT = 500;
+	const U32 KEYFRAME_COUNT = 600;
+	const U32 FRAME_COUNT = 1200;
+	const Second FRAME_TIME = 1.0 / 60.0;
+
+	std::vector<AnimationKeyframe<Vec3>> keyframes;
+	for(U32 i = 0; i < KEYFRAME_COUNT; ++i)
+	{
+		keyframes.push_back(AnimationKeyframe<Vec3>(Second(i) / 30.0, Vec3(F32(i))));
+	}
+	const ConstWeakArray<AnimationKeyframe<Vec3>> keys(&keyframes[0], KEYFRAME_COUNT);
+	const Second duration = keyframes.back().getTime();
+
+	auto bench = [&](auto findFunc) -> Second {
+		std::vector<U32> cursors(BONE_COUNT, 0);
+		Vec3 sum(0.0f);
+
+		HighRezTimer timer;
+		timer.start();
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			const Second time = mod(Second(frame) * FRAME_TIME, duration);
+			for(U32 bone = 0; bone < BONE_COUNT; ++bone)
+			{
+				U32& idx = cursors[bone];
+				if(findFunc(time, idx))
+				{
+					sum += keys[idx].getValue();
+				}
+			}
+		}
+		timer.stop();
+
+		ANKI_TEST_EXPECT_EQ(sum.x() > 0.0f, true);
+		return timer.getElapsedTime() / Second(FRAME_COUNT);
+	};
+
+	const Second linearTime = bench([&](Second time, U32& idx) { return findKeyframesLinear(keyframes, time, idx); });
+
+	const Second binarySearchTime = bench([&](Second time, U32& idx) {
+		idx = 0;
+		return findAnimationKeyframes(keys, time, idx);
+	});
+
+	const Second cursorTime = bench([&](Second time, U32& idx) { return findAnimationKeyframes(keys, time, idx); });
+
+	ANKI_TEST_LOGI("Sampling %u bones of %u keyframes per frame. Linear scan %fms, binary search %fms, cursor %fms",
+				   BONE_COUNT, KEYFRAME_COUNT, linearTime * 1000.0, binarySearchTime * 1000.0, cursorTime * 1000.0);
+}
+
+} // end namespace anki
@@ -0,0 +1,363 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/scene/RayCastTest.h>
+#include <anki/scene/Bvh.h>
+#include <anki/collision/Functions.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/physics/PhysicsWorld.h>
+#include <anki/physics/PhysicsBody.h>
+#include <anki/physics/PhysicsCollisionShape.h>
+#include <algorithm>
+
+namespace anki
+{
+
+static Aabb randomBox(F32 sceneSize, F32 maxBoxSize)
+{
+	const Vec3 min(getRandomRange(-sceneSize, sceneSize - maxBoxSize),
+				   getRandomRange(-sceneSize, sceneSize - maxBoxSize),
+				   getRandomRange(-sceneSize, sceneSize - maxBoxSize));
+	const Vec3 size(getRandomRange(0.1f, maxBoxSize), getRandomRange(0.1f, maxBoxSize),
+					getRandomRange(0.1f, maxBoxSize));
+	return Aabb(min, min + size);
+}
+
+static Bool insideFrustum(const Array<Plane, 6>& planes, const Aabb& box)
+{
+	for(const Plane& plane : planes)
+	{
+		if(testPlane(plane, box) < 0.0f)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static Array<Plane, 6> randomFrustum()
+{
+	const Mat4 proj = Mat4::calculatePerspectiveProjectionMatrix(toRad(60.0f), toRad(60.0f), 0.1f, 200.0f);
+	const Mat4 view(Vec4(getRandomRange(-20.0f, 20.0f), 0.0f, getRandomRange(-20.0f, 20.0f), 1.0f),
+					Mat3(Euler(0.0f, getRandomRange(0.0f, 2.0f * PI), 0.0f)), 1.0f);
+
+	Array<Plane, 6> planes;
+	extractClipPlanes(proj * view.getInverse(), planes);
+	return planes;
+}
+
+ANKI_TEST(Scene, Bvh)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// Fuzzy test against brute force
+	{
+		Bvh bvh(alloc);
+		bvh.init(0.5f);
+
+		const U32 COUNT = 1000;
+		std::vector<OctreePlaceable> placeables(COUNT);
+		std::vector<Aabb> boxes(COUNT);
+		std::vector<Bool> placed(COUNT, false);
+
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			placeables[i].m_userData = &placeables[i];
+		}
+
+		for(U32 iteration = 0; iteration < 5000; ++iteration)
+		{
+			const U32 i = getRandomRange(0u, COUNT - 1);
+			const U32 mode = getRandomRange(0u, 3u);
+
+			if(mode == 0 && placed[i])
+			{
+				bvh.remove(placeables[i]);
+				placed[i] = false;
+			}
+			else if(mode == 1 && placed[i])
+			{
+				// Small movement
+				const Vec4 offset(getRandomRange(-0.2f, 0.2f), getRandomRange(-0.2f, 0.2f),
+								  getRandomRange(-0.2f, 0.2f), 0.0f);
+				boxes[i] = Aabb(boxes[i].getMin() + offset, boxes[i].getMax() + offset);
+				bvh.place(boxes[i], &placeables[i], true);
+			}
+			else
+			{
+				boxes[i] = randomBox(100.0f, 10.0f);
+				bvh.place(boxes[i], &placeables[i], true);
+				placed[i] = true;
+			}
+
+			if((iteration % 100) == 0)
+			{
+				const Array<Plane, 6> planes = randomFrustum();
+
+				DynamicArrayAuto<void*> visibles(alloc);
+				bvh.gatherVisible(&planes[0], 0, nullptr, nullptr, visibles);
+
+				// Every visible box should be in the results. The Bvh is conservative so it may return more
+				for(U32 j = 0; j < COUNT; ++j)
+				{
+					if(placed[j] && insideFrustum(planes, boxes[j]))
+					{
+						ANKI_TEST_EXPECT_EQ(
+							std::find(visibles.getBegin(), visibles.getEnd(), &placeables[j]) != visibles.getEnd(),
+							true);
+					}
+				}
+
+				// And nothing is reported twice
+				std::sort(visibles.getBegin(), visibles.getEnd());
+				ANKI_TEST_EXPECT_EQ(std::unique(visibles.getBegin(), visibles.getEnd()) == visibles.getEnd(), true);
+			}
+		}
+
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			if(placed[i])
+			{
+				bvh.remove(placeables[i]);
+			}
+		}
+	}
+}
+
+ANKI_TEST(Scene, BvhRayCast)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	Bvh bvh(alloc);
+	bvh.init(0.5f);
+
+	const U32 COUNT = 2000;
+	const F32 SCENE_SIZE = 100.0f;
+	const F32 MAX_DISTANCE = 150.0f;
+	std::vector<OctreePlaceable> placeables(COUNT);
+	std::vector<Aabb> boxes(COUNT);
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		boxes[i] = randomBox(SCENE_SIZE, 5.0f);
+		placeables[i].m_userData = &boxes[i];
+		bvh.place(boxes[i], &placeables[i], true);
+	}
+
+	testRayCastAgainstBruteForce(bvh, randomRays(RAY_CAST_TEST_RAY_COUNT, SCENE_SIZE), boxes, MAX_DISTANCE);
+
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		bvh.remove(placeables[i]);
+	}
+}
+
+ANKI_TEST(Scene, BvhRayCastVsPhysicsBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 COUNT = 5000;
+	const U32 RAY_COUNT = 10000;
+	const F32 SCENE_SIZE = 200.0f;
+	const F32 MAX_DISTANCE = 100.0f;
+
+	std::vector<Aabb> boxes(COUNT);
+	for(Aabb& box : boxes)
+	{
+		box = randomBox(SCENE_SIZE, 5.0f);
+	}
+
+	const std::vector<Ray> rays = randomRays(RAY_COUNT, SCENE_SIZE);
+
+	// Bvh
+	U32 bvhHitCount = 0;
+	Second bvhTime;
+	{
+		Bvh bvh(alloc);
+		bvh.init(0.1f);
+
+		std::vector<OctreePlaceable> placeables(COUNT);
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			placeables[i].m_userData = &boxes[i];
+			bvh.place(boxes[i], &placeables[i], true);
+		}
+
+		std::vector<OctreeRayHit> hits(RAY_COUNT);
+
+		HighRezTimer timer;
+		timer.start();
+		bvh.rayCast(ConstWeakArray<Ray>(&rays[0], RAY_COUNT), MAX_DISTANCE,
+					[&](void* userData, const Ray& ray, F32 boxDistance) {
+						return rayBoxDistance(ray, *static_cast<const Aabb*>(userData), MAX_DISTANCE);
+					},
+					WeakArray<OctreeRayHit>(&hits[0], RAY_COUNT));
+		timer.stop();
+		bvhTime = timer.getElapsedTime();
+
+		for(const OctreeRayHit& hit : hits)
+		{
+			bvhHitCount += hit.m_userData != nullptr;
+		}
+
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			bvh.remove(placeables[i]);
+		}
+	}
+
+	// Physics
+	U32 physicsHitCount = 0;
+	Second physicsTime;
+	{
+		PhysicsWorld* physics = new PhysicsWorld();
+		ANKI_TEST_EXPECT_NO_ERR(physics->create(allocAligned, nullptr));
+
+		{
+			std::vector<PhysicsCollisionShapePtr> shapes;
+			std::vector<PhysicsBodyPtr> bodies;
+			for(const Aabb& box : boxes)
+			{
+				PhysicsBodyInitInfo init;
+				init.m_shape = physics->newInstance<PhysicsBox>((box.getMax() - box.getMin()).xyz() / 2.0f);
+				init.m_transform =
+					Transform(((box.getMax() + box.getMin()) / 2.0f).xyz0(), Mat3x4::getIdentity(), 1.0f);
+				shapes.push_back(init.m_shape);
+				bodies.push_back(physics->newInstance<PhysicsBody>(init));
+			}
+
+			class RayCast : public PhysicsWorldRayCastCallback
+			{
+			public:
+				Bool m_hit = false;
+
+				RayCast(const Vec3& from, const Vec3& to)
+					: PhysicsWorldRayCastCallback(from, to, PhysicsMaterialBit::ALL)
+				{
+				}
+
+				void processResult(PhysicsFilteredObject& obj, const Vec3& worldNormal, const Vec3& worldPosition)
+				{
+					m_hit = true;
+				}
+			};
+
+			std::vector<RayCast> rayCasts;
+			std::vector<PhysicsWorldRayCastCallback*> rayCastPtrs;
+			rayCasts.reserve(RAY_COUNT);
+			for(const Ray& ray : rays)
+			{
+				rayCasts.emplace_back(ray.getOrigin().xyz(),
+									  (ray.getOrigin() + ray.getDirection() * MAX_DISTANCE).xyz());
+				rayCastPtrs.push_back(&rayCasts.back());
+			}
+
+			HighRezTimer timer;
+			timer.start();
+			physics->rayCast(WeakArray<PhysicsWorldRayCastCallback*>(&rayCastPtrs[0], RAY_COUNT));
+			timer.stop();
+			physicsTime = timer.getElapsedTime();
+
+			for(const RayCast& rayCast : rayCasts)
+			{
+				physicsHitCount += rayCast.m_hit;
+			}
+		}
+
+		delete physics;
+	}
+
+	ANKI_TEST_LOGI("%u rays against %u boxes", RAY_COUNT, COUNT);
+	ANKI_TEST_LOGI("Bvh:     %fms hits %u", bvhTime * 1000.0, bvhHitCount);
+	ANKI_TEST_LOGI("Physics: %fms hits %u", physicsTime * 1000.0, physicsHitCount);
+}
+
+ANKI_TEST(Scene, BvhVsOctreeBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 COUNT = 20000;
+	const U32 FRAME_COUNT = 60;
+	const F32 SCENE_SIZE = 500.0f;
+
+	std::vector<Aabb> boxes(COUNT);
+	std::vector<Vec4> velocities(COUNT);
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		boxes[i] = randomBox(SCENE_SIZE, 5.0f);
+		velocities[i] = Vec4(getRandomRange(-0.3f, 0.3f), 0.0f, getRandomRange(-0.3f, 0.3f), 0.0f);
+	}
+
+	std::vector<Array<Plane, 6>> frustums(FRAME_COUNT);
+	for(U32 i = 0; i < FRAME_COUNT; ++i)
+	{
+		frustums[i] = randomFrustum();
+	}
+
+	// Runs a number of frames where all objects move and then a frustum is tested. Returns the visible count
+	auto runFrames = [&](auto& tree, Second& placeTime, Second& gatherTime) -> PtrSize {
+		std::vector<OctreePlaceable> placeables(COUNT);
+		std::vector<Aabb> crntBoxes = boxes;
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			placeables[i].m_userData = &placeables[i];
+			tree.place(crntBoxes[i], &placeables[i], true);
+		}
+
+		HighRezTimer placeTimer, gatherTimer;
+		placeTime = gatherTime = 0.0;
+		PtrSize visibleCount = 0;
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			placeTimer.start();
+			for(U32 i = 0; i < COUNT; ++i)
+			{
+				crntBoxes[i] = Aabb(crntBoxes[i].getMin() + velocities[i], crntBoxes[i].getMax() + velocities[i]);
+				placeables[i].reset();
+				tree.place(crntBoxes[i], &placeables[i], true);
+			}
+			placeTimer.stop();
+			placeTime += placeTimer.getElapsedTime();
+
+			gatherTimer.start();
+			DynamicArrayAuto<void*> visibles(alloc);
+			tree.gatherVisible(&frustums[frame][0], 0, nullptr, nullptr, visibles);
+			gatherTimer.stop();
+			gatherTime += gatherTimer.getElapsedTime();
+
+			visibleCount += visibles.getSize();
+		}
+
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			tree.remove(placeables[i]);
+		}
+
+		return visibleCount;
+	};
+
+	Second octreePlace, octreeGather;
+	PtrSize octreeVisibles;
+	{
+		Octree octree(alloc);
+		octree.init(Vec3(-SCENE_SIZE - 50.0f), Vec3(SCENE_SIZE + 50.0f), 5);
+		octreeVisibles = runFrames(octree, octreePlace, octreeGather);
+	}
+
+	Second bvhPlace, bvhGather;
+	PtrSize bvhVisibles;
+	{
+		Bvh bvh(alloc);
+		bvh.init(0.5f);
+		bvhVisibles = runFrames(bvh, bvhPlace, bvhGather);
+	}
+
+	ANKI_TEST_LOGI("%u moving objects, %u frames", COUNT, FRAME_COUNT);
+	ANKI_TEST_LOGI("Octree: place %fms gather %fms visibles %lu", octreePlace * 1000.0, octreeGather * 1000.0,
+				   octreeVisibles);
+	ANKI_TEST_LOGI("Bvh:    place %fms gather %fms visibles %lu", bvhPlace * 1000.0, bvhGather * 1000.0, bvhVisibles);
+}
+
+} // end namespace anki
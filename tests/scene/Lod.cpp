@@ -0,0 +1,50 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/components/RenderComponent.h>
+
+namespace anki
+{
+
+ANKI_TEST(Scene, Lod)
+{
+	const Array<F32, MAX_LOD_COUNT - 1> lodScreenSizes = {{0.2f, 0.1f}};
+	const F32 hysteresis = 0.1f;
+
+	// Without history it's the plain thresholds
+	ANKI_TEST_EXPECT_EQ(computeLod(0.5f, lodScreenSizes, hysteresis, MAX_U8), 0);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.2f, lodScreenSizes, hysteresis, MAX_U8), 0);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.19f, lodScreenSizes, hysteresis, MAX_U8), 1);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.1f, lodScreenSizes, hysteresis, MAX_U8), 1);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.09f, lodScreenSizes, hysteresis, MAX_U8), 2);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.0f, lodScreenSizes, hysteresis, MAX_U8), 2);
+
+	// Inside the band it keeps the previous LOD
+	ANKI_TEST_EXPECT_EQ(computeLod(0.19f, lodScreenSizes, hysteresis, 0), 0);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.21f, lodScreenSizes, hysteresis, 1), 1);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.095f, lodScreenSizes, hysteresis, 1), 1);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.105f, lodScreenSizes, hysteresis, 2), 2);
+
+	// Out of the band it switches, even across many LODs
+	ANKI_TEST_EXPECT_EQ(computeLod(0.17f, lodScreenSizes, hysteresis, 0), 1);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.23f, lodScreenSizes, hysteresis, 1), 0);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.05f, lodScreenSizes, hysteresis, 0), 2);
+	ANKI_TEST_EXPECT_EQ(computeLod(0.5f, lodScreenSizes, hysteresis, 2), 0);
+
+	// An object that wobbles around a threshold doesn't pop every frame
+	U8 lod = MAX_U8;
+	U32 switchCount = 0;
+	for(U32 frame = 0; frame < 100; ++frame)
+	{
+		const F32 screenSize = 0.2f + ((frame & 1) ? 0.01f : -0.01f);
+		const U8 newLod = computeLod(screenSize, lodScreenSizes, hysteresis, lod);
+		switchCount += (lod != MAX_U8 && newLod != lod) ? 1 : 0;
+		lod = newLod;
+	}
+	ANKI_TEST_EXPECT_EQ(switchCount, 0u);
+}
+
+} // end namespace anki
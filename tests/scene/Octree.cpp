@@ -3,8 +3,13 @@
 // Code licensed under the BSD License.
 // http://www.anki3d.org/LICENSE
 
-#include <tests/framework/Framework.h>
+#include <tests/scene/RayCastTest.h>
 #include <anki/scene/Octree.h>
+#include <anki/collision/Plane.h>
+#include <anki/collision/Functions.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/System.h>
 
 namespace anki
 {
@@ -86,4 +91,572 @@ ANKI_TEST(Scene, Octree)
 #endif
 }
 
+/// Create the planes of a box that can be used to gather from the Octree.
+static void computeBoxPlanes(const Vec3& min, const Vec3& max, Array<Plane, 6>& planes)
+{
+	for(U32 i = 0; i < 3; ++i)
+	{
+		Vec4 normal(0.0f);
+		normal[i] = 1.0f;
+		planes[i * 2] = Plane(normal, min[i]);
+		planes[i * 2 + 1] = Plane(-normal, -max[i]);
+	}
+}
+
+class OctreeMtTestContext
+{
+public:
+	Octree* m_octree = nullptr;
+	OctreePlaceable* m_placeables = nullptr;
+	const Aabb* m_volumes = nullptr;
+	U32 m_first = 0;
+	U32 m_count = 0;
+	Bool m_remove = false;
+};
+
+static void placeOrRemoveTask(void* arg, U32, ThreadHive&, ThreadHiveSemaphore*)
+{
+	OctreeMtTestContext& ctx = *static_cast<OctreeMtTestContext*>(arg);
+	for(U32 i = ctx.m_first; i < ctx.m_first + ctx.m_count; ++i)
+	{
+		if(ctx.m_remove)
+		{
+			ctx.m_octree->remove(ctx.m_placeables[i]);
+		}
+		else
+		{
+			ctx.m_octree->place(ctx.m_volumes[i], &ctx.m_placeables[i], true);
+		}
+	}
+}
+
+ANKI_TEST(Scene, OctreeMtPlacementBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 OBJECT_COUNT = 20000;
+	const U32 FRAME_COUNT = 10;
+	const U32 OBJECTS_PER_TASK = 128;
+	const U32 threadCount = max(2u, getCpuCoresCount());
+
+	Octree octree(alloc);
+	octree.init(Vec3(-100.0f), Vec3(100.0f), 5);
+
+	std::vector<OctreePlaceable> placeables(OBJECT_COUNT);
+	std::vector<Aabb> volumes(OBJECT_COUNT);
+	for(U32 i = 0; i < OBJECT_COUNT; ++i)
+	{
+		placeables[i].m_userData = &placeables[i];
+
+		const Vec3 min(getRandomRange(-99.0f, 95.0f), getRandomRange(-99.0f, 95.0f), getRandomRange(-99.0f, 95.0f));
+		volumes[i] = Aabb(min, min + Vec3(getRandomRange(0.1f, 4.0f)));
+	}
+
+	// Move all objects a bit like a frame would do
+	auto moveObjects = [&]() {
+		for(Aabb& volume : volumes)
+		{
+			Vec4 offset(getRandomRange(-0.5f, 0.5f), getRandomRange(-0.5f, 0.5f), getRandomRange(-0.5f, 0.5f), 0.0f);
+			offset = offset.max(Vec4(-99.0f) - volume.getMin()).min(Vec4(99.0f) - volume.getMax());
+			volume = Aabb(volume.getMin() + offset, volume.getMax() + offset);
+		}
+	};
+
+	// Gather with planes that contain the whole scene and check that all objects are there
+	auto gatherAll = [&](U32 testId) -> U32 {
+		Array<Plane, 6> planes;
+		computeBoxPlanes(Vec3(-1000.0f), Vec3(1000.0f), planes);
+
+		DynamicArrayAuto<void*> out(alloc);
+		octree.gatherVisible(&planes[0], testId, nullptr, nullptr, out);
+		return U32(out.getSize());
+	};
+
+	// Single threaded
+	Second singleThreadTime = 0.0;
+	for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		moveObjects();
+
+		HighRezTimer timer;
+		timer.start();
+		for(U32 i = 0; i < OBJECT_COUNT; ++i)
+		{
+			octree.place(volumes[i], &placeables[i], true);
+		}
+		timer.stop();
+		singleThreadTime += timer.getElapsedTime();
+	}
+
+	ANKI_TEST_EXPECT_EQ(gatherAll(0), OBJECT_COUNT);
+
+	// Multi threaded
+	ThreadHive hive(threadCount, alloc);
+	const U32 taskCount = (OBJECT_COUNT + OBJECTS_PER_TASK - 1) / OBJECTS_PER_TASK;
+	std::vector<OctreeMtTestContext> contexts(taskCount);
+	for(U32 i = 0; i < taskCount; ++i)
+	{
+		contexts[i].m_octree = &octree;
+		contexts[i].m_placeables = &placeables[0];
+		contexts[i].m_volumes = &volumes[0];
+		contexts[i].m_first = i * OBJECTS_PER_TASK;
+		contexts[i].m_count = min(OBJECTS_PER_TASK, OBJECT_COUNT - contexts[i].m_first);
+	}
+
+	Second multiThreadTime = 0.0;
+	for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		moveObjects();
+
+		HighRezTimer timer;
+		timer.start();
+		for(OctreeMtTestContext& ctx : contexts)
+		{
+			hive.submitTask(placeOrRemoveTask, &ctx);
+		}
+		hive.waitAllTasks();
+		timer.stop();
+		multiThreadTime += timer.getElapsedTime();
+
+		// Check that nothing got lost
+		for(OctreePlaceable& placeable : placeables)
+		{
+			placeable.reset();
+		}
+		ANKI_TEST_EXPECT_EQ(gatherAll(0), OBJECT_COUNT);
+	}
+
+	Vec3 sceneMin, sceneMax;
+	octree.getActualSceneBounds(sceneMin, sceneMax);
+	ANKI_TEST_EXPECT_GEQ(sceneMin.x(), -99.0f - EPSILON);
+	ANKI_TEST_EXPECT_LEQ(sceneMax.x(), 99.0f + EPSILON);
+
+	// Remove everything in parallel
+	for(OctreeMtTestContext& ctx : contexts)
+	{
+		ctx.m_remove = true;
+		hive.submitTask(placeOrRemoveTask, &ctx);
+	}
+	hive.waitAllTasks();
+
+	ANKI_TEST_LOGI("Placing %u moving objects for %u frames. 1 thread %fms, %u threads %fms", OBJECT_COUNT,
+				   FRAME_COUNT, singleThreadTime * 1000.0, threadCount, multiThreadTime * 1000.0);
+}
+
+ANKI_TEST(Scene, OctreeIncrementalPlacement)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 OBJECT_COUNT = 5000;
+	const U32 FRAME_COUNT = 20;
+
+	Octree octree(alloc);
+	octree.init(Vec3(-100.0f), Vec3(100.0f), 5);
+
+	std::vector<OctreePlaceable> placeables(OBJECT_COUNT);
+	std::vector<Aabb> volumes(OBJECT_COUNT);
+	for(U32 i = 0; i < OBJECT_COUNT; ++i)
+	{
+		placeables[i].m_userData = &placeables[i];
+
+		const Vec3 min(getRandomRange(-99.0f, 95.0f), getRandomRange(-99.0f, 95.0f), getRandomRange(-99.0f, 95.0f));
+		volumes[i] = Aabb(min, min + Vec3(getRandomRange(0.1f, 4.0f)));
+		octree.place(volumes[i], &placeables[i], true);
+	}
+
+	auto place = [&]() -> Second {
+		HighRezTimer timer;
+		timer.start();
+		for(U32 i = 0; i < OBJECT_COUNT; ++i)
+		{
+			octree.place(volumes[i], &placeables[i], true);
+		}
+		timer.stop();
+		return timer.getElapsedTime();
+	};
+
+	// Re-placing without moving should be cheap
+	const Second unchangedTime = place();
+
+	// Move slowly and check that the gather doesn't miss anything
+	Second movingTime = 0.0;
+	for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		for(Aabb& volume : volumes)
+		{
+			Vec4 offset(getRandomRange(-0.2f, 0.2f), getRandomRange(-0.2f, 0.2f), getRandomRange(-0.2f, 0.2f), 0.0f);
+			offset = offset.max(Vec4(-99.0f) - volume.getMin()).min(Vec4(99.0f) - volume.getMax());
+			volume = Aabb(volume.getMin() + offset, volume.getMax() + offset);
+		}
+
+		movingTime += place();
+
+		const Vec3 queryMin(getRandomRange(-100.0f, 0.0f), getRandomRange(-100.0f, 0.0f), getRandomRange(-100.0f, 0.0f));
+		const Aabb query(queryMin, queryMin + Vec3(getRandomRange(10.0f, 100.0f)));
+		Array<Plane, 6> planes;
+		computeBoxPlanes(query.getMin().xyz(), query.getMax().xyz(), planes);
+
+		for(OctreePlaceable& placeable : placeables)
+		{
+			placeable.reset();
+		}
+
+		DynamicArrayAuto<void*> out(alloc);
+		octree.gatherVisible(&planes[0], 0, nullptr, nullptr, out);
+
+		std::vector<Bool> gathered(OBJECT_COUNT, false);
+		for(void* userData : out)
+		{
+			gathered[static_cast<OctreePlaceable*>(userData) - &placeables[0]] = true;
+		}
+
+		for(U32 i = 0; i < OBJECT_COUNT; ++i)
+		{
+			if(testCollision(volumes[i], query))
+			{
+				ANKI_TEST_EXPECT_EQ(gathered[i], true);
+			}
+		}
+	}
+
+	for(OctreePlaceable& placeable : placeables)
+	{
+		octree.remove(placeable);
+	}
+
+	ANKI_TEST_LOGI("Re-placing %u objects. Not moving %fms, slowly moving %fms per frame", OBJECT_COUNT,
+				   unchangedTime * 1000.0, movingTime * 1000.0 / F32(FRAME_COUNT));
+}
+
+ANKI_TEST(Scene, OctreeCompactGatherBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 OBJECT_COUNT = 100000;
+	const U32 QUERY_COUNT = 200;
+
+	Octree octree(alloc);
+	octree.init(Vec3(-1000.0f), Vec3(1000.0f), 6);
+
+	std::vector<OctreePlaceable> placeables(OBJECT_COUNT);
+	for(U32 i = 0; i < OBJECT_COUNT; ++i)
+	{
+		placeables[i].m_userData = &placeables[i];
+
+		const Vec3 min(getRandomRange(-999.0f, 990.0f), getRandomRange(-999.0f, 990.0f),
+					   getRandomRange(-999.0f, 990.0f));
+		octree.place(Aabb(min, min + Vec3(getRandomRange(0.5f, 8.0f))), &placeables[i], true);
+	}
+
+	std::vector<Array<Plane, 6>> queries(QUERY_COUNT);
+	for(Array<Plane, 6>& planes : queries)
+	{
+		const Vec3 min(getRandomRange(-1000.0f, 500.0f), getRandomRange(-1000.0f, 500.0f),
+					   getRandomRange(-1000.0f, 500.0f));
+		computeBoxPlanes(min, min + Vec3(getRandomRange(50.0f, 500.0f)), planes);
+	}
+
+	auto bench = [&](U32& gatherCount) -> Second {
+		gatherCount = 0;
+		HighRezTimer timer;
+		timer.start();
+		for(U32 i = 0; i < QUERY_COUNT; ++i)
+		{
+			const U32 testId = i % 64;
+			if(testId == 0)
+			{
+				for(OctreePlaceable& placeable : placeables)
+				{
+					placeable.reset();
+				}
+			}
+
+			DynamicArrayAuto<void*> out(alloc);
+			octree.gatherVisible(&queries[i][0], testId, nullptr, nullptr, out);
+			gatherCount += U32(out.getSize());
+		}
+		timer.stop();
+		return timer.getElapsedTime();
+	};
+
+	U32 pointerGatherCount, compactGatherCount;
+	const Second pointerTime = bench(pointerGatherCount);
+
+	octree.setCompactTraversal(true);
+	DynamicArrayAuto<void*> warmup(alloc);
+	HighRezTimer buildTimer;
+	buildTimer.start();
+	octree.gatherVisible(&queries[0][0], 0, nullptr, nullptr, warmup); // Builds the compact tree
+	buildTimer.stop();
+
+	const Second compactTime = bench(compactGatherCount);
+	ANKI_TEST_EXPECT_EQ(pointerGatherCount, compactGatherCount);
+
+	// The parallel gather should find the same
+	ThreadHive hive(max(2u, getCpuCoresCount()), alloc);
+	for(U32 i = 0; i < 8; ++i)
+	{
+		for(OctreePlaceable& placeable : placeables)
+		{
+			placeable.reset();
+		}
+
+		DynamicArrayAuto<void*> serialOut(alloc);
+		octree.gatherVisible(&queries[i][0], 0, nullptr, nullptr, serialOut);
+
+		DynamicArrayAuto<void*> parallelOut(alloc);
+		ThreadHiveSemaphore* signalSemaphore;
+		octree.gatherVisibleParallel(&queries[i][0], 1, nullptr, nullptr, &parallelOut, hive, nullptr,
+									 signalSemaphore);
+		hive.waitAllTasks();
+
+		ANKI_TEST_EXPECT_EQ(serialOut.getSize(), parallelOut.getSize());
+	}
+
+	for(OctreePlaceable& placeable : placeables)
+	{
+		octree.remove(placeable);
+	}
+
+	ANKI_TEST_LOGI("%u gathers on %u objects (%u results). Pointer tree %fms, compact tree %fms (built in %fms)",
+				   QUERY_COUNT, OBJECT_COUNT, compactGatherCount, pointerTime * 1000.0, compactTime * 1000.0,
+				   buildTimer.getElapsedTime() * 1000.0);
+}
+
+ANKI_TEST(Scene, OctreeEmpty)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(2, alloc);
+
+	Array<Plane, 6> planes;
+	computeBoxPlanes(Vec3(-100.0f), Vec3(100.0f), planes);
+
+	for(U32 compact = 0; compact < 2; ++compact)
+	{
+		Octree octree(alloc);
+		octree.init(Vec3(-100.0f), Vec3(100.0f), 4);
+		octree.setCompactTraversal(compact != 0);
+
+		// Never had a placeable and then emptied again
+		for(U32 pass = 0; pass < 2; ++pass)
+		{
+			if(pass == 1)
+			{
+				OctreePlaceable placeable;
+				placeable.m_userData = &placeable;
+				octree.place(Aabb(Vec3(1.0f), Vec3(2.0f)), &placeable, true);
+				octree.remove(placeable);
+			}
+
+			DynamicArrayAuto<void*> out(alloc);
+			octree.gatherVisible(&planes[0], 0, nullptr, nullptr, out);
+			ANKI_TEST_EXPECT_EQ(out.getSize(), 0u);
+
+			U32 placeableCount = 0;
+			octree.walkTree(1, [](const Aabb&) { return true; }, [&](void*) { ++placeableCount; });
+			ANKI_TEST_EXPECT_EQ(placeableCount, 0u);
+
+			DynamicArrayAuto<void*> parallelOut(alloc);
+			ThreadHiveSemaphore* signalSemaphore;
+			octree.gatherVisibleParallel(&planes[0], 2, nullptr, nullptr, &parallelOut, hive, nullptr,
+										 signalSemaphore);
+			hive.waitAllTasks();
+			ANKI_TEST_EXPECT_EQ(parallelOut.getSize(), 0u);
+		}
+	}
+}
+
+ANKI_TEST(Scene, OctreeTestEpochs)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	Array<Plane, 6> planes;
+	computeBoxPlanes(Vec3(-100.0f), Vec3(100.0f), planes);
+
+	Octree octree(alloc);
+	octree.init(Vec3(-100.0f), Vec3(100.0f), 4);
+
+	// Big enough to be in more than one leaf
+	Array<OctreePlaceable, 3> placeables;
+	for(U32 i = 0; i < placeables.getSize(); ++i)
+	{
+		placeables[i].m_userData = &placeables[i];
+		octree.place(Aabb(Vec3(F32(i) * 10.0f - 5.0f), Vec3(F32(i) * 10.0f + 5.0f)), &placeables[i], true);
+	}
+
+	auto gather = [&](U32 testId) -> U32 {
+		DynamicArrayAuto<void*> out(alloc);
+		octree.gatherVisible(&planes[0], testId, nullptr, nullptr, out);
+		return U32(out.getSize());
+	};
+
+	// Every test of an epoch visits the placeables once
+	ANKI_TEST_EXPECT_EQ(gather(OctreePlaceable::computeTestId(1, 0)), 3u);
+	ANKI_TEST_EXPECT_EQ(gather(OctreePlaceable::computeTestId(1, 0)), 0u);
+	ANKI_TEST_EXPECT_EQ(gather(OctreePlaceable::computeTestId(1, 63)), 3u);
+
+	// A new epoch forgets the older tests without a reset
+	ANKI_TEST_EXPECT_EQ(gather(OctreePlaceable::computeTestId(2, 0)), 3u);
+	ANKI_TEST_EXPECT_EQ(gather(OctreePlaceable::computeTestId(2, 63)), 3u);
+	ANKI_TEST_EXPECT_EQ(gather(OctreePlaceable::computeTestId(2, 63)), 0u);
+
+	for(OctreePlaceable& placeable : placeables)
+	{
+		octree.remove(placeable);
+	}
+}
+
+ANKI_TEST(Scene, OctreeLooseVsStrictBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 OBJECT_COUNT = 20000;
+	const U32 FRAME_COUNT = 10;
+	const U32 QUERY_COUNT = 100;
+
+	std::vector<Aabb> volumes(OBJECT_COUNT);
+	for(U32 i = 0; i < OBJECT_COUNT; ++i)
+	{
+		const Vec3 min(getRandomRange(-99.0f, 90.0f), getRandomRange(-99.0f, 90.0f), getRandomRange(-99.0f, 90.0f));
+		volumes[i] = Aabb(min, min + Vec3(getRandomRange(0.1f, 8.0f)));
+	}
+
+	std::vector<Aabb> queries(QUERY_COUNT);
+	for(Aabb& query : queries)
+	{
+		const Vec3 min(getRandomRange(-100.0f, 50.0f), getRandomRange(-100.0f, 50.0f), getRandomRange(-100.0f, 50.0f));
+		query = Aabb(min, min + Vec3(getRandomRange(5.0f, 50.0f)));
+	}
+
+	auto bench = [&](F32 looseness, Second& placeTime, Second& gatherTime, U32& gatherCount) {
+		Octree octree(alloc);
+		octree.init(Vec3(-100.0f), Vec3(100.0f), 5, looseness);
+
+		std::vector<OctreePlaceable> placeables(OBJECT_COUNT);
+		std::vector<Aabb> movingVolumes = volumes;
+		placeTime = 0.0;
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			for(Aabb& volume : movingVolumes)
+			{
+				const Vec4 offset = (frame & 1) ? Vec4(0.3f, 0.0f, 0.0f, 0.0f) : Vec4(-0.3f, 0.0f, 0.0f, 0.0f);
+				volume = Aabb(volume.getMin() + offset, volume.getMax() + offset);
+			}
+
+			HighRezTimer timer;
+			timer.start();
+			for(U32 i = 0; i < OBJECT_COUNT; ++i)
+			{
+				placeables[i].m_userData = &placeables[i];
+				octree.place(movingVolumes[i], &placeables[i], true);
+			}
+			timer.stop();
+			placeTime += timer.getElapsedTime();
+		}
+
+		gatherTime = 0.0;
+		gatherCount = 0;
+		for(const Aabb& query : queries)
+		{
+			for(OctreePlaceable& placeable : placeables)
+			{
+				placeable.reset();
+			}
+
+			Array<Plane, 6> planes;
+			computeBoxPlanes(query.getMin().xyz(), query.getMax().xyz(), planes);
+
+			DynamicArrayAuto<void*> out(alloc);
+			HighRezTimer timer;
+			timer.start();
+			octree.gatherVisible(&planes[0], 0, nullptr, nullptr, out);
+			timer.stop();
+			gatherTime += timer.getElapsedTime();
+			gatherCount += U32(out.getSize());
+
+			// Nothing should be missed
+			std::vector<Bool> gathered(OBJECT_COUNT, false);
+			for(void* userData : out)
+			{
+				gathered[static_cast<OctreePlaceable*>(userData) - &placeables[0]] = true;
+			}
+
+			for(U32 i = 0; i < OBJECT_COUNT; ++i)
+			{
+				if(testCollision(movingVolumes[i], query))
+				{
+					ANKI_TEST_EXPECT_EQ(gathered[i], true);
+				}
+			}
+		}
+
+		for(OctreePlaceable& placeable : placeables)
+		{
+			octree.remove(placeable);
+		}
+	};
+
+	Second strictPlaceTime, strictGatherTime, loosePlaceTime, looseGatherTime;
+	U32 strictGatherCount, looseGatherCount;
+	bench(1.0f, strictPlaceTime, strictGatherTime, strictGatherCount);
+	bench(2.0f, loosePlaceTime, looseGatherTime, looseGatherCount);
+
+	ANKI_TEST_LOGI("%u moving objects. Strict octree: placement %fms, gather %fms (%u results). Loose octree: placement "
+				   "%fms, gather %fms (%u results)",
+				   OBJECT_COUNT, strictPlaceTime * 1000.0, strictGatherTime * 1000.0, strictGatherCount,
+				   loosePlaceTime * 1000.0, looseGatherTime * 1000.0, looseGatherCount);
+}
+
+ANKI_TEST(Scene, OctreeRayCast)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 OBJECT_COUNT = 2000;
+	const F32 MAX_DISTANCE = 150.0f;
+
+	std::vector<Aabb> volumes(OBJECT_COUNT);
+	for(Aabb& volume : volumes)
+	{
+		const Vec3 min(getRandomRange(-99.0f, 90.0f), getRandomRange(-99.0f, 90.0f), getRandomRange(-99.0f, 90.0f));
+		volume = Aabb(min, min + Vec3(getRandomRange(0.1f, 8.0f)));
+	}
+
+	const std::vector<Ray> rays = randomRays(RAY_CAST_TEST_RAY_COUNT, 100.0f);
+
+	auto test = [&](F32 looseness, Bool compact) {
+		Octree octree(alloc);
+		octree.init(Vec3(-100.0f), Vec3(100.0f), 5, looseness);
+		octree.setCompactTraversal(compact);
+
+		std::vector<OctreePlaceable> placeables(OBJECT_COUNT);
+		for(U32 i = 0; i < OBJECT_COUNT; ++i)
+		{
+			placeables[i].m_userData = &volumes[i];
+			octree.place(volumes[i], &placeables[i], true);
+		}
+
+		testRayCastAgainstBruteForce(octree, rays, volumes, MAX_DISTANCE);
+
+		for(OctreePlaceable& placeable : placeables)
+		{
+			octree.remove(placeable);
+		}
+
+		// An empty tree hits nothing
+		std::vector<OctreeRayHit> hits(rays.size());
+		octree.rayCast(ConstWeakArray<Ray>(&rays[0], U32(rays.size())), MAX_DISTANCE,
+					   [&](void*, const Ray&, F32 leafDistance) { return leafDistance; },
+					   WeakArray<OctreeRayHit>(&hits[0], U32(hits.size())));
+		for(const OctreeRayHit& hit : hits)
+		{
+			ANKI_TEST_EXPECT_EQ(hit.m_userData, nullptr);
+		}
+	};
+
+	test(1.0f, false);
+	test(1.0f, true);
+	test(2.0f, false);
+	test(2.0f, true);
+}
+
 } // end namespace anki
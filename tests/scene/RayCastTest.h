@@ -0,0 +1,91 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#pragma once
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/Octree.h>
+#include <anki/collision/RayPacket.h>
+#include <vector>
+
+namespace anki
+{
+
+/// Not a multiple of RayPacket::SIZE so the last packet of the ray casts is partial.
+static const U32 RAY_CAST_TEST_RAY_COUNT = RayPacket::SIZE * 250 + 1;
+
+/// The distance where the ray enters the box or a negative value if it misses it. It's the brute force reference of
+/// the ray casts and the exact hit test of their placeables.
+inline F32 rayBoxDistance(const Ray& ray, const Aabb& box, F32 maxDistance)
+{
+	F32 tNear = 0.0f;
+	F32 tFar = maxDistance;
+	for(U32 i = 0; i < 3; ++i)
+	{
+		const F32 invDir = 1.0f / ray.getDirection()[i];
+		const F32 t0 = (box.getMin()[i] - ray.getOrigin()[i]) * invDir;
+		const F32 t1 = (box.getMax()[i] - ray.getOrigin()[i]) * invDir;
+		tNear = max(tNear, min(t0, t1));
+		tFar = min(tFar, max(t0, t1));
+	}
+
+	return (tNear <= tFar) ? tNear : -1.0f;
+}
+
+/// Rays that start inside a cube of half size sceneSize and point anywhere.
+inline std::vector<Ray> randomRays(U32 count, F32 sceneSize)
+{
+	std::vector<Ray> rays(count);
+	for(Ray& ray : rays)
+	{
+		const Vec3 origin(getRandomRange(-sceneSize, sceneSize), getRandomRange(-sceneSize, sceneSize),
+						  getRandomRange(-sceneSize, sceneSize));
+		Vec3 dir(getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f), getRandomRange(-1.0f, 1.0f));
+		dir = (dir.getLengthSquared() > EPSILON) ? dir.getNormalized() : Vec3(0.0f, 1.0f, 0.0f);
+		ray = Ray(origin, dir);
+	}
+
+	return rays;
+}
+
+/// Cast the rays against a tree whose placeables have the boxes as user data and compare the hits with a brute force
+/// test of all the boxes.
+template<typename TTree>
+void testRayCastAgainstBruteForce(TTree& tree, const std::vector<Ray>& rays, const std::vector<Aabb>& boxes,
+								  F32 maxDistance)
+{
+	const U32 rayCount = U32(rays.size());
+	std::vector<OctreeRayHit> hits(rayCount);
+	tree.rayCast(ConstWeakArray<Ray>(&rays[0], rayCount), maxDistance,
+				 [&](void* userData, const Ray& ray, F32 boxDistance) {
+					 return rayBoxDistance(ray, *static_cast<const Aabb*>(userData), maxDistance);
+				 },
+				 WeakArray<OctreeRayHit>(&hits[0], rayCount));
+
+	for(U32 r = 0; r < rayCount; ++r)
+	{
+		F32 closest = MAX_F32;
+		for(const Aabb& box : boxes)
+		{
+			const F32 dist = rayBoxDistance(rays[r], box, maxDistance);
+			if(dist >= 0.0f)
+			{
+				closest = min(closest, dist);
+			}
+		}
+
+		if(closest == MAX_F32)
+		{
+			ANKI_TEST_EXPECT_EQ(hits[r].m_userData, nullptr);
+		}
+		else
+		{
+			ANKI_TEST_EXPECT_NEQ(hits[r].m_userData, nullptr);
+			ANKI_TEST_EXPECT_NEAR(hits[r].m_distance, closest, 0.001f);
+		}
+	}
+}
+
+} // end namespace anki
@@ -0,0 +1,94 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/SceneComponentPool.h>
+#include <vector>
+
+namespace anki
+{
+
+class TestPooledObject
+{
+public:
+	U32 m_id = 0;
+	Array<U8, 60> m_data;
+
+	virtual ~TestPooledObject()
+	{
+	}
+};
+
+class TestBigPooledObject : public TestPooledObject
+{
+public:
+	Array<U8, 256> m_moreData;
+};
+
+ANKI_TEST(Scene, SceneComponentPool)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	SceneComponentPool pool;
+	pool.init(alloc, sizeof(TestPooledObject), alignof(TestPooledObject));
+
+	const U32 COUNT = SceneComponentPool::OBJECTS_PER_CHUNK * 3 + 10;
+	std::vector<TestPooledObject*> objects;
+	for(U32 i = 0; i < COUNT; ++i)
+	{
+		void* mem = pool.allocate(sizeof(TestPooledObject), alignof(TestPooledObject));
+		ANKI_TEST_EXPECT_NEQ(mem, nullptr);
+		ANKI_TEST_EXPECT_EQ(ptrToNumber(mem) % alignof(TestPooledObject), 0u);
+		TestPooledObject* obj = ::new(mem) TestPooledObject();
+		obj->m_id = i;
+		objects.push_back(obj);
+	}
+
+	ANKI_TEST_EXPECT_EQ(pool.getObjectCount(), COUNT);
+	ANKI_TEST_EXPECT_EQ(pool.getChunkCount(), 4u);
+
+	// The slots of a chunk are handed out in memory order
+	for(U32 i = 1; i < SceneComponentPool::OBJECTS_PER_CHUNK; ++i)
+	{
+		ANKI_TEST_EXPECT_EQ(ptrToNumber(objects[i]) > ptrToNumber(objects[i - 1]), true);
+	}
+
+	// Free every other one. The rest are not touched
+	for(U32 i = 1; i < COUNT; i += 2)
+	{
+		objects[i]->~TestPooledObject();
+		pool.free(objects[i]);
+		objects[i] = nullptr;
+	}
+
+	ANKI_TEST_EXPECT_EQ(pool.getObjectCount(), COUNT - COUNT / 2);
+	for(U32 i = 0; i < COUNT; i += 2)
+	{
+		ANKI_TEST_EXPECT_EQ(objects[i]->m_id, i);
+	}
+
+	// The freed slots are reused before the pool grows
+	for(U32 i = 1; i < COUNT; i += 2)
+	{
+		objects[i] = ::new(pool.allocate(sizeof(TestPooledObject), alignof(TestPooledObject))) TestPooledObject();
+		objects[i]->m_id = i;
+	}
+	ANKI_TEST_EXPECT_EQ(pool.getChunkCount(), 4u);
+
+	// Derived objects that don't fit are refused so the caller can put them somewhere else
+	ANKI_TEST_EXPECT_EQ(pool.allocate(sizeof(TestBigPooledObject), alignof(TestBigPooledObject)), nullptr);
+	ANKI_TEST_EXPECT_EQ(pool.getObjectCount(), COUNT);
+
+	// Cleanup
+	for(TestPooledObject* obj : objects)
+	{
+		obj->~TestPooledObject();
+		pool.free(obj);
+	}
+
+	ANKI_TEST_EXPECT_EQ(pool.getObjectCount(), 0u);
+}
+
+} // end namespace anki
@@ -0,0 +1,1408 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/Scene.h>
+#include <anki/Physics.h>
+#include <anki/core/ConfigSet.h>
+#include <anki/renderer/RenderQueue.h>
+#include <anki/resource/SkeletonResource.h>
+#include <anki/resource/AnimationResource.h>
+#include <anki/util/ThreadHive.h>
+#include <anki/util/System.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/File.h>
+#include <algorithm>
+#include <vector>
+
+namespace anki
+{
+
+/// Creates a SceneGraph and all the subsystems it needs.
+class SceneGraphTestContext
+{
+public:
+	ConfigSet m_cfg;
+	NativeWindow* m_win = nullptr;
+	GrManager* m_gr = nullptr;
+	PhysicsWorld* m_physics = nullptr;
+	ResourceFilesystem* m_fs = nullptr;
+	ResourceManager* m_resources = nullptr;
+	ThreadHive* m_hive = nullptr;
+	SceneGraph* m_scene = nullptr;
+	Timestamp m_globalTimestamp = 1;
+	Second m_time = 0.0;
+
+	SceneGraphTestContext(const ConfigSet& cfg)
+		: m_cfg(cfg)
+	{
+		initConfig(m_cfg);
+		m_cfg.set("rsrc_dataPaths", "engine_data");
+
+		m_win = createWindow(m_cfg);
+		m_gr = createGrManager(m_cfg, m_win);
+		m_resources = createResourceManager(m_cfg, m_gr, m_physics, m_fs);
+		m_hive = new ThreadHive(getCpuCoresCount(), HeapAllocator<U8>(allocAligned, nullptr));
+
+		m_scene = new SceneGraph();
+		ANKI_TEST_EXPECT_NO_ERR(
+			m_scene->init(allocAligned, nullptr, m_hive, m_resources, nullptr, nullptr, &m_globalTimestamp, m_cfg));
+	}
+
+	~SceneGraphTestContext()
+	{
+		delete m_scene;
+		delete m_hive;
+		delete m_resources;
+		delete m_physics;
+		delete m_fs;
+		GrManager::deleteInstance(m_gr);
+		delete m_win;
+	}
+
+	/// Update the scene like the App does.
+	void update()
+	{
+		const Second prevTime = m_time;
+		m_time += 1.0 / 60.0;
+		ANKI_TEST_EXPECT_NO_ERR(m_scene->update(prevTime, m_time));
+		++m_globalTimestamp;
+	}
+};
+
+class TestOccluderNode : public SceneNode
+{
+public:
+	TestOccluderNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init()
+	{
+		newComponent<OccluderComponent>();
+		return Error::NONE;
+	}
+};
+
+ANKI_TEST(Scene, SceneGraphOccluderList)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	ANKI_TEST_EXPECT_EQ(scene.getOccluders().getSize(), 0u);
+
+	Array<TestOccluderNode*, 4> nodes;
+	for(TestOccluderNode*& node : nodes)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<TestOccluderNode>(CString(), node));
+	}
+
+	auto isListed = [&](const TestOccluderNode* node) {
+		const OccluderComponent* occluder = &node->getComponent<OccluderComponent>();
+		ConstWeakArray<OccluderComponent*> occluders = scene.getOccluders();
+		return std::find(occluders.getBegin(), occluders.getEnd(), occluder) != occluders.getEnd();
+	};
+
+	ANKI_TEST_EXPECT_EQ(scene.getOccluders().getSize(), 4u);
+	for(const TestOccluderNode* node : nodes)
+	{
+		ANKI_TEST_EXPECT_EQ(isListed(node), true);
+	}
+
+	// Remove one from the middle and the last one, the rest stay listed
+	nodes[1]->setMarkedForDeletion();
+	nodes[3]->setMarkedForDeletion();
+	ctx.update();
+
+	ANKI_TEST_EXPECT_EQ(scene.getOccluders().getSize(), 2u);
+	ANKI_TEST_EXPECT_EQ(isListed(nodes[0]), true);
+	ANKI_TEST_EXPECT_EQ(isListed(nodes[2]), true);
+}
+
+ANKI_TEST(Scene, SceneGraphVisibilityCache)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	// A static camera that looks down -Z and only wants fog volumes
+	PerspectiveCameraNode* cam;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<PerspectiveCameraNode>("cam", cam));
+	FrustumComponent& frc = cam->getComponent<FrustumComponent>();
+	frc.setPerspective(0.1f, 100.0f, toRad(60.0f), toRad(60.0f));
+	frc.setEnabledVisibilityTests(FrustumComponentVisibilityTestFlag::FOG_DENSITY_COMPONENTS);
+	frc.setVisibilityCacheEnabled(true);
+	scene.setActiveCameraNode(cam);
+
+	auto newFogNode = [&](const Vec4& pos) {
+		FogDensityNode* node;
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<FogDensityNode>(CString(), node));
+		node->getComponent<FogDensityComponent>().setAabb(Vec4(Vec3(-1.0f), 0.0f), Vec4(Vec3(1.0f), 0.0f));
+		node->getComponent<MoveComponent>().setLocalOrigin(pos);
+		return node;
+	};
+
+	FogDensityNode* a = newFogNode(Vec4(-1.0f, 0.0f, -10.0f, 0.0f));
+	FogDensityNode* b = newFogNode(Vec4(1.0f, 0.0f, -10.0f, 0.0f));
+	FogDensityNode* c = newFogNode(Vec4(100.0f, 0.0f, -10.0f, 0.0f));
+
+	// Update and test. Return if the cache was used and the X of the visible volumes
+	auto runFrame = [&](Bool& cacheHit) {
+		ctx.update();
+
+		ConstWeakArray<SpatialComponent*> cachedVisibles;
+		cacheHit = frc.getCachedVisibles(scene, cachedVisibles);
+
+		RenderQueue rqueue;
+		scene.doVisibilityTests(rqueue);
+
+		std::vector<F32> visibles;
+		for(const FogDensityQueueElement& el : rqueue.m_fogDensityVolumes)
+		{
+			visibles.push_back((el.m_aabbMin.x() + el.m_aabbMax.x()) / 2.0f);
+		}
+		std::sort(visibles.begin(), visibles.end());
+		return visibles;
+	};
+
+	Bool cacheHit;
+	ANKI_TEST_EXPECT_EQ(runFrame(cacheHit) == std::vector<F32>({-1.0f, 1.0f}), true);
+	ANKI_TEST_EXPECT_EQ(cacheHit, false);
+
+	// Nothing changed
+	ANKI_TEST_EXPECT_EQ(runFrame(cacheHit) == std::vector<F32>({-1.0f, 1.0f}), true);
+	ANKI_TEST_EXPECT_EQ(cacheHit, true);
+
+	// The frustum is static and the objects move. One leaves the frustum and one enters it
+	a->getComponent<MoveComponent>().setLocalOrigin(Vec4(200.0f, 0.0f, -10.0f, 0.0f));
+	c->getComponent<MoveComponent>().setLocalOrigin(Vec4(3.0f, 0.0f, -10.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(runFrame(cacheHit) == std::vector<F32>({1.0f, 3.0f}), true);
+	ANKI_TEST_EXPECT_EQ(cacheHit, true);
+
+	// A removed node invalidates the cache since the cache points to its spatial
+	b->setMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(runFrame(cacheHit) == std::vector<F32>({3.0f}), true);
+	ANKI_TEST_EXPECT_EQ(cacheHit, false);
+
+	ANKI_TEST_EXPECT_EQ(runFrame(cacheHit) == std::vector<F32>({3.0f}), true);
+	ANKI_TEST_EXPECT_EQ(cacheHit, true);
+
+	// A moving frustum invalidates the cache
+	cam->getComponent<MoveComponent>().setLocalOrigin(Vec4(200.0f, 0.0f, 0.0f, 0.0f));
+	ANKI_TEST_EXPECT_EQ(runFrame(cacheHit) == std::vector<F32>({200.0f}), true);
+	ANKI_TEST_EXPECT_EQ(cacheHit, false);
+
+	ANKI_TEST_EXPECT_EQ(runFrame(cacheHit) == std::vector<F32>({200.0f}), true);
+	ANKI_TEST_EXPECT_EQ(cacheHit, true);
+}
+
+ANKI_TEST(Scene, SceneGraphVisibilityCacheStaticScene)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	PerspectiveCameraNode* cam;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<PerspectiveCameraNode>("cam", cam));
+	FrustumComponent& frc = cam->getComponent<FrustumComponent>();
+	frc.setPerspective(0.1f, 100.0f, toRad(60.0f), toRad(60.0f));
+	frc.setEnabledVisibilityTests(FrustumComponentVisibilityTestFlag::FOG_DENSITY_COMPONENTS);
+	frc.setVisibilityCacheEnabled(true);
+	scene.setActiveCameraNode(cam);
+
+	// A row of volumes in front of the camera and a row behind it
+	std::vector<const SpatialComponent*> expectedVisibles;
+	for(U32 i = 0; i < 16; ++i)
+	{
+		const F32 x = F32(i) - 8.0f;
+		for(F32 z : {-20.0f, 20.0f})
+		{
+			FogDensityNode* node;
+			ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<FogDensityNode>(CString(), node));
+			node->getComponent<FogDensityComponent>().setAabb(Vec4(Vec3(-0.25f), 0.0f), Vec4(Vec3(0.25f), 0.0f));
+			node->getComponent<MoveComponent>().setLocalOrigin(Vec4(x, 0.0f, z, 0.0f));
+
+			if(z < 0.0f)
+			{
+				expectedVisibles.push_back(&node->getComponent<SpatialComponent>());
+			}
+		}
+	}
+	std::sort(expectedVisibles.begin(), expectedVisibles.end());
+
+	// Nothing moves after the first frame. All the frames after it are served from the cache and the cache holds the
+	// visibles of the previous frame
+	for(U32 frame = 0; frame < 8; ++frame)
+	{
+		ctx.update();
+
+		ConstWeakArray<SpatialComponent*> cachedVisibles;
+		const Bool cacheHit = frc.getCachedVisibles(scene, cachedVisibles);
+		ANKI_TEST_EXPECT_EQ(cacheHit, frame > 0);
+
+		std::vector<const SpatialComponent*> cached(cachedVisibles.getBegin(), cachedVisibles.getEnd());
+		std::sort(cached.begin(), cached.end());
+		ANKI_TEST_EXPECT_EQ(cached == expectedVisibles, frame > 0);
+
+		// Nothing changed this frame so the cache is all the visibility tests get
+		if(frame > 0)
+		{
+			ANKI_TEST_EXPECT_EQ(scene.getUpdatedSpatials().getSize(), 0u);
+		}
+
+		RenderQueue rqueue;
+		scene.doVisibilityTests(rqueue);
+		ANKI_TEST_EXPECT_EQ(rqueue.m_fogDensityVolumes.getSize(), expectedVisibles.size());
+	}
+}
+
+ANKI_TEST(Scene, SceneGraphVisibilityCacheSpatialRemoval)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	PerspectiveCameraNode* cam;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<PerspectiveCameraNode>("cam", cam));
+	FrustumComponent& frc = cam->getComponent<FrustumComponent>();
+	frc.setPerspective(0.1f, 100.0f, toRad(60.0f), toRad(60.0f));
+	frc.setEnabledVisibilityTests(FrustumComponentVisibilityTestFlag::FOG_DENSITY_COMPONENTS);
+	frc.setVisibilityCacheEnabled(true);
+	scene.setActiveCameraNode(cam);
+
+	auto newFogNode = [&](const Vec4& pos) {
+		FogDensityNode* node;
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<FogDensityNode>(CString(), node));
+		node->getComponent<FogDensityComponent>().setAabb(Vec4(Vec3(-1.0f), 0.0f), Vec4(Vec3(1.0f), 0.0f));
+		node->getComponent<MoveComponent>().setLocalOrigin(pos);
+		return node;
+	};
+
+	FogDensityNode* visible0 = newFogNode(Vec4(-2.0f, 0.0f, -10.0f, 0.0f));
+	FogDensityNode* visible1 = newFogNode(Vec4(2.0f, 0.0f, -10.0f, 0.0f));
+	FogDensityNode* hidden = newFogNode(Vec4(0.0f, 0.0f, 10.0f, 0.0f));
+	TestOccluderNode* noSpatial;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<TestOccluderNode>(CString(), noSpatial));
+
+	// Update and test. Return if the cache was valid and what it held at the start of the frame
+	auto runFrame = [&](std::vector<const SpatialComponent*>& cached) {
+		ctx.update();
+
+		ConstWeakArray<SpatialComponent*> cachedVisibles;
+		const Bool cacheHit = frc.getCachedVisibles(scene, cachedVisibles);
+		cached.assign(cachedVisibles.getBegin(), cachedVisibles.getEnd());
+
+		RenderQueue rqueue;
+		scene.doVisibilityTests(rqueue);
+		return cacheHit;
+	};
+
+	auto contains = [](const std::vector<const SpatialComponent*>& cached, const SceneNode* node) {
+		return std::find(cached.begin(), cached.end(), &node->getComponent<SpatialComponent>()) != cached.end();
+	};
+
+	std::vector<const SpatialComponent*> cached;
+	ANKI_TEST_EXPECT_EQ(runFrame(cached), false);
+	ANKI_TEST_EXPECT_EQ(runFrame(cached), true);
+	ANKI_TEST_EXPECT_EQ(cached.size(), 2u);
+	ANKI_TEST_EXPECT_EQ(contains(cached, visible0) && contains(cached, visible1), true);
+
+	// Removing a node without a spatial keeps the cache
+	noSpatial->setMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(runFrame(cached), true);
+	ANKI_TEST_EXPECT_EQ(cached.size(), 2u);
+
+	// Removing a visible spatial invalidates the cache since it points to it. The next frame caches the rest
+	visible0->setMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(runFrame(cached), false);
+	ANKI_TEST_EXPECT_EQ(cached.size(), 0u);
+	ANKI_TEST_EXPECT_EQ(runFrame(cached), true);
+	ANKI_TEST_EXPECT_EQ(cached.size(), 1u);
+	ANKI_TEST_EXPECT_EQ(contains(cached, visible1), true);
+
+	// The cache doesn't know which spatials it lacks so removing a hidden spatial invalidates it as well
+	hidden->setMarkedForDeletion();
+	ANKI_TEST_EXPECT_EQ(runFrame(cached), false);
+	ANKI_TEST_EXPECT_EQ(runFrame(cached), true);
+	ANKI_TEST_EXPECT_EQ(cached.size(), 1u);
+	ANKI_TEST_EXPECT_EQ(contains(cached, visible1), true);
+}
+
+/// Counts how many times the SceneGraph updated it.
+class UpdateCountComponent : public SceneComponent
+{
+public:
+	U32 m_updateCount = 0;
+
+	UpdateCountComponent(SceneComponentType type = SceneComponentType::NONE)
+		: SceneComponent(type)
+	{
+	}
+
+	ANKI_USE_RESULT Error update(SceneNode&, Second, Second, Bool& updated) override
+	{
+		++m_updateCount;
+		updated = false;
+		return Error::NONE;
+	}
+};
+
+/// A node with a box for a spatial that counts its updates.
+class UpdateCountNode : public SceneNode
+{
+public:
+	Aabb m_box = Aabb(Vec3(-1.0f), Vec3(1.0f));
+	UpdateCountComponent* m_counter = nullptr;
+
+	UpdateCountNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init(Bool updateEveryFrame)
+	{
+		m_counter = newComponent<UpdateCountComponent>();
+		newComponent<SpatialComponent>(this, &m_box);
+		setUpdateEveryFrame(updateEveryFrame);
+		return Error::NONE;
+	}
+
+	U32 getUpdateCount() const
+	{
+		return m_counter->m_updateCount;
+	}
+
+	void setBox(F32 center)
+	{
+		m_box = Aabb(Vec3(center - 1.0f), Vec3(center + 1.0f));
+		getComponent<SpatialComponent>().markForUpdate();
+	}
+
+	/// Add a component with a type that changes without marking its node, like the scripts.
+	void addScriptLikeComponent()
+	{
+		newComponent<UpdateCountComponent>(SceneComponentType::SCRIPT);
+	}
+
+	OccluderComponent* addOccluder()
+	{
+		return newComponent<OccluderComponent>();
+	}
+
+	void setEveryFrame(Bool everyFrame)
+	{
+		setUpdateEveryFrame(everyFrame);
+	}
+};
+
+ANKI_TEST(Scene, SceneGraphUpdateMarking)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	Array<UpdateCountNode*, 4> nodes;
+	for(UpdateCountNode*& node : nodes)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<UpdateCountNode>(CString(), node, false));
+	}
+
+	auto spatialUpdated = [&](const UpdateCountNode* node) {
+		const SpatialComponent* sp = &node->getComponent<SpatialComponent>();
+		ConstWeakArray<SpatialComponent*> spatials = scene.getUpdatedSpatials();
+		return std::find(spatials.getBegin(), spatials.getEnd(), sp) != spatials.getEnd();
+	};
+
+	auto spatialCenter = [&](const UpdateCountNode* node) {
+		const Aabb& aabb = node->getComponent<SpatialComponent>().getAabb();
+		return (aabb.getMin().x() + aabb.getMax().x()) / 2.0f;
+	};
+
+	// The new nodes and their spatials are updated once
+	ctx.update();
+	for(const UpdateCountNode* node : nodes)
+	{
+		ANKI_TEST_EXPECT_EQ(node->getUpdateCount(), 1u);
+		ANKI_TEST_EXPECT_EQ(spatialUpdated(node), true);
+	}
+
+	// Nothing is marked so nothing is updated
+	ctx.update();
+	for(const UpdateCountNode* node : nodes)
+	{
+		ANKI_TEST_EXPECT_EQ(node->getUpdateCount(), 1u);
+		ANKI_TEST_EXPECT_EQ(spatialUpdated(node), false);
+	}
+
+	// A marked node is updated, a marked spatial is updated without its node
+	nodes[1]->markForUpdate();
+	nodes[2]->setBox(5.0f);
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(nodes[0]->getUpdateCount(), 1u);
+	ANKI_TEST_EXPECT_EQ(nodes[1]->getUpdateCount(), 2u);
+	ANKI_TEST_EXPECT_EQ(nodes[2]->getUpdateCount(), 1u);
+	ANKI_TEST_EXPECT_EQ(spatialUpdated(nodes[1]), false);
+	ANKI_TEST_EXPECT_EQ(spatialUpdated(nodes[2]), true);
+	ANKI_TEST_EXPECT_EQ(spatialCenter(nodes[2]), 5.0f);
+
+	// A spatial that changed without a mark is not visited
+	nodes[3]->m_box = Aabb(Vec3(9.0f), Vec3(11.0f));
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(spatialUpdated(nodes[3]), false);
+	ANKI_TEST_EXPECT_EQ(spatialCenter(nodes[3]), 0.0f);
+
+	// Deleting marked nodes takes them out of the lists. The spatial of nodes[3] takes the place of the spatial of
+	// nodes[0] in the list of the spatials to update
+	nodes[0]->markForUpdate();
+	nodes[0]->setBox(7.0f);
+	nodes[3]->setBox(10.0f);
+	nodes[0]->setMarkedForDeletion();
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(spatialUpdated(nodes[3]), true);
+	ANKI_TEST_EXPECT_EQ(spatialCenter(nodes[3]), 10.0f);
+	ANKI_TEST_EXPECT_EQ(nodes[3]->getUpdateCount(), 1u);
+
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(spatialUpdated(nodes[3]), false);
+}
+
+ANKI_TEST(Scene, SceneGraphEveryFrameNodes)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	Array<UpdateCountNode*, 4> nodes;
+	for(UpdateCountNode*& node : nodes)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<UpdateCountNode>(CString(), node, true));
+	}
+
+	UpdateCountNode* other;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<UpdateCountNode>(CString(), other, false));
+
+	ctx.update();
+	ctx.update();
+	for(const UpdateCountNode* node : nodes)
+	{
+		ANKI_TEST_EXPECT_EQ(node->getUpdateCount(), 2u);
+	}
+	ANKI_TEST_EXPECT_EQ(other->getUpdateCount(), 1u);
+
+	// Remove the first, the last takes its place in the list
+	nodes[0]->setMarkedForDeletion();
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(nodes[1]->getUpdateCount(), 3u);
+	ANKI_TEST_EXPECT_EQ(nodes[2]->getUpdateCount(), 3u);
+	ANKI_TEST_EXPECT_EQ(nodes[3]->getUpdateCount(), 3u);
+
+	// Remove the moved one and one from the middle
+	nodes[3]->setMarkedForDeletion();
+	nodes[1]->setMarkedForDeletion();
+	ctx.update();
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(nodes[2]->getUpdateCount(), 5u);
+	ANKI_TEST_EXPECT_EQ(other->getUpdateCount(), 1u);
+
+	// New ones join the list
+	UpdateCountNode* newNode;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<UpdateCountNode>(CString(), newNode, true));
+	ctx.update();
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(nodes[2]->getUpdateCount(), 7u);
+	ANKI_TEST_EXPECT_EQ(newNode->getUpdateCount(), 2u);
+}
+
+ANKI_TEST(Scene, SceneGraphComponentsAddedLater)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	UpdateCountNode* node;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<UpdateCountNode>(CString(), node, false));
+	ctx.update();
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(node->getUpdateCount(), 1u);
+
+	// A component that can't tell when it changes makes the node update every frame
+	node->addScriptLikeComponent();
+	ctx.update();
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(node->getUpdateCount(), 3u);
+
+	// So does the flag and clearing it doesn't take the node out of the list while it has the component
+	node->setEveryFrame(true);
+	node->setEveryFrame(false);
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(node->getUpdateCount(), 4u);
+
+	UpdateCountNode* other;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<UpdateCountNode>(CString(), other, false));
+	ctx.update();
+	other->setEveryFrame(true);
+	ctx.update();
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(other->getUpdateCount(), 3u);
+	other->setEveryFrame(false);
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(other->getUpdateCount(), 3u);
+
+	// Occluders added later are listed and they leave the list with their node
+	const OccluderComponent* occluder = node->addOccluder();
+	ANKI_TEST_EXPECT_EQ(scene.getOccluders().getSize(), 1u);
+	ANKI_TEST_EXPECT_EQ(scene.getOccluders()[0], occluder);
+
+	node->setMarkedForDeletion();
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(scene.getOccluders().getSize(), 0u);
+	ANKI_TEST_EXPECT_EQ(other->getUpdateCount(), 3u);
+}
+
+/// A trigger component that checks the thread its contacts come from.
+class ThreadCheckTriggerComponent : public TriggerComponent
+{
+public:
+	ThreadId m_expectedThreadId = 0;
+	U32 m_contactCount = 0;
+	U32 m_wrongThreadCount = 0;
+
+	ThreadCheckTriggerComponent(SceneNode* node, PhysicsTriggerPtr trigger)
+		: TriggerComponent(node, trigger)
+	{
+	}
+
+	void processContact(SceneNode& node) override
+	{
+		++m_contactCount;
+		m_wrongThreadCount += (Thread::getCurrentThreadId() != m_expectedThreadId) ? 1 : 0;
+		TriggerComponent::processContact(node);
+	}
+};
+
+class ThreadCheckTriggerNode : public SceneNode
+{
+public:
+	PhysicsCollisionShapePtr m_shape;
+	PhysicsTriggerPtr m_trigger;
+	ThreadCheckTriggerComponent* m_triggerc = nullptr;
+
+	ThreadCheckTriggerNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init()
+	{
+		m_shape = getSceneGraph().getPhysicsWorld().newInstance<PhysicsSphere>(5.0f);
+		m_trigger = getSceneGraph().getPhysicsWorld().newInstance<PhysicsTrigger>(m_shape);
+		m_trigger->setUserData(this);
+		m_triggerc = newComponent<ThreadCheckTriggerComponent>(this, m_trigger);
+		return Error::NONE;
+	}
+};
+
+/// A falling sphere.
+class FallingBodyNode : public SceneNode
+{
+public:
+	PhysicsCollisionShapePtr m_shape;
+	PhysicsBodyPtr m_body;
+
+	FallingBodyNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init()
+	{
+		m_shape = getSceneGraph().getPhysicsWorld().newInstance<PhysicsSphere>(1.0f);
+
+		PhysicsBodyInitInfo init;
+		init.m_shape = m_shape;
+		init.m_mass = 1.0f;
+		m_body = getSceneGraph().getPhysicsWorld().newInstance<PhysicsBody>(init);
+		m_body->setUserData(this);
+		return Error::NONE;
+	}
+};
+
+ANKI_TEST(Scene, SceneGraphAsyncPhysicsTrigger)
+{
+	ConfigSet cfg = DefaultConfigSet::get();
+	cfg.set("scene_asyncPhysics", 1);
+	SceneGraphTestContext ctx(cfg);
+	SceneGraph& scene = *ctx.m_scene;
+
+	ThreadCheckTriggerNode* trigger;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<ThreadCheckTriggerNode>("trigger", trigger));
+	trigger->m_triggerc->m_expectedThreadId = Thread::getCurrentThreadId();
+
+	FallingBodyNode* body;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<FallingBodyNode>("body", body));
+
+	for(U32 frame = 0; frame < 10; ++frame)
+	{
+		// The step starts at the end of the update and runs in the physics thread
+		ctx.update();
+
+		// Sync before reading the results of the step, like App::mainLoop does
+		ANKI_TEST_EXPECT_NO_ERR(scene.getPhysicsWorld().waitUpdate());
+
+		if(frame > 0)
+		{
+			WeakArray<SceneNode*> contacts = trigger->m_triggerc->getContactSceneNodes();
+			ANKI_TEST_EXPECT_EQ(contacts.getSize(), 1u);
+			ANKI_TEST_EXPECT_EQ(contacts[0], body);
+		}
+	}
+
+	ANKI_TEST_EXPECT_GT(trigger->m_triggerc->m_contactCount, 0u);
+	ANKI_TEST_EXPECT_EQ(trigger->m_triggerc->m_wrongThreadCount, 0u);
+}
+
+/// A node that keeps the events that touched it in the order they did.
+class EventLogNode : public SceneNode
+{
+public:
+	std::vector<U32> m_log;
+
+	EventLogNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init()
+	{
+		return Error::NONE;
+	}
+};
+
+/// An event that burns some time and then writes its index to the logs of its nodes.
+class LogEvent : public Event
+{
+public:
+	U32 m_idx = 0;
+	F32 m_value = 0.0f;
+
+	LogEvent(EventManager* manager)
+		: Event(manager)
+	{
+	}
+
+	ANKI_USE_RESULT Error init(U32 idx, Bool touchesOnlyAssociatedNodes, ConstWeakArray<EventLogNode*> nodes)
+	{
+		Event::init(-1.0, -1.0);
+		m_idx = idx;
+		m_touchesOnlyAssociatedNodes = touchesOnlyAssociatedNodes;
+		for(EventLogNode* node : nodes)
+		{
+			addAssociatedSceneNode(node);
+		}
+		return Error::NONE;
+	}
+
+	ANKI_USE_RESULT Error update(Second, Second) override
+	{
+		for(U32 i = 0; i < 100; ++i)
+		{
+			m_value = sin(m_value + 1.0f);
+		}
+
+		for(SceneNode* node : getAssociatedSceneNodes())
+		{
+			static_cast<EventLogNode*>(node)->m_log.push_back(m_idx);
+		}
+
+		return Error::NONE;
+	}
+};
+
+ANKI_TEST(Scene, SceneGraphEventUpdateBench)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	const U32 NODE_COUNT = 2500;
+	const U32 EVENT_COUNT = 10000;
+	const U32 FRAME_COUNT = 30;
+
+	std::vector<EventLogNode*> nodes(NODE_COUNT);
+	for(EventLogNode*& node : nodes)
+	{
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<EventLogNode>(CString(), node));
+	}
+
+	// Every 100th event touches two nodes and it's not allowed to run in parallel. The logs of the nodes should have
+	// the order of the event list
+	std::vector<std::vector<U32>> expectedLogs(NODE_COUNT);
+	U32 serialCount = 0;
+	for(U32 i = 0; i < EVENT_COUNT; ++i)
+	{
+		const Bool serial = (i % 100) == 99;
+		const Array<U32, 2> nodeIdxs = {{i % NODE_COUNT, (i * 7 + 1) % NODE_COUNT}};
+		const Array<EventLogNode*, 2> eventNodes = {{nodes[nodeIdxs[0]], nodes[nodeIdxs[1]]}};
+		const U32 eventNodeCount = (serial) ? 2 : 1;
+
+		LogEvent* event;
+		ANKI_TEST_EXPECT_NO_ERR(scene.getEventManager().newEvent(
+			event, i, !serial, ConstWeakArray<EventLogNode*>(&eventNodes[0], eventNodeCount)));
+
+		for(U32 n = 0; n < eventNodeCount; ++n)
+		{
+			expectedLogs[nodeIdxs[n]].push_back(i);
+		}
+		serialCount += (serial) ? 1 : 0;
+	}
+
+	Second time = 0.0;
+	U32 wrongOrderCount = 0;
+	for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		HighRezTimer timer;
+		timer.start();
+		ctx.update();
+		timer.stop();
+		time += timer.getElapsedTime();
+
+		for(U32 i = 0; i < NODE_COUNT; ++i)
+		{
+			wrongOrderCount += (nodes[i]->m_log != expectedLogs[i]) ? 1 : 0;
+			nodes[i]->m_log.clear();
+		}
+	}
+
+	ANKI_TEST_EXPECT_EQ(wrongOrderCount, 0u);
+
+	ANKI_TEST_LOGI("%u events on %u nodes, %u of them serial, %u hive threads. Scene update %fms", EVENT_COUNT,
+				   NODE_COUNT, serialCount, ctx.m_hive->getThreadCount(), time / Second(FRAME_COUNT) * 1000.0);
+}
+
+/// A node with a MoveComponent, a SpatialComponent and a few more cheap components.
+class BenchNode : public SceneNode
+{
+public:
+	Aabb m_box = Aabb(Vec3(-1.0f), Vec3(1.0f));
+
+	BenchNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init(U32 extraComponentCount)
+	{
+		newComponent<MoveComponent>();
+		newComponent<SpatialComponent>(this, &m_box);
+		for(U32 i = 0; i < extraComponentCount; ++i)
+		{
+			if(i & 1)
+			{
+				newComponent<OccluderComponent>();
+			}
+			else
+			{
+				newComponent<FogDensityComponent>();
+			}
+		}
+
+		return Error::NONE;
+	}
+};
+
+/// The way SceneNode::tryGetComponent() used to work, a scan of all the components.
+template<typename TComponent>
+static const TComponent* tryGetComponentLinear(const SceneNode& node)
+{
+	const TComponent* out = nullptr;
+	Error err = node.iterateComponents([&](const SceneComponent& comp) -> Error {
+		if(comp.getType() == TComponent::CLASS_TYPE)
+		{
+			out = static_cast<const TComponent*>(&comp);
+		}
+		return Error::NONE;
+	});
+	(void)err;
+	return out;
+}
+
+ANKI_TEST(Scene, SceneGraphComponentQueryBench)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	// Nodes with 2 to 5 components
+	const U32 NODE_COUNT = 20000;
+	const U32 ITERATION_COUNT = 100;
+	std::vector<const SceneNode*> nodes;
+	for(U32 i = 0; i < NODE_COUNT; ++i)
+	{
+		BenchNode* node;
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<BenchNode>(CString(), node, i % 4));
+		nodes.push_back(node);
+	}
+
+	// The part of VisibilityTestTask that picks the nodes the frustum wants. It used to query every component type
+	// without the mask
+	auto bench = [&](Bool renderOnly, Bool useMask, U32& wantedCount) -> Second {
+		SceneComponentTypeMask wantedComponents = getSceneComponentTypeBit(SceneComponentType::RENDER);
+		if(!renderOnly)
+		{
+			wantedComponents |= getSceneComponentTypeBit(SceneComponentType::LIGHT)
+								| getSceneComponentTypeBit(SceneComponentType::LENS_FLARE)
+								| getSceneComponentTypeBit(SceneComponentType::REFLECTION_PROBE)
+								| getSceneComponentTypeBit(SceneComponentType::DECAL)
+								| getSceneComponentTypeBit(SceneComponentType::FOG_DENSITY)
+								| getSceneComponentTypeBit(SceneComponentType::GLOBAL_ILLUMINATION_PROBE)
+								| getSceneComponentTypeBit(SceneComponentType::GENERIC_GPU_COMPUTE_JOB_COMPONENT);
+		}
+
+		wantedCount = 0;
+		HighRezTimer timer;
+		timer.start();
+		for(U32 it = 0; it < ITERATION_COUNT; ++it)
+		{
+			for(const SceneNode* node : nodes)
+			{
+				Bool wantNode = false;
+				if(useMask)
+				{
+					if(!(node->getComponentTypeMask() & wantedComponents))
+					{
+						continue;
+					}
+
+					wantNode |= node->tryGetComponent<RenderComponent>() != nullptr;
+					if(!renderOnly)
+					{
+						wantNode |= node->tryGetComponent<LightComponent>() != nullptr;
+						wantNode |= node->tryGetComponent<LensFlareComponent>() != nullptr;
+						wantNode |= node->tryGetComponent<ReflectionProbeComponent>() != nullptr;
+						wantNode |= node->tryGetComponent<DecalComponent>() != nullptr;
+						wantNode |= node->tryGetComponent<FogDensityComponent>() != nullptr;
+						wantNode |= node->tryGetComponent<GlobalIlluminationProbeComponent>() != nullptr;
+						wantNode |= node->tryGetComponent<GenericGpuComputeJobComponent>() != nullptr;
+					}
+				}
+				else
+				{
+					wantNode |= tryGetComponentLinear<RenderComponent>(*node) != nullptr;
+					if(!renderOnly)
+					{
+						wantNode |= tryGetComponentLinear<LightComponent>(*node) != nullptr;
+						wantNode |= tryGetComponentLinear<LensFlareComponent>(*node) != nullptr;
+						wantNode |= tryGetComponentLinear<ReflectionProbeComponent>(*node) != nullptr;
+						wantNode |= tryGetComponentLinear<DecalComponent>(*node) != nullptr;
+						wantNode |= tryGetComponentLinear<FogDensityComponent>(*node) != nullptr;
+						wantNode |= tryGetComponentLinear<GlobalIlluminationProbeComponent>(*node) != nullptr;
+						wantNode |= tryGetComponentLinear<GenericGpuComputeJobComponent>(*node) != nullptr;
+					}
+				}
+
+				wantedCount += wantNode;
+			}
+		}
+		timer.stop();
+
+		return timer.getElapsedTime() / Second(ITERATION_COUNT);
+	};
+
+	U32 linearCount, maskCount;
+	const Second shadowLinearTime = bench(true, false, linearCount);
+	const Second shadowMaskTime = bench(true, true, maskCount);
+	ANKI_TEST_EXPECT_EQ(linearCount, maskCount);
+
+	const Second cameraLinearTime = bench(false, false, linearCount);
+	const Second cameraMaskTime = bench(false, true, maskCount);
+	ANKI_TEST_EXPECT_EQ(linearCount, maskCount);
+	ANKI_TEST_EXPECT_GT(maskCount, 0u);
+
+	ANKI_TEST_LOGI("%u nodes. Render components only: linear scan %fms, mask and table %fms. All component types: "
+				   "linear scan %fms, mask and table %fms",
+				   NODE_COUNT, shadowLinearTime * 1000.0, shadowMaskTime * 1000.0, cameraLinearTime * 1000.0,
+				   cameraMaskTime * 1000.0);
+}
+
+/// A component that burns some time in its update.
+class BusyComponent : public SceneComponent
+{
+public:
+	F32 m_value = 0.0f;
+
+	BusyComponent()
+		: SceneComponent(SceneComponentType::NONE)
+	{
+	}
+
+	ANKI_USE_RESULT Error update(SceneNode&, Second, Second, Bool& updated) override
+	{
+		for(U32 i = 0; i < 200; ++i)
+		{
+			m_value = sin(m_value + 1.0f);
+		}
+
+		updated = false;
+		return Error::NONE;
+	}
+};
+
+class HierarchyBenchNode : public SceneNode
+{
+public:
+	HierarchyBenchNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init()
+	{
+		newComponent<MoveComponent>();
+		newComponent<BusyComponent>();
+		getComponent<MoveComponent>().setLocalOrigin(Vec4(1.0f, 0.0f, 0.0f, 0.0f));
+		return Error::NONE;
+	}
+};
+
+ANKI_TEST(Scene, SceneGraphHierarchyUpdateBench)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	const U32 NODE_COUNT = 4000;
+	const U32 FRAME_COUNT = 30;
+
+	enum class Shape
+	{
+		WIDE, ///< One root with all the others as children.
+		CHAINS, ///< One root with 8 long chains.
+		BINARY_TREE,
+		COUNT
+	};
+	const Array<CString, U32(Shape::COUNT)> shapeNames = {{"one root with 3999 children", "one root with 8 chains",
+														  "binary tree"}};
+
+	for(Shape shape = Shape(0); shape < Shape::COUNT; shape = Shape(U32(shape) + 1))
+	{
+		std::vector<HierarchyBenchNode*> nodes;
+		for(U32 i = 0; i < NODE_COUNT; ++i)
+		{
+			HierarchyBenchNode* node;
+			ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<HierarchyBenchNode>(CString(), node));
+
+			if(i > 0)
+			{
+				U32 parent = 0;
+				switch(shape)
+				{
+				case Shape::WIDE:
+					parent = 0;
+					break;
+				case Shape::CHAINS:
+					parent = (i <= 8) ? 0 : i - 8;
+					break;
+				default:
+					parent = (i - 1) / 2;
+				}
+
+				nodes[parent]->addChild(node);
+			}
+
+			nodes.push_back(node);
+		}
+
+		// Move the root every frame so the whole hierarchy gets updated
+		HighRezTimer timer;
+		timer.start();
+		for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			nodes[0]->getComponent<MoveComponent>().setLocalOrigin(Vec4(F32(frame), 0.0f, 0.0f, 0.0f));
+			ctx.update();
+		}
+		timer.stop();
+
+		// The children were updated after their parents
+		U32 wrongTransformCount = 0;
+		for(U32 i = 1; i < NODE_COUNT; ++i)
+		{
+			const F32 x = nodes[i]->getComponent<MoveComponent>().getWorldTransform().getOrigin().x();
+			const F32 parentX =
+				nodes[i]->getParent()->getComponent<MoveComponent>().getWorldTransform().getOrigin().x();
+			wrongTransformCount += absolute(x - parentX - 1.0f) > 0.001f;
+		}
+		ANKI_TEST_EXPECT_EQ(wrongTransformCount, 0u);
+
+		ANKI_TEST_LOGI("%s, %u nodes, %u hive threads. Scene update %fms", &shapeNames[U32(shape)][0], NODE_COUNT,
+					   ctx.m_hive->getThreadCount(), timer.getElapsedTime() / Second(FRAME_COUNT) * 1000.0);
+
+		for(HierarchyBenchNode* node : nodes)
+		{
+			node->setMarkedForDeletion();
+		}
+		ctx.update();
+	}
+}
+
+/// A shadow caster with a box for a spatial.
+ANKI_TEST(Scene, SceneGraphRemoveChild)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	// Every node is 1 unit to the right of its parent
+	HierarchyBenchNode* parent;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<HierarchyBenchNode>(CString(), parent));
+	HierarchyBenchNode* child;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<HierarchyBenchNode>(CString(), child));
+	parent->addChild(child);
+	ctx.update();
+
+	auto worldX = [](const SceneNode* node) {
+		return node->getComponent<MoveComponent>().getWorldTransform().getOrigin().x();
+	};
+	ANKI_TEST_EXPECT_EQ(worldX(child), 2.0f);
+
+	// A detached child gets the world transform of a root without anything else marking it
+	parent->removeChild(child);
+	ctx.update();
+	ANKI_TEST_EXPECT_EQ(child->getParent(), nullptr);
+	ANKI_TEST_EXPECT_EQ(worldX(child), 1.0f);
+	ANKI_TEST_EXPECT_EQ(worldX(parent), 1.0f);
+}
+
+/// Records when its frameUpdate runs.
+class FrameUpdateOrderNode : public SceneNode
+{
+public:
+	static Atomic<U32> m_frameUpdateCounter;
+	U32 m_frameUpdateOrder = 0;
+
+	FrameUpdateOrderNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init()
+	{
+		newComponent<BusyComponent>();
+		return Error::NONE;
+	}
+
+	ANKI_USE_RESULT Error frameUpdate(Second, Second) override
+	{
+		m_frameUpdateOrder = m_frameUpdateCounter.fetchAdd(1) + 1;
+		return Error::NONE;
+	}
+};
+
+Atomic<U32> FrameUpdateOrderNode::m_frameUpdateCounter = {0};
+
+ANKI_TEST(Scene, SceneGraphNestedSplitUpdateOrder)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	// A tree with 4 children per node and 6 levels. The 3 upper levels have enough nodes under them to split their
+	// children to tasks. The test needs more than one hive thread to split anything
+	const U32 CHILDREN_PER_NODE = 4;
+	const U32 LEVEL_COUNT = 6;
+	std::vector<FrameUpdateOrderNode*> nodes;
+	U32 levelBegin = 0;
+	for(U32 level = 0; level < LEVEL_COUNT; ++level)
+	{
+		const U32 levelEnd = U32(nodes.size());
+		const U32 parentCount = (level == 0) ? 1 : levelEnd - levelBegin;
+		for(U32 p = 0; p < parentCount; ++p)
+		{
+			for(U32 c = 0; c < ((level == 0) ? 1 : CHILDREN_PER_NODE); ++c)
+			{
+				FrameUpdateOrderNode* node;
+				ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<FrameUpdateOrderNode>(CString(), node));
+				if(level > 0)
+				{
+					nodes[levelBegin + p]->addChild(node);
+				}
+				nodes.push_back(node);
+			}
+		}
+
+		levelBegin = levelEnd;
+	}
+
+	for(U32 frame = 0; frame < 4; ++frame)
+	{
+		nodes[0]->markForUpdate();
+		ctx.update();
+
+		// Every frameUpdate ran after the frameUpdate of all the children
+		U32 wrongOrderCount = 0;
+		for(FrameUpdateOrderNode* node : nodes)
+		{
+			ANKI_TEST_EXPECT_GT(node->m_frameUpdateOrder, 0u);
+			Error err = node->visitChildrenMaxDepth(0, [&](SceneNode& child) -> Error {
+				wrongOrderCount +=
+					static_cast<FrameUpdateOrderNode&>(child).m_frameUpdateOrder > node->m_frameUpdateOrder;
+				return Error::NONE;
+			});
+			ANKI_TEST_EXPECT_NO_ERR(err);
+		}
+		ANKI_TEST_EXPECT_EQ(wrongOrderCount, 0u);
+
+		for(FrameUpdateOrderNode* node : nodes)
+		{
+			node->m_frameUpdateOrder = 0;
+		}
+	}
+
+	ANKI_TEST_LOGI("%u nodes, %u hive threads", U32(nodes.size()), ctx.m_hive->getThreadCount());
+}
+
+class ShadowCasterNode : public SceneNode
+{
+public:
+	Aabb m_box;
+
+	ShadowCasterNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init(const Vec3& min, const Vec3& max)
+	{
+		m_box = Aabb(min, max);
+
+		RenderComponent* rc = newComponent<RenderComponent>();
+		rc->setup(drawCallback, this, 0);
+		rc->setFlags(RenderComponentFlag::CASTS_SHADOW);
+
+		newComponent<SpatialComponent>(this, &m_box);
+		return Error::NONE;
+	}
+
+private:
+	static void drawCallback(RenderQueueDrawContext&, ConstWeakArray<void*>)
+	{
+	}
+};
+
+ANKI_TEST(Scene, SceneGraphShadowFrustumsBench)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	const U32 CASTER_COUNT = 20000;
+	const U32 POINT_LIGHT_COUNT = 10;
+	const U32 FRAME_COUNT = 10;
+
+	// The default camera is at the origin and looks down -Z
+	std::vector<const ShadowCasterNode*> casters;
+	for(U32 i = 0; i < CASTER_COUNT; ++i)
+	{
+		const Vec3 min(getRandomRange(-100.0f, 100.0f), getRandomRange(-10.0f, 10.0f), getRandomRange(-200.0f, 0.0f));
+		ShadowCasterNode* node;
+		ANKI_TEST_EXPECT_NO_ERR(
+			scene.newSceneNode<ShadowCasterNode>(CString(), node, min, min + Vec3(getRandomRange(0.5f, 2.0f))));
+		casters.push_back(node);
+	}
+
+	std::vector<const PointLightNode*> pointLights;
+	for(U32 i = 0; i < POINT_LIGHT_COUNT; ++i)
+	{
+		PointLightNode* node;
+		ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<PointLightNode>(CString(), node));
+		node->getComponent<LightComponent>().setRadius(15.0f);
+		node->getComponent<LightComponent>().setShadowEnabled(true);
+		node->getComponent<MoveComponent>().setLocalOrigin(
+			Vec4(getRandomRange(-10.0f, 10.0f), 0.0f, getRandomRange(-80.0f, -30.0f), 0.0f));
+		pointLights.push_back(node);
+	}
+
+	DirectionalLightNode* dirLight;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<DirectionalLightNode>("dirLight", dirLight));
+	dirLight->getComponent<LightComponent>().setShadowEnabled(true);
+	dirLight->getComponent<MoveComponent>().setLocalRotation(Mat3x4(Vec3(0.0f), Euler(toRad(-60.0f), 0.0f, 0.0f)));
+
+	// Place everything and create the shadow frustums of the point lights
+	for(U32 i = 0; i < 3; ++i)
+	{
+		ctx.update();
+	}
+
+	Second visibilityTime = 0.0;
+	for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		ctx.update();
+
+		RenderQueue rqueue;
+		HighRezTimer timer;
+		timer.start();
+		scene.doVisibilityTests(rqueue);
+		timer.stop();
+		visibilityTime += timer.getElapsedTime();
+
+		if(frame + 1 < FRAME_COUNT)
+		{
+			continue;
+		}
+
+		// All the cascades got casters
+		ANKI_TEST_EXPECT_EQ(rqueue.m_directionalLight.m_shadowCascadeCount, MAX_SHADOW_CASCADES);
+		for(U32 i = 0; i < rqueue.m_directionalLight.m_shadowCascadeCount; ++i)
+		{
+			ANKI_TEST_EXPECT_GT(rqueue.m_directionalLight.m_shadowRenderQueues[i]->m_renderables.getSize(), 0u);
+		}
+
+		// The faces of the point lights got the same casters as testing every caster against them
+		ANKI_TEST_EXPECT_EQ(rqueue.m_shadowPointLights.getSize(), POINT_LIGHT_COUNT);
+		for(const PointLightQueueElement* el : rqueue.m_shadowPointLights)
+		{
+			const PointLightNode* node = nullptr;
+			for(const PointLightNode* light : pointLights)
+			{
+				const Vec4 origin = light->getComponent<MoveComponent>().getWorldTransform().getOrigin();
+				if(origin.xyz() == el->m_worldPosition)
+				{
+					node = light;
+				}
+			}
+			ANKI_TEST_EXPECT_NEQ(node, nullptr);
+
+			std::vector<U32> faceCounts, expectedFaceCounts;
+			for(U32 face = 0; face < 6; ++face)
+			{
+				faceCounts.push_back(el->m_shadowRenderQueues[face]->m_renderables.getSize());
+			}
+
+			Error err = node->iterateComponentsOfType<FrustumComponent>([&](const FrustumComponent& frc) -> Error {
+				U32 count = 0;
+				for(const ShadowCasterNode* caster : casters)
+				{
+					count += frc.insideFrustum(caster->m_box);
+				}
+				expectedFaceCounts.push_back(count);
+				return Error::NONE;
+			});
+			(void)err;
+
+			std::sort(faceCounts.begin(), faceCounts.end());
+			std::sort(expectedFaceCounts.begin(), expectedFaceCounts.end());
+			ANKI_TEST_EXPECT_EQ(faceCounts == expectedFaceCounts, true);
+		}
+	}
+
+	ANKI_TEST_LOGI("%u casters, %u cascades and %u point lights, %u hive threads. Visibility tests %fms",
+				   CASTER_COUNT, MAX_SHADOW_CASCADES, POINT_LIGHT_COUNT, ctx.m_hive->getThreadCount(),
+				   visibilityTime / Second(FRAME_COUNT) * 1000.0);
+}
+
+class SkinBenchNode : public SceneNode
+{
+public:
+	SkinBenchNode(SceneGraph* scene, CString name)
+		: SceneNode(scene, name)
+	{
+	}
+
+	ANKI_USE_RESULT Error init(SkeletonResourcePtr skeleton)
+	{
+		newComponent<SkinComponent>(this, skeleton);
+		return Error::NONE;
+	}
+};
+
+ANKI_TEST(Scene, SkinComponentBench)
+{
+	SceneGraphTestContext ctx(DefaultConfigSet::get());
+	SceneGraph& scene = *ctx.m_scene;
+
+	// A 500 bone skeleton where every bone has 4 children and a 4 second clip at 30 keyframes per second. Every bone
+	// is 1 unit above its parent and all of them rotate around Y
+	const U32 BONE_COUNT = 500;
+	const U32 KEYFRAME_COUNT = 120;
+	const U32 FRAME_COUNT = 600;
+	const Second FRAME_TIME = 1.0 / 60.0;
+	const CString identity = "1 0 0 0 0 1 0 0 0 0 1 0 0 0 0 1";
+
+	// Write them to the cache directory of the resource manager since it's searched on every load
+	{
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open("SkinComponentBench.ankiskel", FileOpenFlag::WRITE));
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("<skeleton><bones>\n"));
+		for(U32 i = 0; i < BONE_COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText("<bone name=\"b%u\" transform=\"%s\" boneTransform=\"%s\"", i,
+												   identity.cstr(), identity.cstr()));
+			if(i > 0)
+			{
+				ANKI_TEST_EXPECT_NO_ERR(file.writeText(" parent=\"b%u\"", (i - 1) / 4));
+			}
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText("/>\n"));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("</bones></skeleton>\n"));
+	}
+
+	{
+		File file;
+		ANKI_TEST_EXPECT_NO_ERR(file.open("SkinComponentBench.ankianim", FileOpenFlag::WRITE));
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("<animation><channels>\n"));
+		const Second duration = Second(KEYFRAME_COUNT - 1) / 30.0;
+		for(U32 i = 0; i < BONE_COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText("<channel name=\"b%u\"><positionKeys>"
+												   "<key time=\"0\">0 1 0</key><key time=\"%f\">0 1 0</key>"
+												   "</positionKeys><rotationKeys>\n",
+												   i, duration));
+			for(U32 k = 0; k < KEYFRAME_COUNT; ++k)
+			{
+				const F32 angle = F32(k) / F32(KEYFRAME_COUNT - 1) * PI;
+				ANKI_TEST_EXPECT_NO_ERR(file.writeText("<key time=\"%f\">0 %f 0 %f</key>\n", Second(k) / 30.0,
+													   sin(angle / 2.0f), cos(angle / 2.0f)));
+			}
+			ANKI_TEST_EXPECT_NO_ERR(file.writeText("</rotationKeys></channel>\n"));
+		}
+		ANKI_TEST_EXPECT_NO_ERR(file.writeText("</channels></animation>\n"));
+	}
+
+	SkeletonResourcePtr skeleton;
+	ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("SkinComponentBench.ankiskel", skeleton));
+	AnimationResourcePtr anim;
+	ANKI_TEST_EXPECT_NO_ERR(ctx.m_resources->loadResource("SkinComponentBench.ankianim", anim));
+	ANKI_TEST_EXPECT_EQ(skeleton->getBones().getSize(), BONE_COUNT);
+
+	SkinBenchNode* node;
+	ANKI_TEST_EXPECT_NO_ERR(scene.newSceneNode<SkinBenchNode>("skin", node, skeleton));
+	SkinComponent& skin = node->getComponent<SkinComponent>();
+
+	AnimationPlayInfo info;
+	info.m_repeatTimes = -1.0f;
+	skin.playAnimation(0, anim, info);
+
+	HighRezTimer timer;
+	timer.start();
+	Second time = 0.0;
+	for(U32 frame = 0; frame < FRAME_COUNT; ++frame)
+	{
+		Bool updated;
+		ANKI_TEST_EXPECT_NO_ERR(skin.update(*node, time, time + FRAME_TIME, updated));
+		ANKI_TEST_EXPECT_EQ(updated, true);
+		time += FRAME_TIME;
+	}
+	timer.stop();
+
+	// Every bone got animated, not only the first ones. The rotations around Y don't move the bones so a bone is as
+	// many units up as its depth in the hierarchy plus one
+	ConstWeakArray<Mat4> trfs = skin.getBoneTransforms();
+	for(U32 i = 0; i < BONE_COUNT; ++i)
+	{
+		U32 depth = 0;
+		for(U32 parent = i; parent > 0; parent = (parent - 1) / 4)
+		{
+			++depth;
+		}
+
+		const Vec4 pos = trfs[i].getTranslationPart();
+		ANKI_TEST_EXPECT_NEAR(pos.x(), 0.0f, 0.001f);
+		ANKI_TEST_EXPECT_NEAR(pos.y(), F32(depth + 1), 0.001f);
+		ANKI_TEST_EXPECT_NEAR(pos.z(), 0.0f, 0.001f);
+	}
+
+	ANKI_TEST_LOGI("SkinComponent with %u bones of %u keyframes. Update %fms", BONE_COUNT, KEYFRAME_COUNT,
+				   timer.getElapsedTime() / Second(FRAME_COUNT) * 1000.0);
+}
+
+} // end namespace anki
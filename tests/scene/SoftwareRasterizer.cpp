@@ -0,0 +1,437 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/scene/SoftwareRasterizer.h>
+#include <anki/collision/Aabb.h>
+#include <anki/util/HighRezTimer.h>
+
+namespace anki
+{
+
+/// The scalar per pixel rasterizer that the tiled one replaced. Used as a reference.
+class ReferenceRasterizer
+{
+public:
+	Mat4 m_mv;
+	Mat4 m_p;
+	Mat4 m_mvp;
+	U32 m_width;
+	U32 m_height;
+	std::vector<F32> m_zbuffer;
+
+	ReferenceRasterizer(const Mat4& mv, const Mat4& p, U32 width, U32 height)
+		: m_mv(mv)
+		, m_p(p)
+		, m_mvp(p * mv)
+		, m_width(width)
+		, m_height(height)
+		, m_zbuffer(width * height, 1.0f)
+	{
+	}
+
+	/// Draw triangles that don't need clipping.
+	void draw(const Vec3* verts, U32 vertCount)
+	{
+		for(U32 i = 0; i < vertCount; i += 3)
+		{
+			Array<Vec4, 3> clip;
+			for(U32 j = 0; j < 3; ++j)
+			{
+				clip[j] = m_mvp * Vec4(verts[i + j], 1.0f);
+			}
+
+			rasterizeTriangle(&clip[0]);
+		}
+	}
+
+	Bool visibilityTest(const Aabb& aabb) const
+	{
+		const Vec4& minv = aabb.getMin();
+		const Vec4& maxv = aabb.getMax();
+		Vec4 bboxMin(MAX_F32);
+		Vec4 bboxMax(MIN_F32);
+		for(U32 i = 0; i < 8; ++i)
+		{
+			Vec4 p((i & 1) ? maxv.x() : minv.x(), (i & 2) ? maxv.y() : minv.y(), (i & 4) ? maxv.z() : minv.z(), 1.0f);
+			p = m_mvp * p;
+			if(p.w() <= 0.0f)
+			{
+				return true;
+			}
+
+			p /= p.w();
+			p = (p * Vec4(0.5f, 0.5f, 1.0f, 1.0f) + Vec4(0.5f, 0.5f, 0.0f, 0.0f))
+				* Vec4(F32(m_width), F32(m_height), 1.0f, 1.0f);
+			bboxMin = bboxMin.min(p);
+			bboxMax = bboxMax.max(p);
+		}
+
+		const U32 minX = U32(clamp(floorf(bboxMin.x()), 0.0f, F32(m_width)));
+		const U32 maxX = U32(clamp(ceilf(bboxMax.x()), 0.0f, F32(m_width)));
+		const U32 minY = U32(clamp(floorf(bboxMin.y()), 0.0f, F32(m_height)));
+		const U32 maxY = U32(clamp(ceilf(bboxMax.y()), 0.0f, F32(m_height)));
+		for(U32 y = minY; y < maxY; ++y)
+		{
+			for(U32 x = minX; x < maxX; ++x)
+			{
+				if(bboxMin.z() < m_zbuffer[y * m_width + x])
+				{
+					return true;
+				}
+			}
+		}
+
+		return false;
+	}
+
+private:
+	static Bool computeBarycetrinc(const Vec2& a, const Vec2& b, const Vec2& c, const Vec2& p, Vec3& uvw)
+	{
+		const Vec2 dca = c - a;
+		const Vec2 dba = b - a;
+		const Vec2 dap = a - p;
+
+		const Vec3 k = Vec3(dca.x(), dba.x(), dap.x()).cross(Vec3(dca.y(), dba.y(), dap.y()));
+		if(isZero(k.z()))
+		{
+			return true;
+		}
+
+		uvw = Vec3(1.0f - (k.x() + k.y()) / k.z(), k.y() / k.z(), k.x() / k.z());
+		return uvw.x() < 0.0f || uvw.y() < 0.0f || uvw.z() < 0.0f;
+	}
+
+	void rasterizeTriangle(const Vec4* tri)
+	{
+		const Vec2 windowSize{F32(m_width), F32(m_height)};
+		Array<Vec3, 3> ndc;
+		Array<Vec2, 3> window;
+		Vec2 bboxMin(MAX_F32), bboxMax(MIN_F32);
+		for(U32 i = 0; i < 3; i++)
+		{
+			ndc[i] = tri[i].xyz() / tri[i].w();
+			window[i] = (ndc[i].xy() / 2.0f + 0.5f) * windowSize;
+
+			for(U32 j = 0; j < 2; j++)
+			{
+				bboxMin[j] = clamp(std::floor(min(bboxMin[j], window[i][j])), 0.0f, windowSize[j]);
+				bboxMax[j] = clamp(std::ceil(max(bboxMax[j], window[i][j])), 0.0f, windowSize[j]);
+			}
+		}
+
+		for(F32 y = bboxMin.y() + 0.5f; y < bboxMax.y() + 0.5f; y += 1.0f)
+		{
+			for(F32 x = bboxMin.x() + 0.5f; x < bboxMax.x() + 0.5f; x += 1.0f)
+			{
+				Vec3 bc;
+				if(!computeBarycetrinc(window[0], window[1], window[2], Vec2(x, y), bc))
+				{
+					const F32 depth = ndc[0].z() * bc[0] + ndc[1].z() * bc[1] + ndc[2].z() * bc[2];
+					F32& out = m_zbuffer[U32(y) * m_width + U32(x)];
+					out = min(out, depth);
+				}
+			}
+		}
+	}
+};
+
+/// Create random triangles in front of the camera. They don't touch the near plane.
+static void createOccluders(const Mat4& camTrf, U32 triangleCount, F32 size, std::vector<Vec3>& verts)
+{
+	verts.resize(triangleCount * 3);
+	for(U32 i = 0; i < triangleCount; ++i)
+	{
+		const F32 depth = getRandomRange(2.0f, 50.0f);
+		const Vec3 center(getRandomRange(-depth, depth) * 0.7f, getRandomRange(-depth, depth) * 0.4f, -depth);
+		for(U32 j = 0; j < 3; ++j)
+		{
+			Vec3 v =
+				center + Vec3(getRandomRange(-size, size), getRandomRange(-size, size), getRandomRange(-1.0f, 1.0f));
+			v.z() = min(v.z(), -1.0f);
+			verts[i * 3 + j] = (camTrf * Vec4(v, 1.0f)).xyz();
+		}
+	}
+}
+
+/// Create random boxes in front of the camera.
+static void createBoxes(const Mat4& camTrf, U32 boxCount, std::vector<Aabb>& boxes)
+{
+	boxes.resize(boxCount);
+	for(Aabb& box : boxes)
+	{
+		const F32 depth = getRandomRange(2.0f, 60.0f);
+		const Vec3 center(getRandomRange(-depth, depth) * 0.7f, getRandomRange(-depth, depth) * 0.4f, -depth);
+		const Vec4 c = camTrf * Vec4(center, 1.0f);
+		const Vec4 extend(getRandomRange(0.2f, 3.0f), getRandomRange(0.2f, 3.0f), getRandomRange(0.2f, 3.0f), 0.0f);
+		box = Aabb(c.xyz0() - extend, c.xyz0() + extend);
+	}
+}
+
+/// Create random box meshes in front of the camera like OccluderNodes would have.
+static void createBoxOccluders(const Mat4& camTrf, U32 boxCount, std::vector<Vec3>& verts)
+{
+	const Array<Array<U32, 4>, 6> quads = {{{{0, 1, 3, 2}},
+											{{4, 5, 7, 6}},
+											{{0, 1, 5, 4}},
+											{{2, 3, 7, 6}},
+											{{0, 2, 6, 4}},
+											{{1, 3, 7, 5}}}};
+
+	verts.resize(boxCount * 6 * 2 * 3);
+	U32 count = 0;
+	for(U32 i = 0; i < boxCount; ++i)
+	{
+		const F32 depth = getRandomRange(4.0f, 60.0f);
+		const Vec3 center(getRandomRange(-depth, depth) * 0.7f, getRandomRange(-depth, depth) * 0.4f, -depth);
+		const Vec3 extend(getRandomRange(0.2f, 2.0f), getRandomRange(0.2f, 2.0f), getRandomRange(0.2f, 2.0f));
+
+		Array<Vec3, 8> corners;
+		for(U32 c = 0; c < 8; ++c)
+		{
+			const Vec3 sign((c & 1) ? 1.0f : -1.0f, (c & 2) ? 1.0f : -1.0f, (c & 4) ? 1.0f : -1.0f);
+			corners[c] = (camTrf * Vec4(center + sign * extend, 1.0f)).xyz();
+		}
+
+		const Vec3 boxCenter = (camTrf * Vec4(center, 1.0f)).xyz();
+		for(const Array<U32, 4>& quad : quads)
+		{
+			for(U32 t = 0; t < 2; ++t)
+			{
+				Vec3 a = corners[quad[0]];
+				Vec3 b = corners[quad[1 + t]];
+				Vec3 c = corners[quad[2 + t]];
+
+				// Make them face outwards
+				if((b - a).cross(c - b).dot(a - boxCenter) < 0.0f)
+				{
+					std::swap(b, c);
+				}
+
+				verts[count++] = a;
+				verts[count++] = b;
+				verts[count++] = c;
+			}
+		}
+	}
+}
+
+static void setupCamera(Mat4& camTrf, Mat4& view, Mat4& proj, U32 width, U32 height)
+{
+	camTrf = Mat4(Vec4(3.0f, 1.0f, -2.0f, 1.0f), Mat3(Euler(0.1f, 0.7f, 0.0f)), 1.0f);
+	view = camTrf.getInverse();
+	const F32 fovX = toRad(70.0f);
+	proj = Mat4::calculatePerspectiveProjectionMatrix(fovX, fovX * F32(height) / F32(width), 0.5f, 100.0f);
+}
+
+ANKI_TEST(Scene, SoftwareRasterizer)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	// A size that is not a multiple of the tile size
+	const U32 WIDTH = 100;
+	const U32 HEIGHT = 60;
+	const U32 QUERY_COUNT = 5000;
+
+	Mat4 camTrf, view, proj;
+	setupCamera(camTrf, view, proj, WIDTH, HEIGHT);
+
+	std::vector<Vec3> verts;
+	createOccluders(camTrf, 100, 3.0f, verts);
+
+	std::vector<Aabb> boxes;
+	createBoxes(camTrf, QUERY_COUNT, boxes);
+
+	ReferenceRasterizer ref(view, proj, WIDTH, HEIGHT);
+	ref.draw(&verts[0], U32(verts.size()));
+
+	// Draw the same occluders. The edge pixels may differ a bit so allow a few mismatches
+	{
+		SoftwareRasterizer r;
+		r.init(alloc);
+		r.prepare(view, proj, WIDTH, HEIGHT);
+		r.draw(&verts[0][0], verts.size(), sizeof(Vec3), false);
+
+		U32 mismatches = 0;
+		U32 visibleCount = 0;
+		for(const Aabb& box : boxes)
+		{
+			const Bool visible = r.visibilityTest(box);
+			mismatches += visible != ref.visibilityTest(box);
+			visibleCount += visible;
+		}
+
+		ANKI_TEST_EXPECT_LEQ(mismatches, QUERY_COUNT / 100);
+
+		// Make sure that the test is not trivial
+		ANKI_TEST_EXPECT_GT(visibleCount, QUERY_COUNT / 100);
+		ANKI_TEST_EXPECT_LT(visibleCount, QUERY_COUNT - QUERY_COUNT / 100);
+	}
+
+	// Fill the depth buffer with the reference. Only the quantization may cause differences
+	{
+		SoftwareRasterizer r;
+		r.init(alloc);
+		r.prepare(view, proj, WIDTH, HEIGHT);
+		r.fillDepthBuffer(ConstWeakArray<F32>(&ref.m_zbuffer[0], U32(ref.m_zbuffer.size())));
+
+		U32 mismatches = 0;
+		for(const Aabb& box : boxes)
+		{
+			mismatches += r.visibilityTest(box) != ref.visibilityTest(box);
+		}
+
+		ANKI_TEST_EXPECT_LEQ(mismatches, QUERY_COUNT / 1000);
+	}
+
+	// Without occluders only the boxes that are outside the window are not visible
+	{
+		SoftwareRasterizer r;
+		r.init(alloc);
+		r.prepare(view, proj, WIDTH, HEIGHT);
+
+		const ReferenceRasterizer emptyRef(view, proj, WIDTH, HEIGHT);
+		for(U32 i = 0; i < 100; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(r.visibilityTest(boxes[i]), emptyRef.visibilityTest(boxes[i]));
+		}
+	}
+}
+
+ANKI_TEST(Scene, SoftwareRasterizerReprojection)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 WIDTH = 100;
+	const U32 HEIGHT = 60;
+	const U32 SCENE_COUNT = 10;
+	const U32 QUERY_COUNT = 2000;
+
+	U32 occludedCount = 0;
+	U32 staleFalseCulls = 0;
+	U32 reprojectedFalseCulls = 0;
+	U32 reprojectedOccludedCount = 0;
+	for(U32 sceneIdx = 0; sceneIdx < SCENE_COUNT; ++sceneIdx)
+	{
+		Mat4 camTrf, view, proj;
+		setupCamera(camTrf, view, proj, WIDTH, HEIGHT);
+
+		std::vector<Vec3> verts;
+		createBoxOccluders(camTrf, 60, verts);
+
+		std::vector<Aabb> boxes;
+		createBoxes(camTrf, QUERY_COUNT, boxes);
+
+		// The depth of the previous frame
+		ReferenceRasterizer prevRef(view, proj, WIDTH, HEIGHT);
+		prevRef.draw(&verts[0], U32(verts.size()));
+		const ConstWeakArray<F32> prevDepth(&prevRef.m_zbuffer[0], U32(prevRef.m_zbuffer.size()));
+
+		// Move the camera sideways and forward and turn it a bit
+		const Vec4 translation(getRandomRange(-1.0f, 1.0f), getRandomRange(-0.5f, 0.5f), getRandomRange(-1.5f, 0.0f), 1.0f);
+		const Mat4 move(translation, Mat3(Euler(0.0f, getRandomRange(-0.1f, 0.1f), 0.0f)), 1.0f);
+		const Mat4 newView = (camTrf * move).getInverse();
+		ReferenceRasterizer ref(newView, proj, WIDTH, HEIGHT);
+		ref.draw(&verts[0], U32(verts.size()));
+
+		SoftwareRasterizer stale;
+		stale.init(alloc);
+		stale.prepare(newView, proj, WIDTH, HEIGHT);
+		stale.fillDepthBuffer(prevDepth);
+
+		SoftwareRasterizer reprojected;
+		reprojected.init(alloc);
+		reprojected.prepare(newView, proj, WIDTH, HEIGHT);
+		reprojected.fillDepthBufferReprojected(prevDepth, proj * view);
+
+		for(const Aabb& box : boxes)
+		{
+			const Bool visible = ref.visibilityTest(box);
+			occludedCount += !visible;
+
+			staleFalseCulls += visible && !stale.visibilityTest(box);
+
+			const Bool reprojectedVisible = reprojected.visibilityTest(box);
+			reprojectedFalseCulls += visible && !reprojectedVisible;
+			reprojectedOccludedCount += !reprojectedVisible;
+		}
+	}
+
+	ANKI_TEST_LOGI("Occluded %u. Stale depth false culls %u. Reprojected depth false culls %u, occluded %u",
+				   occludedCount, staleFalseCulls, reprojectedFalseCulls, reprojectedOccludedCount);
+
+	// The stale depth culls visible objects. The reprojected depth shouldn't but the hole filling guesses a few wrong
+	const U32 totalQueryCount = SCENE_COUNT * QUERY_COUNT;
+	ANKI_TEST_EXPECT_GT(staleFalseCulls, totalQueryCount / 50);
+	ANKI_TEST_EXPECT_LEQ(reprojectedFalseCulls, totalQueryCount / 500);
+
+	// The holes shouldn't throw away most of the occlusion
+	ANKI_TEST_EXPECT_GT(reprojectedOccludedCount, occludedCount / 4);
+}
+
+ANKI_TEST(Scene, SoftwareRasterizerBench)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+
+	const U32 WIDTH = 256;
+	const U32 HEIGHT = 144;
+	const U32 TRIANGLE_COUNT = 5000;
+	const U32 QUERY_COUNT = 100000;
+
+	Mat4 camTrf, view, proj;
+	setupCamera(camTrf, view, proj, WIDTH, HEIGHT);
+
+	std::vector<Vec3> verts;
+	createOccluders(camTrf, TRIANGLE_COUNT, 6.0f, verts);
+
+	std::vector<Aabb> boxes;
+	createBoxes(camTrf, QUERY_COUNT, boxes);
+
+	HighRezTimer timer;
+
+	// Reference
+	timer.start();
+	ReferenceRasterizer ref(view, proj, WIDTH, HEIGHT);
+	ref.draw(&verts[0], U32(verts.size()));
+	timer.stop();
+	const Second refDrawTime = timer.getElapsedTime();
+
+	timer.start();
+	U32 refVisibleCount = 0;
+	for(const Aabb& box : boxes)
+	{
+		refVisibleCount += ref.visibilityTest(box);
+	}
+	timer.stop();
+	const Second refTestTime = timer.getElapsedTime();
+
+	// Tiled
+	SoftwareRasterizer r;
+	r.init(alloc);
+
+	timer.start();
+	r.prepare(view, proj, WIDTH, HEIGHT);
+	r.draw(&verts[0][0], verts.size(), sizeof(Vec3), false);
+	timer.stop();
+	const Second drawTime = timer.getElapsedTime();
+
+	timer.start();
+	U32 visibleCount = 0;
+	for(const Aabb& box : boxes)
+	{
+		visibleCount += r.visibilityTest(box);
+	}
+	timer.stop();
+	const Second testTime = timer.getElapsedTime();
+
+	ANKI_TEST_EXPECT_LEQ(absolute(I32(visibleCount) - I32(refVisibleCount)), I32(QUERY_COUNT / 100));
+
+	ANKI_TEST_LOGI("%u triangles in %ux%u. Scalar draw %fms, tiled draw %fms", TRIANGLE_COUNT, WIDTH, HEIGHT,
+				   refDrawTime * 1000.0, drawTime * 1000.0);
+	ANKI_TEST_LOGI("%u box tests (%u visible). Scalar %fms, tiled with HiZ %fms", QUERY_COUNT, visibleCount,
+				   refTestTime * 1000.0, testTime * 1000.0);
+}
+
+} // end namespace anki
@@ -0,0 +1,244 @@
+// Copyright (C) 2009-2020, Panagiotis Christopoulos Charitos and contributors.
+// All rights reserved.
+// Code licensed under the BSD License.
+// http://www.anki3d.org/LICENSE
+
+#include <tests/framework/Framework.h>
+#include <anki/util/RadixSort.h>
+#include <anki/util/HighRezTimer.h>
+#include <anki/util/System.h>
+#include <vector>
+#include <random>
+
+namespace anki
+{
+
+class RadixSortTestElement
+{
+public:
+	U64 m_key;
+	U32 m_originalIdx;
+
+	Bool operator<(const RadixSortTestElement& b) const
+	{
+		return m_key < b.m_key;
+	}
+};
+
+class RadixSortTestCheckTask
+{
+public:
+	const U64* m_keys = nullptr;
+	U32 m_count = 0;
+	Bool m_sorted = false;
+
+	void check()
+	{
+		m_sorted = std::is_sorted(m_keys, m_keys + m_count);
+	}
+};
+
+ANKI_TEST(Util, RadixSort)
+{
+	std::mt19937_64 rand(0xABCD);
+
+	for(U32 keyBits : {8u, 32u, 64u})
+	{
+		const U32 COUNT = 10000;
+		std::vector<U64> keys(COUNT);
+		std::vector<U32> values(COUNT);
+		std::vector<RadixSortTestElement> reference(COUNT);
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			keys[i] = (keyBits == 64) ? rand() : (rand() & ((U64(1) << U64(keyBits)) - 1));
+			values[i] = i;
+			reference[i] = {keys[i], i};
+		}
+
+		std::vector<U64> tmpKeys(COUNT);
+		std::vector<U32> tmpValues(COUNT);
+		radixSort(&keys[0], &values[0], COUNT, &tmpKeys[0], &tmpValues[0]);
+
+		// It's stable so it should match std::stable_sort exactly
+		std::stable_sort(reference.begin(), reference.end());
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(keys[i], reference[i].m_key);
+			ANKI_TEST_EXPECT_EQ(values[i], reference[i].m_originalIdx);
+		}
+	}
+
+	// All keys the same
+	{
+		Array<U64, 4> keys = {{7, 7, 7, 7}};
+		Array<U32, 4> values = {{3, 2, 1, 0}};
+		Array<U64, 4> tmpKeys;
+		Array<U32, 4> tmpValues;
+		radixSort(&keys[0], &values[0], 4, &tmpKeys[0], &tmpValues[0]);
+		ANKI_TEST_EXPECT_EQ(values[0], 3u);
+		ANKI_TEST_EXPECT_EQ(values[3], 0u);
+	}
+}
+
+ANKI_TEST(Util, RadixSortParallel)
+{
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(8, alloc);
+	std::mt19937_64 rand(0xDCBA);
+
+	// Odd and even number of passes, one key per task and keys that are all the same
+	for(U32 keyBits : {0u, 8u, 16u, 24u, 64u})
+	{
+		for(U32 count : {1u, 5u, 10000u})
+		{
+			std::vector<U64> keys(count);
+			std::vector<U32> values(count);
+			std::vector<RadixSortTestElement> reference(count);
+			for(U32 i = 0; i < count; ++i)
+			{
+				keys[i] = (keyBits == 64) ? rand() : (rand() & ((U64(1) << U64(keyBits)) - 1));
+				values[i] = i;
+				reference[i] = {keys[i], i};
+			}
+
+			std::vector<U64> tmpKeys(count);
+			std::vector<U32> tmpValues(count);
+			ThreadHiveSemaphore* sem;
+			radixSortParallel(hive, hive.getThreadCount(), &keys[0], &values[0], count, &tmpKeys[0], &tmpValues[0],
+							  nullptr, sem);
+			hive.waitAllTasks();
+
+			std::stable_sort(reference.begin(), reference.end());
+			for(U32 i = 0; i < count; ++i)
+			{
+				ANKI_TEST_EXPECT_EQ(keys[i], reference[i].m_key);
+				ANKI_TEST_EXPECT_EQ(values[i], reference[i].m_originalIdx);
+			}
+		}
+	}
+
+	// Gather the elements the values point to
+	for(U32 keyBits : {0u, 8u, 16u, 64u})
+	{
+		const U32 COUNT = 5000;
+		std::vector<RadixSortTestElement> elements(COUNT);
+		std::vector<U64> keys(COUNT * 2);
+		std::vector<const RadixSortTestElement*> pointers(COUNT * 2);
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			keys[i] = (keyBits == 64) ? rand() : (rand() & ((U64(1) << U64(keyBits)) - 1));
+			elements[i] = {keys[i], i};
+			pointers[i] = &elements[i];
+		}
+
+		std::vector<RadixSortTestElement> sorted(COUNT);
+		ThreadHiveSemaphore* sem;
+		radixSortGatherParallel(hive, hive.getThreadCount(), &keys[0], &pointers[0], COUNT, &keys[COUNT],
+								&pointers[COUNT], &sorted[0], nullptr, sem);
+		hive.waitAllTasks();
+
+		std::stable_sort(elements.begin(), elements.end());
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(sorted[i].m_key, elements[i].m_key);
+			ANKI_TEST_EXPECT_EQ(sorted[i].m_originalIdx, elements[i].m_originalIdx);
+		}
+	}
+
+	// A task that waits for the sort sees the sorted keys
+	{
+		const U32 COUNT = 1000;
+		std::vector<U64> keys(COUNT);
+		std::vector<U32> values(COUNT);
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			keys[i] = COUNT - i;
+			values[i] = i;
+		}
+
+		std::vector<U64> tmpKeys(COUNT);
+		std::vector<U32> tmpValues(COUNT);
+		ThreadHiveSemaphore* sem;
+		radixSortParallel(hive, hive.getThreadCount(), &keys[0], &values[0], COUNT, &tmpKeys[0], &tmpValues[0],
+						  nullptr, sem);
+
+		RadixSortTestCheckTask check;
+		check.m_keys = &keys[0];
+		check.m_count = COUNT;
+		ThreadHiveTask task = ANKI_THREAD_HIVE_TASK({ self->check(); }, &check, sem, nullptr);
+		hive.submitTasks(&task, 1);
+		hive.waitAllTasks();
+		ANKI_TEST_EXPECT_EQ(check.m_sorted, true);
+	}
+}
+
+ANKI_TEST(Util, RadixSortBench)
+{
+	const U32 COUNT = 50000;
+	const U32 ITERATION_COUNT = 20;
+	std::mt19937_64 rand(0x1234);
+
+	std::vector<U64> keys(COUNT);
+	for(U64& key : keys)
+	{
+		key = rand();
+	}
+
+	std::vector<U64> sortedKeys(COUNT);
+	std::vector<U32> values(COUNT);
+	std::vector<U64> tmpKeys(COUNT);
+	std::vector<U32> tmpValues(COUNT);
+	std::vector<RadixSortTestElement> elements(COUNT);
+
+	HeapAllocator<U8> alloc(allocAligned, nullptr);
+	ThreadHive hive(getCpuCoresCount(), alloc);
+
+	Second radixTime = 0.0;
+	Second parallelRadixTime = 0.0;
+	Second stdTime = 0.0;
+	for(U32 it = 0; it < ITERATION_COUNT; ++it)
+	{
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			sortedKeys[i] = keys[i];
+			values[i] = i;
+			elements[i] = {keys[i], i};
+		}
+
+		HighRezTimer timer;
+		timer.start();
+		radixSort(&sortedKeys[0], &values[0], COUNT, &tmpKeys[0], &tmpValues[0]);
+		timer.stop();
+		radixTime += timer.getElapsedTime();
+
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			sortedKeys[i] = keys[i];
+			values[i] = i;
+		}
+
+		timer.start();
+		ThreadHiveSemaphore* sem;
+		radixSortParallel(hive, hive.getThreadCount(), &sortedKeys[0], &values[0], COUNT, &tmpKeys[0], &tmpValues[0],
+						  nullptr, sem);
+		hive.waitAllTasks();
+		timer.stop();
+		parallelRadixTime += timer.getElapsedTime();
+
+		timer.start();
+		std::sort(elements.begin(), elements.end());
+		timer.stop();
+		stdTime += timer.getElapsedTime();
+
+		for(U32 i = 0; i < COUNT; ++i)
+		{
+			ANKI_TEST_EXPECT_EQ(sortedKeys[i], elements[i].m_key);
+		}
+	}
+
+	ANKI_TEST_LOGI("Sorting %u keys. Radix sort %fms, parallel radix sort with %u threads %fms, std::sort %fms", COUNT,
+				   radixTime / ITERATION_COUNT * 1000.0, hive.getThreadCount(),
+				   parallelRadixTime / ITERATION_COUNT * 1000.0, stdTime / ITERATION_COUNT * 1000.0);
+}
+
+} // end namespace anki